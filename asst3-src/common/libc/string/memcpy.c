@@ -39,6 +39,7 @@
 #include <stdint.h>
 #include <string.h>
 #endif
+#include "strword.h"
 
 /*
  * C standard function - copy a block of memory.
@@ -47,39 +48,73 @@
 void *
 memcpy(void *dst, const void *src, size_t len)
 {
-	size_t i;
+	unsigned char *d = dst;
+	const unsigned char *s = src;
+	strword_t *dw;
+	const strword_t *sw;
+	strword_t lo, hi;
+	unsigned shift;
 
 	/*
 	 * memcpy does not support overlapping buffers, so always do it
 	 * forwards. (Don't change this without adjusting memmove.)
 	 *
-	 * For speedy copying, optimize the common case where both pointers
-	 * and the length are word-aligned, and copy word-at-a-time instead
-	 * of byte-at-a-time. Otherwise, copy by bytes.
-	 *
-	 * The alignment logic below should be portable. We rely on
-	 * the compiler to be reasonably intelligent about optimizing
-	 * the divides and modulos out. Fortunately, it is.
+	 * Copy bytes until the destination is word-aligned. Then, if
+	 * the source is now aligned too, copy in unrolled blocks of
+	 * words and then single words; this is the path whole pages
+	 * (as_copy, most of uiomove) take, with no head or tail at all.
+	 * If the source isn't aligned, load aligned source words and
+	 * shift pairs of them together, so each destination word still
+	 * costs one load and one store. Finish with the leftover bytes.
 	 */
 
-	if ((uintptr_t)dst % sizeof(long) == 0 &&
-	    (uintptr_t)src % sizeof(long) == 0 &&
-	    len % sizeof(long) == 0) {
-
-		long *d = dst;
-		const long *s = src;
+	if (len >= STRWORD_MINLEN) {
+		while (!STRWORD_ALIGNED(d)) {
+			*d++ = *s++;
+			len--;
+		}
+		dw = (strword_t *)d;
 
-		for (i=0; i<len/sizeof(long); i++) {
-			d[i] = s[i];
+		if (STRWORD_ALIGNED(s)) {
+			sw = (const strword_t *)s;
+			while (len >= 8 * STRWORD_SIZE) {
+				dw[0] = sw[0];
+				dw[1] = sw[1];
+				dw[2] = sw[2];
+				dw[3] = sw[3];
+				dw[4] = sw[4];
+				dw[5] = sw[5];
+				dw[6] = sw[6];
+				dw[7] = sw[7];
+				dw += 8;
+				sw += 8;
+				len -= 8 * STRWORD_SIZE;
+			}
+			while (len >= STRWORD_SIZE) {
+				*dw++ = *sw++;
+				len -= STRWORD_SIZE;
+			}
+			s = (const unsigned char *)sw;
 		}
+		else {
+			shift = ((uintptr_t)s & STRWORD_MASK) * 8;
+			sw = (const strword_t *)((uintptr_t)s & ~STRWORD_MASK);
+			lo = *sw++;
+			while (len >= STRWORD_SIZE) {
+				hi = *sw++;
+				*dw++ = STRWORD_MERGE(lo, hi, shift);
+				lo = hi;
+				len -= STRWORD_SIZE;
+			}
+			/* we're SHIFT bits into the last word loaded */
+			s = (const unsigned char *)(sw - 1) + shift / 8;
+		}
+		d = (unsigned char *)dw;
 	}
-	else {
-		char *d = dst;
-		const char *s = src;
 
-		for (i=0; i<len; i++) {
-			d[i] = s[i];
-		}
+	while (len > 0) {
+		*d++ = *s++;
+		len--;
 	}
 
 	return dst;
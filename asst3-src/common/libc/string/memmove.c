@@ -39,6 +39,7 @@
 #include <stdint.h>
 #include <string.h>
 #endif
+#include "strword.h"
 
 /*
  * C standard function - copy a block of memory, handling overlapping
@@ -48,7 +49,12 @@
 void *
 memmove(void *dst, const void *src, size_t len)
 {
-	size_t i;
+	unsigned char *d;
+	const unsigned char *s;
+	strword_t *dw;
+	const strword_t *sw;
+	strword_t lo, hi;
+	unsigned shift;
 
 	/*
 	 * If the buffers don't overlap, it doesn't matter what direction
@@ -75,42 +81,75 @@ memmove(void *dst, const void *src, size_t len)
          *                     |___|
 	 */
 
-	if ((uintptr_t)dst < (uintptr_t)src) {
+	if ((uintptr_t)dst < (uintptr_t)src ||
+	    (uintptr_t)dst >= (uintptr_t)src + len) {
 		/*
 		 * As author/maintainer of libc, take advantage of the
-		 * fact that we know memcpy copies forwards.
+		 * fact that we know memcpy copies forwards. That's also
+		 * what we want when they don't overlap at all.
 		 */
 		return memcpy(dst, src, len);
 	}
 
 	/*
-	 * Copy by words in the common case. Look in memcpy.c for more
-	 * information.
+	 * Copy backwards, the same way memcpy copies forwards (look
+	 * there for more information): bytes until the end of the
+	 * destination is aligned, then blocks and words, or shifted
+	 * pairs of words if the source is misaligned, then bytes.
+	 * Within a block the highest word goes first, because the
+	 * destination may be only one word above the source.
 	 */
 
-	if ((uintptr_t)dst % sizeof(long) == 0 &&
-	    (uintptr_t)src % sizeof(long) == 0 &&
-	    len % sizeof(long) == 0) {
+	d = (unsigned char *)dst + len;
+	s = (const unsigned char *)src + len;
 
-		long *d = dst;
-		const long *s = src;
-
-		/*
-		 * The reason we copy index i-1 and test i>0 is that
-		 * i is unsigned -- so testing i>=0 doesn't work.
-		 */
+	if (len >= STRWORD_MINLEN) {
+		while (!STRWORD_ALIGNED(d)) {
+			*--d = *--s;
+			len--;
+		}
+		dw = (strword_t *)d;
 
-		for (i=len/sizeof(long); i>0; i--) {
-			d[i-1] = s[i-1];
+		if (STRWORD_ALIGNED(s)) {
+			sw = (const strword_t *)s;
+			while (len >= 8 * STRWORD_SIZE) {
+				dw -= 8;
+				sw -= 8;
+				dw[7] = sw[7];
+				dw[6] = sw[6];
+				dw[5] = sw[5];
+				dw[4] = sw[4];
+				dw[3] = sw[3];
+				dw[2] = sw[2];
+				dw[1] = sw[1];
+				dw[0] = sw[0];
+				len -= 8 * STRWORD_SIZE;
+			}
+			while (len >= STRWORD_SIZE) {
+				*--dw = *--sw;
+				len -= STRWORD_SIZE;
+			}
+			s = (const unsigned char *)sw;
+		}
+		else {
+			shift = ((uintptr_t)s & STRWORD_MASK) * 8;
+			sw = (const strword_t *)((uintptr_t)s & ~STRWORD_MASK);
+			hi = *sw;
+			while (len >= STRWORD_SIZE) {
+				lo = *--sw;
+				*--dw = STRWORD_MERGE(lo, hi, shift);
+				hi = lo;
+				len -= STRWORD_SIZE;
+			}
+			/* we're SHIFT bits into the last word loaded */
+			s = (const unsigned char *)sw + shift / 8;
 		}
+		d = (unsigned char *)dw;
 	}
-	else {
-		char *d = dst;
-		const char *s = src;
 
-		for (i=len; i>0; i--) {
-			d[i-1] = s[i-1];
-		}
+	while (len > 0) {
+		*--d = *--s;
+		len--;
 	}
 
 	return dst;
@@ -27,12 +27,19 @@
  * SUCH DAMAGE.
  */
 
+/*
+ * This file is shared between libc and the kernel, so don't put anything
+ * in here that won't work in both contexts.
+ */
+
 #ifdef _KERNEL
 #include <types.h>
 #include <lib.h>
 #else
+#include <stdint.h>
 #include <string.h>
 #endif
+#include "strword.h"
 
 /*
  * C standard function - initialize a block of memory
@@ -41,11 +48,46 @@
 void *
 memset(void *ptr, int ch, size_t len)
 {
-	char *p = ptr;
-	size_t i;
+	unsigned char *p = ptr;
+	strword_t *pw;
+	strword_t fill;
+
+	/*
+	 * Store bytes until the pointer is word-aligned, then whole
+	 * words of CH in unrolled blocks, then the leftover bytes.
+	 * See memcpy.c.
+	 */
+
+	if (len >= STRWORD_MINLEN) {
+		while (!STRWORD_ALIGNED(p)) {
+			*p++ = ch;
+			len--;
+		}
+
+		fill = STRWORD_ONES * (unsigned char)ch;
+		pw = (strword_t *)p;
+		while (len >= 8 * STRWORD_SIZE) {
+			pw[0] = fill;
+			pw[1] = fill;
+			pw[2] = fill;
+			pw[3] = fill;
+			pw[4] = fill;
+			pw[5] = fill;
+			pw[6] = fill;
+			pw[7] = fill;
+			pw += 8;
+			len -= 8 * STRWORD_SIZE;
+		}
+		while (len >= STRWORD_SIZE) {
+			*pw++ = fill;
+			len -= STRWORD_SIZE;
+		}
+		p = (unsigned char *)pw;
+	}
 
-	for (i=0; i<len; i++) {
-		p[i] = ch;
+	while (len > 0) {
+		*p++ = ch;
+		len--;
 	}
 
 	return ptr;
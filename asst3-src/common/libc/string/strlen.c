@@ -36,8 +36,10 @@
 #include <types.h>
 #include <lib.h>
 #else
+#include <stdint.h>
 #include <string.h>
 #endif
+#include "strword.h"
 
 /*
  * C standard string function: get length of a string
@@ -46,10 +48,31 @@
 size_t
 strlen(const char *str)
 {
-	size_t ret = 0;
+	const char *p = str;
+	const strword_t *w;
 
-	while (str[ret]) {
-		ret++;
+	/*
+	 * Check bytes until we're word-aligned, then whole words until
+	 * one has a zero byte in it, then find which byte it was.
+	 * Reading the whole word past the terminator is fine since it
+	 * can't cross into another page.
+	 */
+
+	while (!STRWORD_ALIGNED(p)) {
+		if (*p == 0) {
+			return p - str;
+		}
+		p++;
+	}
+
+	w = (const strword_t *)p;
+	while (!STRWORD_HASZERO(*w)) {
+		w++;
+	}
+
+	p = (const char *)w;
+	while (*p) {
+		p++;
 	}
-	return ret;
+	return p - str;
 }
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Word-at-a-time helpers for the string functions. Private to this
+ * directory; like the rest of it, shared between libc and the kernel.
+ */
+
+#ifndef _STRWORD_H_
+#define _STRWORD_H_
+
+#include <kern/endian.h>
+
+/*
+ * The unit we move memory in. Loads and stores of these must be
+ * aligned, which is what all the fiddling with heads and tails is
+ * for. An aligned load never crosses a page boundary, so it's safe to
+ * read a whole word that's only partly inside a buffer.
+ */
+typedef unsigned long strword_t;
+
+#define STRWORD_SIZE	sizeof(strword_t)
+#define STRWORD_MASK	(STRWORD_SIZE - 1)
+#define STRWORD_BITS	(STRWORD_SIZE * 8)
+
+#define STRWORD_ALIGNED(p)	(((uintptr_t)(p) & STRWORD_MASK) == 0)
+
+/*
+ * Below this many bytes, lining things up costs more than it saves.
+ * Must be at least twice the word size, so there's always a whole
+ * word left after aligning the head.
+ */
+#define STRWORD_MINLEN	(4 * STRWORD_SIZE)
+
+/* A word with every byte 0x01, and one with every byte 0x80. */
+#define STRWORD_ONES	((strword_t)-1 / 0xff)
+#define STRWORD_HIGHS	(STRWORD_ONES * 0x80)
+
+/* Nonzero iff some byte of W is zero. */
+#define STRWORD_HASZERO(w) \
+	(((w) - STRWORD_ONES) & ~(w) & STRWORD_HIGHS)
+
+/*
+ * Given two consecutive aligned words LO and HI (LO at the lower
+ * address), get the word that starts SHIFT bits (0 < SHIFT <
+ * STRWORD_BITS) into LO. This is how a misaligned source gets copied
+ * with one load and one store per word.
+ */
+#if _BYTE_ORDER == _BIG_ENDIAN
+#define STRWORD_MERGE(lo, hi, shift) \
+	(((lo) << (shift)) | ((hi) >> (STRWORD_BITS - (shift))))
+#elif _BYTE_ORDER == _LITTLE_ENDIAN
+#define STRWORD_MERGE(lo, hi, shift) \
+	(((lo) >> (shift)) | ((hi) << (STRWORD_BITS - (shift))))
+#else
+#error "strword.h: unsupported byte order"
+#endif
+
+#endif /* _STRWORD_H_ */
@@ -126,16 +126,21 @@ paddr_t ram_getfirstfree(void);
  * TLB shootdown bits.
  *
  * We'll take up to 16 invalidations before just flushing the whole TLB.
+ *
+ * A shootdown names the address space by its serial number (see
+ * addrspace.c); a cpu whose TLB holds some other address space has
+ * nothing to do. Serial 0 matches any address space. The entryhi is
+ * the page plus ASID as loaded into the TLB, or TLBSHOOTDOWN_ALL for
+ * every entry.
  */
 
 struct tlbshootdown {
-	/*
-	 * Change this to what you need for your VM design.
-	 */
-	int ts_placeholder;
+	uint32_t ts_serial;		/* Address space, or 0 for any */
+	uint32_t ts_entryhi;		/* Page and ASID to invalidate */
 };
 
 #define TLBSHOOTDOWN_MAX 16
+#define TLBSHOOTDOWN_ALL 0xffffffff
 
 
 #endif /* _MIPS_VM_H_ */
@@ -160,10 +160,13 @@ mips_trap(struct trapframe *tf)
 	/* Interrupt? Call the interrupt handler and return. */
 	if (code == EX_IRQ) {
 		int old_in;
+		bool old_user;
 		bool doadjust;
 
 		old_in = curthread->t_in_interrupt;
+		old_user = curthread->t_intr_user;
 		curthread->t_in_interrupt = 1;
+		curthread->t_intr_user = !iskern;
 
 		/*
 		 * The processor has turned interrupts off; if the
@@ -203,6 +206,7 @@ mips_trap(struct trapframe *tf)
 		}
 
 		curthread->t_in_interrupt = old_in;
+		curthread->t_intr_user = old_user;
 		goto done2;
 	}
 
@@ -330,6 +334,18 @@ mips_trap(struct trapframe *tf)
 	cpu_irqoff();
  done2:
 
+	/*
+	 * If another thread in our process has called _exit (or died),
+	 * don't go back to user mode; exit instead. Interrupts are
+	 * logically on here (we're going back to user mode), so turn
+	 * them back on to match.
+	 */
+	if (!iskern && curproc->p_exiting) {
+		KASSERT(curthread->t_curspl == 0);
+		cpu_irqon();
+		proc_exit(0);
+	}
+
 	/*
 	 * The boot thread can get here (e.g. on interrupt return) but
 	 * since it doesn't go to userlevel, it can't be returning to
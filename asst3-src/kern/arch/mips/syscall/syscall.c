@@ -37,6 +37,7 @@
 #include <current.h>
 #include <copyinout.h>
 #include <syscall.h>
+#include <systrace.h>
 
 
 /*
@@ -83,12 +84,15 @@ syscall(struct trapframe *tf)
 	int callno;
 	int32_t retval;
 	int err;
+	bool traced;
+	uint64_t tracestart;
 
 	KASSERT(curthread != NULL);
 	KASSERT(curthread->t_curspl == 0);
 	KASSERT(curthread->t_iplhigh_count == 0);
 
 	callno = tf->tf_v0;
+	traced = SYSTRACE_START(&tracestart);
 
 	/*
 	 * Initialize retval to 0. Many of the system calls don't
@@ -113,6 +117,21 @@ syscall(struct trapframe *tf)
 				 (userptr_t)tf->tf_a1);
 		break;
 
+	    case SYS_nanosleep:
+		err = sys_nanosleep((const_userptr_t)tf->tf_a0,
+				    (userptr_t)tf->tf_a1);
+		break;
+
+	    case SYS_getitimer:
+		err = sys_getitimer(tf->tf_a0, (userptr_t)tf->tf_a1);
+		break;
+
+	    case SYS_setitimer:
+		err = sys_setitimer(tf->tf_a0,
+				    (const_userptr_t)tf->tf_a1,
+				    (userptr_t)tf->tf_a2);
+		break;
+
 
 	    /* process calls */
 
@@ -120,6 +139,37 @@ syscall(struct trapframe *tf)
 		err = sys_fork(tf, &retval);
 		break;
 
+	    case SYS_vfork:
+		err = sys_vfork(tf, &retval);
+		break;
+
+	    case SYS___spawn:
+		err = sys___spawn(
+			(userptr_t)tf->tf_a0,
+			(userptr_t)tf->tf_a1,
+			(userptr_t)tf->tf_a2,
+			tf->tf_a3,
+			&retval);
+		break;
+
+	    case SYS___ioring_enter:
+		err = sys___ioring_enter(
+			(userptr_t)tf->tf_a0,
+			tf->tf_a1,
+			tf->tf_a2,
+			&retval);
+		break;
+
+#if OPT_SYSTRACE
+	    case SYS___systrace:
+		err = sys___systrace(
+			tf->tf_a0,
+			(userptr_t)tf->tf_a1,
+			tf->tf_a2,
+			&retval);
+		break;
+#endif
+
 	    case SYS_execv:
 		err = sys_execv(
 			(userptr_t)tf->tf_a0,
@@ -138,10 +188,58 @@ syscall(struct trapframe *tf)
 			&retval);
 		break;
 
+	    case SYS_wait4:
+		err = sys_wait4(
+			tf->tf_a0,
+			(userptr_t)tf->tf_a1,
+			tf->tf_a2,
+			(userptr_t)tf->tf_a3,
+			&retval);
+		break;
+
+	    case SYS_getrusage:
+		err = sys_getrusage(tf->tf_a0, (userptr_t)tf->tf_a1);
+		break;
+
 	    case SYS_getpid:
 		err = sys_getpid(&retval);
 		break;
 
+	    case SYS_setaffinity:
+		err = sys_setaffinity(tf->tf_a0, tf->tf_a1);
+		break;
+
+	    case SYS_getaffinity:
+		err = sys_getaffinity(tf->tf_a0, (userptr_t)tf->tf_a1);
+		break;
+
+	    case SYS_futex:
+		err = sys_futex((userptr_t)tf->tf_a0, tf->tf_a1, tf->tf_a2,
+				(const_userptr_t)tf->tf_a3, &retval);
+		break;
+
+	    case SYS___thread_create:
+		err = sys___thread_create((userptr_t)tf->tf_a0,
+					  (userptr_t)tf->tf_a1,
+					  (userptr_t)tf->tf_a2, &retval);
+		break;
+
+	    case SYS___thread_exit:
+		sys___thread_exit((userptr_t)tf->tf_a0);
+		panic("Returning from __thread_exit\n");
+
+	    case SYS___thread_join:
+		err = sys___thread_join(tf->tf_a0, (userptr_t)tf->tf_a1);
+		break;
+
+	    case SYS___thread_self:
+		err = sys___thread_self(&retval);
+		break;
+
+	    case SYS___thread_detach:
+		err = sys___thread_detach(tf->tf_a0);
+		break;
+
 
 	    /* file calls */
 
@@ -164,6 +262,10 @@ syscall(struct trapframe *tf)
 		err = sys_close(tf->tf_a0);
 		break;
 
+	    case SYS_pipe:
+		err = sys_pipe((userptr_t)tf->tf_a0);
+		break;
+
 	    case SYS_read:
 		err = sys_read(
 			tf->tf_a0,
@@ -178,6 +280,90 @@ syscall(struct trapframe *tf)
 			tf->tf_a2,
 			&retval);
 		break;
+	    case SYS_readv:
+		err = sys_readv(
+			tf->tf_a0,
+			(const_userptr_t)tf->tf_a1,
+			tf->tf_a2,
+			&retval);
+		break;
+	    case SYS_writev:
+		err = sys_writev(
+			tf->tf_a0,
+			(const_userptr_t)tf->tf_a1,
+			tf->tf_a2,
+			&retval);
+		break;
+	    case SYS_pread:
+	    case SYS_pwrite:
+	    case SYS_preadv:
+	    case SYS_pwritev:
+		{
+			/*
+			 * The position is 64 bits wide and comes fourth,
+			 * so it goes in the next aligned register pair,
+			 * which is off the end of a0-a3; fetch it from
+			 * the stack.
+			 */
+			uint64_t pos;
+
+			err = copyin((userptr_t)tf->tf_sp + 16,
+				     &pos, sizeof(uint64_t));
+			if (err) {
+				break;
+			}
+
+			switch (callno) {
+			    case SYS_pread:
+				err = sys_pread(tf->tf_a0,
+						(userptr_t)tf->tf_a1,
+						tf->tf_a2, pos, &retval);
+				break;
+			    case SYS_pwrite:
+				err = sys_pwrite(tf->tf_a0,
+						 (userptr_t)tf->tf_a1,
+						 tf->tf_a2, pos, &retval);
+				break;
+			    case SYS_preadv:
+				err = sys_preadv(tf->tf_a0,
+						 (const_userptr_t)tf->tf_a1,
+						 tf->tf_a2, pos, &retval);
+				break;
+			    default:
+				err = sys_pwritev(tf->tf_a0,
+						  (const_userptr_t)tf->tf_a1,
+						  tf->tf_a2, pos, &retval);
+				break;
+			}
+		}
+		break;
+	    case SYS_poll:
+		err = sys_poll(
+			(userptr_t)tf->tf_a0,
+			tf->tf_a1,
+			tf->tf_a2,
+			&retval);
+		break;
+	    case SYS_select:
+		{
+			/* The fifth argument is on the stack. */
+			userptr_t timeout;
+
+			err = copyin((userptr_t)tf->tf_sp + 16,
+				     &timeout, sizeof(timeout));
+			if (err) {
+				break;
+			}
+			err = sys_select(
+				tf->tf_a0,
+				(userptr_t)tf->tf_a1,
+				(userptr_t)tf->tf_a2,
+				(userptr_t)tf->tf_a3,
+				timeout,
+				&retval);
+		}
+		break;
+
 	    case SYS_lseek:
 		{
 			/*
@@ -269,6 +455,7 @@ syscall(struct trapframe *tf)
 		break;
 	}
 
+	SYSTRACE_END(tf, callno, err, retval, traced, tracestart);
 
 	if (err) {
 		/*
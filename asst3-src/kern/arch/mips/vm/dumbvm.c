@@ -400,6 +400,16 @@ as_define_stack(struct addrspace *as, vaddr_t *stackptr)
 	return 0;
 }
 
+int
+as_define_threadstack(struct addrspace *as, unsigned slot, vaddr_t *stackptr)
+{
+	/* There's only room for the one stack. */
+	(void)as;
+	(void)slot;
+	(void)stackptr;
+	return ENOSYS;
+}
+
 int
 as_copy(struct addrspace *old, struct addrspace **ret)
 {
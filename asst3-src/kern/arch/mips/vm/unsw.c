@@ -54,10 +54,11 @@ static uint32_t last_frame;
 
 
 /* frame_table protected by spinlock (interrupt disabling on
- * uniprocessor) as this implementation does not block.
+ * uniprocessor) as this implementation does not block. Every CPU
+ * allocating pages comes through here, so it's a ticket lock.
  */ 
 
-static struct spinlock frame_table_spinlock = SPINLOCK_INITIALIZER;
+static struct spinlock frame_table_spinlock = SPINLOCK_TICKET_INITIALIZER;
 
 /*
  * Called very early in system boot to figure out how much physical
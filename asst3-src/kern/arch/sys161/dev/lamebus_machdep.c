@@ -314,7 +314,12 @@ mainbus_interrupt(struct trapframe *tf)
 		seen = true;
 	}
 	if (cause & MIPS_TIMER_BIT) {
-		/* Reset the timer (this clears the interrupt) */
+		/*
+		 * Reset the timer (this clears the interrupt). Until
+		 * hardclock adds to c_hardclocks, cpu_getcycles would
+		 * come out a period short, so nothing in between may
+		 * use it.
+		 */
 		mips_timer_set(CPU_FREQUENCY / HZ);
 		/* and call hardclock */
 		hardclock();
@@ -342,3 +347,122 @@ mainbus_interrupt(struct trapframe *tf)
 		}
 	}
 }
+
+/*
+ * Tickless idle.
+ *
+ * On System/161 the cycle counter (c0_count) goes back to zero when
+ * it reaches c0_compare, which is what makes the timer periodic. So
+ * while the counter is in the first period, setting c0_compare to
+ * several periods makes the next interrupt come at the end of that
+ * many periods. Putting it back means dividing the counter into
+ * whole periods and the part of the current one.
+ *
+ * Writing c0_compare clears a pending timer interrupt, so never
+ * touch it if one is pending.
+ */
+
+#define TIMER_PERIOD		(CPU_FREQUENCY / HZ)
+#define TIMER_MAXPERIODS	(0xffffffffU / TIMER_PERIOD)
+
+static
+uint32_t
+mips_timer_getcount(void)
+{
+	uint32_t count;
+
+	/* $9 == c0_count */
+	__asm volatile("mfc0 %0, $9" : "=r" (count));
+	return count;
+}
+
+static
+void
+mips_timer_setcount(uint32_t count)
+{
+	/* $9 == c0_count */
+	__asm volatile("mtc0 %0, $9" :: "r" (count));
+}
+
+static
+bool
+mips_timer_pending(void)
+{
+	uint32_t cause;
+
+	/* $13 == c0_cause */
+	__asm volatile("mfc0 %0, $13" : "=r" (cause));
+	return (cause & MIPS_TIMER_BIT) != 0;
+}
+
+/*
+ * The cycle clock (see cpu.h). The counter only counts cycles since
+ * the last timer interrupt, so add the periods counted in
+ * c_hardclocks. If the timer has gone off and hardclock hasn't run
+ * yet (we have interrupts off), the counter has already gone back to
+ * zero but c_hardclocks hasn't caught up; count the period (or, if
+ * the timer was stretched, the periods) it's about to add. Read the
+ * counter again in that case, since it may have gone off after the
+ * first read. While the timer is stretched the counter just keeps
+ * going past one period, and unstretching moves whole periods from
+ * the counter to c_hardclocks, so neither makes the clock jump.
+ */
+uint64_t
+cpu_getcycles(void)
+{
+	uint64_t ticks;
+	uint32_t count;
+	int spl;
+
+	spl = splhigh();
+	ticks = curcpu->c_hardclocks;
+	count = mips_timer_getcount();
+	if (mips_timer_pending()) {
+		ticks += curcpu->c_tickless > 0 ? curcpu->c_tickless : 1;
+		count = mips_timer_getcount();
+	}
+	splx(spl);
+
+	return ticks * TIMER_PERIOD + count;
+}
+
+uint64_t
+cpu_cycles_since(uint64_t start)
+{
+	uint64_t now;
+
+	now = cpu_getcycles();
+	return now > start ? now - start : 0;
+}
+
+unsigned
+mainbus_timer_stretch(unsigned ticks)
+{
+	KASSERT(curthread->t_curspl > 0);
+
+	if (ticks > TIMER_MAXPERIODS) {
+		ticks = TIMER_MAXPERIODS;
+	}
+	if (ticks <= 1 || mips_timer_pending()) {
+		return 1;
+	}
+	mips_timer_set(ticks * TIMER_PERIOD);
+	return ticks;
+}
+
+bool
+mainbus_timer_unstretch(unsigned *elapsed)
+{
+	uint32_t count;
+
+	KASSERT(curthread->t_curspl > 0);
+
+	if (mips_timer_pending()) {
+		return false;
+	}
+	count = mips_timer_getcount();
+	*elapsed = count / TIMER_PERIOD;
+	mips_timer_setcount(count % TIMER_PERIOD);
+	mips_timer_set(TIMER_PERIOD);
+	return true;
+}
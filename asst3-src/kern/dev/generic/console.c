@@ -49,6 +49,7 @@
 
 #include <types.h>
 #include <kern/errno.h>
+#include <kern/poll.h>
 #include <lib.h>
 #include <uio.h>
 #include <cpu.h>
@@ -174,6 +175,7 @@ con_input(void *vcs, int ch)
 	cs->cs_gotchars_head = nexthead;
 
 	V(cs->cs_rsem);
+	pollwakeup(&cs->cs_pollhead);
 }
 
 /*
@@ -302,10 +304,35 @@ con_ioctl(struct device *dev, int op, userptr_t data)
 	return EINVAL;
 }
 
+/*
+ * Input is ready if there are characters buffered; output is always
+ * ready. Record first and look after, because input arrives from the
+ * interrupt handler without any lock we could hold here.
+ */
+static
+int
+con_poll(struct device *dev, int events, struct pollset *ps)
+{
+	struct con_softc *cs = dev->d_data;
+	int ret;
+
+	ret = events & POLLOUT;
+	if (events & POLLIN) {
+		if (ps != NULL) {
+			pollrecord(&cs->cs_pollhead, ps);
+		}
+		if (cs->cs_gotchars_head != cs->cs_gotchars_tail) {
+			ret |= POLLIN;
+		}
+	}
+	return ret;
+}
+
 static const struct device_ops console_devops = {
 	.devop_eachopen = con_eachopen,
 	.devop_io = con_io,
 	.devop_ioctl = con_ioctl,
+	.devop_poll = con_poll,
 };
 
 static
@@ -386,6 +413,7 @@ config_con(struct con_softc *cs, int unit)
 	cs->cs_wsem = wsem;
 	cs->cs_gotchars_head = 0;
 	cs->cs_gotchars_tail = 0;
+	pollhead_init(&cs->cs_pollhead);
 
 	the_console = cs;
 	con_userlock_read = rlk;
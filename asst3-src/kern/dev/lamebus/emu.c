@@ -1092,6 +1092,7 @@ static const struct vnode_ops emufs_fileops = {
 	.vop_stat = emufs_stat,
 	.vop_gettype = emufs_file_gettype,
 	.vop_isseekable = emufs_isseekable,
+	.vop_poll = vnode_pollready,
 	.vop_fsync = emufs_fsync,
 	.vop_mmap = emufs_mmap,
 	.vop_truncate = emufs_truncate,
@@ -1126,6 +1127,7 @@ static const struct vnode_ops emufs_dirops = {
 	.vop_stat = emufs_stat,
 	.vop_gettype = emufs_dir_gettype,
 	.vop_isseekable = emufs_isseekable,
+	.vop_poll = vnode_pollready,
 	.vop_fsync = emufs_void_op_isdir,
 	.vop_mmap = emufs_void_op_isdir,
 	.vop_truncate = emufs_truncate_isdir,
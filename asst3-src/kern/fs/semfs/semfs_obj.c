@@ -63,6 +63,7 @@ semfs_sem_create(const char *name)
 		goto fail_lock;
 	}
 	sem->sems_count = 0;
+	pollhead_init(&sem->sems_pollhead);
 	sem->sems_hasvnode = false;
 	sem->sems_linked = false;
 	return sem;
@@ -81,6 +82,7 @@ semfs_sem_create(const char *name)
 void
 semfs_sem_destroy(struct semfs_sem *sem)
 {
+	pollhead_cleanup(&sem->sems_pollhead);
 	cv_destroy(sem->sems_cv);
 	lock_destroy(sem->sems_lock);
 	kfree(sem);
@@ -30,6 +30,7 @@
 #include <types.h>
 #include <kern/errno.h>
 #include <kern/fcntl.h>
+#include <kern/poll.h>
 #include <stat.h>
 #include <uio.h>
 #include <synch.h>
@@ -38,6 +39,7 @@
 #include <current.h>
 #include <vfs.h>
 #include <vnode.h>
+#include <poll.h>
 
 #include "semfs.h"
 
@@ -151,6 +153,33 @@ semfs_wakeup(struct semfs_sem *sem, unsigned newcount)
 	else {
 		cv_broadcast(sem->sems_cv, sem->sems_lock);
 	}
+	pollwakeup(&sem->sems_pollhead);
+}
+
+/*
+ * Poll. V (write) never blocks; P (read) doesn't if the count is
+ * nonzero.
+ */
+static
+int
+semfs_poll(struct vnode *vn, int events, struct pollset *ps)
+{
+	struct semfs_vnode *semv = vn->vn_data;
+	struct semfs_sem *sem;
+	int ret;
+
+	sem = semfs_getsem(semv);
+
+	ret = events & POLLOUT;
+	lock_acquire(sem->sems_lock);
+	if (sem->sems_count > 0) {
+		ret |= events & POLLIN;
+	}
+	else if (ps != NULL && (events & POLLIN)) {
+		pollrecord(&sem->sems_pollhead, ps);
+	}
+	lock_release(sem->sems_lock);
+	return ret;
 }
 
 /*
@@ -662,6 +691,7 @@ static const struct vnode_ops semfs_dirops = {
 	.vop_stat = semfs_dirstat,
 	.vop_gettype = semfs_gettype,
 	.vop_isseekable = semfs_isseekable,
+	.vop_poll = vnode_pollready,
 	.vop_fsync = semfs_fsync,
 	.vop_mmap = vopfail_mmap_isdir,
 	.vop_truncate = vopfail_truncate_isdir,
@@ -695,6 +725,7 @@ static const struct vnode_ops semfs_semops = {
 	.vop_stat = semfs_semstat,
 	.vop_gettype = semfs_gettype,
 	.vop_isseekable = semfs_isseekable,
+	.vop_poll = semfs_poll,
 	.vop_fsync = semfs_fsync,
 	.vop_mmap = vopfail_mmap_perm,
 	.vop_truncate = semfs_truncate,
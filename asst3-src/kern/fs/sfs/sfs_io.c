@@ -36,6 +36,8 @@
 #include <kern/errno.h>
 #include <lib.h>
 #include <uio.h>
+#include <thread.h>
+#include <current.h>
 #include <vfs.h>
 #include <device.h>
 #include <sfs.h>
@@ -98,6 +100,15 @@ sfs_rwblock(struct sfs_fs *sfs, struct uio *uio)
 				uio->uio_offset / SFS_BLOCKSIZE, tries);
 		}
 	}
+	if (result == 0 && curthread != NULL) {
+		/* Charge it to whoever asked for it. */
+		if (uio->uio_rw == UIO_READ) {
+			curthread->t_usage.u_inblock++;
+		}
+		else {
+			curthread->t_usage.u_oublock++;
+		}
+	}
 	return result;
 }
 
@@ -598,6 +598,7 @@ const struct vnode_ops sfs_fileops = {
 	.vop_stat = sfs_stat,
 	.vop_gettype = sfs_gettype,
 	.vop_isseekable = sfs_isseekable,
+	.vop_poll = vnode_pollready,
 	.vop_fsync = sfs_fsync,
 	.vop_mmap = sfs_mmap,
 	.vop_truncate = sfs_truncate,
@@ -632,6 +633,7 @@ const struct vnode_ops sfs_dirops = {
 	.vop_stat = sfs_stat,
 	.vop_gettype = sfs_gettype,
 	.vop_isseekable = sfs_isseekable,
+	.vop_poll = vnode_pollready,
 	.vop_fsync = sfs_fsync,
 	.vop_mmap = vopfail_mmap_isdir,
 	.vop_truncate = vopfail_truncate_isdir,
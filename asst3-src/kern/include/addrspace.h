@@ -71,6 +71,9 @@ struct addrspace {
         /* Put stuff here for your VM system */
         struct as_region * header; // header of linked region list
         uint32_t id;
+        uint32_t as_serial;		/* Unique; see as_activate */
+        uint32_t as_stackslots;		/* Thread stacks defined (bitmap) */
+        volatile uint32_t as_cpus;	/* CPUs that have loaded it (bitmap) */
 #endif
 };
 
@@ -111,6 +114,12 @@ struct addrspace {
  *                (Normally called *after* as_complete_load().) Hands
  *                back the initial stack pointer for the new process.
  *
+ *    as_define_threadstack - set up the user stack for the thread in
+ *                slot SLOT of the process's thread table (see proc.h),
+ *                if it isn't there already. Slot 0 is the main stack
+ *                from as_define_stack. Hands back the initial stack
+ *                pointer.
+ *
  * Note that when using dumbvm, addrspace.c is not used and these
  * functions are found in dumbvm.c.
  */
@@ -130,6 +139,8 @@ int               as_define_region(struct addrspace *as,
 int               as_prepare_load(struct addrspace *as);
 int               as_complete_load(struct addrspace *as);
 int               as_define_stack(struct addrspace *as, vaddr_t *initstackptr);
+int               as_define_threadstack(struct addrspace *as, unsigned slot,
+                                        vaddr_t *initstackptr);
 
 
 /*
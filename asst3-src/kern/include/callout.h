@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _CALLOUT_H_
+#define _CALLOUT_H_
+
+/*
+ * Callouts: functions to be called a given number of hardclock ticks
+ * in the future.
+ *
+ * Each CPU has its own callout wheel, a hash table of pending
+ * callouts keyed by the tick they're due on (modulo the table size).
+ * hardclock() advances the wheel one tick at a time and only has to
+ * look at one bucket per tick, so scheduling, cancelling and firing
+ * are all cheap no matter how many callouts are pending.
+ *
+ * A callout runs on the CPU that scheduled it, from hardclock(), in
+ * interrupt context: it must not sleep. It may reschedule itself.
+ *
+ * The struct callout belongs to the caller, which must initialize it
+ * with callout_init and mustn't free it while it's pending (cancel it
+ * first). callout_cancel does not wait for a callout that has already
+ * started firing on some CPU; if that matters, the callout function
+ * must synchronize with the canceller itself.
+ */
+
+#include <spinlock.h>
+
+struct cpu;
+
+struct callout {
+	struct callout *co_next;	/* Next in bucket */
+	struct callout **co_prevp;	/* Pointer to us in bucket */
+	struct cpu *co_cpu;		/* Wheel we're on, or NULL */
+	unsigned co_when;		/* Tick to fire on */
+	void (*co_func)(void *);	/* Function to call */
+	void *co_arg;			/* Argument for co_func */
+};
+
+/* Wheel size; must be a power of 2. */
+#define CALLWHEEL_SIZE	128
+
+struct callwheel {
+	struct spinlock cw_lock;
+	unsigned cw_ticks;		/* Ticks so far */
+	unsigned cw_pending;		/* Number of callouts pending */
+	struct callout *cw_running;	/* Callout now firing, if any */
+	struct callout *cw_buckets[CALLWHEEL_SIZE];
+};
+
+/*
+ * Per-CPU setup (called from cpu_create), the per-tick hook (called
+ * from hardclock, possibly for several ticks at once after tickless
+ * idle), and the number of ticks until the next callout on the
+ * current CPU is due, or 0 if there isn't one (for tickless idle).
+ */
+void callwheel_init(struct callwheel *cw);
+void callout_hardclock(unsigned ticks);
+unsigned callout_nextdue(void);
+
+/*
+ * Operations:
+ *    callout_init     - Set up a callout to call FUNC(ARG).
+ *    callout_schedule - Make a callout fire TICKS hardclock ticks from
+ *                       now (at least 1) on the current CPU. If it was
+ *                       already pending, it's rescheduled.
+ *    callout_cancel   - Stop a pending callout. Returns true if it was
+ *                       pending, false if it had fired (or was firing)
+ *                       or was never scheduled.
+ *    callout_halt     - Like callout_cancel, but if the callout is
+ *                       firing, wait for it to finish. Use this before
+ *                       freeing a callout. Must not be called from the
+ *                       callout itself, or with any lock held that the
+ *                       callout takes.
+ *    callout_pending  - Check if a callout is scheduled and hasn't
+ *                       fired yet.
+ *    callout_remaining - Number of ticks until a pending callout fires,
+ *                       or 0 if it isn't pending.
+ */
+void callout_init(struct callout *co, void (*func)(void *), void *arg);
+void callout_schedule(struct callout *co, unsigned ticks);
+bool callout_cancel(struct callout *co);
+void callout_halt(struct callout *co);
+bool callout_pending(struct callout *co);
+unsigned callout_remaining(struct callout *co);
+
+
+#endif /* _CALLOUT_H_ */
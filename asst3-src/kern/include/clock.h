@@ -39,7 +39,8 @@
 
 /*
  * hardclock() is called on every CPU HZ times a second, possibly only
- * when the CPU is not idle, for scheduling.
+ * when the CPU is not idle, for scheduling. (Idle CPUs skip ticks; see
+ * hardclock_idle_begin.)
  */
 
 /* hardclocks per second */
@@ -48,6 +49,13 @@
 void hardclock_bootstrap(void);
 void hardclock(void);
 
+/*
+ * Tickless idle: the idle loop calls these around cpu_idle() so that
+ * idle CPUs only take clock interrupts when a callout is due.
+ */
+void hardclock_idle_begin(void);
+void hardclock_idle_end(void);
+
 /*
  * timerclock() is called on one CPU once a second to allow simple
  * timed operations. (This is a fairly simpleminded interface.)
@@ -73,11 +81,29 @@ void timespec_sub(const struct timespec *t1,
 		  const struct timespec *t2,
 		  struct timespec *ret);
 
+/*
+ * Conversions between times and hardclock ticks. timespec_to_ticks
+ * rounds up, and caps absurdly long times.
+ */
+unsigned timespec_to_ticks(const struct timespec *ts);
+void ticks_to_timespec(unsigned ticks, struct timespec *ret);
+
 /*
  * clocksleep() suspends execution for the requested number of seconds,
  * like userlevel sleep(3). (Don't confuse it with wchan_sleep.)
+ *
+ * clocksleep_ticks() is the same in hardclock ticks. Because the
+ * current tick is already partly over, the sleep may come up to one
+ * tick short. If INTERRUPTIBLE is set, it returns EINTR early if the
+ * process's ITIMER_REAL goes off; otherwise it returns 0.
  */
 void clocksleep(int seconds);
+int clocksleep_ticks(unsigned ticks, bool interruptible);
+
+/*
+ * Callout function for a process's ITIMER_REAL (proc->p_itimer).
+ */
+void itimer_expire(void *proc);
 
 
 #endif /* _CLOCK_H_ */
@@ -33,6 +33,7 @@
 
 #include <spinlock.h>
 #include <threadlist.h>
+#include <callout.h>
 #include <machine/vm.h>  /* for TLBSHOOTDOWN_MAX */
 
 
@@ -59,8 +60,20 @@ struct cpu {
 	 */
 	struct thread *c_curthread;	/* Current thread on cpu */
 	struct threadlist c_zombies;	/* List of exited threads */
+	struct threadlist c_migrating;	/* Threads to move to other cpus */
+	struct threadlist c_threadcache; /* Dead threads kept for reuse */
+	unsigned c_threadcache_hits;	/* Forks that reused a thread */
+	unsigned c_threadcache_misses;	/* Forks that had to allocate */
 	unsigned c_hardclocks;		/* Counter of hardclock() calls */
+	unsigned c_tickless;		/* Ticks timer is stretched to */
 	unsigned c_spinlocks;		/* Counter of spinlocks held */
+	uint32_t c_lastas;		/* Serial of address space in TLB */
+
+	/*
+	 * Accessed by other cpus (to cancel callouts).
+	 * Protected by its own lock.
+	 */
+	struct callwheel c_callwheel;	/* Callouts scheduled on this cpu */
 
 	/*
 	 * Accessed by other cpus.
@@ -82,10 +95,21 @@ struct cpu {
 	 * The contents of struct tlbshootdown are also machine-
 	 * dependent and might reasonably be either an address space
 	 * and vaddr pair, or a paddr, or something else.
+	 *
+	 * If more than that are queued before the cpu gets to them,
+	 * they're dropped and c_shootdown_all is set instead, which
+	 * flushes the whole TLB. Each batch queued bumps
+	 * c_shootdown_reqs; the cpu copies it to c_shootdown_acks
+	 * once it has done all the work queued so far, which is what
+	 * senders wait for. The acks count and the pending bits are
+	 * also read without the lock while waiting.
 	 */
-	uint32_t c_ipi_pending;		/* One bit for each IPI number */
+	volatile uint32_t c_ipi_pending; /* One bit for each IPI number */
 	struct tlbshootdown c_shootdown[TLBSHOOTDOWN_MAX];
 	unsigned c_numshootdown;
+	bool c_shootdown_all;		/* Queue overflowed; flush it all */
+	uint32_t c_shootdown_reqs;	/* Batches queued */
+	volatile uint32_t c_shootdown_acks; /* Batches done */
 	struct spinlock c_ipi_lock;
 
 	/*
@@ -112,11 +136,31 @@ void cpu_machdep_init(struct cpu *);
 /*ASMLINKAGE*/ void cpu_start_secondary(void);
 void cpu_hatch(unsigned software_number);
 
+/*
+ * cpu_count returns the number of CPUs, which are numbered (c_number)
+ * from 0 to cpu_count()-1; cpu_get looks one up by number. CPUs are
+ * only added during boot, so these need no locking afterwards.
+ */
+unsigned cpu_count(void);
+struct cpu *cpu_get(unsigned num);
+
 /*
  * Produce a string describing the CPU type.
  */
 void cpu_identify(char *buf, size_t max);
 
+/*
+ * Read the current CPU's cycle clock: cycles since the CPU started
+ * taking clock interrupts, counting ticks skipped by tickless idle.
+ * It's 64 bits and doesn't wrap at clock ticks, so it can time long
+ * intervals, but each CPU has its own, and they aren't synchronized.
+ * An interval that starts on one CPU and ends on another (because
+ * the thread slept or migrated) can come out wrong, even negative;
+ * cpu_cycles_since returns 0 instead of a negative interval.
+ */
+uint64_t cpu_getcycles(void);
+uint64_t cpu_cycles_since(uint64_t start);
+
 /*
  * Hardware-level interrupt on/off, for the current CPU.
  *
@@ -156,6 +200,16 @@ void cpu_halt(void);
  * ipi_broadcast sends an IPI to all CPUs except the current one.
  * ipi_tlbshootdown is like ipi_send but carries TLB shootdown data.
  *
+ * ipi_tlbshootdown_batch queues N shootdowns for one CPU and sends a
+ * single IPI for all of them. It returns a ticket to hand to
+ * ipi_tlbshootdown_wait, which spins until the target has done the
+ * work. To shoot down on several CPUs, send to all of them first and
+ * then wait for each, so they work in parallel. Waiting is done at
+ * splhigh; a CPU waiting carries out shootdowns sent to it in the
+ * meantime, so two CPUs shooting at each other don't deadlock. Don't
+ * wait while holding a spinlock: the target might be spinning for it
+ * with interrupts off.
+ *
  * interprocessor_interrupt is called on the target CPU when an IPI is
  * received.
  */
@@ -169,6 +223,9 @@ void cpu_halt(void);
 void ipi_send(struct cpu *target, int code);
 void ipi_broadcast(int code);
 void ipi_tlbshootdown(struct cpu *target, const struct tlbshootdown *mapping);
+uint32_t ipi_tlbshootdown_batch(struct cpu *target,
+				const struct tlbshootdown *mappings, unsigned n);
+void ipi_tlbshootdown_wait(struct cpu *target, uint32_t ticket);
 
 void interprocessor_interrupt(void);
 
@@ -37,41 +37,74 @@
 #include <limits.h> /* for OPEN_MAX */
 
 
+struct lock;
+
 /*
- * The file table is an array of open files.
+ * The file table is an array of open files that grows on demand.
+ *
+ * It starts out with FT_MINSIZE slots and doubles (up to OPEN_MAX)
+ * when a descriptor past the end is placed, so the common process
+ * with a handful of open files pays for a handful of slots, and fork
+ * only has to walk the populated part of the parent's table.
+ *
+ * Because processes can have several threads, the table is shared
+ * among threads and needs synchronization. Changes (place, placeat,
+ * growing, copying) are serialized by ft_lock, which is a sleep lock
+ * because growing calls kmalloc. Lookups (filetable_get) take no
+ * lock at all: they read the slot and then take their own reference
+ * to the openfile with openfile_tryincref, then check that the slot
+ * still holds that file. This is safe against a concurrent close
+ * because of two forms of deferred reclamation:
+ *
+ *    - openfiles are type-stable (see openfile.c): a closed openfile's
+ *      memory is cached for reuse as another openfile and never goes
+ *      back to kmalloc, and tryincref refuses one whose count has
+ *      dropped to zero;
  *
- * There is no particular reason to use a fixed size array (of size
- * OPEN_MAX) instead of a dynamically sized array (using array.h) --
- * the code was just written this way years ago and there's no
- * compelling reason to change it that outweighs this benefit: you can
- * look through the code to see what it would take to make it dynamic,
- * or even to make it dynamic with the limit being user-settable. (See
- * setrlimit(2) on a Unix machine.)
+ *    - when the table grows, the old array is not freed, because a
+ *      reader may still be looking at it. It's chained to the new
+ *      array and freed with the table. Since the array doubles each
+ *      time, the retired arrays together are smaller than the
+ *      current one.
  *
- * Because we only have single-threaded processes, the file table is
- * never shared and so it doesn't require synchronization. On fork,
- * the table is copied. Another exercise: what would you need to do to
- * make this code safe for multithreaded processes? What happens if
- * one thread calls close() while another one is in the middle of e.g.
- * read() using the same file handle?
+ * A reader that gets a reference keeps the openfile alive for as
+ * long as it holds it, even if another thread closes the descriptor
+ * in the meantime; the close takes effect when the reader calls
+ * filetable_put.
  */
+struct fdarray {
+	unsigned fa_size;		/* Number of slots */
+	struct fdarray *fa_retired;	/* Smaller array this replaced */
+	struct openfile **fa_files;	/* The slots (allocated with us) */
+};
+
 struct filetable {
-	struct openfile *ft_openfiles[OPEN_MAX];
+	struct fdarray *ft_files;	/* Current slots; read without lock */
+	struct lock *ft_lock;		/* Lock for changing the table */
+	unsigned ft_nfiles;		/* Number of populated slots */
+	unsigned ft_freehint;		/* No free slot below this */
 };
 
+/* Initial size of the table; must be a power of 2. */
+#define FT_MINSIZE	8
+
 /*
  * Filetable ops:
  *
  * create -  Construct an empty file table.
  * destroy - Wipe out a file table, closing anything open in it.
  * copy -    Clone a file table.
- * okfd -    Check if a file handle is in range.
+ * okfd -    Check if a file handle is in range (below OPEN_MAX, whether
+ *           or not the table has grown that far yet).
  * get/put - Retrieve a fd for use and put it back when done. (Checks
  *           okfd and also fails on files not open; returned openfile
- *           is not NULL.) Call put with the file returned from get.
- * place -   Insert a file and return the fd.
+ *           is not NULL.) Get takes a reference to the openfile and
+ *           put drops it. Call put with the file returned from get.
+ * place -   Insert a file and return the fd. Fails with EMFILE if the
+ *           table is full.
  * placeat - Insert a file at a specific slot and return the file
- *           previously there.
+ *           previously there. Can fail with ENOMEM if the table has
+ *           to grow; placing NULL never fails.
  */
 
 struct filetable *filetable_create(void);
@@ -83,8 +116,8 @@ int filetable_get(struct filetable *ft, int fd, struct openfile **ret);
 void filetable_put(struct filetable *ft, int fd, struct openfile *file);
 
 int filetable_place(struct filetable *ft, struct openfile *file, int *fd);
-void filetable_placeat(struct filetable *ft, struct openfile *newfile, int fd,
-		       struct openfile **oldfile_ret);
+int filetable_placeat(struct filetable *ft, struct openfile *newfile, int fd,
+		      struct openfile **oldfile_ret);
 
 
 #endif /* _FILETABLE_H_ */
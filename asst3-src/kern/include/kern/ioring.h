@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _KERN_IORING_H_
+#define _KERN_IORING_H_
+
+/*
+ * Definitions for the I/O submission ring and __ioring_enter().
+ *
+ * The ring lives in the process's own memory. The process fills in
+ * submission queue entries (SQEs) at ir_sqtail and advances it; the
+ * kernel takes them from ir_sqhead, carries them out in order, and
+ * posts a completion queue entry (CQE) for each at ir_cqtail. The
+ * process reaps completions from ir_cqhead. All four indexes count
+ * up forever; entry N is in slot N % IORING_ENTRIES.
+ *
+ * The kernel never lets the completion queue overflow: it stops
+ * taking submissions while the completion queue is full.
+ *
+ * The operations are like the system calls of the same names:
+ *
+ * IORING_OP_NOP:   do nothing; the result is 0.
+ * IORING_OP_READ:  read(sqe_fd, sqe_buf, sqe_len).
+ * IORING_OP_WRITE: write(sqe_fd, sqe_buf, sqe_len).
+ * IORING_OP_OPEN:  open(sqe_buf, sqe_flags, sqe_mode).
+ * IORING_OP_CLOSE: close(sqe_fd).
+ * IORING_OP_FSYNC: fsync(sqe_fd).
+ *
+ * Flags for __ioring_enter:
+ *
+ * IORING_ENTER_ASYNC:     process the submissions on a kernel worker
+ *                         thread and return right away.
+ * IORING_ENTER_GETEVENTS: before returning, wait until at least the
+ *                         requested number of completions are there
+ *                         to be reaped (or the worker runs dry).
+ */
+
+#define IORING_ENTRIES		64	/* Must be a power of 2 */
+
+#define IORING_OP_NOP		0
+#define IORING_OP_READ		1
+#define IORING_OP_WRITE		2
+#define IORING_OP_OPEN		3
+#define IORING_OP_CLOSE		4
+#define IORING_OP_FSYNC		5
+
+#define IORING_ENTER_ASYNC	1
+#define IORING_ENTER_GETEVENTS	2
+
+struct ioring_sqe {
+	int sqe_op;			/* IORING_OP_* */
+	int sqe_fd;
+#ifdef _KERNEL
+	userptr_t sqe_buf;		/* Buffer, or path for OPEN */
+#else
+	void *sqe_buf;			/* Buffer, or path for OPEN */
+#endif
+	__size_t sqe_len;
+	int sqe_flags;			/* OPEN only */
+	__mode_t sqe_mode;		/* OPEN only */
+	__u32 sqe_data;			/* Passed back in the CQE */
+};
+
+struct ioring_cqe {
+	__u32 cqe_data;			/* sqe_data of the submission */
+	int cqe_res;			/* What the call would return */
+	int cqe_err;			/* Error code, or 0 */
+};
+
+struct ioring {
+	volatile __u32 ir_sqhead;	/* Next SQE the kernel takes */
+	volatile __u32 ir_sqtail;	/* Next SQE the process fills */
+	volatile __u32 ir_cqhead;	/* Next CQE the process reaps */
+	volatile __u32 ir_cqtail;	/* Next CQE the kernel posts */
+	struct ioring_sqe ir_sq[IORING_ENTRIES];
+	struct ioring_cqe ir_cq[IORING_ENTRIES];
+};
+
+
+#endif /* _KERN_IORING_H_ */
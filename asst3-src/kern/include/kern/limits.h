@@ -83,13 +83,13 @@
 #define __PID_MAX       32767
 
 /* Max open files per process */
-#define __OPEN_MAX      128
+#define __OPEN_MAX      4096
 
 /* Max bytes for atomic pipe I/O -- see description in the pipe() man page */
 #define __PIPE_BUF      512
 
-/* Max number of processes at once. */
-#define __PROCS_MAX       128
+/* Max number of processes at once (must be less than the number of pids) */
+#define __PROCS_MAX       1024
 
 
 /*
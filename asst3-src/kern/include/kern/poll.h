@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _KERN_POLL_H_
+#define _KERN_POLL_H_
+
+/*
+ * Definitions for poll() and select().
+ */
+
+/* Events for poll(). POLLERR, POLLHUP, and POLLNVAL are output only. */
+#define POLLIN		0x001	/* Can read without blocking */
+#define POLLPRI		0x002	/* Urgent data (never, in OS/161) */
+#define POLLOUT		0x004	/* Can write without blocking */
+#define POLLERR		0x008	/* Error, e.g. pipe with no reader */
+#define POLLHUP		0x010	/* Hung up, e.g. pipe with no writer */
+#define POLLNVAL	0x020	/* Not an open file descriptor */
+#define POLLRDNORM	POLLIN
+#define POLLWRNORM	POLLOUT
+
+struct pollfd {
+	int fd;			/* File handle, or negative to skip */
+	short events;		/* Events to look for */
+	short revents;		/* Events that happened */
+};
+
+/* Bit sets of file handles for select(). */
+#define FD_SETSIZE	128	/* select only sees fds below this; use poll */
+#define __NFDBITS	32
+
+typedef struct {
+	__u32 fds_bits[(FD_SETSIZE + __NFDBITS - 1) / __NFDBITS];
+} fd_set;
+
+#define FD_SET(fd, set) \
+	((set)->fds_bits[(fd) / __NFDBITS] |= 1U << ((fd) % __NFDBITS))
+#define FD_CLR(fd, set) \
+	((set)->fds_bits[(fd) / __NFDBITS] &= ~(1U << ((fd) % __NFDBITS)))
+#define FD_ISSET(fd, set) \
+	(((set)->fds_bits[(fd) / __NFDBITS] & (1U << ((fd) % __NFDBITS))) != 0)
+#define FD_ZERO(set) \
+	do { \
+		unsigned __fdi; \
+		for (__fdi = 0; __fdi < sizeof((set)->fds_bits) / \
+			     sizeof((set)->fds_bits[0]); __fdi++) { \
+			(set)->fds_bits[__fdi] = 0; \
+		} \
+	} while (0)
+
+
+#endif /* _KERN_POLL_H_ */
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _KERN_SPAWN_H_
+#define _KERN_SPAWN_H_
+
+/*
+ * File actions for __spawn(). They're carried out in order on the new
+ * process's copy of the file table, before the program is loaded.
+ *
+ * SPAWN_CLOSE: close SA_FD. It's not an error if it wasn't open.
+ * SPAWN_DUP2:  make SA_NEWFD refer to the same file as SA_FD.
+ * SPAWN_OPEN:  open SA_PATH with open flags SA_FLAGS and mode SA_MODE
+ *              as SA_FD, closing whatever was there.
+ *
+ * At most SPAWN_MAXACTIONS actions can be given.
+ */
+#define SPAWN_CLOSE		0
+#define SPAWN_DUP2		1
+#define SPAWN_OPEN		2
+
+#define SPAWN_MAXACTIONS	16
+
+struct spawn_action {
+	int sa_type;			/* SPAWN_* */
+	int sa_fd;
+	int sa_newfd;			/* SPAWN_DUP2 only */
+	int sa_flags;			/* SPAWN_OPEN only */
+	__mode_t sa_mode;		/* SPAWN_OPEN only */
+#ifdef _KERNEL
+	userptr_t sa_path;		/* SPAWN_OPEN only */
+#else
+	const char *sa_path;		/* SPAWN_OPEN only */
+#endif
+};
+
+
+#endif /* _KERN_SPAWN_H_ */
@@ -85,8 +85,8 @@
 #define SYS_sigreturn    32
 //#define SYS_sigaltstack 33
 //                              (resource tracking and usage)
-//#define SYS_wait4      34
-//#define SYS_getrusage  35
+#define SYS_wait4        34
+#define SYS_getrusage    35
 //                              (resource limits)
 //#define SYS_getrlimit  36
 //#define SYS_setrlimit  37
@@ -109,13 +109,13 @@
 #define SYS_close        49
 #define SYS_read         50
 #define SYS_pread        51
-//#define SYS_readv      52
-//#define SYS_preadv     53
+#define SYS_readv        52
+#define SYS_preadv       53
 #define SYS_getdirentry  54
 #define SYS_write        55
 #define SYS_pwrite       56
-//#define SYS_writev     57
-//#define SYS_pwritev    58
+#define SYS_writev       57
+#define SYS_pwritev      58
 #define SYS_lseek        59
 #define SYS_flock        60
 #define SYS_ftruncate    61
@@ -189,14 +189,33 @@
 #define SYS___time       113
 #define SYS___settime    114
 #define SYS_nanosleep    115
-//#define SYS_getitimer  116
-//#define SYS_setitimer  117
+#define SYS_getitimer    116
+#define SYS_setitimer    117
 
 //                              -- Other --
 #define SYS_sync         118
 #define SYS_reboot       119
 //#define SYS___sysctl   120
 
+//                              -- OS/161 extensions --
+//                              (scheduling)
+#define SYS_setaffinity  121
+#define SYS_getaffinity  122
+//                              (synchronization)
+#define SYS_futex        123
+//                              (threads)
+#define SYS___thread_create 124
+#define SYS___thread_exit 125
+#define SYS___thread_join 126
+#define SYS___thread_self 127
+#define SYS___thread_detach 128
+//                              (processes)
+#define SYS___spawn      129
+//                              (debugging)
+#define SYS___systrace   130
+//                              (I/O)
+#define SYS___ioring_enter 131
+
 /*CALLEND*/
 
 
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _KERN_SYSTRACE_H_
+#define _KERN_SYSTRACE_H_
+
+/*
+ * Definitions for the system call tracer and __systrace().
+ *
+ * Operations:
+ *
+ * SYSTRACE_OFF, SYSTRACE_ON: stop or start tracing.
+ * SYSTRACE_RESET:  throw away the counts and the log.
+ * SYSTRACE_STATS:  copy out SYSTRACE_NCALLS struct systrace_stats,
+ *                  indexed by call number, summed over all CPUs.
+ * SYSTRACE_LOG:    copy out as many of the most recent calls as fit,
+ *                  as struct systrace_records; returns how many.
+ *
+ * Times are in CPU cycles. Histogram bucket N counts calls that took
+ * at least 2^N and less than 2^(N+1) cycles; the last bucket also
+ * takes everything longer.
+ */
+#define SYSTRACE_OFF		0
+#define SYSTRACE_ON		1
+#define SYSTRACE_RESET		2
+#define SYSTRACE_STATS		3
+#define SYSTRACE_LOG		4
+
+#define SYSTRACE_NCALLS		160	/* Call numbers traced */
+#define SYSTRACE_NBUCKETS	24	/* Histogram buckets */
+#define SYSTRACE_NAMELEN	20
+
+struct systrace_stats {
+	char ss_name[SYSTRACE_NAMELEN];	/* Name of the call, or "" */
+	__u32 ss_calls;			/* Number of calls */
+	__u32 ss_errors;		/* Number that failed */
+	__u64 ss_cycles;		/* Total time */
+	__u32 ss_hist[SYSTRACE_NBUCKETS]; /* log2 latency histogram */
+};
+
+struct systrace_record {
+	__u32 sr_seq;			/* Sequence number on its CPU */
+	__u32 sr_cpu;			/* CPU it finished on */
+	__pid_t sr_pid;			/* Calling process */
+	int sr_callno;			/* Call number */
+	__u32 sr_args[4];		/* First four argument registers */
+	int sr_retval;			/* Return value if it succeeded */
+	int sr_err;			/* Error code, or 0 */
+	__u32 sr_cycles;		/* How long it took */
+};
+
+
+#endif /* _KERN_SYSTRACE_H_ */
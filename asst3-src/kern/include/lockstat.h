@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _LOCKSTAT_H_
+#define _LOCKSTAT_H_
+
+/*
+ * Lock contention statistics. Enable with "options lockstat" in the
+ * kernel config.
+ *
+ * Locks and spinlocks are grouped into classes by name and creation
+ * site (the caller of lock_create or spinlock_init; for statically
+ * initialized spinlocks, the spinlock itself). For each class we
+ * count acquisitions and contended acquisitions (ones that had to
+ * wait), and keep the total time spent waiting and the longest time
+ * any one lock of the class was held. Times are in CPU cycles.
+ *
+ * The counters are updated while holding the lock being counted, but
+ * nothing protects the class as a whole, so if two locks of the same
+ * class are being used at once on different CPUs an update can now
+ * and then get lost. For statistics that's good enough.
+ *
+ * lockstat_dump prints the classes, most contended first;
+ * lockstat_reset zeroes the counters. Both are on the kernel menu.
+ */
+
+#include "opt-lockstat.h"
+
+#if OPT_LOCKSTAT
+
+struct lockstat;
+
+struct lockstat_lockable {
+	struct lockstat *lsl_class;	/* Statistics for this kind of lock */
+	uint64_t lsl_holdstart;		/* When the current holder got it */
+};
+
+void lockstat_init(struct lockstat_lockable *l, const char *name,
+		   const void *site);
+uint64_t lockstat_now(void);
+void lockstat_acquired(struct lockstat_lockable *l, bool contended,
+		       uint64_t start);
+void lockstat_released(struct lockstat_lockable *l);
+
+void lockstat_dump(void);
+void lockstat_reset(void);
+
+#define LOCKSTAT_LOCKABLE(sym)	struct lockstat_lockable sym
+
+/* The class is looked up on first use; see lockstat_acquired. */
+#define LOCKSTAT_LOCKABLE_INITIALIZER	{ NULL, 0 }
+
+/* Must be used directly in lock_create/spinlock_init to get the site. */
+#define LOCKSTAT_INIT(l, name) \
+	lockstat_init(l, name, __builtin_return_address(0))
+
+#define LOCKSTAT_NOW()			lockstat_now()
+#define LOCKSTAT_ACQUIRED(l, c, start)	lockstat_acquired(l, c, start)
+#define LOCKSTAT_RELEASED(l)		lockstat_released(l)
+
+#else
+
+#define LOCKSTAT_LOCKABLE(sym)
+
+#define LOCKSTAT_LOCKABLE_INITIALIZER
+
+#define LOCKSTAT_INIT(l, name)
+
+#define LOCKSTAT_NOW()			0
+#define LOCKSTAT_ACQUIRED(l, c, start)	((void)(c), (void)(start))
+#define LOCKSTAT_RELEASED(l)
+
+#endif
+
+#endif /* _LOCKSTAT_H_ */
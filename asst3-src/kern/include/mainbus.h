@@ -55,6 +55,23 @@ size_t mainbus_ramsize(void);
 /* Switch on an inter-processor interrupt. (Low-level.) */
 void mainbus_send_ipi(struct cpu *target);
 
+/*
+ * Tickless idle support, for the current CPU, with interrupts off.
+ *
+ * mainbus_timer_stretch makes the next clock interrupt come at the end
+ * of the TICKSth hardclock period from now instead of the first, and
+ * returns the number of periods actually set; this may be fewer, or 1
+ * if the timer can't be stretched right now.
+ *
+ * mainbus_timer_unstretch goes back to an interrupt every period
+ * without losing the phase, and sets *ELAPSED to the number of whole
+ * periods that went by while stretched. It returns false, and does
+ * nothing, if the stretched timer has already gone off; in that case
+ * the pending interrupt will call hardclock as usual.
+ */
+unsigned mainbus_timer_stretch(unsigned ticks);
+bool mainbus_timer_unstretch(unsigned *elapsed);
+
 /* Request breaking into the debugger, where available. */
 void mainbus_debugger(void);
 
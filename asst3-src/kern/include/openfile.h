@@ -47,6 +47,11 @@
  * Open files are reference-counted because they get shared via fork
  * and dup2 calls. And they need locking because that sharing can be
  * among multiple concurrent processes.
+ *
+ * Openfiles are type-stable: once allocated, the memory is only ever
+ * reused for another openfile, and of_reflock stays initialized. This
+ * lets the file table look files up without a lock (see filetable.h).
+ * A count of zero means the openfile is dead (closed or cached).
  */
 struct openfile {
 	struct vnode *of_vnode;
@@ -57,15 +62,23 @@ struct openfile {
 
 	struct spinlock of_reflock;	/* lock for of_refcount */
 	int of_refcount;
+
+	struct openfile *of_cachenext;	/* free list link when dead */
 };
 
 /* open a file (args must be kernel pointers; destroys filename) */
 int openfile_open(char *filename, int openflags, mode_t mode,
 		  struct openfile **ret);
 
+/* wrap an already-open vnode (e.g. a pipe end) */
+int openfile_fromvnode(struct vnode *vn, int accmode, struct openfile **ret);
+
 /* adjust the refcount on an openfile */
 void openfile_incref(struct openfile *);
 void openfile_decref(struct openfile *);
 
+/* take a reference unless the openfile is dead; for lockless lookup */
+bool openfile_tryincref(struct openfile *);
+
 
 #endif /* _OPENFILE_H_ */
@@ -59,16 +59,20 @@ void pid_unalloc(pid_t targetpid);
 void pid_disown(pid_t targetpid);
 
 /*
- * Set the exit status of the current thread to status.  Wakes up any threads
- * waiting to read this status, and decrefs the current thread's pid.
+ * Set the exit status of exiting process PROC to status.  Wakes up any
+ * threads waiting to read this status, and decrefs the process's pid.
  */
-void pid_setexitstatus(int status);
+struct proc;
+void pid_setexitstatus(struct proc *proc, int status);
 
 /*
  * Causes the current thread to wait for the thread with pid PID to
- * exit, returning the exit status when it does.
+ * exit, returning the exit status (and, if USAGE isn't null, its
+ * resource usage) when it does.
  */
-int pid_wait(pid_t targetpid, int *status, int flags, pid_t *retpid);
+struct usage;
+int pid_wait(pid_t targetpid, int *status, int flags, pid_t *retpid,
+	     struct usage *usage);
 
 
 #endif /* _PID_H_ */
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _POLL_H_
+#define _POLL_H_
+
+/*
+ * Kernel side of poll() and select().
+ *
+ * Anything that can be waited for (pipes, the console, semfs
+ * semaphores) has a struct pollhead, which is a list of the pollsets
+ * currently waiting on it. A pollset belongs to one thread in one
+ * poll() or select() call and has one entry for each file it's
+ * watching.
+ *
+ * VOP_POLL(vn, events, ps) returns which of EVENTS (POLLIN, POLLOUT,
+ * etc. from <kern/poll.h>) are ready now. If PS isn't NULL, it should
+ * also call pollrecord(head, ps) to get on the head's list, so that
+ * the next pollwakeup(head) will wake the pollset up. To avoid losing
+ * a wakeup, either do both the check and the pollrecord under the
+ * same lock the object's state is changed under, or do the pollrecord
+ * first. It's harmless to record a pollset that turns out to be
+ * ready.
+ *
+ * Objects call pollwakeup whenever something happens that might make
+ * a poller ready. It can be called from interrupt handlers.
+ */
+
+#include <spinlock.h>
+
+struct pollentry;
+struct pollset;
+
+struct pollhead {
+	struct spinlock ph_lock;
+	struct pollentry *ph_entries;	/* Pollsets waiting on us */
+};
+
+void pollhead_init(struct pollhead *ph);
+void pollhead_cleanup(struct pollhead *ph);
+void pollrecord(struct pollhead *ph, struct pollset *ps);
+void pollwakeup(struct pollhead *ph);
+
+
+#endif /* _POLL_H_ */
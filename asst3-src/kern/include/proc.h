@@ -37,10 +37,30 @@
  */
 
 #include <spinlock.h>
+#include <callout.h>
 #include <thread.h> /* required for struct threadarray */
 
 struct addrspace;
+struct semaphore;
 struct vnode;
+struct wchan;
+
+/* Most user threads a process can have at once. */
+#define PROC_MAXTHREADS		32
+
+/*
+ * A user thread. Each process has a fixed table of these; the index
+ * in the table (the thread's t_uslot) also picks the thread's user
+ * stack (see as_define_threadstack). The table entry stays in use after the
+ * thread exits until it is joined, so its exit value can be
+ * collected, unless it was detached.
+ */
+struct uthread {
+	unsigned ut_tid;		/* Thread id, or 0 if entry is free */
+	bool ut_exited;			/* Has exited */
+	bool ut_detached;		/* Nobody will join it */
+	userptr_t ut_retval;		/* Exit value */
+};
 
 /*
  * Process structure.
@@ -60,11 +80,37 @@ struct proc {
 
 	/* VM */
 	struct addrspace *p_addrspace;	/* virtual address space */
+	struct semaphore *p_vforksem;	/* Set while it's the parent's */
 
 	/* VFS */
 	struct vnode *p_cwd;		/* current working directory */
 	struct filetable *p_filetable;	/* table of open files */
 
+	/* Timers (under p_lock) */
+	struct wchan *p_napchan;	/* clocksleep, poll, pipes sleep here */
+	struct callout p_itimer;	/* ITIMER_REAL */
+	bool p_itimer_armed;		/* ITIMER_REAL is set */
+	unsigned p_itimer_interval;	/* ITIMER_REAL reload, in ticks */
+	unsigned p_itimer_expirations;	/* Times ITIMER_REAL has gone off */
+
+	/* User threads (under p_lock) */
+	struct uthread p_uthreads[PROC_MAXTHREADS];
+	unsigned p_nthreads;		/* User threads still running */
+	unsigned p_nexttid;		/* Next thread id to hand out */
+	struct wchan *p_joinchan;	/* __thread_join sleeps here */
+	bool p_exiting;			/* _exit called; other threads leave */
+	int p_exitstatus;		/* Status for when the last one does */
+
+	/* I/O ring (under p_lock; see ioring.c) */
+	userptr_t p_ioring;		/* Ring the worker is serving */
+	bool p_iomore;			/* More was submitted meanwhile */
+	unsigned p_iogen;		/* Bumped for each completion */
+	struct wchan *p_iochan;		/* __ioring_enter waits here */
+
+	/* Resource usage (under p_lock; see usage.h) */
+	struct usage p_usage;		/* From threads that have left */
+	struct usage p_childusage;	/* From children waited for */
+
 	/* add more material here as needed */
 };
 
@@ -80,6 +126,16 @@ int proc_create_runprogram(const char *name, struct proc **ret);
 /* Create a fresh process for use by fork() */
 int proc_fork(struct proc **ret);
 
+/*
+ * Create a fresh process for use by vfork(). Instead of getting a copy
+ * of the caller's address space, it borrows it until it execs or
+ * exits; then proc_vforkdone hands it back and does V on DONESEM.
+ * The new process must be done with the address space (it's been
+ * replaced, or nothing is running in it) by then.
+ */
+int proc_vfork(struct semaphore *donesem, struct proc **ret);
+void proc_vforkdone(struct proc *proc);
+
 /* Undo proc_fork if nothing's run in the new process yet. */
 void proc_unfork(struct proc *proc);
 
@@ -92,8 +148,42 @@ void proc_destroy(struct proc *proc);
  *
  * The status code should be prepared with one of the _MKWAIT macros
  * defined in <kern/wait.h>.
+ *
+ * If the process has other user threads, they leave the next time
+ * they would return to user mode, and the status is posted when the
+ * last one is gone. (If the process was already exiting, STATUS is
+ * ignored; the first one wins.)
+ */
+__DEAD void proc_exit(int status);
+
+/*
+ * Get the resource usage of PROC itself (WHO is RUSAGE_SELF),
+ * counting its live threads, or of its children that have been waited
+ * for (RUSAGE_CHILDREN).
+ */
+void proc_getusage(struct proc *proc, int who, struct usage *ret);
+
+/*
+ * User threads (see thread_syscalls.c for the system calls).
+ *
+ *    proc_setmainthread - Make the current thread the only user thread
+ *                         of its process, in table slot 0. For
+ *                         runprogram and execv.
+ *    proc_uthread_exit  - Exit the current user thread, leaving VAL for
+ *                         __thread_join. If it's the last one, the
+ *                         process exits with status 0.
+ */
+void proc_setmainthread(void);
+__DEAD void proc_uthread_exit(userptr_t val);
+
+/*
+ * Kernel-only worker threads in a user process. These count as
+ * threads of the process until they call proc_worker_exit.
  */
-void proc_exit(int status);
+int proc_worker_start(const char *name,
+		      void (*func)(void *data1, unsigned long data2),
+		      void *data1, unsigned long data2);
+__DEAD void proc_worker_exit(void);
 
 /* Attach a thread to a process. Must not already have a process. */
 int proc_addthread(struct proc *proc, struct thread *t);
@@ -37,6 +37,7 @@
 
 #include <cdefs.h>
 #include <hangman.h>
+#include <lockstat.h>
 
 /* Inlining support - for making sure an out-of-line copy gets built */
 #ifndef SPINLOCK_INLINE
@@ -51,6 +52,16 @@
  *
  * Note that spinlocks are held by CPUs, not by threads.
  *
+ * There are two kinds, chosen when the spinlock is initialized; they
+ * are used the same way. An ordinary spinlock is a test-and-set
+ * lock: cheap when uncontended, but when several CPUs are waiting,
+ * whichever one happens to get there first after a release gets it,
+ * and every release sets all of them off trying to write the lock
+ * word. A ticket spinlock hands out numbers with an atomic increment
+ * and serves them in order, so waiters get the lock first-come
+ * first-served and only read the lock word while they wait. Use
+ * ticket spinlocks for locks many CPUs fight over.
+ *
  * This structure is made public so spinlocks do not have to be
  * malloc'd; however, code that uses spinlocks should not look inside
  * the structure directly but always use the spinlock API functions.
@@ -59,22 +70,37 @@ struct spinlock {
 	volatile spinlock_data_t splk_lock; /* Memory word where we spin. */
 	struct cpu *splk_holder;	    /* CPU holding this lock. */
 	HANGMAN_LOCKABLE(splk_hangman);     /* Deadlock detector hook. */
+	LOCKSTAT_LOCKABLE(splk_lockstat);   /* Contention statistics. */
+	volatile spinlock_data_t splk_next; /* Ticket lock: next ticket. */
+	bool splk_ticket;		    /* Is a ticket lock. */
 };
 
 /*
  * Initializer for cases where a spinlock needs to be static or global.
  */
-#ifdef OPT_HANGMAN
-#define SPINLOCK_INITIALIZER	{ SPINLOCK_DATA_INITIALIZER, NULL, \
-				  HANGMAN_LOCKABLE_INITIALIZER }
+#if OPT_HANGMAN
+#define SPINLOCK_HANGMAN_INITIALIZER	, HANGMAN_LOCKABLE_INITIALIZER
+#else
+#define SPINLOCK_HANGMAN_INITIALIZER
+#endif
+#if OPT_LOCKSTAT
+#define SPINLOCK_LOCKSTAT_INITIALIZER	, LOCKSTAT_LOCKABLE_INITIALIZER
 #else
-#define SPINLOCK_INITIALIZER	{ SPINLOCK_DATA_INITIALIZER, NULL }
+#define SPINLOCK_LOCKSTAT_INITIALIZER
 #endif
+#define SPINLOCK_INITIALIZER_KIND(ticket) \
+				{ SPINLOCK_DATA_INITIALIZER, NULL \
+				  SPINLOCK_HANGMAN_INITIALIZER \
+				  SPINLOCK_LOCKSTAT_INITIALIZER, \
+				  SPINLOCK_DATA_INITIALIZER, (ticket) }
+#define SPINLOCK_INITIALIZER		SPINLOCK_INITIALIZER_KIND(false)
+#define SPINLOCK_TICKET_INITIALIZER	SPINLOCK_INITIALIZER_KIND(true)
 
 /*
  * Spinlock functions.
  *
  * init		Initialize the contents of a spinlock.
+ * init_ticket	Same, but make it a ticket lock.
  * cleanup	Opposite of init. Lock must be unlocked.
  *
  * acquire	Get the lock, spinning as necessary. Also disables interrupts.
@@ -84,6 +110,7 @@ struct spinlock {
  */
 
 void spinlock_init(struct spinlock *lk);
+void spinlock_init_ticket(struct spinlock *lk);
 void spinlock_cleanup(struct spinlock *lk);
 
 void spinlock_acquire(struct spinlock *lk);
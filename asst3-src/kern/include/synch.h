@@ -58,6 +58,9 @@ void sem_destroy(struct semaphore *);
  *     P (proberen): decrement count. If the count is 0, block until
  *                   the count is 1 again before decrementing.
  *     V (verhogen): increment count.
+ *
+ * Waiters get through in FIFO order: if anyone is waiting, V hands
+ * the count directly to the first waiter instead of incrementing it.
  */
 void P(struct semaphore *);
 void V(struct semaphore *);
@@ -78,6 +81,9 @@ struct lock {
         struct wchan *lk_wchan;
         struct spinlock lk_lock;
         struct thread *volatile lk_holder;
+        int lk_waitpri;                 /* Highest waiter priority, or -1 */
+        struct lock *lk_heldnext;       /* Next in holder's t_heldlocks */
+        LOCKSTAT_LOCKABLE(lk_lockstat); /* Contention statistics. */
 };
 
 struct lock *lock_create(const char *name);
@@ -93,6 +99,16 @@ void lock_destroy(struct lock *);
  *                   false otherwise.
  *
  * These operations must be atomic. You get to write them.
+ *
+ * lock_acquire is adaptive: if the holder is running on another CPU
+ * it spins for a while, on the theory that the holder will let go
+ * soon, before going to sleep. lock_release hands the lock directly
+ * to the thread that has been asleep longest, if any.
+ *
+ * Locks do priority inheritance: while a thread is asleep waiting
+ * for a lock, the holder runs at the waiter's priority if that's
+ * higher, and so on down the chain if the holder is itself waiting
+ * for another lock. The holder drops back when it releases the lock.
  */
 void lock_acquire(struct lock *);
 void lock_release(struct lock *);
@@ -133,6 +149,10 @@ void cv_destroy(struct cv *);
  * in. Note that under normal circumstances the same lock should be used
  * on all operations with any particular CV.
  *
+ * cv_signal and cv_broadcast don't actually wake anyone: they move
+ * the waiters onto the lock, and lock_release hands it to them in
+ * turn ("wait morphing").
+ *
  * These operations must be atomic. You get to write them.
  */
 void cv_wait(struct cv *cv, struct lock *lock);
@@ -140,4 +160,57 @@ void cv_signal(struct cv *cv, struct lock *lock);
 void cv_broadcast(struct cv *cv, struct lock *lock);
 
 
+/*
+ * Reader-writer lock.
+ *
+ * Any number of readers can hold the lock at once, or one writer. It
+ * prefers writers: once a writer is waiting, new readers wait too, so
+ * a steady stream of readers can't starve writers out. When a writer
+ * releases the lock, another waiting writer gets it before any
+ * waiting readers. (So readers can starve if writers never let up;
+ * use this for data that's read much more than it's written.)
+ *
+ * Because of the writer preference, a thread that already holds the
+ * lock for reading must not acquire it for reading again; if a
+ * writer arrives in between, that deadlocks.
+ *
+ * The name field is for easier debugging. A copy of the name is
+ * made internally.
+ */
+
+struct rwlock {
+        char *rwlock_name;
+        struct wchan *rw_readwchan;     /* Readers wait here */
+        struct wchan *rw_writewchan;    /* Writers wait here */
+        struct spinlock rw_lock;
+        unsigned rw_readers;            /* Number of readers holding */
+        unsigned rw_writerswaiting;     /* Number of writers waiting */
+        struct thread *rw_writer;       /* Writer holding, if any */
+};
+
+struct rwlock *rwlock_create(const char *name);
+void rwlock_destroy(struct rwlock *);
+
+/*
+ * Operations:
+ *    rwlock_acquire_read  - Get the lock for reading. Multiple threads
+ *                           can hold the lock for reading at the same
+ *                           time.
+ *    rwlock_release_read  - Free the lock.
+ *    rwlock_acquire_write - Get the lock for writing. Only one thread
+ *                           can hold the write lock at one time.
+ *    rwlock_release_write - Free the write lock.
+ *    rwlock_do_i_hold_write - Return true if the current thread holds
+ *                           the lock for writing.
+ *
+ * (There's no rwlock_do_i_hold_read, since readers aren't tracked
+ * individually.)
+ */
+void rwlock_acquire_read(struct rwlock *);
+void rwlock_release_read(struct rwlock *);
+void rwlock_acquire_write(struct rwlock *);
+void rwlock_release_write(struct rwlock *);
+bool rwlock_do_i_hold_write(struct rwlock *);
+
+
 #endif /* _SYNCH_H_ */
@@ -54,6 +54,13 @@ __DEAD void enter_new_process(int argc, userptr_t argv, userptr_t env,
 /* Setup function for exec. */
 void exec_bootstrap(void);
 
+/* Setup function for futexes. */
+void futex_bootstrap(void);
+
+/* Wake all futex waiters in an address space (for process exit). */
+struct addrspace;
+void futex_wakeall(struct addrspace *as);
+
 
 /*
  * Prototypes for IN-KERNEL entry points for system call implementations.
@@ -64,19 +71,49 @@ void exec_bootstrap(void);
 
 int sys_reboot(int code);
 int sys___time(userptr_t user_seconds, userptr_t user_nanoseconds);
+int sys_nanosleep(const_userptr_t req, userptr_t rem);
+int sys_getitimer(int which, userptr_t curval);
+int sys_setitimer(int which, const_userptr_t newval, userptr_t oldval);
 
 int sys_fork(struct trapframe *tf, pid_t *retval);
+int sys_vfork(struct trapframe *tf, pid_t *retval);
 int sys_execv(userptr_t prog, userptr_t args);
+int sys___spawn(userptr_t prog, userptr_t args, userptr_t actions,
+		unsigned nactions, pid_t *retval);
+int sys___systrace(int op, userptr_t buf, size_t len, int32_t *retval);
+int sys___ioring_enter(userptr_t ring, unsigned want, int flags, int *retval);
 __DEAD void sys__exit(int code);
 int sys_waitpid(pid_t pid, userptr_t returncode, int flags, pid_t *retval);
+int sys_wait4(pid_t pid, userptr_t returncode, int flags, userptr_t usage,
+	      pid_t *retval);
+int sys_getrusage(int who, userptr_t usage);
 int sys_getpid(pid_t *retval);
+int sys_setaffinity(pid_t pid, uint32_t mask);
+int sys_getaffinity(pid_t pid, userptr_t maskp);
+int sys_futex(userptr_t uaddr, int op, int val, const_userptr_t timeout,
+	      int *retval);
+int sys___thread_create(userptr_t entry, userptr_t arg1, userptr_t arg2,
+			int *retval);
+__DEAD void sys___thread_exit(userptr_t retval);
+int sys___thread_join(unsigned tid, userptr_t retvalp);
+int sys___thread_self(int *retval);
+int sys___thread_detach(unsigned tid);
 
 int sys_open(const_userptr_t filename, int flags, mode_t mode, int *retval);
 int sys_dup2(int oldfd, int newfd, int *retval);
 int sys_close(int fd);
+int sys_pipe(userptr_t fdsptr);
 int sys_read(int fd, userptr_t buf, size_t size, int *retval);
 int sys_write(int fd, userptr_t buf, size_t size, int *retval);
 int sys_lseek(int fd, off_t offset, int code, off_t *retval);
+int sys_pread(int fd, userptr_t buf, size_t size, off_t pos, int *retval);
+int sys_pwrite(int fd, userptr_t buf, size_t size, off_t pos, int *retval);
+int sys_readv(int fd, const_userptr_t iov, int iovcnt, int *retval);
+int sys_writev(int fd, const_userptr_t iov, int iovcnt, int *retval);
+int sys_preadv(int fd, const_userptr_t iov, int iovcnt, off_t pos,
+	       int *retval);
+int sys_pwritev(int fd, const_userptr_t iov, int iovcnt, off_t pos,
+		int *retval);
 
 int sys_chdir(const_userptr_t path);
 int sys___getcwd(userptr_t buf, size_t buflen, int *retval);
@@ -90,6 +127,9 @@ int sys_rename(userptr_t oldpath, userptr_t newpath);
 int sys_getdirentry(int fd, userptr_t buf, size_t buflen, int *retval);
 int sys_fstat(int fd, userptr_t statptr);
 int sys_fsync(int fd);
+int sys_poll(userptr_t fds, unsigned nfds, int timeout, int *retval);
+int sys_select(int nfds, userptr_t readfds, userptr_t writefds,
+	       userptr_t exceptfds, const_userptr_t timeout, int *retval);
 int sys_ftruncate(int fd, off_t len);
 
 #endif /* _SYSCALL_H_ */
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _SYSTRACE_H_
+#define _SYSTRACE_H_
+
+/*
+ * System call tracing. Enable with "options systrace" in the kernel
+ * config; then turn it on and off with the "systrace" menu command or
+ * the __systrace system call (see <kern/systrace.h>).
+ *
+ * While it's on, each system call that returns is counted, timed, and
+ * added to a log2 histogram of its latency, and a record of it goes
+ * into a ring buffer of recent calls. Each CPU has its own counts and
+ * ring, which only that CPU writes, with interrupts off; so no locks
+ * are needed, and readers on other CPUs check each record's sequence
+ * number to skip ones that were being overwritten. Calls are timed
+ * with cpu_getcycles, so blocking calls that span clock ticks time
+ * correctly; one that blocks and migrates is timed with two different
+ * CPUs' clocks and its time is only approximate.
+ *
+ * Calls that don't return (_exit, a successful execv) aren't traced.
+ */
+
+#include "opt-systrace.h"
+
+#if OPT_SYSTRACE
+
+struct trapframe;
+
+extern volatile bool systrace_on;
+
+bool systrace_start(uint64_t *start);
+void systrace_end(struct trapframe *tf, int callno, int err,
+		  int32_t retval, uint64_t start);
+
+int systrace_enable(bool on);
+void systrace_reset(void);
+void systrace_dump(void);
+void systrace_dumplog(void);
+
+#define SYSTRACE_START(startp) \
+	(systrace_on ? systrace_start(startp) : (*(startp) = 0, false))
+#define SYSTRACE_END(tf, callno, err, retval, traced, start) \
+	((traced) ? systrace_end(tf, callno, err, retval, start) : (void)0)
+
+#else
+
+#define SYSTRACE_START(startp)		(*(startp) = 0, false)
+#define SYSTRACE_END(tf, callno, err, retval, traced, start) \
+	((void)(traced), (void)(start))
+
+#endif
+
+#endif /* _SYSTRACE_H_ */
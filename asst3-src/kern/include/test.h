@@ -49,6 +49,10 @@ int arraytest2(int, char **);
 int bitmaptest(int, char **);
 int threadlisttest(int, char **);
 
+/* string function tests */
+int stringtest(int, char **);
+int stringbench(int, char **);
+
 /* thread tests */
 int threadtest(int, char **);
 int threadtest2(int, char **);
@@ -57,6 +61,16 @@ int semtest(int, char **);
 int locktest(int, char **);
 int cvtest(int, char **);
 int cvtest2(int, char **);
+int lockbench(int, char **);
+int synchbench(int, char **);
+int spinlockbench(int, char **);
+
+/* VM tests */
+int tlbbatchtest(int, char **);
+
+/* priority inheritance tests */
+int pitest(int, char **);
+int pichaintest(int, char **);
 
 /* semaphore unit tests */
 int semu1(int, char **);
@@ -82,6 +96,22 @@ int semu20(int, char **);
 int semu21(int, char **);
 int semu22(int, char **);
 
+/* rwlock unit tests */
+int rwu1(int, char **);
+int rwu2(int, char **);
+int rwu3(int, char **);
+int rwu4(int, char **);
+int rwu5(int, char **);
+int rwu6(int, char **);
+int rwu7(int, char **);
+int rwu8(int, char **);
+int rwu9(int, char **);
+int rwu10(int, char **);
+int rwu11(int, char **);
+
+/* callout test */
+int callouttest(int, char **);
+
 /* filesystem tests */
 int fstest(int, char **);
 int readstress(int, char **);
@@ -39,6 +39,7 @@
 #include <array.h>
 #include <spinlock.h>
 #include <threadlist.h>
+#include <usage.h>
 
 struct cpu;
 
@@ -82,9 +83,25 @@ struct thread {
 	void *t_stack;			/* Kernel-level stack */
 	struct switchframe *t_context;	/* Saved register context (on stack) */
 	struct cpu *t_cpu;		/* CPU thread runs on */
+	uint32_t t_cpumask;		/* CPUs thread may run on (affinity) */
 	struct proc *t_proc;		/* Process thread belongs to */
 	HANGMAN_ACTOR(t_hangman);	/* Deadlock detector hook */
 
+	/*
+	 * Scheduling priority. t_basepri is the thread's own priority;
+	 * t_pri is the one the scheduler uses, which is raised while
+	 * the thread holds a lock a higher-priority thread is waiting
+	 * for (priority inheritance; see synch.c). t_pri and
+	 * t_waitlock are protected by the priority inheritance
+	 * spinlock in synch.c. t_heldlocks is only touched by the
+	 * thread itself, or by lock_release while the thread is
+	 * asleep waiting for the lock it's being handed.
+	 */
+	int t_basepri;			/* Own priority */
+	int t_pri;			/* Effective priority */
+	struct lock *t_waitlock;	/* Lock we're asleep waiting for */
+	struct lock *t_heldlocks;	/* Locks we hold */
+
 	/*
 	 * Interrupt state fields.
 	 *
@@ -99,6 +116,7 @@ struct thread {
 	 * rather than per-cpu or global?
 	 */
 	bool t_in_interrupt;		/* Are we in an interrupt? */
+	bool t_intr_user;		/* Was it taken from user mode? */
 	int t_curspl;			/* Current spl*() state */
 	int t_iplhigh_count;		/* # of times IPL has been raised */
 
@@ -106,9 +124,28 @@ struct thread {
 	 * Public fields
 	 */
 
+	int t_uslot;			/* Entry in t_proc's user thread
+					   table, or -1 if none */
+	struct usage t_usage;		/* Resources used (see usage.h) */
+
 	/* add more here as needed */
 };
 
+/*
+ * Thread priorities. Higher numbers run first; threads of the same
+ * priority take turns.
+ */
+#define PRI_MIN			0
+#define PRI_DEFAULT		50
+#define PRI_MAX			100
+
+/*
+ * CPU affinity masks. Bit N of t_cpumask is set if the thread may run
+ * on the cpu whose c_number is N. (MAXCPUS is at most 32.)
+ */
+#define CPUMASK_ALL		0xffffffffU
+#define CPUMASK_BIT(num)	((uint32_t)1 << (num))
+
 /*
  * Array of threads.
  */
@@ -169,5 +206,40 @@ void schedule(void);
  */
 void thread_consider_migration(void);
 
+/*
+ * Set or fetch the CPU affinity mask of a thread. New threads inherit
+ * the mask of the thread that creates them.
+ *
+ * thread_setaffinity fails with EINVAL if the mask names no cpu that
+ * exists. A sleeping thread picks up the new mask when it's woken up;
+ * one running or waiting to run on a cpu that's no longer allowed is
+ * made to move off it. If T is the current thread, it moves before
+ * returning. Fails with ENOMEM, leaving the old mask, if it can't
+ * make the thread move.
+ */
+int thread_setaffinity(struct thread *t, uint32_t mask);
+uint32_t thread_getaffinity(struct thread *t);
+
+/*
+ * Set the current thread's priority, which new threads it creates
+ * inherit. If there's now a higher-priority thread waiting to run
+ * here, it runs. (This is in synch.c because it has to cooperate with
+ * priority inheritance.)
+ */
+void thread_setpriority(int pri);
+
+/*
+ * Change the effective priority of thread T, moving it within its run
+ * queue if it's waiting to run. Only for synch.c, which must hold its
+ * priority inheritance spinlock.
+ */
+void thread_reprioritize(struct thread *t, int pri);
+
+/*
+ * Print statistics for the per-cpu caches of dead threads that
+ * thread_fork reuses.
+ */
+void thread_cache_stats(void);
+
 
 #endif /* _THREAD_H_ */
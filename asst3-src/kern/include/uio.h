@@ -144,5 +144,13 @@ void uio_kinit(struct iovec *, struct uio *,
 void uio_uinit(struct iovec *, struct uio *,
 	       userptr_t ubuf, size_t len, off_t pos, enum uio_rw rw);
 
+/*
+ * The same, for several user buffers (as for readv and writev). The
+ * IOVCNT iovecs must already be filled in, and LEN must be their
+ * total length.
+ */
+void uio_uinitv(struct iovec *, unsigned iovcnt, struct uio *,
+		size_t len, off_t pos, enum uio_rw rw);
+
 
 #endif /* _UIO_H_ */
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _USAGE_H_
+#define _USAGE_H_
+
+/*
+ * Resource usage accounting, for getrusage and wait4.
+ *
+ * Each thread counts what it uses in its own t_usage. Only the
+ * thread itself, or an interrupt handler running on top of it,
+ * updates those counts, so they need no lock. When a thread leaves
+ * its process the counts are folded into the process's p_usage;
+ * when a process is waited for, its total (including that of the
+ * children it waited for) is added to its parent's p_childusage.
+ *
+ * Times are in hardclock ticks (HZ per second).
+ */
+
+struct rusage;	/* from <kern/resource.h> */
+
+struct usage {
+	unsigned u_utime;		/* Ticks spent in user mode */
+	unsigned u_stime;		/* Ticks spent in the kernel */
+	unsigned u_minflt;		/* Faults serviced without I/O */
+	unsigned u_majflt;		/* Faults that needed I/O */
+	unsigned u_inblock;		/* Filesystem blocks read */
+	unsigned u_oublock;		/* Filesystem blocks written */
+	unsigned u_nvcsw;		/* Voluntary context switches */
+	unsigned u_nivcsw;		/* Involuntary context switches */
+};
+
+/* Clear all the counts. */
+void usage_init(struct usage *u);
+
+/* Add the counts in U to TOTAL. */
+void usage_add(struct usage *total, const struct usage *u);
+
+/* Convert to the user-level struct rusage. */
+void usage_torusage(const struct usage *u, struct rusage *ru);
+
+
+#endif /* _USAGE_H_ */
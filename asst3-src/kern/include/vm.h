@@ -70,6 +70,10 @@ void vm_bootstrap(void);
 /* Fault handling function called by trap code */
 int vm_fault(int faulttype, vaddr_t faultaddress);
 
+/* Look up a user page in some address space, without faulting */
+int vm_translate(struct addrspace *as, vaddr_t vaddr, bool write,
+		 paddr_t *ret);
+
 /* Allocate/free kernel heap pages (called by kmalloc/kfree) */
 vaddr_t alloc_kpages(unsigned npages);
 void free_kpages(vaddr_t addr);
@@ -77,4 +81,38 @@ void free_kpages(vaddr_t addr);
 /* TLB shootdown handling called from interprocessor_interrupt */
 void vm_tlbshootdown(const struct tlbshootdown *);
 
+/*
+ * Batched TLB shootdown, for changing or removing mappings in an
+ * address space that may be loaded on other cpus.
+ *
+ *    tlbbatch_init  - start an empty batch for address space AS.
+ *
+ *    tlbbatch_add   - add the page containing VADDR. Past
+ *                     TLBSHOOTDOWN_MAX pages the batch turns into a
+ *                     flush of everything AS has in the TLB.
+ *
+ *    tlbbatch_flush - invalidate the batch on every cpu that has
+ *                     loaded AS, this one included, with one IPI per
+ *                     cpu, and wait until they've all done it. The
+ *                     batch is empty again afterwards.
+ *
+ * Update the page table first and flush after; once tlbbatch_flush
+ * returns no cpu has the old mappings.
+ *
+ * tlbbatch_flush spins at splhigh until the other cpus answer, so it
+ * must not be called with a spinlock held: a cpu spinning for that
+ * lock would never take the IPI. It does take shootdowns sent to this
+ * cpu while it waits, so flushes from two cpus at once are fine.
+ */
+struct tlbbatch {
+	struct addrspace *tb_as;
+	unsigned tb_num;
+	bool tb_all;
+	struct tlbshootdown tb_ts[TLBSHOOTDOWN_MAX];
+};
+
+void tlbbatch_init(struct tlbbatch *tb, struct addrspace *as);
+void tlbbatch_add(struct tlbbatch *tb, vaddr_t vaddr);
+void tlbbatch_flush(struct tlbbatch *tb);
+
 #endif /* _VM_H_ */
@@ -33,6 +33,7 @@
 #include <spinlock.h>
 struct uio;
 struct stat;
+struct pollset;
 
 
 /*
@@ -117,6 +118,12 @@ struct vnode {
  *                      and directories are seekable, but some devices are
  *                      not.
  *
+ *    vop_poll        - Return which of EVENTS (see kern/poll.h) could be
+ *                      done now without blocking. If PS is not NULL,
+ *                      also arrange to wake it up when that changes;
+ *                      see poll.h. Things that never block can use
+ *                      vnode_pollready.
+ *
  *    vop_fsync       - Force any dirty buffers associated with this file
  *                      to stable storage.
  *
@@ -192,6 +199,7 @@ struct vnode_ops {
 	int (*vop_stat)(struct vnode *object, struct stat *statbuf);
 	int (*vop_gettype)(struct vnode *object, mode_t *result);
 	bool (*vop_isseekable)(struct vnode *object);
+	int (*vop_poll)(struct vnode *object, int events, struct pollset *ps);
 	int (*vop_fsync)(struct vnode *object);
 	int (*vop_mmap)(struct vnode *file /* add stuff */);
 	int (*vop_truncate)(struct vnode *file, off_t len);
@@ -236,6 +244,7 @@ struct vnode_ops {
 #define VOP_STAT(vn, ptr) 	        (__VOP(vn, stat)(vn, ptr))
 #define VOP_GETTYPE(vn, result)         (__VOP(vn, gettype)(vn, result))
 #define VOP_ISSEEKABLE(vn)              (__VOP(vn, isseekable)(vn))
+#define VOP_POLL(vn, events, ps)        (__VOP(vn, poll)(vn, events, ps))
 #define VOP_FSYNC(vn)                   (__VOP(vn, fsync)(vn))
 #define VOP_MMAP(vn /*add stuff */)     (__VOP(vn, mmap)(vn /*add stuff */))
 #define VOP_TRUNCATE(vn, pos)           (__VOP(vn, truncate)(vn, pos))
@@ -279,6 +288,11 @@ int vnode_init(struct vnode *, const struct vnode_ops *ops,
  */
 void vnode_cleanup(struct vnode *);
 
+/*
+ * Common stub for vop_poll on things that are always ready.
+ */
+int vnode_pollready(struct vnode *vn, int events, struct pollset *ps);
+
 /*
  * Common stubs for vnode functions that just fail, in various ways.
  */
@@ -36,6 +36,7 @@
 
 
 struct spinlock; /* in spinlock.h */
+struct thread; /* in thread.h */
 struct wchan; /* Opaque */
 
 /*
@@ -72,9 +73,37 @@ void wchan_sleep(struct wchan *wc, struct spinlock *lk);
  *
  * The current implementation is FIFO but this is not promised by the
  * interface.
+ *
+ * wchan_wakeone returns the thread it woke, or NULL if none was
+ * sleeping. The thread can't get back out of wchan_sleep until the
+ * spinlock is released, so it can be looked at until then.
  */
-void wchan_wakeone(struct wchan *wc, struct spinlock *lk);
+struct thread *wchan_wakeone(struct wchan *wc, struct spinlock *lk);
 void wchan_wakeall(struct wchan *wc, struct spinlock *lk);
 
+/*
+ * Move one thread (or all threads, if ALL is true) sleeping on FROM
+ * to the end of TO without waking it. Both spinlocks should be
+ * locked. When a moved thread is woken, it still relocks FROMLK on
+ * the way out of wchan_sleep. Returns the number of threads moved.
+ */
+unsigned wchan_transfer(struct wchan *from, struct spinlock *fromlk,
+			struct wchan *to, struct spinlock *tolk, bool all);
+
+/*
+ * Wake up thread T if it's sleeping on WC. Returns true if it was,
+ * false if it's somewhere else (for instance, it hasn't gone to sleep
+ * yet). The associated spinlock must be locked.
+ */
+bool wchan_wakethread(struct wchan *wc, struct spinlock *lk,
+		      struct thread *t);
+
+/*
+ * Return the highest effective priority (t_pri) of the threads
+ * sleeping on WC, or -1 if there aren't any. The associated spinlock
+ * must be locked.
+ */
+int wchan_maxpriority(struct wchan *wc, struct spinlock *lk);
+
 
 #endif /* _WCHAN_H_ */
@@ -45,8 +45,11 @@
 #include <pid.h>
 #include <syscall.h>
 #include <test.h>
+#include <systrace.h>
 #include "opt-sfs.h"
 #include "opt-net.h"
+#include "opt-lockstat.h"
+#include "opt-systrace.h"
 
 /*
  * In-kernel menu and command dispatcher.
@@ -130,7 +133,7 @@ common_prog(int nargs, char **args)
 		return result;
 	}
 
-	pid_wait(childpid, &status, 0, NULL);
+	pid_wait(childpid, &status, 0, NULL, NULL);
 	if (WIFEXITED(status)) {
 		kprintf("Program (pid %d) exited with status %d\n",
 			childpid, WEXITSTATUS(status));
@@ -500,6 +503,69 @@ cmd_kheapdump(int nargs, char **args)
 	return 0;
 }
 
+static
+int
+cmd_threadcache(int nargs, char **args)
+{
+	(void)nargs;
+	(void)args;
+
+	thread_cache_stats();
+	return 0;
+}
+
+#if OPT_LOCKSTAT
+static
+int
+cmd_lockstat(int nargs, char **args)
+{
+	if (nargs == 1) {
+		lockstat_dump();
+	}
+	else if (nargs == 2 && !strcmp(args[1], "reset")) {
+		lockstat_reset();
+	}
+	else {
+		kprintf("Usage: lockstat [reset]\n");
+	}
+
+	return 0;
+}
+#endif
+
+#if OPT_SYSTRACE
+static
+int
+cmd_systrace(int nargs, char **args)
+{
+	int result;
+
+	if (nargs == 1) {
+		systrace_dump();
+	}
+	else if (nargs == 2 && !strcmp(args[1], "on")) {
+		result = systrace_enable(true);
+		if (result) {
+			kprintf("systrace: %s\n", strerror(result));
+		}
+	}
+	else if (nargs == 2 && !strcmp(args[1], "off")) {
+		systrace_enable(false);
+	}
+	else if (nargs == 2 && !strcmp(args[1], "reset")) {
+		systrace_reset();
+	}
+	else if (nargs == 2 && !strcmp(args[1], "log")) {
+		systrace_dumplog();
+	}
+	else {
+		kprintf("Usage: systrace [on|off|reset|log]\n");
+	}
+
+	return 0;
+}
+#endif
+
 ////////////////////////////////////////
 //
 // Menus.
@@ -566,6 +632,8 @@ static const char *testmenu[] = {
 	"[km2] kmalloc stress test           ",
 	"[km3] Large kmalloc test            ",
 	"[km4] Multipage kmalloc test        ",
+	"[str1] String function fuzzer       ",
+	"[str2] String function benchmark    ",
 	"[tt1] Thread test 1                 ",
 	"[tt2] Thread test 2                 ",
 	"[tt3] Thread test 3                 ",
@@ -576,7 +644,15 @@ static const char *testmenu[] = {
 	"[sy2] Lock test                     ",
 	"[sy3] CV test                       ",
 	"[sy4] CV test #2                    ",
+	"[sy5] Lock handoff benchmark        ",
+	"[sy6] Synch fairness benchmark      ",
+	"[sy7] Spinlock benchmark            ",
+	"[tlb1] TLB shootdown batch test     ",
+	"[pi1] Priority inheritance test     ",
+	"[pi2] Priority inheritance chain    ",
 	"[semu1-22] Semaphore unit tests     ",
+	"[rwu1-11] RW lock unit tests        ",
+	"[co1] Callout test                  ",
 	"[wt]  waitpid test                  ",
 	"[fs1] Filesystem test               ",
 	"[fs2] FS read stress                ",
@@ -606,6 +682,7 @@ static const char *mainmenu[] = {
 	"[kh] Kernel heap stats              ",
 	"[khgen] Next kernel heap generation ",
 	"[khdump] Dump kernel heap           ",
+	"[tc] Thread cache stats             ",
 	"[q] Quit and shut down              ",
 	NULL
 };
@@ -657,6 +734,13 @@ static struct {
 	{ "kh",         cmd_kheapstats },
 	{ "khgen",      cmd_kheapgeneration },
 	{ "khdump",     cmd_kheapdump },
+	{ "tc",		cmd_threadcache },
+#if OPT_LOCKSTAT
+	{ "lockstat",	cmd_lockstat },
+#endif
+#if OPT_SYSTRACE
+	{ "systrace",	cmd_systrace },
+#endif
 
 	/* base system tests */
 	{ "at",		arraytest },
@@ -667,6 +751,8 @@ static struct {
 	{ "km2",	kmallocstress },
 	{ "km3",	kmalloctest3 },
 	{ "km4",	kmalloctest4 },
+	{ "str1",	stringtest },
+	{ "str2",	stringbench },
 #if OPT_NET
 	{ "net",	nettest },
 #endif
@@ -679,6 +765,12 @@ static struct {
 	{ "sy2",	locktest },
 	{ "sy3",	cvtest },
 	{ "sy4",	cvtest2 },
+	{ "sy5",	lockbench },
+	{ "sy6",	synchbench },
+	{ "sy7",	spinlockbench },
+	{ "tlb1",	tlbbatchtest },
+	{ "pi1",	pitest },
+	{ "pi2",	pichaintest },
 
 	/* semaphore unit tests */
 	{ "semu1",	semu1 },
@@ -704,6 +796,22 @@ static struct {
 	{ "semu21",	semu21 },
 	{ "semu22",	semu22 },
 
+	/* rwlock unit tests */
+	{ "rwu1",	rwu1 },
+	{ "rwu2",	rwu2 },
+	{ "rwu3",	rwu3 },
+	{ "rwu4",	rwu4 },
+	{ "rwu5",	rwu5 },
+	{ "rwu6",	rwu6 },
+	{ "rwu7",	rwu7 },
+	{ "rwu8",	rwu8 },
+	{ "rwu9",	rwu9 },
+	{ "rwu10",	rwu10 },
+	{ "rwu11",	rwu11 },
+
+	/* callout test */
+	{ "co1",	callouttest },
+
 	/* system call assignment tests */
 	/* For testing the wait implementation. */
 	{ "wt",		waittest },
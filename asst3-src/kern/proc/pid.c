@@ -36,8 +36,7 @@
 #include <kern/wait.h>
 #include <limits.h>
 #include <lib.h>
-#include <array.h>
-#include <clock.h>
+#include <spinlock.h>
 #include <thread.h>
 #include <proc.h>
 #include <current.h>
@@ -45,33 +44,67 @@
 #include <pid.h>
 
 /*
- * Structure for holding exit data of a thread.
+ * Structure for holding exit data of a process.
  *
  * If pi_ppid is INVALID_PID, the parent has gone away and will not be
  * waiting. If pi_ppid is INVALID_PID and pi_exited is true, the
- * structure can be freed.
+ * structure can be taken out of the table.
+ *
+ * Each process's pidinfo has its own lock, which covers its exit data
+ * and goes with its CV, and also covers the list of its children
+ * (threaded through their pi_sibling). Lock ordering: a parent's
+ * pi_lock before its children's.
  */
 struct pidinfo {
-	pid_t pi_pid;			// process id of this thread
-	pid_t pi_ppid;			// process id of parent thread
-	volatile bool pi_exited;	// true if thread has exited
+	pid_t pi_pid;			// process id of this process
+	pid_t pi_ppid;			// process id of parent process
+	bool pi_exited;			// true if process has exited
 	int pi_exitstatus;		// status (only valid if exited)
-	struct cv *pi_cv;		// use to wait for thread exit
+	struct usage pi_usage;		// totals (only valid if exited)
+	struct lock *pi_lock;		// lock for the above and lists
+	struct cv *pi_cv;		// use to wait for process exit
+	struct pidinfo *pi_children;	// children not yet waited for
+	struct pidinfo *pi_sibling;	// next in parent's pi_children
+
+	/* Under the hash bucket lock */
+	struct pidinfo *pi_hashnext;	// next in hash chain
+	unsigned pi_refcount;		// lookups in progress
+	bool pi_intable;		// still in the table
 };
 
 
 /*
- * Global pid and exit data.
+ * Global pid data.
+ *
+ * Which pids are in use is kept in a bitmap, so allocating one is a
+ * scan for a word that isn't all ones and then for the zero bit in
+ * it. The scan starts just past the last pid handed out and only
+ * wraps around after PID_MAX, so pids that have been freed aren't
+ * reused straight away.
+ *
+ * The pidinfos are in a hash table of PIDHASH_SIZE chains, so there
+ * can be any number of them; PROCS_MAX is only a limit on resource
+ * usage. Each chain has its own spinlock.
  *
- * The process table is an el-cheapo hash table. It's indexed by
- * (pid % PROCS_MAX), and only allows one process per slot. If a
- * new pid allocation would cause a hash collision, we just don't
- * use that pid.
+ * A pidinfo found by pi_lookup has a reference taken on it and stays
+ * valid (though it might be taken out of the table) until released
+ * with pi_release. Otherwise, one process's pidinfo is kept valid by
+ * the process itself until it exits, and by its parent until the
+ * parent has waited for or disowned it.
  */
-static struct lock *pidlock;		// lock for global exit data
-static struct pidinfo *pidinfo[PROCS_MAX]; // actual pid info
-static pid_t nextpid;			// next candidate pid
-static int nprocs;			// number of allocated pids
+#define PIDMAP_WORDS	(PID_MAX / 32 + 1)
+#define PIDHASH_SIZE	256
+
+struct pidbucket {
+	struct spinlock pb_lock;
+	struct pidinfo *pb_head;
+};
+
+static struct spinlock pidmap_lock = SPINLOCK_INITIALIZER;
+static uint32_t pidmap[PIDMAP_WORDS];	// pids in use, one bit each
+static unsigned pidmap_next;		// pid to start looking at
+static unsigned nprocs;			// number of allocated pids
+static struct pidbucket pidhash[PIDHASH_SIZE];
 
 
 
@@ -91,8 +124,15 @@ pidinfo_create(pid_t pid, pid_t ppid)
 		return NULL;
 	}
 
+	pi->pi_lock = lock_create("pidinfo");
+	if (pi->pi_lock == NULL) {
+		kfree(pi);
+		return NULL;
+	}
+
 	pi->pi_cv = cv_create("pidinfo cv");
 	if (pi->pi_cv == NULL) {
+		lock_destroy(pi->pi_lock);
 		kfree(pi);
 		return NULL;
 	}
@@ -100,7 +140,13 @@ pidinfo_create(pid_t pid, pid_t ppid)
 	pi->pi_pid = pid;
 	pi->pi_ppid = ppid;
 	pi->pi_exited = false;
+	usage_init(&pi->pi_usage);
 	pi->pi_exitstatus = 0xbeef;  /* Recognizably invalid value */
+	pi->pi_children = NULL;
+	pi->pi_sibling = NULL;
+	pi->pi_hashnext = NULL;
+	pi->pi_refcount = 0;
+	pi->pi_intable = false;
 
 	return pi;
 }
@@ -114,166 +160,317 @@ pidinfo_destroy(struct pidinfo *pi)
 {
 	KASSERT(pi->pi_exited == true);
 	KASSERT(pi->pi_ppid == INVALID_PID);
+	KASSERT(pi->pi_children == NULL);
+	KASSERT(pi->pi_refcount == 0);
+	KASSERT(pi->pi_intable == false);
 	cv_destroy(pi->pi_cv);
+	lock_destroy(pi->pi_lock);
 	kfree(pi);
 }
 
 ////////////////////////////////////////////////////////////
 
+/*
+ * Find the first zero bit in a word that isn't all ones.
+ */
+static
+unsigned
+pidmap_ffz(uint32_t word)
+{
+	unsigned bit = 0;
+
+	word = ~word;
+	KASSERT(word != 0);
+	if ((word & 0xffff) == 0) {
+		word >>= 16;
+		bit += 16;
+	}
+	if ((word & 0xff) == 0) {
+		word >>= 8;
+		bit += 8;
+	}
+	if ((word & 0xf) == 0) {
+		word >>= 4;
+		bit += 4;
+	}
+	if ((word & 0x3) == 0) {
+		word >>= 2;
+		bit += 2;
+	}
+	if ((word & 0x1) == 0) {
+		bit += 1;
+	}
+	return bit;
+}
+
+/*
+ * Take a free pid out of the bitmap.
+ */
+static
+int
+pidmap_alloc(pid_t *ret)
+{
+	unsigned i, word, bit;
+	uint32_t bits;
+
+	spinlock_acquire(&pidmap_lock);
+	if (nprocs == PROCS_MAX) {
+		spinlock_release(&pidmap_lock);
+		return EAGAIN;
+	}
+
+	/*
+	 * PROCS_MAX is less than the number of pids, so the above
+	 * test guarantees there's a free one.
+	 *
+	 * Bits in the first word below pidmap_next are masked off so
+	 * they're skipped; if everything past them is in use we come
+	 * round to that word again, unmasked, at the end.
+	 */
+	for (i=0; i<=PIDMAP_WORDS; i++) {
+		word = (pidmap_next / 32 + i) % PIDMAP_WORDS;
+		bits = pidmap[word];
+		if (i == 0) {
+			bits |= ((uint32_t)1 << (pidmap_next % 32)) - 1;
+		}
+		if (bits != 0xffffffff) {
+			break;
+		}
+	}
+	KASSERT(i <= PIDMAP_WORDS);
+
+	bit = pidmap_ffz(bits);
+	pidmap[word] |= (uint32_t)1 << bit;
+	pidmap_next = word * 32 + bit + 1;
+	if (pidmap_next > PID_MAX) {
+		pidmap_next = PID_MIN;
+	}
+	nprocs++;
+	spinlock_release(&pidmap_lock);
+
+	*ret = word * 32 + bit;
+	KASSERT(*ret >= PID_MIN && *ret <= PID_MAX);
+	return 0;
+}
+
+/*
+ * Put a pid back in the bitmap.
+ */
+static
+void
+pidmap_free(pid_t pid)
+{
+	uint32_t mask = (uint32_t)1 << (pid % 32);
+
+	spinlock_acquire(&pidmap_lock);
+	KASSERT(pidmap[pid / 32] & mask);
+	pidmap[pid / 32] &= ~mask;
+	nprocs--;
+	spinlock_release(&pidmap_lock);
+}
+
+////////////////////////////////////////////////////////////
+
 /*
  * pid_bootstrap: initialize.
  */
 void
 pid_bootstrap(void)
 {
-	int i;
+	struct pidinfo *pi;
+	unsigned i;
 
-	pidlock = lock_create("pidlock");
-	if (pidlock == NULL) {
-		panic("Out of memory creating pid lock\n");
+	for (i=0; i<PIDHASH_SIZE; i++) {
+		spinlock_init(&pidhash[i].pb_lock);
+		pidhash[i].pb_head = NULL;
 	}
 
-	/* not really necessary - should start zeroed */
-	for (i=0; i<PROCS_MAX; i++) {
-		pidinfo[i] = NULL;
+	/* Pids below PID_MIN are never handed out; nor past PID_MAX. */
+	for (i=0; i<PIDMAP_WORDS; i++) {
+		pidmap[i] = 0;
+	}
+	for (i=0; i<PID_MIN; i++) {
+		pidmap[i / 32] |= (uint32_t)1 << (i % 32);
 	}
+	for (i=PID_MAX+1; i<PIDMAP_WORDS*32; i++) {
+		pidmap[i / 32] |= (uint32_t)1 << (i % 32);
+	}
+	pidmap_next = PID_MIN;
 
-	pidinfo[KERNEL_PID] = pidinfo_create(KERNEL_PID, INVALID_PID);
-	if (pidinfo[KERNEL_PID]==NULL) {
+	pi = pidinfo_create(KERNEL_PID, INVALID_PID);
+	if (pi==NULL) {
 		panic("Out of memory creating kernel pid data\n");
 	}
-
-	nextpid = PID_MIN;
+	pi->pi_intable = true;
+	pidhash[KERNEL_PID % PIDHASH_SIZE].pb_head = pi;
 	nprocs = 1;
 }
 
 /*
- * pi_get: look up a pidinfo in the process table.
+ * pi_lookup: look up a pidinfo in the process table, and take a
+ * reference to it. Release it with pi_release.
  */
 static
 struct pidinfo *
-pi_get(pid_t pid)
+pi_lookup(pid_t pid)
 {
+	struct pidbucket *pb;
 	struct pidinfo *pi;
 
 	KASSERT(pid>=0);
 	KASSERT(pid != INVALID_PID);
-	KASSERT(lock_do_i_hold(pidlock));
 
-	pi = pidinfo[pid % PROCS_MAX];
-	if (pi==NULL) {
-		return NULL;
-	}
-	if (pi->pi_pid != pid) {
-		return NULL;
+	pb = &pidhash[pid % PIDHASH_SIZE];
+	spinlock_acquire(&pb->pb_lock);
+	for (pi = pb->pb_head; pi != NULL; pi = pi->pi_hashnext) {
+		if (pi->pi_pid == pid) {
+			pi->pi_refcount++;
+			break;
+		}
 	}
+	spinlock_release(&pb->pb_lock);
 	return pi;
 }
 
 /*
- * pi_put: insert a new pidinfo in the process table. The right slot
- * must be empty.
+ * pi_release: drop a reference from pi_lookup. If the pidinfo has
+ * been taken out of the table meanwhile, the last one frees it.
  */
 static
 void
-pi_put(pid_t pid, struct pidinfo *pi)
+pi_release(struct pidinfo *pi)
 {
-	KASSERT(lock_do_i_hold(pidlock));
+	struct pidbucket *pb;
+	bool dead;
+
+	pb = &pidhash[pi->pi_pid % PIDHASH_SIZE];
+	spinlock_acquire(&pb->pb_lock);
+	KASSERT(pi->pi_refcount > 0);
+	pi->pi_refcount--;
+	dead = pi->pi_refcount == 0 && !pi->pi_intable;
+	spinlock_release(&pb->pb_lock);
+
+	if (dead) {
+		pidinfo_destroy(pi);
+	}
+}
 
-	KASSERT(pid != INVALID_PID);
+/*
+ * pi_put: insert a new pidinfo in the process table.
+ */
+static
+void
+pi_put(struct pidinfo *pi)
+{
+	struct pidbucket *pb;
 
-	KASSERT(pidinfo[pid % PROCS_MAX] == NULL);
-	pidinfo[pid % PROCS_MAX] = pi;
-	nprocs++;
+	KASSERT(pi->pi_pid != INVALID_PID);
+	KASSERT(!pi->pi_intable);
+
+	pb = &pidhash[pi->pi_pid % PIDHASH_SIZE];
+	spinlock_acquire(&pb->pb_lock);
+	pi->pi_hashnext = pb->pb_head;
+	pb->pb_head = pi;
+	pi->pi_intable = true;
+	spinlock_release(&pb->pb_lock);
 }
 
 /*
- * pi_drop: remove a pidinfo structure from the process table and free
- * it. It should reflect a process that has already exited and been
- * waited for.
+ * pi_drop: remove a pidinfo structure from the process table, free
+ * its pid, and free it unless someone's still looking at it. It
+ * should reflect a process that has already exited and been waited
+ * for (or that nobody will wait for). It must not be on any parent's
+ * list of children.
  */
 static
 void
-pi_drop(pid_t pid)
+pi_drop(struct pidinfo *pi)
 {
-	struct pidinfo *pi;
-
-	KASSERT(lock_do_i_hold(pidlock));
+	struct pidbucket *pb;
+	struct pidinfo **pp;
+	pid_t pid;
+	bool dead;
 
-	pi = pidinfo[pid % PROCS_MAX];
-	KASSERT(pi != NULL);
-	KASSERT(pi->pi_pid == pid);
+	KASSERT(pi->pi_exited);
+	KASSERT(pi->pi_ppid == INVALID_PID);
 
-	pidinfo_destroy(pi);
-	pidinfo[pid % PROCS_MAX] = NULL;
-	nprocs--;
+	pid = pi->pi_pid;
+	pb = &pidhash[pid % PIDHASH_SIZE];
+	spinlock_acquire(&pb->pb_lock);
+	KASSERT(pi->pi_intable);
+	for (pp = &pb->pb_head; *pp != pi; pp = &(*pp)->pi_hashnext) {
+		KASSERT(*pp != NULL);
+	}
+	*pp = pi->pi_hashnext;
+	pi->pi_hashnext = NULL;
+	pi->pi_intable = false;
+	dead = pi->pi_refcount == 0;
+	spinlock_release(&pb->pb_lock);
+
+	pidmap_free(pid);
+	if (dead) {
+		pidinfo_destroy(pi);
+	}
 }
 
-////////////////////////////////////////////////////////////
-
 /*
- * Helper function for pid_alloc.
+ * Take child KID off the list of PARENT's children. Both must be
+ * locked.
  */
 static
 void
-inc_nextpid(void)
+pi_unlinkchild(struct pidinfo *parent, struct pidinfo *kid)
 {
-	KASSERT(lock_do_i_hold(pidlock));
+	struct pidinfo **pp;
 
-	nextpid++;
-	if (nextpid > PID_MAX) {
-		nextpid = PID_MIN;
+	KASSERT(lock_do_i_hold(parent->pi_lock));
+	KASSERT(lock_do_i_hold(kid->pi_lock));
+	KASSERT(kid->pi_ppid == parent->pi_pid);
+
+	for (pp = &parent->pi_children; *pp != kid; pp = &(*pp)->pi_sibling) {
+		KASSERT(*pp != NULL);
 	}
+	*pp = kid->pi_sibling;
+	kid->pi_sibling = NULL;
 }
 
+////////////////////////////////////////////////////////////
+
 /*
- * pid_alloc: allocate a process id.
+ * pid_alloc: allocate a process id, for a child of the current
+ * process.
  */
 int
 pid_alloc(pid_t *retval)
 {
-	struct pidinfo *pi;
+	struct pidinfo *us, *pi;
 	pid_t pid;
-	int count;
+	int result;
 
 	KASSERT(curproc->p_pid != INVALID_PID);
 
-	/* lock the table */
-	lock_acquire(pidlock);
-
-	if (nprocs == PROCS_MAX) {
-		lock_release(pidlock);
-		return EAGAIN;
-	}
-
-	/*
-	 * The above test guarantees that this loop terminates, unless
-	 * our nprocs count is off. Even so, assert we aren't looping
-	 * forever.
-	 */
-	count = 0;
-	while (pidinfo[nextpid % PROCS_MAX] != NULL) {
-
-		/* avoid various boundary cases by allowing extra loops */
-		KASSERT(count < PROCS_MAX*2+5);
-		count++;
-
-		inc_nextpid();
+	result = pidmap_alloc(&pid);
+	if (result) {
+		return result;
 	}
 
-	pid = nextpid;
-
 	pi = pidinfo_create(pid, curproc->p_pid);
 	if (pi==NULL) {
-		lock_release(pidlock);
+		pidmap_free(pid);
 		return ENOMEM;
 	}
 
-	pi_put(pid, pi);
+	/* We're running, so our own pidinfo is there. */
+	us = pi_lookup(curproc->p_pid);
+	KASSERT(us != NULL);
 
-	inc_nextpid();
+	lock_acquire(us->pi_lock);
+	pi->pi_sibling = us->pi_children;
+	us->pi_children = pi;
+	lock_release(us->pi_lock);
 
-	lock_release(pidlock);
+	pi_put(pi);
+	pi_release(us);
 
 	*retval = pid;
 	return 0;
@@ -286,25 +483,30 @@ pid_alloc(pid_t *retval)
 void
 pid_unalloc(pid_t theirpid)
 {
-	struct pidinfo *them;
+	struct pidinfo *us, *them;
 
 	KASSERT(theirpid >= PID_MIN && theirpid <= PID_MAX);
 
-	lock_acquire(pidlock);
-
-	them = pi_get(theirpid);
+	us = pi_lookup(curproc->p_pid);
+	them = pi_lookup(theirpid);
+	KASSERT(us != NULL);
 	KASSERT(them != NULL);
+
+	lock_acquire(us->pi_lock);
+	lock_acquire(them->pi_lock);
 	KASSERT(them->pi_exited == false);
-	KASSERT(them->pi_ppid == curproc->p_pid);
+	pi_unlinkchild(us, them);
 
 	/* keep pidinfo_destroy from complaining */
 	them->pi_exitstatus = 0xdead;
 	them->pi_exited = true;
 	them->pi_ppid = INVALID_PID;
+	lock_release(them->pi_lock);
+	lock_release(us->pi_lock);
 
-	pi_drop(theirpid);
-
-	lock_release(pidlock);
+	pi_drop(them);
+	pi_release(them);
+	pi_release(us);
 }
 
 /*
@@ -314,71 +516,90 @@ pid_unalloc(pid_t theirpid)
 void
 pid_disown(pid_t theirpid)
 {
-	struct pidinfo *them;
+	struct pidinfo *us, *them;
+	bool exited;
 
 	KASSERT(theirpid >= PID_MIN && theirpid <= PID_MAX);
 
-	lock_acquire(pidlock);
-
-	them = pi_get(theirpid);
+	us = pi_lookup(curproc->p_pid);
+	them = pi_lookup(theirpid);
+	KASSERT(us != NULL);
 	KASSERT(them != NULL);
-	KASSERT(them->pi_ppid==curproc->p_pid);
 
+	lock_acquire(us->pi_lock);
+	lock_acquire(them->pi_lock);
+	pi_unlinkchild(us, them);
 	them->pi_ppid = INVALID_PID;
-	if (them->pi_exited) {
-		pi_drop(them->pi_pid);
-	}
+	exited = them->pi_exited;
+	lock_release(them->pi_lock);
+	lock_release(us->pi_lock);
 
-	lock_release(pidlock);
+	if (exited) {
+		pi_drop(them);
+	}
+	pi_release(them);
+	pi_release(us);
 }
 
 /*
- * pid_setexitstatus: Sets the exit status of this process. Must only
- * be called if the thread actually had a pid assigned. Wakes up any
- * waiters and disposes of the piddata if nobody else is still using it.
+ * pid_setexitstatus: Sets the exit status of process PROC, which is
+ * exiting. (The exiting thread has already left PROC by the time it
+ * gets here, so it isn't curproc.) Must only be called if the process
+ * actually had a pid assigned. Wakes up any waiters and disposes of
+ * the piddata if nobody else is still using it.
  *
  * As far as the process is concerned, this releases its pid for
- * subsequent reuse; thus we set curproc->p_pid to INVALID_PID.
+ * subsequent reuse; thus we set proc->p_pid to INVALID_PID.
  */
 void
-pid_setexitstatus(int status)
+pid_setexitstatus(struct proc *proc, int status)
 {
-	struct pidinfo *us;
-	int i;
+	struct pidinfo *us, *kid, *next;
+	bool kidexited, orphan;
 
-	lock_acquire(pidlock);
-	KASSERT(curproc->p_pid != INVALID_PID);
+	KASSERT(proc->p_pid != INVALID_PID);
+
+	us = pi_lookup(proc->p_pid);
+	KASSERT(us != NULL);
+
+	lock_acquire(us->pi_lock);
 
 	/* First, disown all children */
-	for (i=0; i<PROCS_MAX; i++) {
-		if (pidinfo[i]==NULL) {
-			continue;
-		}
-		if (pidinfo[i]->pi_ppid == curproc->p_pid) {
-			pidinfo[i]->pi_ppid = INVALID_PID;
-			if (pidinfo[i]->pi_exited) {
-				pi_drop(pidinfo[i]->pi_pid);
-			}
+	for (kid = us->pi_children; kid != NULL; kid = next) {
+		lock_acquire(kid->pi_lock);
+		next = kid->pi_sibling;
+		kid->pi_sibling = NULL;
+		kid->pi_ppid = INVALID_PID;
+		kidexited = kid->pi_exited;
+		lock_release(kid->pi_lock);
+		if (kidexited) {
+			pi_drop(kid);
 		}
 	}
+	us->pi_children = NULL;
 
-	/* Now, wake up our parent */
-	us = pi_get(curproc->p_pid);
-	KASSERT(us != NULL);
-
+	/*
+	 * Now, wake up our parent. Our usage so far goes along with
+	 * the status, plus that of the children we waited for. No
+	 * threads are left to change either.
+	 */
 	us->pi_exitstatus = status;
+	us->pi_usage = proc->p_usage;
+	usage_add(&us->pi_usage, &proc->p_childusage);
 	us->pi_exited = true;
+	orphan = us->pi_ppid == INVALID_PID;
+	if (!orphan) {
+		cv_broadcast(us->pi_cv, us->pi_lock);
+	}
+	lock_release(us->pi_lock);
 
-	if (us->pi_ppid == INVALID_PID) {
+	if (orphan) {
 		/* no parent */
-		pi_drop(curproc->p_pid);
-	}
-	else {
-		cv_broadcast(us->pi_cv, pidlock);
+		pi_drop(us);
 	}
+	pi_release(us);
 
-	curproc->p_pid = INVALID_PID;
-	lock_release(pidlock);
+	proc->p_pid = INVALID_PID;
 }
 
 /*
@@ -387,17 +608,27 @@ pid_setexitstatus(int status)
  * userland and may thus be maliciously invalid.
  *
  * status may be null, in which case the status is thrown away. ret
- * may only be null if WNOHANG is not set.
+ * may only be null if WNOHANG is not set. If usage isn't null, the
+ * child's resource usage (including its waited-for children's) is
+ * returned there; either way it's added to the current process's
+ * p_childusage.
+ *
+ * Two threads of the same process can wait for the same child; only
+ * one of them gets it, and the other fails with ESRCH as if the child
+ * had already been collected when it started.
  */
 int
-pid_wait(pid_t theirpid, int *status, int flags, pid_t *ret)
+pid_wait(pid_t theirpid, int *status, int flags, pid_t *ret,
+	 struct usage *usage)
 {
-	struct pidinfo *them;
+	struct pidinfo *us, *them;
+	pid_t mypid;
 
-	KASSERT(curproc->p_pid != INVALID_PID);
+	mypid = curproc->p_pid;
+	KASSERT(mypid != INVALID_PID);
 
 	/* Don't let a process wait for itself. */
-	if (theirpid == curproc->p_pid) {
+	if (theirpid == mypid) {
 		return EINVAL;
 	}
 
@@ -415,37 +646,69 @@ pid_wait(pid_t theirpid, int *status, int flags, pid_t *ret)
 		return EINVAL;
 	}
 
-	lock_acquire(pidlock);
-
-	them = pi_get(theirpid);
+	them = pi_lookup(theirpid);
 	if (them==NULL) {
-		lock_release(pidlock);
 		return ESRCH;
 	}
 
 	KASSERT(them->pi_pid==theirpid);
 
+	lock_acquire(them->pi_lock);
+
 	/* Only allow waiting for own children. */
-	if (them->pi_ppid != curproc->p_pid) {
-		lock_release(pidlock);
+	if (them->pi_ppid != mypid) {
+		lock_release(them->pi_lock);
+		pi_release(them);
 		return EPERM;
 	}
 
 	if (them->pi_exited == false) {
 		if (flags == WNOHANG) {
-			lock_release(pidlock);
+			lock_release(them->pi_lock);
+			pi_release(them);
 			KASSERT(ret != NULL);
 			*ret = 0;
 			return 0;
 		}
-		/* don't need to loop on this */
-		cv_wait(them->pi_cv, pidlock);
-		KASSERT(them->pi_exited == true);
+		while (them->pi_exited == false) {
+			cv_wait(them->pi_cv, them->pi_lock);
+		}
 	}
+	lock_release(them->pi_lock);
 
+	/*
+	 * Collect it. This needs our lock as well, to take it off our
+	 * list of children, and that has to come first.
+	 */
+	us = pi_lookup(mypid);
+	KASSERT(us != NULL);
+	lock_acquire(us->pi_lock);
+	lock_acquire(them->pi_lock);
+	if (them->pi_ppid != mypid) {
+		/* Another of our threads beat us to it. */
+		lock_release(them->pi_lock);
+		lock_release(us->pi_lock);
+		pi_release(us);
+		pi_release(them);
+		return ESRCH;
+	}
+	pi_unlinkchild(us, them);
+	them->pi_ppid = INVALID_PID;
 	if (status != NULL) {
 		*status = them->pi_exitstatus;
 	}
+	if (usage != NULL) {
+		*usage = them->pi_usage;
+	}
+	lock_release(them->pi_lock);
+	lock_release(us->pi_lock);
+	pi_release(us);
+
+	/* It's been waited for; its usage now counts towards ours. */
+	spinlock_acquire(&curproc->p_lock);
+	usage_add(&curproc->p_childusage, &them->pi_usage);
+	spinlock_release(&curproc->p_lock);
+
 	if (ret != NULL) {
 		/*
 		 * In Unix you can wait for any of several possible
@@ -457,9 +720,7 @@ pid_wait(pid_t theirpid, int *status, int flags, pid_t *ret)
 		*ret = theirpid;
 	}
 
-	them->pi_ppid = 0;
-	pi_drop(them->pi_pid);
-
-	lock_release(pidlock);
+	pi_drop(them);
+	pi_release(them);
 	return 0;
 }
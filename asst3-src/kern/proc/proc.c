@@ -38,20 +38,31 @@
  * things they point to. Rearrange this (and/or change it to be a
  * regular lock) as needed.
  *
- * Unless you're implementing multithreaded user processes, the only
- * process that will have more than one thread is the kernel process.
+ * User processes can have more than one thread (see the __thread_*
+ * system calls in thread_syscalls.c). Each user thread has an entry in
+ * the process's p_uthreads table, and p_nthreads counts the ones still
+ * running. When one of them calls _exit (or dies), p_exiting is set,
+ * and the others leave the next time they'd go back to user mode, or
+ * when they're woken from a sleep that checks for it; the last one
+ * out posts the exit status and destroys the process.
  */
 
 #include <types.h>
 #include <kern/errno.h>
+#include <kern/wait.h>
+#include <kern/time.h>
+#include <kern/resource.h>
 #include <spl.h>
+#include <wchan.h>
 #include <synch.h>
+#include <clock.h>
 #include <proc.h>
 #include <current.h>
 #include <addrspace.h>
 #include <vnode.h>
 #include <pid.h>
 #include <filetable.h>
+#include <syscall.h>
 
 /*
  * The process for the kernel; this holds all the kernel-only threads.
@@ -66,6 +77,7 @@ struct proc *
 proc_create(const char *name)
 {
 	struct proc *proc;
+	unsigned i;
 
 	proc = kmalloc(sizeof(*proc));
 	if (proc == NULL) {
@@ -85,16 +97,72 @@ proc_create(const char *name)
 	}
 	threadarray_init(&proc->p_threads);
 
+	proc->p_napchan = wchan_create("nap");
+	if (proc->p_napchan == NULL) {
+		lock_destroy(proc->p_threadslock);
+		kfree(proc->p_name);
+		kfree(proc);
+		return NULL;
+	}
+
+	proc->p_joinchan = wchan_create("join");
+	if (proc->p_joinchan == NULL) {
+		wchan_destroy(proc->p_napchan);
+		lock_destroy(proc->p_threadslock);
+		kfree(proc->p_name);
+		kfree(proc);
+		return NULL;
+	}
+
+	proc->p_iochan = wchan_create("ioring");
+	if (proc->p_iochan == NULL) {
+		wchan_destroy(proc->p_joinchan);
+		wchan_destroy(proc->p_napchan);
+		lock_destroy(proc->p_threadslock);
+		kfree(proc->p_name);
+		kfree(proc);
+		return NULL;
+	}
+
 	spinlock_init(&proc->p_lock);
 	proc->p_pid = INVALID_PID;
 
 	/* VM fields */
 	proc->p_addrspace = NULL;
+	proc->p_vforksem = NULL;
 
 	/* VFS fields */
 	proc->p_cwd = NULL;
 	proc->p_filetable = NULL;
 
+	/* Timer fields */
+	callout_init(&proc->p_itimer, itimer_expire, proc);
+	proc->p_itimer_armed = false;
+	proc->p_itimer_interval = 0;
+	proc->p_itimer_expirations = 0;
+
+	/* User thread fields; slot 0 is for the thread that will run. */
+	for (i=0; i<PROC_MAXTHREADS; i++) {
+		proc->p_uthreads[i].ut_tid = 0;
+		proc->p_uthreads[i].ut_exited = false;
+		proc->p_uthreads[i].ut_detached = false;
+		proc->p_uthreads[i].ut_retval = NULL;
+	}
+	proc->p_uthreads[0].ut_tid = 1;
+	proc->p_nthreads = 1;
+	proc->p_nexttid = 2;
+	proc->p_exiting = false;
+	proc->p_exitstatus = _MKWAIT_EXIT(0);
+
+	/* Usage fields */
+	usage_init(&proc->p_usage);
+	usage_init(&proc->p_childusage);
+
+	/* I/O ring fields */
+	proc->p_ioring = NULL;
+	proc->p_iomore = false;
+	proc->p_iogen = 0;
+
 	return proc;
 }
 
@@ -124,6 +192,12 @@ proc_destroy(struct proc *proc)
 	 * incorrect to destroy it.)
 	 */
 
+	/* Timer fields; the itimer can still go off until halted. */
+	spinlock_acquire(&proc->p_lock);
+	proc->p_itimer_armed = false;
+	spinlock_release(&proc->p_lock);
+	callout_halt(&proc->p_itimer);
+
 	/* VFS fields */
 	if (proc->p_cwd) {
 		VOP_DECREF(proc->p_cwd);
@@ -135,6 +209,11 @@ proc_destroy(struct proc *proc)
 	}
 
 	/* VM fields */
+	if (proc->p_vforksem != NULL) {
+		/* Borrowed; it goes back to the parent, not away. */
+		proc->p_addrspace = NULL;
+		proc_vforkdone(proc);
+	}
 	if (proc->p_addrspace) {
 		/*
 		 * If p is the current process, remove it safely from
@@ -183,6 +262,9 @@ proc_destroy(struct proc *proc)
 	}
 
 	KASSERT(proc->p_pid == INVALID_PID);
+	wchan_destroy(proc->p_iochan);
+	wchan_destroy(proc->p_joinchan);
+	wchan_destroy(proc->p_napchan);
 	spinlock_cleanup(&proc->p_lock);
 	threadarray_cleanup(&proc->p_threads);
 	lock_destroy(proc->p_threadslock);
@@ -259,15 +341,18 @@ proc_create_runprogram(const char *name, struct proc **ret)
  * is not null. (If RET is null, what we're creating is a kernel-only
  * thread and it doesn't need an address space or file handles.)
  * However, the new thread always inherits its current working
- * directory from the caller. The new thread is given no address space
- * (the caller decides that).
+ * directory from the caller. The new thread is given a copy of the
+ * caller's address space, or for vfork (VFORKSEM not null) the same
+ * one.
  */
+static
 int
-proc_fork(struct proc **ret)
+proc_dofork(struct semaphore *vforksem, struct proc **ret)
 {
 	struct proc *newproc;
 	struct addrspace *as;
 	struct filetable *tbl;
+	int slot;
 	int result;
 
 	newproc = proc_create(curproc->p_name);
@@ -281,6 +366,21 @@ proc_fork(struct proc **ret)
 		return result;
 	}
 
+	/*
+	 * The new process's thread is a copy of the calling thread,
+	 * running on the same user stack, so it keeps the same thread
+	 * table slot and thread id. The caller must set its t_uslot.
+	 */
+	slot = curthread->t_uslot;
+	if (slot >= 0) {
+		spinlock_acquire(&curproc->p_lock);
+		newproc->p_uthreads[0].ut_tid = 0;
+		newproc->p_uthreads[slot].ut_tid =
+			curproc->p_uthreads[slot].ut_tid;
+		newproc->p_nexttid = curproc->p_nexttid;
+		spinlock_release(&curproc->p_lock);
+	}
+
 #if 0 /* not yet */
 	/*
 	 * If the caller doesn't want to collect the exit status,
@@ -293,7 +393,11 @@ proc_fork(struct proc **ret)
 
 	/* VM fields */
 	as = proc_getas();
-	if (as != NULL) {
+	if (vforksem != NULL) {
+		newproc->p_addrspace = as;
+		newproc->p_vforksem = vforksem;
+	}
+	else if (as != NULL) {
 		result = as_copy(as, &newproc->p_addrspace);
 		if (result) {
 			pid_unalloc(newproc->p_pid);
@@ -308,7 +412,12 @@ proc_fork(struct proc **ret)
 	if (tbl != NULL) {
 		result = filetable_copy(tbl, &newproc->p_filetable);
 		if (result) {
-			as_destroy(newproc->p_addrspace);
+			if (vforksem != NULL) {
+				newproc->p_vforksem = NULL;
+			}
+			else if (newproc->p_addrspace != NULL) {
+				as_destroy(newproc->p_addrspace);
+			}
 			newproc->p_addrspace = NULL;
 			pid_unalloc(newproc->p_pid);
 			newproc->p_pid = INVALID_PID;
@@ -333,17 +442,97 @@ proc_fork(struct proc **ret)
 	return 0;
 }
 
+int
+proc_fork(struct proc **ret)
+{
+	return proc_dofork(NULL, ret);
+}
+
+int
+proc_vfork(struct semaphore *donesem, struct proc **ret)
+{
+	KASSERT(donesem != NULL);
+	return proc_dofork(donesem, ret);
+}
+
+/*
+ * A vforked process is finished with its parent's address space:
+ * it has exec'd or is being destroyed. Wake the parent. Only the
+ * process's own (single) thread changes p_vforksem, so no locking.
+ */
+void
+proc_vforkdone(struct proc *proc)
+{
+	struct semaphore *sem;
+
+	sem = proc->p_vforksem;
+	if (sem != NULL) {
+		proc->p_vforksem = NULL;
+		V(sem);
+	}
+}
+
 /*
- * Undo proc_fork if nothing's run in the new process yet.
+ * Undo proc_fork or proc_vfork if nothing's run in the new process
+ * yet. The parent isn't woken up.
  */
 void
 proc_unfork(struct proc *newproc)
 {
+	if (newproc->p_vforksem != NULL) {
+		newproc->p_vforksem = NULL;
+		newproc->p_addrspace = NULL;
+	}
 	pid_unalloc(newproc->p_pid);
 	newproc->p_pid = INVALID_PID;
 	proc_destroy(newproc);
 }
 
+/*
+ * Common code for the current thread leaving its process for good.
+ * If it's the last one out, it posts the exit status and destroys the
+ * process.
+ *
+ * Since the process is destroyed as soon as the count of threads goes
+ * to zero, each thread must be all the way out (not even in
+ * p_threads) before it decrements it.
+ */
+static
+__DEAD
+void
+proc_leave(void)
+{
+	struct proc *proc = curproc;
+	bool last;
+
+	/* Detach from the process and attach to the kernel process. */
+	KASSERT(curthread->t_proc == proc);
+	proc_remthread(curthread);
+	proc_addthread(kproc, curthread);
+	curthread->t_uslot = -1;
+
+	spinlock_acquire(&proc->p_lock);
+	usage_add(&proc->p_usage, &curthread->t_usage);
+	usage_init(&curthread->t_usage);
+	KASSERT(proc->p_nthreads > 0);
+	proc->p_nthreads--;
+	last = proc->p_nthreads == 0;
+	spinlock_release(&proc->p_lock);
+
+	if (last) {
+		/* There should be no threads left in the target process. */
+		KASSERT(threadarray_num(&proc->p_threads) == 0);
+
+		/* Set exit status and wake up anyone waiting for us. */
+		pid_setexitstatus(proc, proc->p_exitstatus);
+
+		/* Now we can destroy the process. */
+		proc_destroy(proc);
+	}
+
+	thread_exit();
+}
+
 /*
  * Make the current process exit.
  */
@@ -351,25 +540,137 @@ void
 proc_exit(int status)
 {
 	struct proc *proc = curproc;
+	struct addrspace *as;
+	bool others;
 
 	/* The kernel isn't supposed to exit. */
 	KASSERT(proc != kproc);
 
-	/* Set exit status and wake up anyone waiting for us. */
-	pid_setexitstatus(status);
+	/*
+	 * Mark the process exiting, and get any other threads out of
+	 * the sleeps that know to look for that.
+	 */
+	spinlock_acquire(&proc->p_lock);
+	if (!proc->p_exiting) {
+		proc->p_exiting = true;
+		proc->p_exitstatus = status;
+	}
+	others = proc->p_nthreads > 1;
+	if (others) {
+		wchan_wakeall(proc->p_joinchan, &proc->p_lock);
+		wchan_wakeall(proc->p_napchan, &proc->p_lock);
+		wchan_wakeall(proc->p_iochan, &proc->p_lock);
+	}
+	as = proc->p_addrspace;
+	spinlock_release(&proc->p_lock);
 
-	/* Detach from the process and attach to the kernel process. */
-	KASSERT(curthread->t_proc == proc);
-	proc_remthread(curthread);
-	proc_addthread(kproc, curthread);
+	/* A vforked process's address space isn't its own. */
+	if (others && as != NULL && proc->p_vforksem == NULL) {
+		futex_wakeall(as);
+	}
 
-	/* There should be no threads left in the target process. */
-	KASSERT(threadarray_num(&proc->p_threads) == 0);
+	proc_leave();
+}
 
-	/* Now we can destroy the process. */
-	proc_destroy(proc);
+/*
+ * Make the current thread the only user thread of its process, in
+ * table slot 0 (on the main user stack). It keeps its thread id.
+ */
+void
+proc_setmainthread(void)
+{
+	struct proc *proc = curproc;
+	unsigned tid, i;
 
-	thread_exit();
+	spinlock_acquire(&proc->p_lock);
+	KASSERT(proc->p_nthreads == 1);
+	tid = 1;
+	if (curthread->t_uslot >= 0) {
+		tid = proc->p_uthreads[curthread->t_uslot].ut_tid;
+	}
+	for (i=0; i<PROC_MAXTHREADS; i++) {
+		proc->p_uthreads[i].ut_tid = 0;
+		proc->p_uthreads[i].ut_exited = false;
+		proc->p_uthreads[i].ut_detached = false;
+		proc->p_uthreads[i].ut_retval = NULL;
+	}
+	proc->p_uthreads[0].ut_tid = tid;
+	spinlock_release(&proc->p_lock);
+
+	curthread->t_uslot = 0;
+}
+
+/*
+ * Exit the current user thread. If it's the last one, the process
+ * exits (with status 0, unless it was already exiting).
+ */
+void
+proc_uthread_exit(userptr_t val)
+{
+	struct proc *proc = curproc;
+	struct uthread *ut;
+
+	KASSERT(curthread->t_uslot >= 0);
+
+	spinlock_acquire(&proc->p_lock);
+	ut = &proc->p_uthreads[curthread->t_uslot];
+	if (ut->ut_detached) {
+		/* Nobody wants the value; free the slot now. */
+		ut->ut_tid = 0;
+		ut->ut_detached = false;
+	}
+	else {
+		ut->ut_exited = true;
+		ut->ut_retval = val;
+		wchan_wakeall(proc->p_joinchan, &proc->p_lock);
+	}
+	spinlock_release(&proc->p_lock);
+
+	proc_leave();
+}
+
+/*
+ * Start a kernel-only worker thread in the current process, running
+ * FUNC(DATA1, DATA2). It's counted along with the user threads, so
+ * the process can't finish exiting (or exec) while it's running; it
+ * must finish with proc_worker_exit. It should notice p_exiting and
+ * stop early.
+ */
+int
+proc_worker_start(const char *name,
+		  void (*func)(void *data1, unsigned long data2),
+		  void *data1, unsigned long data2)
+{
+	struct proc *proc = curproc;
+	int result;
+
+	spinlock_acquire(&proc->p_lock);
+	if (proc->p_exiting) {
+		spinlock_release(&proc->p_lock);
+		return EINTR;
+	}
+	proc->p_nthreads++;
+	spinlock_release(&proc->p_lock);
+
+	result = thread_fork(name, proc, func, data1, data2);
+	if (result) {
+		spinlock_acquire(&proc->p_lock);
+		proc->p_nthreads--;
+		spinlock_release(&proc->p_lock);
+		return result;
+	}
+	return 0;
+}
+
+/*
+ * Exit a worker thread. If it's the last thread out, the process
+ * exits with the status already posted, or 0.
+ */
+void
+proc_worker_exit(void)
+{
+	KASSERT(curthread->t_uslot < 0);
+	proc_leave();
 }
 
 /*
@@ -484,3 +785,79 @@ proc_setas(struct addrspace *newas)
 	spinlock_release(&proc->p_lock);
 	return oldas;
 }
+
+/*
+ * Resource usage.
+ */
+
+void
+usage_init(struct usage *u)
+{
+	bzero(u, sizeof(*u));
+}
+
+void
+usage_add(struct usage *total, const struct usage *u)
+{
+	total->u_utime += u->u_utime;
+	total->u_stime += u->u_stime;
+	total->u_minflt += u->u_minflt;
+	total->u_majflt += u->u_majflt;
+	total->u_inblock += u->u_inblock;
+	total->u_oublock += u->u_oublock;
+	total->u_nvcsw += u->u_nvcsw;
+	total->u_nivcsw += u->u_nivcsw;
+}
+
+static
+void
+usage_ticks2timeval(unsigned ticks, struct timeval *tv)
+{
+	tv->tv_sec = ticks / HZ;
+	tv->tv_usec = (ticks % HZ) * (1000000 / HZ);
+}
+
+void
+usage_torusage(const struct usage *u, struct rusage *ru)
+{
+	bzero(ru, sizeof(*ru));
+	usage_ticks2timeval(u->u_utime, &ru->ru_utime);
+	usage_ticks2timeval(u->u_stime, &ru->ru_stime);
+	ru->ru_minflt = u->u_minflt;
+	ru->ru_majflt = u->u_majflt;
+	ru->ru_inblock = u->u_inblock;
+	ru->ru_oublock = u->u_oublock;
+	ru->ru_nvcsw = u->u_nvcsw;
+	ru->ru_nivcsw = u->u_nivcsw;
+}
+
+/*
+ * The live threads' counts are read without stopping them; the
+ * result is a snapshot that may be a tick or a fault out of date.
+ */
+void
+proc_getusage(struct proc *proc, int who, struct usage *ret)
+{
+	struct thread *t;
+	unsigned num, i;
+
+	if (who == RUSAGE_CHILDREN) {
+		spinlock_acquire(&proc->p_lock);
+		*ret = proc->p_childusage;
+		spinlock_release(&proc->p_lock);
+		return;
+	}
+
+	KASSERT(who == RUSAGE_SELF);
+
+	lock_acquire(proc->p_threadslock);
+	spinlock_acquire(&proc->p_lock);
+	*ret = proc->p_usage;
+	spinlock_release(&proc->p_lock);
+	num = threadarray_num(&proc->p_threads);
+	for (i=0; i<num; i++) {
+		t = threadarray_get(&proc->p_threads, i);
+		usage_add(ret, &t->t_usage);
+	}
+	lock_release(proc->p_threadslock);
+}
@@ -38,6 +38,7 @@
 #include <kern/seek.h>
 #include <kern/stat.h>
 #include <lib.h>
+#include <limits.h>
 #include <uio.h>
 #include <proc.h>
 #include <current.h>
@@ -46,6 +47,7 @@
 #include <vfs.h>
 #include <vnode.h>
 #include <openfile.h>
+#include <pipe.h>
 #include <filetable.h>
 #include <syscall.h>
 
@@ -105,20 +107,24 @@ sys_open(const_userptr_t upath, int flags, mode_t mode, int *retval)
 }
 
 /*
- * Common logic for read and write.
+ * Common logic for all the reads and writes.
  *
- * Look up the fd, then use VOP_READ or VOP_WRITE.
+ * Look up the fd, then use VOP_READ or VOP_WRITE on UIO, which has
+ * been set up with the buffer(s). Plain reads and writes go at the
+ * file's seek position and move it, holding the offset lock meanwhile.
+ * Positional ones (pread and friends) go at POS, which is already in
+ * the uio, and leave the seek position alone; they don't need the
+ * offset lock at all, so threads and processes sharing the file can
+ * do them in parallel.
  */
 static
 int
-sys_readwrite(int fd, userptr_t buf, size_t size, enum uio_rw rw,
-	      int badaccmode, ssize_t *retval)
+sys_rwuio(int fd, struct uio *useruio, bool positional, int badaccmode,
+	  ssize_t *retval)
 {
 	struct openfile *file;
 	bool locked;
-	off_t pos;
-	struct iovec iov;
-	struct uio useruio;
+	size_t size;
 	int result;
 
 	/* better be a valid file descriptor */
@@ -128,13 +134,24 @@ sys_readwrite(int fd, userptr_t buf, size_t size, enum uio_rw rw,
 	}
 
 	/* Only lock the seek position if we're really using it. */
-	locked = VOP_ISSEEKABLE(file->of_vnode);
-	if (locked) {
+	locked = false;
+	if (positional) {
+		if (!VOP_ISSEEKABLE(file->of_vnode)) {
+			result = ESPIPE;
+			goto fail;
+		}
+		if (useruio->uio_offset < 0) {
+			result = EINVAL;
+			goto fail;
+		}
+	}
+	else if (VOP_ISSEEKABLE(file->of_vnode)) {
+		locked = true;
 		lock_acquire(file->of_offsetlock);
-		pos = file->of_offset;
+		useruio->uio_offset = file->of_offset;
 	}
 	else {
-		pos = 0;
+		useruio->uio_offset = 0;
 	}
 
 	if (file->of_accmode == badaccmode) {
@@ -142,30 +159,28 @@ sys_readwrite(int fd, userptr_t buf, size_t size, enum uio_rw rw,
 		goto fail;
 	}
 
-	/* set up a uio with the buffer, its size, and the current offset */
-	uio_uinit(&iov, &useruio, buf, size, pos, rw);
-
 	/* do the read or write */
-	result = (rw == UIO_READ) ?
-		VOP_READ(file->of_vnode, &useruio) :
-		VOP_WRITE(file->of_vnode, &useruio);
+	size = useruio->uio_resid;
+	result = (useruio->uio_rw == UIO_READ) ?
+		VOP_READ(file->of_vnode, useruio) :
+		VOP_WRITE(file->of_vnode, useruio);
 	if (result) {
 		goto fail;
 	}
 
 	if (locked) {
 		/* set the offset to the updated offset in the uio */
-		file->of_offset = useruio.uio_offset;
+		file->of_offset = useruio->uio_offset;
 		lock_release(file->of_offsetlock);
 	}
 
 	filetable_put(curproc->p_filetable, fd, file);
 
 	/*
-	 * The amount read (or written) is the original buffer size,
-	 * minus how much is left in it.
+	 * The amount read (or written) is the original size, minus
+	 * how much is left.
 	 */
-	*retval = size - useruio.uio_resid;
+	*retval = size - useruio->uio_resid;
 
 	return 0;
 
@@ -177,13 +192,88 @@ fail:
 	return result;
 }
 
+/*
+ * Common logic for read/write and pread/pwrite: one buffer.
+ */
+static
+int
+sys_readwrite(int fd, userptr_t buf, size_t size, bool positional,
+	      off_t pos, enum uio_rw rw, int badaccmode, ssize_t *retval)
+{
+	struct iovec iov;
+	struct uio useruio;
+
+	/* set up a uio with the buffer, its size, and the offset */
+	uio_uinit(&iov, &useruio, buf, size, pos, rw);
+	return sys_rwuio(fd, &useruio, positional, badaccmode, retval);
+}
+
+/*
+ * Common logic for readv/writev and preadv/pwritev: copy in the
+ * iovecs and check them, then pass them all through in one uio.
+ * Small vectors are copied onto the stack; larger ones (up to
+ * IOV_MAX) into a temporary buffer.
+ */
+#define SMALL_IOVCNT	8
+
+static
+int
+sys_readwritev(int fd, const_userptr_t uiov, int iovcnt, bool positional,
+	       off_t pos, enum uio_rw rw, int badaccmode, ssize_t *retval)
+{
+	struct iovec smalliov[SMALL_IOVCNT];
+	struct iovec *iov;
+	struct uio useruio;
+	size_t size;
+	int i, result;
+
+	if (iovcnt < 0 || iovcnt > IOV_MAX) {
+		return EINVAL;
+	}
+	if (iovcnt <= SMALL_IOVCNT) {
+		iov = smalliov;
+	}
+	else {
+		iov = kmalloc(iovcnt * sizeof(*iov));
+		if (iov == NULL) {
+			return ENOMEM;
+		}
+	}
+
+	result = copyin(uiov, iov, iovcnt * sizeof(*iov));
+	if (result) {
+		goto done;
+	}
+
+	/* The total has to fit in the return value. */
+	size = 0;
+	for (i=0; i<iovcnt; i++) {
+		if (size + iov[i].iov_len < size ||
+		    (ssize_t)(size + iov[i].iov_len) < 0) {
+			result = EINVAL;
+			goto done;
+		}
+		size += iov[i].iov_len;
+	}
+
+	uio_uinitv(iov, iovcnt, &useruio, size, pos, rw);
+	result = sys_rwuio(fd, &useruio, positional, badaccmode, retval);
+
+ done:
+	if (iov != smalliov) {
+		kfree(iov);
+	}
+	return result;
+}
+
 /*
  * read() - use sys_readwrite
  */
 int
 sys_read(int fd, userptr_t buf, size_t size, int *retval)
 {
-	return sys_readwrite(fd, buf, size, UIO_READ, O_WRONLY, retval);
+	return sys_readwrite(fd, buf, size, false, 0, UIO_READ, O_WRONLY,
+			     retval);
 }
 
 /*
@@ -192,7 +282,124 @@ sys_read(int fd, userptr_t buf, size_t size, int *retval)
 int
 sys_write(int fd, userptr_t buf, size_t size, int *retval)
 {
-	return sys_readwrite(fd, buf, size, UIO_WRITE, O_RDONLY, retval);
+	return sys_readwrite(fd, buf, size, false, 0, UIO_WRITE, O_RDONLY,
+			     retval);
+}
+
+/*
+ * pread() - use sys_readwrite
+ */
+int
+sys_pread(int fd, userptr_t buf, size_t size, off_t pos, int *retval)
+{
+	return sys_readwrite(fd, buf, size, true, pos, UIO_READ, O_WRONLY,
+			     retval);
+}
+
+/*
+ * pwrite() - use sys_readwrite
+ */
+int
+sys_pwrite(int fd, userptr_t buf, size_t size, off_t pos, int *retval)
+{
+	return sys_readwrite(fd, buf, size, true, pos, UIO_WRITE, O_RDONLY,
+			     retval);
+}
+
+/*
+ * readv() - use sys_readwritev
+ */
+int
+sys_readv(int fd, const_userptr_t iov, int iovcnt, int *retval)
+{
+	return sys_readwritev(fd, iov, iovcnt, false, 0, UIO_READ, O_WRONLY,
+			      retval);
+}
+
+/*
+ * writev() - use sys_readwritev
+ */
+int
+sys_writev(int fd, const_userptr_t iov, int iovcnt, int *retval)
+{
+	return sys_readwritev(fd, iov, iovcnt, false, 0, UIO_WRITE, O_RDONLY,
+			      retval);
+}
+
+/*
+ * preadv() - use sys_readwritev
+ */
+int
+sys_preadv(int fd, const_userptr_t iov, int iovcnt, off_t pos, int *retval)
+{
+	return sys_readwritev(fd, iov, iovcnt, true, pos, UIO_READ, O_WRONLY,
+			      retval);
+}
+
+/*
+ * pwritev() - use sys_readwritev
+ */
+int
+sys_pwritev(int fd, const_userptr_t iov, int iovcnt, off_t pos, int *retval)
+{
+	return sys_readwritev(fd, iov, iovcnt, true, pos, UIO_WRITE, O_RDONLY,
+			      retval);
+}
+
+/*
+ * pipe() - make a pipe, wrap openfiles around its two ends, and put
+ * them in the file table.
+ */
+int
+sys_pipe(userptr_t fdsptr)
+{
+	struct vnode *rvn, *wvn;
+	struct openfile *rfile, *wfile, *junk;
+	int fds[2];
+	int result;
+
+	result = pipe_create(&rvn, &wvn);
+	if (result) {
+		return result;
+	}
+
+	result = openfile_fromvnode(rvn, O_RDONLY, &rfile);
+	if (result) {
+		vfs_close(rvn);
+		vfs_close(wvn);
+		return result;
+	}
+	result = openfile_fromvnode(wvn, O_WRONLY, &wfile);
+	if (result) {
+		openfile_decref(rfile);
+		vfs_close(wvn);
+		return result;
+	}
+
+	result = filetable_place(curproc->p_filetable, rfile, &fds[0]);
+	if (result) {
+		openfile_decref(rfile);
+		openfile_decref(wfile);
+		return result;
+	}
+	result = filetable_place(curproc->p_filetable, wfile, &fds[1]);
+	if (result) {
+		filetable_placeat(curproc->p_filetable, NULL, fds[0], &junk);
+		openfile_decref(rfile);
+		openfile_decref(wfile);
+		return result;
+	}
+
+	result = copyout(fds, fdsptr, sizeof(fds));
+	if (result) {
+		filetable_placeat(curproc->p_filetable, NULL, fds[1], &junk);
+		filetable_placeat(curproc->p_filetable, NULL, fds[0], &junk);
+		openfile_decref(rfile);
+		openfile_decref(wfile);
+		return result;
+	}
+
+	return 0;
 }
 
 /*
@@ -321,7 +528,11 @@ sys_dup2(int oldfd, int newfd, int *retval)
 	filetable_put(ft, oldfd, oldfdfile);
 
 	/* place it */
-	filetable_placeat(ft, oldfdfile, newfd, &newfdfile);
+	result = filetable_placeat(ft, oldfdfile, newfd, &newfdfile);
+	if (result) {
+		openfile_decref(oldfdfile);
+		return result;
+	}
 
 	/* if there was a file already there, drop that reference */
 	if (newfdfile != NULL) {
@@ -34,52 +34,148 @@
 #include <types.h>
 #include <kern/errno.h>
 #include <lib.h>
+#include <membar.h>
+#include <synch.h>
 #include <openfile.h>
 #include <filetable.h>
 
 
 /*
- * Construct a filetable.
+ * Allocate an array of SIZE empty slots. The slots live in the same
+ * block as the header.
  */
+static
+struct fdarray *
+fdarray_create(unsigned size)
+{
+	struct fdarray *fa;
+	unsigned i;
+
+	fa = kmalloc(sizeof(*fa) + size * sizeof(struct openfile *));
+	if (fa == NULL) {
+		return NULL;
+	}
+	fa->fa_size = size;
+	fa->fa_retired = NULL;
+	fa->fa_files = (struct openfile **)(fa + 1);
+	for (i = 0; i < size; i++) {
+		fa->fa_files[i] = NULL;
+	}
+	return fa;
+}
+
+/*
+ * Construct a filetable with room for SIZE files.
+ */
+static
 struct filetable *
-filetable_create(void)
+filetable_create_sized(unsigned size)
 {
 	struct filetable *ft;
-	int fd;
 
 	ft = kmalloc(sizeof(struct filetable));
 	if (ft == NULL) {
 		return NULL;
 	}
 
+	ft->ft_lock = lock_create("filetable");
+	if (ft->ft_lock == NULL) {
+		kfree(ft);
+		return NULL;
+	}
+
 	/* the table starts empty */
-	for (fd = 0; fd < OPEN_MAX; fd++) {
-		ft->ft_openfiles[fd] = NULL;
+	ft->ft_files = fdarray_create(size);
+	if (ft->ft_files == NULL) {
+		lock_destroy(ft->ft_lock);
+		kfree(ft);
+		return NULL;
 	}
+	ft->ft_nfiles = 0;
+	ft->ft_freehint = 0;
 
 	return ft;
 }
 
+/*
+ * Construct a filetable.
+ */
+struct filetable *
+filetable_create(void)
+{
+	return filetable_create_sized(FT_MINSIZE);
+}
+
 /*
  * Destroy a filetable.
  */
 void
 filetable_destroy(struct filetable *ft)
 {
-	int fd;
+	struct fdarray *fa, *next;
+	unsigned fd;
 
 	KASSERT(ft != NULL);
 
 	/* Close any open files. */
-	for (fd = 0; fd < OPEN_MAX; fd++) {
-		if (ft->ft_openfiles[fd] != NULL) {
-			openfile_decref(ft->ft_openfiles[fd]);
-			ft->ft_openfiles[fd] = NULL;
+	fa = ft->ft_files;
+	for (fd = 0; fd < fa->fa_size; fd++) {
+		if (fa->fa_files[fd] != NULL) {
+			openfile_decref(fa->fa_files[fd]);
+			fa->fa_files[fd] = NULL;
 		}
 	}
+
+	/* Nobody can be looking at the table now; free every array. */
+	for (; fa != NULL; fa = next) {
+		next = fa->fa_retired;
+		kfree(fa);
+	}
+	lock_destroy(ft->ft_lock);
 	kfree(ft);
 }
 
+/*
+ * Grow the table so it has a slot FD. Doubles until it fits. The old
+ * array can't be freed, since a reader might be in the middle of
+ * looking at it; it's kept until the table is destroyed.
+ *
+ * Call with ft_lock held.
+ */
+static
+int
+filetable_grow(struct filetable *ft, unsigned fd)
+{
+	struct fdarray *old, *new;
+	unsigned size, i;
+
+	KASSERT(lock_do_i_hold(ft->ft_lock));
+	KASSERT(fd < OPEN_MAX);
+
+	old = ft->ft_files;
+	size = old->fa_size;
+	while (size <= fd) {
+		size *= 2;
+	}
+	if (size > OPEN_MAX) {
+		size = OPEN_MAX;
+	}
+
+	new = fdarray_create(size);
+	if (new == NULL) {
+		return ENOMEM;
+	}
+	for (i = 0; i < old->fa_size; i++) {
+		new->fa_files[i] = old->fa_files[i];
+	}
+	new->fa_retired = old;
+
+	/* fill it in completely before readers can find it */
+	membar_store_store();
+	ft->ft_files = new;
+	return 0;
+}
+
 /*
  * Clone a filetable, for use in fork.
  *
@@ -94,13 +190,18 @@ filetable_destroy(struct filetable *ft)
  *
  * produce the intended output instead of having the second echo
  * command overwrite the first.
+ *
+ * The new table is only as big as it needs to be to hold the highest
+ * open descriptor, and we stop looking once we've seen all the open
+ * files, so the cost goes by what's open rather than by OPEN_MAX.
  */
 int
 filetable_copy(struct filetable *src, struct filetable **dest_ret)
 {
 	struct filetable *dest;
+	struct fdarray *srcfa, *destfa;
 	struct openfile *file;
-	int fd;
+	unsigned fd, top, seen, size;
 
 	/* Copying the nonexistent table avoids special cases elsewhere */
 	if (src == NULL) {
@@ -108,31 +209,59 @@ filetable_copy(struct filetable *src, struct filetable **dest_ret)
 		return 0;
 	}
 
-	dest = filetable_create();
+	/* Hold the lock so other threads can't change it under us */
+	lock_acquire(src->ft_lock);
+	srcfa = src->ft_files;
+
+	/* find the end of the populated part */
+	top = 0;
+	seen = 0;
+	for (fd = 0; seen < src->ft_nfiles; fd++) {
+		KASSERT(fd < srcfa->fa_size);
+		if (srcfa->fa_files[fd] != NULL) {
+			seen++;
+			top = fd + 1;
+		}
+	}
+
+	size = FT_MINSIZE;
+	while (size < top) {
+		size *= 2;
+	}
+	if (size > OPEN_MAX) {
+		size = OPEN_MAX;
+	}
+
+	dest = filetable_create_sized(size);
 	if (dest == NULL) {
+		lock_release(src->ft_lock);
 		return ENOMEM;
 	}
+	destfa = dest->ft_files;
 
 	/* share the entries */
-	for (fd = 0; fd < OPEN_MAX; fd++) {
-		file = src->ft_openfiles[fd];
+	for (fd = 0; fd < top; fd++) {
+		file = srcfa->fa_files[fd];
 		if (file != NULL) {
 			openfile_incref(file);
+			destfa->fa_files[fd] = file;
 		}
-		dest->ft_openfiles[fd] = file;
 	}
+	dest->ft_nfiles = src->ft_nfiles;
+	dest->ft_freehint = src->ft_freehint;
+	lock_release(src->ft_lock);
 
 	*dest_ret = dest;
 	return 0;
 }
 
 /*
- * Check if a file handle is in range.
+ * Check if a file handle is in range. This is the range the table
+ * can grow to, not how big it is right now.
  */
 bool
 filetable_okfd(struct filetable *ft, int fd)
 {
-	/* We have a fixed-size table so we don't need to check the size */
 	(void)ft;
 
 	return (fd >= 0 && fd < OPEN_MAX);
@@ -145,46 +274,71 @@ filetable_okfd(struct filetable *ft, int fd)
  * This checks that the file handle is in range and fails rather than
  * returning a null openfile; it only yields files that are actually
  * open.
+ *
+ * This doesn't take ft_lock. We read the slot, take a reference to
+ * what we found, and then check that the slot (in the current array)
+ * still holds it. If another thread closed or replaced it, or grew
+ * the table, in between, we drop the reference and look again. The
+ * openfile we found may have been closed and even reused by then,
+ * but its memory is still an openfile (see openfile.c), so trying to
+ * take the reference is safe.
  */
 int
 filetable_get(struct filetable *ft, int fd, struct openfile **ret)
 {
+	struct fdarray *fa;
 	struct openfile *file;
 
 	if (!filetable_okfd(ft, fd)) {
 		return EBADF;
 	}
 
-	file = ft->ft_openfiles[fd];
-	if (file == NULL) {
-		return EBADF;
-	}
+	while (1) {
+		fa = ft->ft_files;
+		membar_load_load();
+		if ((unsigned)fd < fa->fa_size) {
+			file = fa->fa_files[fd];
+		}
+		else {
+			file = NULL;
+		}
 
-	*ret = file;
-	return 0;
+		if (file == NULL) {
+			/* not open, unless the table grew meanwhile */
+			membar_load_load();
+			if (ft->ft_files == fa) {
+				return EBADF;
+			}
+			continue;
+		}
+
+		if (openfile_tryincref(file)) {
+			membar_load_load();
+			if (ft->ft_files == fa && fa->fa_files[fd] == file) {
+				*ret = file;
+				return 0;
+			}
+			openfile_decref(file);
+		}
+		/* lost a race with another thread; try again */
+	}
 }
 
 /*
- * Put a file handle back when done with it. This does not actually do
- * anything (other than crosscheck) but it's always good practice to
- * build things so when you take them out you put them back again
- * rather than dropping them on the floor. Then if you need to do
- * something at cleanup time you can put it in this function instead
- * of having to hunt for all the places to insert the new logic.
+ * Put a file handle back when done with it. This drops the reference
+ * filetable_get took; if another thread closed the descriptor in the
+ * meantime, this is where the file actually gets closed.
  *
- * (For example, if you have multithreaded processes you will need to
- * insert additional lock and/or refcount manipulations here and in
- * filetable_get.)
- *
- * The openfile should be the one returned from filetable_get. If you
- * want to manipulate the table so the assertion's no longer true, get
- * your own reference to the openfile (with openfile_incref) and call
- * filetable_put before mucking about.
+ * The openfile should be the one returned from filetable_get. It may
+ * no longer be the one in the table, so don't check that.
  */
 void
 filetable_put(struct filetable *ft, int fd, struct openfile *file)
 {
-	KASSERT(ft->ft_openfiles[fd] == file);
+	(void)ft;
+	(void)fd;
+
+	openfile_decref(file);
 }
 
 /*
@@ -194,23 +348,50 @@ filetable_put(struct filetable *ft, int fd, struct openfile *file)
  * the behavior had to be defined explicitly in order to allow
  * manipulating stdin/stdout/stderr.)
  *
+ * ft_freehint lets us skip the part of the table we know is full;
+ * if there's no free slot, grow the table.
+ *
  * Consumes a reference to the openfile object. (That reference is
  * placed in the table.)
  */
 int
 filetable_place(struct filetable *ft, struct openfile *file, int *fd_ret)
 {
-	int fd;
+	struct fdarray *fa;
+	unsigned fd;
+	int result;
 
-	for (fd = 0; fd < OPEN_MAX; fd++) {
-		if (ft->ft_openfiles[fd] == NULL) {
-			ft->ft_openfiles[fd] = file;
-			*fd_ret = fd;
-			return 0;
+	lock_acquire(ft->ft_lock);
+	fa = ft->ft_files;
+
+	for (fd = ft->ft_freehint; fd < fa->fa_size; fd++) {
+		if (fa->fa_files[fd] == NULL) {
+			break;
+		}
+	}
+	if (fd == fa->fa_size) {
+		if (fd >= OPEN_MAX) {
+			ft->ft_freehint = fd;
+			lock_release(ft->ft_lock);
+			return EMFILE;
 		}
+		result = filetable_grow(ft, fd);
+		if (result) {
+			lock_release(ft->ft_lock);
+			return result;
+		}
+		fa = ft->ft_files;
 	}
 
-	return EMFILE;
+	/* make the openfile visible before the slot that points to it */
+	membar_store_store();
+	fa->fa_files[fd] = file;
+	ft->ft_nfiles++;
+	ft->ft_freehint = fd + 1;
+	lock_release(ft->ft_lock);
+
+	*fd_ret = fd;
+	return 0;
 }
 
 /*
@@ -221,17 +402,56 @@ filetable_place(struct filetable *ft, struct openfile *file, int *fd_ret)
  * reference to the old openfile object (if not NULL); this should
  * generally be decref'd.
  *
- * Doesn't fail.
+ * Fails only if the table needs to grow and there's no memory;
+ * then nothing is consumed or returned.
  *
  * Note that you can use this to place NULL in the filetable, which is
- * potentially handy.
+ * potentially handy. That never needs to grow the table, so it never
+ * fails.
  */
-void
+int
 filetable_placeat(struct filetable *ft, struct openfile *newfile, int fd,
 		  struct openfile **oldfile_ret)
 {
+	struct fdarray *fa;
+	struct openfile *oldfile;
+	int result;
+
 	KASSERT(filetable_okfd(ft, fd));
 
-	*oldfile_ret = ft->ft_openfiles[fd];
-	ft->ft_openfiles[fd] = newfile;
+	lock_acquire(ft->ft_lock);
+	fa = ft->ft_files;
+
+	if ((unsigned)fd >= fa->fa_size) {
+		if (newfile == NULL) {
+			/* past the end, so it's already empty */
+			lock_release(ft->ft_lock);
+			*oldfile_ret = NULL;
+			return 0;
+		}
+		result = filetable_grow(ft, fd);
+		if (result) {
+			lock_release(ft->ft_lock);
+			return result;
+		}
+		fa = ft->ft_files;
+	}
+
+	oldfile = fa->fa_files[fd];
+	membar_store_store();
+	fa->fa_files[fd] = newfile;
+
+	if (oldfile != NULL) {
+		ft->ft_nfiles--;
+	}
+	if (newfile != NULL) {
+		ft->ft_nfiles++;
+	}
+	else if ((unsigned)fd < ft->ft_freehint) {
+		ft->ft_freehint = fd;
+	}
+	lock_release(ft->ft_lock);
+
+	*oldfile_ret = oldfile;
+	return 0;
 }
@@ -0,0 +1,364 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Futexes: sleeping and waking on user addresses.
+ *
+ * This lets user-level mutexes and semaphores do everything in user
+ * space with atomic operations when there's no contention, and only
+ * come into the kernel to sleep and wake up.
+ *
+ * There's no per-address object in the kernel. A waiter is keyed by
+ * its address space and the user address, and hashed into one of a
+ * fixed set of buckets; it puts a record of itself (on its own stack)
+ * on the bucket's list and sleeps on the bucket's wait channel.
+ * FUTEX_WAKE looks for matching records in the bucket and wakes those
+ * threads in particular, so an address sharing a bucket with a busy
+ * one doesn't cause extra wakeups.
+ *
+ * To avoid losing a wakeup, a waiter goes on the list *before* it
+ * reads the user value (which might fault, so it can't be done with
+ * the bucket spinlock held). A waker that changes the value and then
+ * calls FUTEX_WAKE either runs before the read, in which case the
+ * waiter sees the new value and doesn't sleep, or finds the record
+ * and takes it off the list, in which case the waiter doesn't sleep
+ * either.
+ *
+ * When a process exits, its other threads have to notice; the exiting
+ * thread wakes all the waiters in the address space with
+ * futex_wakeall, and a waiter that goes on a list after that sees
+ * p_exiting and doesn't sleep.
+ */
+
+#include <types.h>
+#include <kern/errno.h>
+#include <kern/futex.h>
+#include <lib.h>
+#include <spinlock.h>
+#include <wchan.h>
+#include <thread.h>
+#include <current.h>
+#include <clock.h>
+#include <callout.h>
+#include <proc.h>
+#include <copyinout.h>
+#include <syscall.h>
+
+/* Number of buckets; must be a power of 2. */
+#define FUTEX_NBUCKETS	64
+
+struct futex_bucket {
+	struct spinlock fb_lock;
+	struct wchan *fb_wchan;
+	struct futex_waiter *fb_waiters;	/* Oldest first */
+};
+
+struct futex_waiter {
+	struct futex_waiter *fw_next;		/* Next in bucket */
+	struct futex_bucket *fw_bucket;		/* Bucket we're in */
+	struct addrspace *fw_as;		/* Key: address space */
+	vaddr_t fw_addr;			/* Key: user address */
+	struct thread *fw_thread;		/* Thread waiting */
+	struct callout fw_timeout;		/* For FUTEX_WAIT timeouts */
+	bool fw_queued;				/* Still on the list */
+	bool fw_timedout;			/* Timeout took us off it */
+};
+
+static struct futex_bucket futex_buckets[FUTEX_NBUCKETS];
+
+/*
+ * Set up the buckets.
+ */
+void
+futex_bootstrap(void)
+{
+	unsigned i;
+
+	for (i=0; i<FUTEX_NBUCKETS; i++) {
+		spinlock_init(&futex_buckets[i].fb_lock);
+		futex_buckets[i].fb_wchan = wchan_create("futex");
+		if (futex_buckets[i].fb_wchan == NULL) {
+			panic("futex_bootstrap: Out of memory\n");
+		}
+		futex_buckets[i].fb_waiters = NULL;
+	}
+}
+
+static
+struct futex_bucket *
+futex_hash(struct addrspace *as, vaddr_t addr)
+{
+	uint32_t h;
+
+	h = (addr >> 2) + ((uintptr_t)as >> 4);
+	h ^= h >> 11;
+	h ^= h >> 6;
+	return &futex_buckets[h & (FUTEX_NBUCKETS - 1)];
+}
+
+/*
+ * Add a waiter at the end of its bucket. Call with the bucket locked.
+ */
+static
+void
+futex_enqueue(struct futex_waiter *fw)
+{
+	struct futex_waiter **pp;
+
+	KASSERT(spinlock_do_i_hold(&fw->fw_bucket->fb_lock));
+
+	for (pp = &fw->fw_bucket->fb_waiters; *pp != NULL;
+	     pp = &(*pp)->fw_next) {
+		/* nothing */
+	}
+	fw->fw_next = NULL;
+	*pp = fw;
+	fw->fw_queued = true;
+}
+
+/*
+ * Take a waiter out of its bucket. Call with the bucket locked.
+ */
+static
+void
+futex_dequeue(struct futex_waiter *fw)
+{
+	struct futex_waiter **pp;
+
+	KASSERT(spinlock_do_i_hold(&fw->fw_bucket->fb_lock));
+	KASSERT(fw->fw_queued);
+
+	for (pp = &fw->fw_bucket->fb_waiters; *pp != fw;
+	     pp = &(*pp)->fw_next) {
+		KASSERT(*pp != NULL);
+	}
+	*pp = fw->fw_next;
+	fw->fw_next = NULL;
+	fw->fw_queued = false;
+}
+
+/*
+ * Callout for a FUTEX_WAIT with a timeout. Runs from hardclock.
+ */
+static
+void
+futex_timeout(void *arg)
+{
+	struct futex_waiter *fw = arg;
+	struct futex_bucket *fb = fw->fw_bucket;
+
+	spinlock_acquire(&fb->fb_lock);
+	if (fw->fw_queued) {
+		futex_dequeue(fw);
+		fw->fw_timedout = true;
+		wchan_wakethread(fb->fb_wchan, &fb->fb_lock, fw->fw_thread);
+	}
+	spinlock_release(&fb->fb_lock);
+}
+
+/*
+ * FUTEX_WAIT. TICKS is the timeout, if HASTIMEOUT is set.
+ */
+static
+int
+futex_wait(struct addrspace *as, userptr_t uaddr, int val,
+	   bool hastimeout, unsigned ticks)
+{
+	struct futex_waiter fw;
+	struct futex_bucket *fb;
+	int cur, result;
+
+	fb = futex_hash(as, (vaddr_t)uaddr);
+	fw.fw_bucket = fb;
+	fw.fw_as = as;
+	fw.fw_addr = (vaddr_t)uaddr;
+	fw.fw_thread = curthread;
+	fw.fw_timedout = false;
+	callout_init(&fw.fw_timeout, futex_timeout, &fw);
+
+	spinlock_acquire(&fb->fb_lock);
+	futex_enqueue(&fw);
+	spinlock_release(&fb->fb_lock);
+
+	result = copyin(uaddr, &cur, sizeof(cur));
+	if (result == 0 && cur != val) {
+		result = EAGAIN;
+	}
+	if (result == 0 && curproc->p_exiting) {
+		result = EINTR;
+	}
+	if (result == 0 && hastimeout) {
+		if (ticks == 0) {
+			result = ETIMEDOUT;
+		}
+		else {
+			callout_schedule(&fw.fw_timeout, ticks);
+		}
+	}
+
+	spinlock_acquire(&fb->fb_lock);
+	if (result == 0) {
+		while (fw.fw_queued) {
+			wchan_sleep(fb->fb_wchan, &fb->fb_lock);
+		}
+		if (fw.fw_timedout) {
+			result = ETIMEDOUT;
+		}
+	}
+	else if (fw.fw_queued) {
+		futex_dequeue(&fw);
+	}
+	else {
+		/*
+		 * A FUTEX_WAKE picked us before we could leave. It
+		 * counted us as woken, so say we were; otherwise the
+		 * wakeup is lost. The caller has to look at the value
+		 * again anyway.
+		 */
+		result = 0;
+	}
+	spinlock_release(&fb->fb_lock);
+
+	/* FW is on our stack; make sure the callout is done with it. */
+	callout_halt(&fw.fw_timeout);
+	return result;
+}
+
+/*
+ * FUTEX_WAKE: wake up to MAX waiters on the address, oldest first.
+ */
+static
+unsigned
+futex_wake(struct addrspace *as, vaddr_t addr, unsigned max)
+{
+	struct futex_bucket *fb;
+	struct futex_waiter *fw, **pp;
+	unsigned n;
+
+	fb = futex_hash(as, addr);
+	n = 0;
+
+	spinlock_acquire(&fb->fb_lock);
+	pp = &fb->fb_waiters;
+	while (*pp != NULL && n < max) {
+		fw = *pp;
+		if (fw->fw_as != as || fw->fw_addr != addr) {
+			pp = &fw->fw_next;
+			continue;
+		}
+		*pp = fw->fw_next;
+		fw->fw_next = NULL;
+		fw->fw_queued = false;
+		/* The waiter can't leave until we unlock the bucket. */
+		wchan_wakethread(fb->fb_wchan, &fb->fb_lock, fw->fw_thread);
+		n++;
+	}
+	spinlock_release(&fb->fb_lock);
+
+	return n;
+}
+
+/*
+ * Wake every waiter in address space AS.
+ */
+void
+futex_wakeall(struct addrspace *as)
+{
+	struct futex_bucket *fb;
+	struct futex_waiter *fw, **pp;
+	unsigned i;
+
+	for (i=0; i<FUTEX_NBUCKETS; i++) {
+		fb = &futex_buckets[i];
+		spinlock_acquire(&fb->fb_lock);
+		pp = &fb->fb_waiters;
+		while (*pp != NULL) {
+			fw = *pp;
+			if (fw->fw_as != as) {
+				pp = &fw->fw_next;
+				continue;
+			}
+			*pp = fw->fw_next;
+			fw->fw_next = NULL;
+			fw->fw_queued = false;
+			wchan_wakethread(fb->fb_wchan, &fb->fb_lock,
+					 fw->fw_thread);
+		}
+		spinlock_release(&fb->fb_lock);
+	}
+}
+
+/*
+ * futex system call.
+ */
+int
+sys_futex(userptr_t uaddr, int op, int val, const_userptr_t utimeout,
+	  int *retval)
+{
+	struct addrspace *as;
+	struct timespec timeout;
+	unsigned ticks;
+	int result;
+
+	if ((vaddr_t)uaddr % sizeof(int) != 0) {
+		return EINVAL;
+	}
+	as = proc_getas();
+	KASSERT(as != NULL);
+
+	switch (op) {
+	    case FUTEX_WAIT:
+		ticks = 0;
+		if (utimeout != NULL) {
+			result = copyin(utimeout, &timeout, sizeof(timeout));
+			if (result) {
+				return result;
+			}
+			if (timeout.tv_sec < 0 || timeout.tv_nsec < 0 ||
+			    timeout.tv_nsec >= 1000000000) {
+				return EINVAL;
+			}
+			ticks = timespec_to_ticks(&timeout);
+		}
+		result = futex_wait(as, uaddr, val, utimeout != NULL, ticks);
+		if (result) {
+			return result;
+		}
+		*retval = 0;
+		return 0;
+
+	    case FUTEX_WAKE:
+		if (val < 0) {
+			return EINVAL;
+		}
+		*retval = futex_wake(as, (vaddr_t)uaddr, val);
+		return 0;
+	}
+	return EINVAL;
+}
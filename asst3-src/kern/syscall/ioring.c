@@ -0,0 +1,372 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * I/O submission ring: __ioring_enter. See <kern/ioring.h>.
+ *
+ * The ring is in the process's memory, so the kernel gets at it with
+ * copyin and copyout like any other user buffer. Each operation is
+ * carried out by calling the ordinary system call function for it,
+ * so it behaves exactly as if the process had made that call (from
+ * the same thread, or from the worker, which is in the same process
+ * and address space).
+ *
+ * At most one worker per process runs at a time, serving one ring
+ * (p_ioring). Entering with IORING_ENTER_ASYNC while it's running
+ * sets p_iomore so it takes another look before quitting. Each
+ * completion the worker posts bumps p_iogen and wakes anyone waiting
+ * on p_iochan.
+ *
+ * Only one thread at a time should enter a given ring.
+ */
+
+#include <types.h>
+#include <kern/errno.h>
+#include <kern/ioring.h>
+#include <lib.h>
+#include <spinlock.h>
+#include <wchan.h>
+#include <thread.h>
+#include <proc.h>
+#include <current.h>
+#include <copyinout.h>
+#include <syscall.h>
+
+/* Where things are in the process's struct ioring. */
+#define IORING_FIELD(ring, field) \
+	((ring) + __builtin_offsetof(struct ioring, field))
+#define IORING_SQE(ring, n) \
+	(IORING_FIELD(ring, ir_sq) + \
+	 ((n) % IORING_ENTRIES) * sizeof(struct ioring_sqe))
+#define IORING_CQE(ring, n) \
+	(IORING_FIELD(ring, ir_cq) + \
+	 ((n) % IORING_ENTRIES) * sizeof(struct ioring_cqe))
+
+/*
+ * The indexes at the front of struct ioring.
+ */
+struct ioring_idx {
+	uint32_t sqhead;
+	uint32_t sqtail;
+	uint32_t cqhead;
+	uint32_t cqtail;
+};
+
+/*
+ * Read the indexes.
+ */
+static
+int
+ioring_getidx(userptr_t ring, struct ioring_idx *idx)
+{
+	return copyin(IORING_FIELD(ring, ir_sqhead), idx, sizeof(*idx));
+}
+
+/*
+ * Write back the indexes the kernel owns. The others belong to the
+ * process and it may be changing them.
+ */
+static
+int
+ioring_putidx(userptr_t ring, const struct ioring_idx *idx)
+{
+	int result;
+
+	result = copyout(&idx->sqhead, IORING_FIELD(ring, ir_sqhead),
+			 sizeof(idx->sqhead));
+	if (result) {
+		return result;
+	}
+	return copyout(&idx->cqtail, IORING_FIELD(ring, ir_cqtail),
+		       sizeof(idx->cqtail));
+}
+
+/*
+ * Carry out one submission.
+ */
+static
+void
+ioring_do(const struct ioring_sqe *sqe, struct ioring_cqe *cqe)
+{
+	int retval = 0;
+	int result;
+
+	switch (sqe->sqe_op) {
+	    case IORING_OP_NOP:
+		result = 0;
+		break;
+	    case IORING_OP_READ:
+		result = sys_read(sqe->sqe_fd, sqe->sqe_buf, sqe->sqe_len,
+				  &retval);
+		break;
+	    case IORING_OP_WRITE:
+		result = sys_write(sqe->sqe_fd, sqe->sqe_buf, sqe->sqe_len,
+				   &retval);
+		break;
+	    case IORING_OP_OPEN:
+		result = sys_open(sqe->sqe_buf, sqe->sqe_flags, sqe->sqe_mode,
+				  &retval);
+		break;
+	    case IORING_OP_CLOSE:
+		result = sys_close(sqe->sqe_fd);
+		break;
+	    case IORING_OP_FSYNC:
+		result = sys_fsync(sqe->sqe_fd);
+		break;
+	    default:
+		result = EINVAL;
+		break;
+	}
+
+	cqe->cqe_data = sqe->sqe_data;
+	cqe->cqe_res = result ? -1 : retval;
+	cqe->cqe_err = result;
+}
+
+/*
+ * Take submissions from RING and carry them out until there are no
+ * more, the completion queue is full, or the process is exiting.
+ * Returns the number taken in *RET, even on error.
+ *
+ * The worker (ASYNC) writes back the indexes after each one and looks
+ * for new submissions as it goes; otherwise they're written back once
+ * at the end.
+ */
+static
+int
+ioring_run(userptr_t ring, bool async, unsigned *ret)
+{
+	struct proc *proc = curproc;
+	struct ioring_idx idx;
+	struct ioring_sqe sqe;
+	struct ioring_cqe cqe;
+	unsigned n = 0;
+	int result, result2;
+
+	*ret = 0;
+	result = ioring_getidx(ring, &idx);
+	if (result) {
+		return result;
+	}
+
+	while (idx.sqhead != idx.sqtail &&
+	       idx.cqtail - idx.cqhead < IORING_ENTRIES &&
+	       !proc->p_exiting) {
+		result = copyin(IORING_SQE(ring, idx.sqhead), &sqe,
+				sizeof(sqe));
+		if (result) {
+			break;
+		}
+		ioring_do(&sqe, &cqe);
+		result = copyout(&cqe, IORING_CQE(ring, idx.cqtail),
+				 sizeof(cqe));
+		if (result) {
+			break;
+		}
+		idx.sqhead++;
+		idx.cqtail++;
+		n++;
+
+		if (async) {
+			result = ioring_putidx(ring, &idx);
+			if (result) {
+				break;
+			}
+			spinlock_acquire(&proc->p_lock);
+			proc->p_iogen++;
+			wchan_wakeall(proc->p_iochan, &proc->p_lock);
+			spinlock_release(&proc->p_lock);
+
+			/* Pick up new submissions and reaped completions. */
+			result = ioring_getidx(ring, &idx);
+			if (result) {
+				break;
+			}
+		}
+	}
+
+	if (!async && n > 0) {
+		result2 = ioring_putidx(ring, &idx);
+		if (result == 0) {
+			result = result2;
+		}
+	}
+	*ret = n;
+	return result;
+}
+
+/*
+ * The worker thread: run the ring until it's dry and nothing more
+ * has been submitted.
+ */
+static
+void
+ioring_worker(void *data1, unsigned long data2)
+{
+	struct proc *proc = curproc;
+	userptr_t ring = data1;
+	unsigned n;
+	int result;
+
+	(void)data2;
+
+	while (1) {
+		result = ioring_run(ring, true, &n);
+
+		spinlock_acquire(&proc->p_lock);
+		if (result == 0 && proc->p_iomore && !proc->p_exiting) {
+			proc->p_iomore = false;
+			spinlock_release(&proc->p_lock);
+			continue;
+		}
+		proc->p_ioring = NULL;
+		proc->p_iomore = false;
+		proc->p_iogen++;
+		wchan_wakeall(proc->p_iochan, &proc->p_lock);
+		spinlock_release(&proc->p_lock);
+		break;
+	}
+
+	proc_worker_exit();
+}
+
+/*
+ * Wait until at least WANT completions are waiting to be reaped, or
+ * there's no worker that could post more.
+ */
+static
+int
+ioring_wait(userptr_t ring, unsigned want)
+{
+	struct proc *proc = curproc;
+	struct ioring_idx idx;
+	unsigned gen;
+	int result;
+
+	while (1) {
+		/* Note the generation first so no wakeup gets lost. */
+		spinlock_acquire(&proc->p_lock);
+		gen = proc->p_iogen;
+		spinlock_release(&proc->p_lock);
+
+		result = ioring_getidx(ring, &idx);
+		if (result) {
+			return result;
+		}
+		if (idx.cqtail - idx.cqhead >= want) {
+			return 0;
+		}
+
+		spinlock_acquire(&proc->p_lock);
+		if (proc->p_exiting) {
+			spinlock_release(&proc->p_lock);
+			return EINTR;
+		}
+		if (proc->p_ioring != ring) {
+			/* Nothing more is coming. */
+			spinlock_release(&proc->p_lock);
+			return 0;
+		}
+		if (proc->p_iogen == gen) {
+			wchan_sleep(proc->p_iochan, &proc->p_lock);
+		}
+		spinlock_release(&proc->p_lock);
+	}
+}
+
+/*
+ * __ioring_enter: process the submissions in RING, either now or on
+ * the worker, and optionally wait for WANT completions. Returns the
+ * number of submissions taken (always 0 for ASYNC).
+ */
+int
+sys___ioring_enter(userptr_t ring, unsigned want, int flags, int *retval)
+{
+	struct proc *proc = curproc;
+	bool start, busy;
+	unsigned n = 0;
+	int result;
+
+	if ((flags & ~(IORING_ENTER_ASYNC|IORING_ENTER_GETEVENTS)) != 0 ||
+	    want > IORING_ENTRIES || ring == NULL) {
+		return EINVAL;
+	}
+
+	if (flags & IORING_ENTER_ASYNC) {
+		spinlock_acquire(&proc->p_lock);
+		if (proc->p_ioring == ring) {
+			proc->p_iomore = true;
+			start = false;
+		}
+		else if (proc->p_ioring != NULL) {
+			spinlock_release(&proc->p_lock);
+			return EBUSY;
+		}
+		else {
+			proc->p_ioring = ring;
+			proc->p_iomore = false;
+			start = true;
+		}
+		spinlock_release(&proc->p_lock);
+
+		if (start) {
+			result = proc_worker_start("ioring", ioring_worker,
+						   ring, 0);
+			if (result) {
+				spinlock_acquire(&proc->p_lock);
+				proc->p_ioring = NULL;
+				spinlock_release(&proc->p_lock);
+				return result;
+			}
+		}
+	}
+	else {
+		spinlock_acquire(&proc->p_lock);
+		busy = proc->p_ioring == ring;
+		spinlock_release(&proc->p_lock);
+		if (busy) {
+			/* The worker has it. */
+			return EBUSY;
+		}
+		result = ioring_run(ring, false, &n);
+		if (result) {
+			return result;
+		}
+	}
+
+	if (flags & IORING_ENTER_GETEVENTS) {
+		result = ioring_wait(ring, want);
+		if (result) {
+			return result;
+		}
+	}
+
+	*retval = n;
+	return 0;
+}
@@ -39,6 +39,14 @@
 #include <vfs.h>
 #include <openfile.h>
 
+/*
+ * Dead openfiles, kept for reuse. They are never freed, so a lockless
+ * reader that loses a race with close still points at an openfile
+ * (see filetable_get), and their offset locks are kept for next time.
+ */
+static struct spinlock openfile_cachelock = SPINLOCK_INITIALIZER;
+static struct openfile *openfile_cache;
+
 /*
  * Constructor for struct openfile.
  */
@@ -53,30 +61,51 @@ openfile_create(struct vnode *vn, int accmode)
 		accmode == O_WRONLY ||
 		accmode == O_RDWR);
 
-	file = kmalloc(sizeof(struct openfile));
-	if (file == NULL) {
-		return NULL;
+	spinlock_acquire(&openfile_cachelock);
+	file = openfile_cache;
+	if (file != NULL) {
+		openfile_cache = file->of_cachenext;
 	}
+	spinlock_release(&openfile_cachelock);
 
-	file->of_offsetlock = lock_create("openfile");
-	if (file->of_offsetlock == NULL) {
-		kfree(file);
-		return NULL;
+	if (file == NULL) {
+		file = kmalloc(sizeof(struct openfile));
+		if (file == NULL) {
+			return NULL;
+		}
+
+		file->of_offsetlock = lock_create("openfile");
+		if (file->of_offsetlock == NULL) {
+			kfree(file);
+			return NULL;
+		}
+
+		spinlock_init(&file->of_reflock);
+		file->of_refcount = 0;
 	}
 
-	spinlock_init(&file->of_reflock);
-
 	file->of_vnode = vn;
 	file->of_accmode = accmode;
 	file->of_offset = 0;
+	file->of_cachenext = NULL;
+
+	/*
+	 * A reused openfile may be seen by a lockless reader at any
+	 * time, so don't reinitialize the spinlock; bring it to life
+	 * under it, after the rest is filled in.
+	 */
+	spinlock_acquire(&file->of_reflock);
+	KASSERT(file->of_refcount == 0);
 	file->of_refcount = 1;
+	spinlock_release(&file->of_reflock);
 
 	return file;
 }
 
 /*
  * Destructor for struct openfile. Private; should only be used via
- * openfile_decref().
+ * openfile_decref(), which has already marked it dead. The memory
+ * goes to the cache, not back to kmalloc.
  */
 static
 void
@@ -84,10 +113,12 @@ openfile_destroy(struct openfile *file)
 {
 	/* balance vfs_open with vfs_close (not VOP_DECREF) */
 	vfs_close(file->of_vnode);
+	file->of_vnode = NULL;
 
-	spinlock_cleanup(&file->of_reflock);
-	lock_destroy(file->of_offsetlock);
-	kfree(file);
+	spinlock_acquire(&openfile_cachelock);
+	file->of_cachenext = openfile_cache;
+	openfile_cache = file;
+	spinlock_release(&openfile_cachelock);
 }
 
 /*
@@ -116,6 +147,25 @@ openfile_open(char *filename, int openflags, mode_t mode,
 	return 0;
 }
 
+/*
+ * Wrap an openfile object around a vnode that didn't come from
+ * vfs_open, such as one end of a pipe. Consumes the vnode reference
+ * on success.
+ */
+int
+openfile_fromvnode(struct vnode *vn, int accmode, struct openfile **ret)
+{
+	struct openfile *file;
+
+	file = openfile_create(vn, accmode);
+	if (file == NULL) {
+		return ENOMEM;
+	}
+
+	*ret = file;
+	return 0;
+}
+
 /*
  * Increment the reference count on an openfile.
  */
@@ -123,10 +173,29 @@ void
 openfile_incref(struct openfile *file)
 {
 	spinlock_acquire(&file->of_reflock);
+	KASSERT(file->of_refcount > 0);
 	file->of_refcount++;
 	spinlock_release(&file->of_reflock);
 }
 
+/*
+ * Increment the reference count on an openfile that might have been
+ * closed since the caller found it. Fails if it's dead.
+ */
+bool
+openfile_tryincref(struct openfile *file)
+{
+	bool ret;
+
+	spinlock_acquire(&file->of_reflock);
+	ret = file->of_refcount > 0;
+	if (ret) {
+		file->of_refcount++;
+	}
+	spinlock_release(&file->of_reflock);
+	return ret;
+}
+
 /*
  * Decrement the reference count on an openfile. Destroys it when the
  * reference count reaches zero.
@@ -138,6 +207,8 @@ openfile_decref(struct openfile *file)
 
 	/* if this is the last close of this file, free it up */
 	if (file->of_refcount == 1) {
+		/* mark it dead first so tryincref won't revive it */
+		file->of_refcount = 0;
 		spinlock_release(&file->of_reflock);
 		openfile_destroy(file);
 	}
@@ -0,0 +1,494 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * poll() and select(), and the pollhead/pollset machinery under them.
+ * See poll.h.
+ *
+ * A pollset sleeps on its process's nap channel, the same as
+ * clocksleep_ticks, so ITIMER_REAL and another thread calling _exit
+ * interrupt it the same way. pollwakeup wakes the particular thread
+ * with wchan_wakethread; the timeout is a callout that does the same.
+ *
+ * Lock order: a pollhead's lock, then the process's p_lock.
+ */
+
+#include <types.h>
+#include <kern/errno.h>
+#include <kern/poll.h>
+#include <kern/time.h>
+#include <limits.h>
+#include <lib.h>
+#include <spinlock.h>
+#include <wchan.h>
+#include <thread.h>
+#include <current.h>
+#include <clock.h>
+#include <callout.h>
+#include <proc.h>
+#include <copyinout.h>
+#include <vnode.h>
+#include <openfile.h>
+#include <filetable.h>
+#include <poll.h>
+#include <syscall.h>
+
+struct pollentry {
+	struct pollentry *pe_next;		/* Next on the head's list */
+	struct pollhead *pe_head;		/* Head we're on */
+	struct pollset *pe_set;			/* Pollset we belong to */
+};
+
+struct pollset {
+	struct proc *ps_proc;			/* Process (for p_lock) */
+	struct thread *ps_thread;		/* Thread waiting */
+	bool ps_woken;				/* Something happened */
+	bool ps_timedout;			/* The timeout ran out */
+	struct callout ps_timeout;		/* For the timeout */
+	struct pollentry *ps_entries;		/* Entries, one per file */
+	unsigned ps_num;			/* Entries in use */
+	unsigned ps_max;			/* Entries available */
+};
+
+////////////////////////////////////////////////////////////
+// pollheads
+
+void
+pollhead_init(struct pollhead *ph)
+{
+	spinlock_init(&ph->ph_lock);
+	ph->ph_entries = NULL;
+}
+
+void
+pollhead_cleanup(struct pollhead *ph)
+{
+	KASSERT(ph->ph_entries == NULL);
+	spinlock_cleanup(&ph->ph_lock);
+}
+
+/*
+ * Put PS on PH's list.
+ */
+void
+pollrecord(struct pollhead *ph, struct pollset *ps)
+{
+	struct pollentry *pe;
+
+	KASSERT(ps->ps_num < ps->ps_max);
+	pe = &ps->ps_entries[ps->ps_num++];
+	pe->pe_head = ph;
+	pe->pe_set = ps;
+
+	spinlock_acquire(&ph->ph_lock);
+	pe->pe_next = ph->ph_entries;
+	ph->ph_entries = pe;
+	spinlock_release(&ph->ph_lock);
+}
+
+/*
+ * Wake up a pollset.
+ */
+static
+void
+pollset_wake(struct pollset *ps)
+{
+	spinlock_acquire(&ps->ps_proc->p_lock);
+	if (!ps->ps_woken) {
+		ps->ps_woken = true;
+		wchan_wakethread(ps->ps_proc->p_napchan, &ps->ps_proc->p_lock,
+				 ps->ps_thread);
+	}
+	spinlock_release(&ps->ps_proc->p_lock);
+}
+
+/*
+ * Wake up everything polling on PH. The pollsets stay on the list
+ * until they're done; a pollset that's woken and finds nothing ready
+ * after all goes back to sleep still on it.
+ */
+void
+pollwakeup(struct pollhead *ph)
+{
+	struct pollentry *pe;
+
+	spinlock_acquire(&ph->ph_lock);
+	for (pe = ph->ph_entries; pe != NULL; pe = pe->pe_next) {
+		pollset_wake(pe->pe_set);
+	}
+	spinlock_release(&ph->ph_lock);
+}
+
+////////////////////////////////////////////////////////////
+// pollsets
+
+/*
+ * Callout for the timeout. Runs from hardclock.
+ */
+static
+void
+pollset_timeout(void *arg)
+{
+	struct pollset *ps = arg;
+
+	spinlock_acquire(&ps->ps_proc->p_lock);
+	ps->ps_timedout = true;
+	wchan_wakethread(ps->ps_proc->p_napchan, &ps->ps_proc->p_lock,
+			 ps->ps_thread);
+	spinlock_release(&ps->ps_proc->p_lock);
+}
+
+static
+void
+pollset_init(struct pollset *ps, struct pollentry *entries, unsigned max)
+{
+	ps->ps_proc = curproc;
+	ps->ps_thread = curthread;
+	ps->ps_woken = false;
+	ps->ps_timedout = false;
+	callout_init(&ps->ps_timeout, pollset_timeout, ps);
+	ps->ps_entries = entries;
+	ps->ps_num = 0;
+	ps->ps_max = max;
+}
+
+/*
+ * Take all of PS's entries off their heads' lists and stop the
+ * timeout.
+ */
+static
+void
+pollset_cleanup(struct pollset *ps)
+{
+	struct pollentry *pe, **pp;
+	struct pollhead *ph;
+	unsigned i;
+
+	for (i=0; i<ps->ps_num; i++) {
+		pe = &ps->ps_entries[i];
+		ph = pe->pe_head;
+		spinlock_acquire(&ph->ph_lock);
+		for (pp = &ph->ph_entries; *pp != pe; pp = &(*pp)->pe_next) {
+			KASSERT(*pp != NULL);
+		}
+		*pp = pe->pe_next;
+		spinlock_release(&ph->ph_lock);
+	}
+	ps->ps_num = 0;
+
+	/* PS is on our caller's stack; make sure the callout is done. */
+	callout_halt(&ps->ps_timeout);
+}
+
+/*
+ * Look at all the files once. Returns the number with something to
+ * report. If PS isn't NULL, the files record it.
+ */
+static
+unsigned
+poll_scan(struct pollfd *fds, struct openfile **files, unsigned nfds,
+	  struct pollset *ps)
+{
+	unsigned i, n;
+
+	n = 0;
+	for (i=0; i<nfds; i++) {
+		if (fds[i].fd < 0) {
+			fds[i].revents = 0;
+			continue;
+		}
+		if (files[i] == NULL) {
+			fds[i].revents = POLLNVAL;
+		}
+		else {
+			fds[i].revents = VOP_POLL(files[i]->of_vnode,
+						  fds[i].events, ps) &
+				(fds[i].events | POLLERR | POLLHUP);
+		}
+		if (fds[i].revents != 0) {
+			n++;
+		}
+	}
+	return n;
+}
+
+/*
+ * The common part of poll and select: wait until at least one of the
+ * NFDS files in FDS has one of its events, or until TICKS run out if
+ * HASTIMEOUT is set. The revents fields are filled in and the number
+ * of files with something to report is returned in *RETVAL.
+ */
+static
+int
+poll_wait(struct pollfd *fds, unsigned nfds, bool hastimeout,
+	  unsigned ticks, int *retval)
+{
+	struct proc *p = curproc;
+	struct openfile **files;
+	struct pollentry *entries;
+	struct pollset ps;
+	unsigned i, n, expirations;
+	bool record;
+	int result;
+
+	files = NULL;
+	entries = NULL;
+	if (nfds > 0) {
+		files = kmalloc(nfds * sizeof(*files));
+		entries = kmalloc(nfds * sizeof(*entries));
+		if (files == NULL || entries == NULL) {
+			kfree(files);
+			kfree(entries);
+			return ENOMEM;
+		}
+	}
+
+	/*
+	 * Hold a reference to each file while we wait, so another
+	 * thread closing it can't pull the vnode (and its pollhead)
+	 * out from under us.
+	 */
+	for (i=0; i<nfds; i++) {
+		files[i] = NULL;
+		if (fds[i].fd >= 0 &&
+		    filetable_get(p->p_filetable, fds[i].fd, &files[i]) == 0) {
+			openfile_incref(files[i]);
+			filetable_put(p->p_filetable, fds[i].fd, files[i]);
+		}
+	}
+
+	pollset_init(&ps, entries, nfds);
+	spinlock_acquire(&p->p_lock);
+	expirations = p->p_itimer_expirations;
+	spinlock_release(&p->p_lock);
+
+	result = 0;
+	record = true;
+	while (1) {
+		/* Clear this first, so a wakeup during the scan counts. */
+		spinlock_acquire(&p->p_lock);
+		ps.ps_woken = false;
+		spinlock_release(&p->p_lock);
+
+		n = poll_scan(fds, files, nfds, record ? &ps : NULL);
+		record = false;
+		if (n > 0 || ps.ps_timedout || (hastimeout && ticks == 0)) {
+			break;
+		}
+		if (hastimeout && !callout_pending(&ps.ps_timeout)) {
+			callout_schedule(&ps.ps_timeout, ticks);
+		}
+
+		spinlock_acquire(&p->p_lock);
+		while (!ps.ps_woken && !ps.ps_timedout) {
+			if (p->p_itimer_expirations != expirations ||
+			    p->p_exiting) {
+				result = EINTR;
+				break;
+			}
+			wchan_sleep(p->p_napchan, &p->p_lock);
+		}
+		spinlock_release(&p->p_lock);
+		if (result) {
+			break;
+		}
+	}
+
+	pollset_cleanup(&ps);
+	for (i=0; i<nfds; i++) {
+		if (files[i] != NULL) {
+			openfile_decref(files[i]);
+		}
+	}
+	kfree(files);
+	kfree(entries);
+
+	*retval = n;
+	return result;
+}
+
+////////////////////////////////////////////////////////////
+// system calls
+
+/*
+ * poll() - copy the pollfds in, wait, and copy them back out.
+ * TIMEOUT is in milliseconds; negative means forever.
+ */
+int
+sys_poll(userptr_t ufds, unsigned nfds, int timeout, int *retval)
+{
+	struct pollfd *fds;
+	struct timespec ts;
+	unsigned ticks;
+	int result;
+
+	if (nfds > OPEN_MAX) {
+		return EINVAL;
+	}
+
+	fds = NULL;
+	if (nfds > 0) {
+		fds = kmalloc(nfds * sizeof(*fds));
+		if (fds == NULL) {
+			return ENOMEM;
+		}
+		result = copyin(ufds, fds, nfds * sizeof(*fds));
+		if (result) {
+			kfree(fds);
+			return result;
+		}
+	}
+
+	ticks = 0;
+	if (timeout > 0) {
+		ts.tv_sec = timeout / 1000;
+		ts.tv_nsec = (timeout % 1000) * 1000000;
+		ticks = timespec_to_ticks(&ts);
+	}
+
+	result = poll_wait(fds, nfds, timeout >= 0, ticks, retval);
+	if (result == 0 && nfds > 0) {
+		result = copyout(fds, ufds, nfds * sizeof(*fds));
+	}
+	kfree(fds);
+	return result;
+}
+
+/*
+ * select() - turn the fd_sets into pollfds, wait, and turn the results
+ * back into fd_sets. The sets that aren't NULL are copied back out
+ * with only the ready files left in them.
+ */
+int
+sys_select(int nfds, userptr_t ureadfds, userptr_t uwritefds,
+	   userptr_t uexceptfds, const_userptr_t utimeout, int *retval)
+{
+	fd_set sets[3];
+	userptr_t usets[3] = { ureadfds, uwritefds, uexceptfds };
+	static const short events[3] = { POLLIN, POLLOUT, POLLPRI };
+	static const short results[3] = {
+		POLLIN | POLLHUP | POLLERR,
+		POLLOUT | POLLERR,
+		POLLPRI,
+	};
+	struct pollfd *fds;
+	struct timeval tv;
+	struct timespec ts;
+	unsigned ticks, num, i, j;
+	int fd, result, count;
+
+	if (nfds < 0 || nfds > FD_SETSIZE) {
+		return EINVAL;
+	}
+
+	for (j=0; j<3; j++) {
+		FD_ZERO(&sets[j]);
+		if (usets[j] != NULL) {
+			result = copyin(usets[j], &sets[j], sizeof(fd_set));
+			if (result) {
+				return result;
+			}
+		}
+	}
+
+	ticks = 0;
+	if (utimeout != NULL) {
+		result = copyin(utimeout, &tv, sizeof(tv));
+		if (result) {
+			return result;
+		}
+		if (tv.tv_sec < 0 || tv.tv_usec < 0 ||
+		    tv.tv_usec >= 1000000) {
+			return EINVAL;
+		}
+		ts.tv_sec = tv.tv_sec;
+		ts.tv_nsec = tv.tv_usec * 1000;
+		ticks = timespec_to_ticks(&ts);
+	}
+
+	fds = NULL;
+	if (nfds > 0) {
+		fds = kmalloc(nfds * sizeof(*fds));
+		if (fds == NULL) {
+			return ENOMEM;
+		}
+	}
+
+	/* One pollfd for each file that's in any of the sets. */
+	num = 0;
+	for (fd=0; fd<nfds; fd++) {
+		fds[num].fd = fd;
+		fds[num].events = 0;
+		for (j=0; j<3; j++) {
+			if (FD_ISSET(fd, &sets[j])) {
+				fds[num].events |= events[j];
+			}
+		}
+		if (fds[num].events != 0) {
+			num++;
+		}
+	}
+
+	result = poll_wait(fds, num, utimeout != NULL, ticks, &count);
+	if (result) {
+		goto out;
+	}
+
+	count = 0;
+	for (j=0; j<3; j++) {
+		FD_ZERO(&sets[j]);
+	}
+	for (i=0; i<num; i++) {
+		if (fds[i].revents & POLLNVAL) {
+			result = EBADF;
+			goto out;
+		}
+		for (j=0; j<3; j++) {
+			if (fds[i].events & events[j] &&
+			    fds[i].revents & results[j]) {
+				FD_SET(fds[i].fd, &sets[j]);
+				count++;
+			}
+		}
+	}
+
+	for (j=0; j<3; j++) {
+		if (usets[j] != NULL) {
+			result = copyout(&sets[j], usets[j], sizeof(fd_set));
+			if (result) {
+				goto out;
+			}
+		}
+	}
+	*retval = count;
+
+ out:
+	kfree(fds);
+	return result;
+}
@@ -34,9 +34,12 @@
 #include <types.h>
 #include <kern/errno.h>
 #include <kern/wait.h>
+#include <kern/time.h>
+#include <kern/resource.h>
 #include <lib.h>
 #include <machine/trapframe.h>
 #include <clock.h>
+#include <synch.h>
 #include <thread.h>
 #include <proc.h>
 #include <current.h>
@@ -44,7 +47,7 @@
 #include <pid.h>
 #include <syscall.h>
 
-/* note that sys_execv is in runprogram.c */
+/* note that sys_execv and sys___spawn are in runprogram.c */
 
 
 /*
@@ -81,12 +84,13 @@ sys__exit(int status)
 
 static
 void
-fork_newthread(void *vtf, unsigned long junk)
+fork_newthread(void *vtf, unsigned long slot)
 {
 	struct trapframe mytf;
 	struct trapframe *ntf = vtf;
 
-	(void)junk;
+	/* We're in the same thread table slot as the parent thread. */
+	curthread->t_uslot = slot;
 
 	/*
 	 * Now copy the trapframe to our stack, so we can free the one
@@ -127,7 +131,7 @@ sys_fork(struct trapframe *tf, pid_t *retval)
 	*retval = newproc->p_pid;
 
 	result = thread_fork(curthread->t_name, newproc,
-			     fork_newthread, ntf, 0);
+			     fork_newthread, ntf, curthread->t_uslot);
 	if (result) {
 		proc_unfork(newproc);
 		kfree(ntf);
@@ -137,23 +141,177 @@ sys_fork(struct trapframe *tf, pid_t *retval)
 	return 0;
 }
 
+/*
+ * sys_vfork
+ *
+ * Like fork, but the new process runs in our address space instead of
+ * a copy of it, and we sleep until it execs or exits. For the usual
+ * fork-then-exec this saves copying every page only to throw the copy
+ * away in execv. Until we wake up the child is also on our user
+ * stack; it's up to it not to return from the function that called
+ * vfork.
+ */
+int
+sys_vfork(struct trapframe *tf, pid_t *retval)
+{
+	struct semaphore *donesem;
+	struct trapframe *ntf;
+	struct proc *newproc;
+	int result;
+
+	donesem = sem_create("vfork", 0);
+	if (donesem == NULL) {
+		return ENOMEM;
+	}
+
+	/* The child frees this, as for fork. */
+	ntf = kmalloc(sizeof(struct trapframe));
+	if (ntf == NULL) {
+		sem_destroy(donesem);
+		return ENOMEM;
+	}
+	*ntf = *tf;
+
+	result = proc_vfork(donesem, &newproc);
+	if (result) {
+		kfree(ntf);
+		sem_destroy(donesem);
+		return result;
+	}
+	*retval = newproc->p_pid;
+
+	result = thread_fork(curthread->t_name, newproc,
+			     fork_newthread, ntf, curthread->t_uslot);
+	if (result) {
+		proc_unfork(newproc);
+		kfree(ntf);
+		sem_destroy(donesem);
+		return result;
+	}
+
+	/* The child may be gone by the time this returns. */
+	P(donesem);
+	sem_destroy(donesem);
+	return 0;
+}
+
 /*
  * sys_waitpid
- * just pass off the work to the pid code.
+ * the same as wait4 without the usage.
  */
 int
 sys_waitpid(pid_t pid, userptr_t retstatus, int flags, pid_t *retval)
+{
+	return sys_wait4(pid, retstatus, flags, NULL, retval);
+}
+
+/*
+ * sys_wait4
+ * just pass off the work to the pid code.
+ */
+int
+sys_wait4(pid_t pid, userptr_t retstatus, int flags, userptr_t retusage,
+	  pid_t *retval)
 {
 	int status;
+	struct usage usage;
+	struct rusage ru;
 	int result;
 
-	result = pid_wait(pid, &status, flags, retval);
+	result = pid_wait(pid, &status, flags, retval, &usage);
 	if (result) {
 		return result;
 	}
+	if (*retval == 0) {
+		/* WNOHANG, and it hasn't exited */
+		return 0;
+	}
 
 	if (retstatus != NULL) {
 		result = copyout(&status, retstatus, sizeof(int));
+		if (result) {
+			return result;
+		}
+	}
+	if (retusage != NULL) {
+		usage_torusage(&usage, &ru);
+		result = copyout(&ru, retusage, sizeof(ru));
+	}
+	return result;
+}
+
+/*
+ * sys_getrusage
+ * Resources used by this process, or by its children that have
+ * been waited for.
+ */
+int
+sys_getrusage(int who, userptr_t retusage)
+{
+	struct usage usage;
+	struct rusage ru;
+
+	if (who != RUSAGE_SELF && who != RUSAGE_CHILDREN) {
+		return EINVAL;
+	}
+	proc_getusage(curproc, who, &usage);
+	usage_torusage(&usage, &ru);
+	return copyout(&ru, retusage, sizeof(ru));
+}
+
+/*
+ * sys_setaffinity
+ * Set the CPUs the threads of a process may run on. Since we can't
+ * look up other processes by pid, only the current process (pid 0
+ * or our own pid) is supported.
+ */
+int
+sys_setaffinity(pid_t pid, uint32_t mask)
+{
+	struct proc *proc = curproc;
+	struct thread *t;
+	unsigned i, num;
+	int result;
+
+	if (pid != 0 && pid != proc->p_pid) {
+		return ESRCH;
+	}
+
+	/* Set our own mask first; this also checks it for validity. */
+	result = thread_setaffinity(curthread, mask);
+	if (result) {
+		return result;
 	}
+
+	lock_acquire(proc->p_threadslock);
+	num = threadarray_num(&proc->p_threads);
+	for (i=0; i<num; i++) {
+		t = threadarray_get(&proc->p_threads, i);
+		if (t != curthread) {
+			result = thread_setaffinity(t, mask);
+			if (result) {
+				break;
+			}
+		}
+	}
+	lock_release(proc->p_threadslock);
+
 	return result;
 }
+
+/*
+ * sys_getaffinity
+ * Report the CPUs the current thread may run on.
+ */
+int
+sys_getaffinity(pid_t pid, userptr_t maskp)
+{
+	uint32_t mask;
+
+	if (pid != 0 && pid != curproc->p_pid) {
+		return ESRCH;
+	}
+
+	mask = thread_getaffinity(curthread);
+	return copyout(&mask, maskp, sizeof(mask));
+}
@@ -28,14 +28,16 @@
  */
 
 /*
- * Code for running a user program from the menu, and code for execv,
- * which have a lot in common.
+ * Code for running a user program from the menu, and code for execv
+ * and spawn, which have a lot in common.
  */
 
 #include <types.h>
 #include <kern/errno.h>
 #include <kern/fcntl.h>
+#include <kern/spawn.h>
 #include <kern/unistd.h>
+#include <kern/wait.h>
 #include <limits.h>
 #include <lib.h>
 #include <proc.h>
@@ -47,6 +49,7 @@
 #include <vfs.h>
 #include <openfile.h>
 #include <filetable.h>
+#include <pid.h>
 #include <syscall.h>
 #include <test.h>
 
@@ -391,7 +394,11 @@ loadexec(char *path, vaddr_t *entrypoint, vaddr_t *stackptr)
 	 * Note: once this is done, execv() must not fail, because there's
 	 * nothing left for it to return an error to.
 	 */
-	if (oldvm) {
+	if (curproc->p_vforksem != NULL) {
+		/* It was our parent's (vfork); give it back. */
+		proc_vforkdone(curproc);
+	}
+	else if (oldvm) {
 		as_destroy(oldvm);
 	}
 
@@ -402,43 +409,66 @@ loadexec(char *path, vaddr_t *entrypoint, vaddr_t *stackptr)
 	kfree(curthread->t_name);
 	curthread->t_name = newname;
 
+	/* We're the main thread of the new program, on the main stack. */
+	proc_setmainthread();
+
 	return 0;
 }
 
 
 /*
- * Open a file on a selected file descriptor. Takes care of various
- * minutiae, like the vfs-level open destroying pathnames.
+ * Open a file on a selected file descriptor of file table FT, closing
+ * whatever was there before. Note that the vfs-level open destroys
+ * PATH.
  */
 static
 int
-placed_open(const char *path, int openflags, int fd)
+placed_open(struct filetable *ft, char *path, int openflags, mode_t mode,
+	    int fd)
 {
 	struct openfile *newfile, *oldfile;
-	char mypath[32];
 	int result;
 
-	/*
-	 * The filename comes from the kernel, in fact right in this
-	 * file; assume reasonable length. But make sure we fit.
-	 */
-	KASSERT(strlen(path) < sizeof(mypath));
-	strcpy(mypath, path);
-
-	result = openfile_open(mypath, openflags, 0664, &newfile);
+	result = openfile_open(path, openflags, mode, &newfile);
 	if (result) {
 		return result;
 	}
 
 	/* place the file in the filetable in the right slot */
-	filetable_placeat(curproc->p_filetable, newfile, fd, &oldfile);
+	result = filetable_placeat(ft, newfile, fd, &oldfile);
+	if (result) {
+		openfile_decref(newfile);
+		return result;
+	}
 
-	/* the table should previously have been empty */
-	KASSERT(oldfile == NULL);
+	if (oldfile != NULL) {
+		openfile_decref(oldfile);
+	}
 
 	return 0;
 }
 
+/*
+ * placed_open on the current process's table, for a path from the
+ * kernel. Takes care of various minutiae, like the vfs-level open
+ * destroying pathnames.
+ */
+static
+int
+placed_kopen(const char *path, int openflags, int fd)
+{
+	char mypath[32];
+
+	/*
+	 * The filename comes from the kernel, in fact right in this
+	 * file; assume reasonable length. But make sure we fit.
+	 */
+	KASSERT(strlen(path) < sizeof(mypath));
+	strcpy(mypath, path);
+
+	return placed_open(curproc->p_filetable, mypath, openflags, 0664, fd);
+}
+
 /*
  * Open the standard file descriptors: stdin, stdout, stderr.
  *
@@ -452,17 +482,17 @@ open_stdfds(const char *inpath, const char *outpath, const char *errpath)
 {
 	int result;
 
-	result = placed_open(inpath, O_RDONLY, STDIN_FILENO);
+	result = placed_kopen(inpath, O_RDONLY, STDIN_FILENO);
 	if (result) {
 		return result;
 	}
 
-	result = placed_open(outpath, O_WRONLY, STDOUT_FILENO);
+	result = placed_kopen(outpath, O_WRONLY, STDOUT_FILENO);
 	if (result) {
 		return result;
 	}
 
-	result = placed_open(errpath, O_WRONLY, STDERR_FILENO);
+	result = placed_kopen(errpath, O_WRONLY, STDERR_FILENO);
 	if (result) {
 		return result;
 	}
@@ -550,6 +580,10 @@ runprogram(char *progname)
  * 3. Load the executable.
  * 4. Copy the argv out again with copyout_args.
  * 5. Warp to usermode.
+ *
+ * A multithreaded process can't exec until its other threads have
+ * exited; there's no way to stop them in their tracks. (Otherwise
+ * they'd wake up running the new program.)
  */
 int
 sys_execv(userptr_t prog, userptr_t uargv)
@@ -558,8 +592,16 @@ sys_execv(userptr_t prog, userptr_t uargv)
 	struct argbuf kargv;
 	vaddr_t entrypoint, stackptr;
 	int argc;
+	bool others;
 	int result;
 
+	spinlock_acquire(&curproc->p_lock);
+	others = curproc->p_nthreads > 1;
+	spinlock_release(&curproc->p_lock);
+	if (others) {
+		return EBUSY;
+	}
+
 	path = kmalloc(PATH_MAX);
 	if (!path) {
 		return ENOMEM;
@@ -611,3 +653,232 @@ sys_execv(userptr_t prog, userptr_t uargv)
 	panic("enter_new_process returned\n");
 	return EINVAL;
 }
+
+/*
+ * spawn.
+ *
+ * Start a new process running PROG with the arguments ARGV, in one go
+ * rather than with fork (or vfork) and then execv. Nothing of ours is
+ * copied but the file table and the current directory, and nothing
+ * is built just to be torn down again.
+ *
+ * We do all the parts that read our own memory: the program name, the
+ * argv, and the file actions, which are carried out on the new
+ * process's file table here. Then the new process's thread loads the
+ * program, since that has to happen in the address space being built,
+ * and tells us how it went. If it failed, the new process exits and
+ * we collect it and return the error, so the caller sees the same
+ * errors execv would give.
+ */
+
+struct spawninfo {
+	char *si_path;			/* Program */
+	struct argbuf si_argv;		/* Its arguments */
+	struct semaphore *si_done;	/* V'd when loaded (or not) */
+	int si_result;			/* Whether it was */
+};
+
+/*
+ * Carry out the file actions on the new process's table FT.
+ */
+static
+int
+spawn_fileactions(struct filetable *ft, const struct spawn_action *actions,
+		  unsigned nactions)
+{
+	const struct spawn_action *sa;
+	struct openfile *file, *oldfile;
+	char *path;
+	unsigned i;
+	int result;
+
+	for (i=0; i<nactions; i++) {
+		sa = &actions[i];
+		if (!filetable_okfd(ft, sa->sa_fd)) {
+			return EBADF;
+		}
+		switch (sa->sa_type) {
+		    case SPAWN_CLOSE:
+			filetable_placeat(ft, NULL, sa->sa_fd, &oldfile);
+			if (oldfile != NULL) {
+				openfile_decref(oldfile);
+			}
+			break;
+		    case SPAWN_DUP2:
+			if (!filetable_okfd(ft, sa->sa_newfd)) {
+				return EBADF;
+			}
+			result = filetable_get(ft, sa->sa_fd, &file);
+			if (result) {
+				return result;
+			}
+			openfile_incref(file);
+			filetable_put(ft, sa->sa_fd, file);
+			result = filetable_placeat(ft, file, sa->sa_newfd,
+						   &oldfile);
+			if (result) {
+				openfile_decref(file);
+				return result;
+			}
+			if (oldfile != NULL) {
+				openfile_decref(oldfile);
+			}
+			break;
+		    case SPAWN_OPEN:
+			path = kmalloc(PATH_MAX);
+			if (path == NULL) {
+				return ENOMEM;
+			}
+			result = copyinstr(sa->sa_path, path, PATH_MAX, NULL);
+			if (result == 0) {
+				result = placed_open(ft, path, sa->sa_flags,
+						     sa->sa_mode, sa->sa_fd);
+			}
+			kfree(path);
+			if (result) {
+				return result;
+			}
+			break;
+		    default:
+			return EINVAL;
+		}
+	}
+	return 0;
+}
+
+/*
+ * The new process's thread. Once it has V'd si_done, SI is gone.
+ */
+static
+void
+spawn_newthread(void *vsi, unsigned long junk)
+{
+	struct spawninfo *si = vsi;
+	vaddr_t entrypoint, stackptr;
+	userptr_t uargv;
+	int argc;
+	int result;
+
+	(void)junk;
+
+	/* Load the executable. Note: must not fail after this succeeds. */
+	result = loadexec(si->si_path, &entrypoint, &stackptr);
+	if (result) {
+		si->si_result = result;
+		V(si->si_done);
+		proc_exit(_MKWAIT_EXIT(255));
+	}
+
+	result = argbuf_copyout(&si->si_argv, &stackptr, &argc, &uargv);
+	if (result) {
+		/* If copyout fails, *we* messed up, so panic */
+		panic("spawn: copyout_args failed: %s\n", strerror(result));
+	}
+
+	si->si_result = 0;
+	V(si->si_done);
+
+	/* Warp to user mode. */
+	enter_new_process(argc, uargv, NULL /*uenv*/, stackptr, entrypoint);
+
+	/* enter_new_process does not return. */
+	panic("enter_new_process returned\n");
+}
+
+int
+sys___spawn(userptr_t prog, userptr_t uargv, userptr_t uactions,
+	    unsigned nactions, pid_t *retval)
+{
+	struct spawn_action actions[SPAWN_MAXACTIONS];
+	struct spawninfo si;
+	struct proc *newproc;
+	pid_t pid;
+	int result;
+
+	if (nactions > SPAWN_MAXACTIONS) {
+		return EINVAL;
+	}
+	if (nactions > 0) {
+		result = copyin(uactions, actions,
+				nactions * sizeof(actions[0]));
+		if (result) {
+			return result;
+		}
+	}
+
+	si.si_path = kmalloc(PATH_MAX);
+	if (si.si_path == NULL) {
+		return ENOMEM;
+	}
+
+	/* Get the filename. */
+	result = copyinstr(prog, si.si_path, PATH_MAX, NULL);
+	if (result) {
+		kfree(si.si_path);
+		return result;
+	}
+
+	/* get the argv strings. */
+	argbuf_init(&si.si_argv);
+	result = argbuf_fromuser(&si.si_argv, uargv);
+	if (result) {
+		goto fail;
+	}
+
+	si.si_done = sem_create("spawn", 0);
+	if (si.si_done == NULL) {
+		result = ENOMEM;
+		goto fail;
+	}
+
+	/* A fresh process with our current directory... */
+	result = proc_create_runprogram(si.si_path, &newproc);
+	if (result) {
+		goto fail_sem;
+	}
+
+	/* ...and our files, as modified by the file actions. */
+	if (curproc->p_filetable != NULL) {
+		result = filetable_copy(curproc->p_filetable,
+					&newproc->p_filetable);
+	}
+	else {
+		newproc->p_filetable = filetable_create();
+		if (newproc->p_filetable == NULL) {
+			result = ENOMEM;
+		}
+	}
+	if (result == 0) {
+		result = spawn_fileactions(newproc->p_filetable,
+					   actions, nactions);
+	}
+	if (result) {
+		proc_unfork(newproc);
+		goto fail_sem;
+	}
+
+	pid = newproc->p_pid;
+	result = thread_fork(newproc->p_name, newproc,
+			     spawn_newthread, &si, 0);
+	if (result) {
+		proc_unfork(newproc);
+		goto fail_sem;
+	}
+
+	P(si.si_done);
+	result = si.si_result;
+	if (result) {
+		/* It's exiting; collect it. */
+		pid_wait(pid, NULL, 0, &pid, NULL);
+	}
+	else {
+		*retval = pid;
+	}
+
+ fail_sem:
+	sem_destroy(si.si_done);
+ fail:
+	argbuf_cleanup(&si.si_argv);
+	kfree(si.si_path);
+	return result;
+}
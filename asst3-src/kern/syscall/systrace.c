@@ -0,0 +1,585 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * System call tracer. See systrace.h.
+ */
+
+#include <types.h>
+#include <kern/errno.h>
+#include <kern/syscall.h>
+#include <kern/systrace.h>
+#include <lib.h>
+#include <cpu.h>
+#include <spl.h>
+#include <membar.h>
+#include <spinlock.h>
+#include <current.h>
+#include <proc.h>
+#include <copyinout.h>
+#include <machine/trapframe.h>
+#include <syscall.h>
+#include <systrace.h>
+
+/* Number of recent calls kept per CPU; must be a power of 2. */
+#define SYSTRACE_RINGSIZE	256
+
+/*
+ * Per-CPU trace data. Only the CPU it belongs to writes it, with
+ * interrupts off.
+ *
+ * sc_next is the sequence number the next record will get; record
+ * SEQ goes in slot SEQ % SYSTRACE_RINGSIZE. Sequence numbers start
+ * at 1 so that 0 can mean the slot is empty or being written.
+ */
+struct systrace_cpu {
+	struct systrace_stats sc_stats[SYSTRACE_NCALLS];
+	struct systrace_record sc_ring[SYSTRACE_RINGSIZE];
+	uint32_t sc_next;
+};
+
+volatile bool systrace_on;
+
+/*
+ * One systrace_cpu per CPU, indexed by c_number. Allocated the first
+ * time tracing is turned on and never freed; systrace_cpus_lock is
+ * only for installing it.
+ */
+static struct systrace_cpu **volatile systrace_cpus;
+static unsigned systrace_ncpus;
+static struct spinlock systrace_cpus_lock = SPINLOCK_INITIALIZER;
+
+static const char *const systrace_names[SYSTRACE_NCALLS] = {
+	[SYS_fork] = "fork",
+	[SYS_vfork] = "vfork",
+	[SYS_execv] = "execv",
+	[SYS__exit] = "_exit",
+	[SYS_waitpid] = "waitpid",
+	[SYS_getpid] = "getpid",
+	[SYS_getppid] = "getppid",
+	[SYS_sbrk] = "sbrk",
+	[SYS_mmap] = "mmap",
+	[SYS_munmap] = "munmap",
+	[SYS_mprotect] = "mprotect",
+	[SYS_umask] = "umask",
+	[SYS_issetugid] = "issetugid",
+	[SYS_getresuid] = "getresuid",
+	[SYS_setresuid] = "setresuid",
+	[SYS_getresgid] = "getresgid",
+	[SYS_setresgid] = "setresgid",
+	[SYS_getgroups] = "getgroups",
+	[SYS_setgroups] = "setgroups",
+	[SYS___getlogin] = "__getlogin",
+	[SYS___setlogin] = "__setlogin",
+	[SYS_kill] = "kill",
+	[SYS_sigaction] = "sigaction",
+	[SYS_sigpending] = "sigpending",
+	[SYS_sigprocmask] = "sigprocmask",
+	[SYS_sigsuspend] = "sigsuspend",
+	[SYS_sigreturn] = "sigreturn",
+	[SYS_wait4] = "wait4",
+	[SYS_getrusage] = "getrusage",
+	[SYS_open] = "open",
+	[SYS_pipe] = "pipe",
+	[SYS_dup] = "dup",
+	[SYS_dup2] = "dup2",
+	[SYS_close] = "close",
+	[SYS_read] = "read",
+	[SYS_pread] = "pread",
+	[SYS_readv] = "readv",
+	[SYS_preadv] = "preadv",
+	[SYS_getdirentry] = "getdirentry",
+	[SYS_write] = "write",
+	[SYS_pwrite] = "pwrite",
+	[SYS_writev] = "writev",
+	[SYS_pwritev] = "pwritev",
+	[SYS_lseek] = "lseek",
+	[SYS_flock] = "flock",
+	[SYS_ftruncate] = "ftruncate",
+	[SYS_fsync] = "fsync",
+	[SYS_fcntl] = "fcntl",
+	[SYS_ioctl] = "ioctl",
+	[SYS_select] = "select",
+	[SYS_poll] = "poll",
+	[SYS_link] = "link",
+	[SYS_remove] = "remove",
+	[SYS_mkdir] = "mkdir",
+	[SYS_rmdir] = "rmdir",
+	[SYS_mkfifo] = "mkfifo",
+	[SYS_rename] = "rename",
+	[SYS_access] = "access",
+	[SYS_chdir] = "chdir",
+	[SYS_fchdir] = "fchdir",
+	[SYS___getcwd] = "__getcwd",
+	[SYS_symlink] = "symlink",
+	[SYS_readlink] = "readlink",
+	[SYS_mount] = "mount",
+	[SYS_unmount] = "unmount",
+	[SYS_stat] = "stat",
+	[SYS_fstat] = "fstat",
+	[SYS_lstat] = "lstat",
+	[SYS_utimes] = "utimes",
+	[SYS_futimes] = "futimes",
+	[SYS_lutimes] = "lutimes",
+	[SYS_chmod] = "chmod",
+	[SYS_chown] = "chown",
+	[SYS_fchmod] = "fchmod",
+	[SYS_fchown] = "fchown",
+	[SYS_lchmod] = "lchmod",
+	[SYS_lchown] = "lchown",
+	[SYS_socket] = "socket",
+	[SYS_bind] = "bind",
+	[SYS_connect] = "connect",
+	[SYS_listen] = "listen",
+	[SYS_accept] = "accept",
+	[SYS_shutdown] = "shutdown",
+	[SYS_getsockname] = "getsockname",
+	[SYS_getpeername] = "getpeername",
+	[SYS_getsockopt] = "getsockopt",
+	[SYS_setsockopt] = "setsockopt",
+	[SYS___time] = "__time",
+	[SYS___settime] = "__settime",
+	[SYS_nanosleep] = "nanosleep",
+	[SYS_getitimer] = "getitimer",
+	[SYS_setitimer] = "setitimer",
+	[SYS_sync] = "sync",
+	[SYS_reboot] = "reboot",
+	[SYS_setaffinity] = "setaffinity",
+	[SYS_getaffinity] = "getaffinity",
+	[SYS_futex] = "futex",
+	[SYS___thread_create] = "__thread_create",
+	[SYS___thread_exit] = "__thread_exit",
+	[SYS___thread_join] = "__thread_join",
+	[SYS___thread_self] = "__thread_self",
+	[SYS___thread_detach] = "__thread_detach",
+	[SYS___spawn] = "__spawn",
+	[SYS___systrace] = "__systrace",
+	[SYS___ioring_enter] = "__ioring_enter",
+};
+
+////////////////////////////////////////////////////////////
+// Recording
+
+/*
+ * Get the starting time for a call. SYSTRACE_START only calls this
+ * when tracing is on, so the call is always traced.
+ */
+bool
+systrace_start(uint64_t *start)
+{
+	*start = cpu_getcycles();
+	return true;
+}
+
+/*
+ * Histogram bucket for a time: floor(log2(cycles)), capped.
+ */
+static
+unsigned
+systrace_bucket(uint64_t cycles)
+{
+	unsigned b = 0;
+
+	while (cycles > 1 && b < SYSTRACE_NBUCKETS - 1) {
+		cycles >>= 1;
+		b++;
+	}
+	return b;
+}
+
+/*
+ * Record a call that's about to return. TF still has the arguments.
+ */
+void
+systrace_end(struct trapframe *tf, int callno, int err, int32_t retval,
+	     uint64_t start)
+{
+	struct systrace_cpu **cpus;
+	struct systrace_cpu *sc;
+	struct systrace_stats *ss;
+	struct systrace_record *sr;
+	uint64_t cycles;
+	uint32_t seq;
+	int spl;
+
+	cycles = cpu_cycles_since(start);
+
+	cpus = systrace_cpus;
+	if (cpus == NULL || callno < 0 || callno >= SYSTRACE_NCALLS) {
+		return;
+	}
+
+	spl = splhigh();
+	sc = cpus[curcpu->c_number];
+
+	ss = &sc->sc_stats[callno];
+	ss->ss_calls++;
+	if (err) {
+		ss->ss_errors++;
+	}
+	ss->ss_cycles += cycles;
+	ss->ss_hist[systrace_bucket(cycles)]++;
+
+	seq = sc->sc_next++;
+	sr = &sc->sc_ring[seq % SYSTRACE_RINGSIZE];
+	sr->sr_seq = 0;
+	membar_store_store();
+	sr->sr_cpu = curcpu->c_number;
+	sr->sr_pid = curproc->p_pid;
+	sr->sr_callno = callno;
+	sr->sr_args[0] = tf->tf_a0;
+	sr->sr_args[1] = tf->tf_a1;
+	sr->sr_args[2] = tf->tf_a2;
+	sr->sr_args[3] = tf->tf_a3;
+	sr->sr_retval = err ? -1 : retval;
+	sr->sr_err = err;
+	/* the record only has 32 bits; that's almost three minutes */
+	sr->sr_cycles = cycles > 0xffffffff ? 0xffffffff : cycles;
+	membar_store_store();
+	sr->sr_seq = seq;
+
+	splx(spl);
+}
+
+////////////////////////////////////////////////////////////
+// Control
+
+/*
+ * Allocate the per-CPU data, if it isn't there yet.
+ */
+static
+int
+systrace_alloc(void)
+{
+	struct systrace_cpu **cpus;
+	unsigned i, num;
+
+	if (systrace_cpus != NULL) {
+		return 0;
+	}
+
+	num = cpu_count();
+	cpus = kmalloc(num * sizeof(*cpus));
+	if (cpus == NULL) {
+		return ENOMEM;
+	}
+	for (i=0; i<num; i++) {
+		cpus[i] = kmalloc(sizeof(struct systrace_cpu));
+		if (cpus[i] == NULL) {
+			goto fail;
+		}
+		bzero(cpus[i], sizeof(struct systrace_cpu));
+		cpus[i]->sc_next = 1;
+	}
+
+	spinlock_acquire(&systrace_cpus_lock);
+	if (systrace_cpus == NULL) {
+		systrace_ncpus = num;
+		membar_store_store();
+		systrace_cpus = cpus;
+		cpus = NULL;
+	}
+	spinlock_release(&systrace_cpus_lock);
+
+	if (cpus == NULL) {
+		return 0;
+	}
+	/* Someone else got there first. */
+	i = num;
+ fail:
+	while (i-- > 0) {
+		kfree(cpus[i]);
+	}
+	kfree(cpus);
+	return systrace_cpus != NULL ? 0 : ENOMEM;
+}
+
+/*
+ * Turn tracing on or off.
+ */
+int
+systrace_enable(bool on)
+{
+	int result;
+
+	if (on) {
+		result = systrace_alloc();
+		if (result) {
+			return result;
+		}
+	}
+	systrace_on = on;
+	return 0;
+}
+
+/*
+ * Throw away the counts and the log. If tracing is on, an update or
+ * two made on another CPU meanwhile may survive or be half lost.
+ */
+void
+systrace_reset(void)
+{
+	struct systrace_cpu *sc;
+	unsigned i, j;
+
+	if (systrace_cpus == NULL) {
+		return;
+	}
+	for (i=0; i<systrace_ncpus; i++) {
+		sc = systrace_cpus[i];
+		bzero(sc->sc_stats, sizeof(sc->sc_stats));
+		for (j=0; j<SYSTRACE_RINGSIZE; j++) {
+			sc->sc_ring[j].sr_seq = 0;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////
+// Reading
+
+/*
+ * Sum the counts over all CPUs into STATS (SYSTRACE_NCALLS of them).
+ */
+static
+void
+systrace_getstats(struct systrace_stats *stats)
+{
+	struct systrace_stats *ss, *cs;
+	unsigned i, j, k;
+
+	bzero(stats, SYSTRACE_NCALLS * sizeof(*stats));
+	for (j=0; j<SYSTRACE_NCALLS; j++) {
+		if (systrace_names[j] != NULL) {
+			strcpy(stats[j].ss_name, systrace_names[j]);
+		}
+	}
+	if (systrace_cpus == NULL) {
+		return;
+	}
+	for (i=0; i<systrace_ncpus; i++) {
+		for (j=0; j<SYSTRACE_NCALLS; j++) {
+			ss = &stats[j];
+			cs = &systrace_cpus[i]->sc_stats[j];
+			ss->ss_calls += cs->ss_calls;
+			ss->ss_errors += cs->ss_errors;
+			ss->ss_cycles += cs->ss_cycles;
+			for (k=0; k<SYSTRACE_NBUCKETS; k++) {
+				ss->ss_hist[k] += cs->ss_hist[k];
+			}
+		}
+	}
+}
+
+/*
+ * Copy out up to MAX of the most recent records on CPU SC, oldest
+ * first. Records that are being overwritten are skipped. Returns
+ * the number copied.
+ */
+static
+unsigned
+systrace_getlog(struct systrace_cpu *sc, struct systrace_record *recs,
+		unsigned max)
+{
+	struct systrace_record *sr;
+	uint32_t seq, next;
+	unsigned n;
+
+	next = sc->sc_next;
+	seq = next > max ? next - max : 1;
+	if (next - seq > SYSTRACE_RINGSIZE) {
+		seq = next - SYSTRACE_RINGSIZE;
+	}
+
+	n = 0;
+	for (; seq != next; seq++) {
+		sr = &sc->sc_ring[seq % SYSTRACE_RINGSIZE];
+		if (sr->sr_seq != seq) {
+			continue;
+		}
+		membar_load_load();
+		recs[n] = *sr;
+		membar_load_load();
+		if (sr->sr_seq != seq || recs[n].sr_seq != seq) {
+			continue;
+		}
+		n++;
+	}
+	return n;
+}
+
+/*
+ * Print the counts for the calls that have been made, and their
+ * histograms. For the kernel menu.
+ */
+void
+systrace_dump(void)
+{
+	struct systrace_stats *stats, *ss;
+	unsigned i, k;
+
+	stats = kmalloc(SYSTRACE_NCALLS * sizeof(*stats));
+	if (stats == NULL) {
+		kprintf("systrace: Out of memory\n");
+		return;
+	}
+	systrace_getstats(stats);
+
+	kprintf("systrace is %s\n", systrace_on ? "on" : "off");
+	kprintf("%-20s %10s %10s %12s\n", "call", "calls", "errors",
+		"avg cycles");
+	for (i=0; i<SYSTRACE_NCALLS; i++) {
+		ss = &stats[i];
+		if (ss->ss_calls == 0) {
+			continue;
+		}
+		kprintf("%-20s %10u %10u %12llu\n",
+			ss->ss_name[0] ? ss->ss_name : "(unknown)",
+			ss->ss_calls, ss->ss_errors,
+			ss->ss_cycles / ss->ss_calls);
+		for (k=0; k<SYSTRACE_NBUCKETS; k++) {
+			if (ss->ss_hist[k] != 0) {
+				kprintf("    >= 2^%-2u cycles: %u\n",
+					k, ss->ss_hist[k]);
+			}
+		}
+	}
+	kfree(stats);
+}
+
+/*
+ * Print each CPU's log of recent calls. For the kernel menu.
+ */
+void
+systrace_dumplog(void)
+{
+	struct systrace_record *recs, *sr;
+	const char *name;
+	unsigned i, j, n;
+
+	if (systrace_cpus == NULL) {
+		kprintf("systrace: Nothing traced yet\n");
+		return;
+	}
+	recs = kmalloc(SYSTRACE_RINGSIZE * sizeof(*recs));
+	if (recs == NULL) {
+		kprintf("systrace: Out of memory\n");
+		return;
+	}
+	for (i=0; i<systrace_ncpus; i++) {
+		n = systrace_getlog(systrace_cpus[i], recs, SYSTRACE_RINGSIZE);
+		for (j=0; j<n; j++) {
+			sr = &recs[j];
+			name = systrace_names[sr->sr_callno];
+			kprintf("cpu%u %u: pid %d %s(0x%x, 0x%x, 0x%x, 0x%x) "
+				"= %d", sr->sr_cpu, sr->sr_seq, sr->sr_pid,
+				name != NULL ? name : "(unknown)",
+				sr->sr_args[0], sr->sr_args[1],
+				sr->sr_args[2], sr->sr_args[3], sr->sr_retval);
+			if (sr->sr_err) {
+				kprintf(" (%s)", strerror(sr->sr_err));
+			}
+			kprintf(" [%u cycles]\n", sr->sr_cycles);
+		}
+	}
+	kfree(recs);
+}
+
+////////////////////////////////////////////////////////////
+// System call
+
+/*
+ * __systrace: control the tracer and read it out. See
+ * <kern/systrace.h> for the operations.
+ */
+int
+sys___systrace(int op, userptr_t buf, size_t len, int32_t *retval)
+{
+	struct systrace_stats *stats;
+	struct systrace_record *recs;
+	unsigned i, n, max, got;
+	int result;
+
+	switch (op) {
+	    case SYSTRACE_OFF:
+	    case SYSTRACE_ON:
+		return systrace_enable(op == SYSTRACE_ON);
+	    case SYSTRACE_RESET:
+		systrace_reset();
+		return 0;
+	    case SYSTRACE_STATS:
+		n = len / sizeof(*stats);
+		if (n > SYSTRACE_NCALLS) {
+			n = SYSTRACE_NCALLS;
+		}
+		stats = kmalloc(SYSTRACE_NCALLS * sizeof(*stats));
+		if (stats == NULL) {
+			return ENOMEM;
+		}
+		systrace_getstats(stats);
+		result = copyout(stats, buf, n * sizeof(*stats));
+		kfree(stats);
+		break;
+	    case SYSTRACE_LOG:
+		n = 0;
+		result = 0;
+		if (systrace_cpus == NULL) {
+			break;
+		}
+		/* Give each CPU an equal share of the space. */
+		max = len / sizeof(*recs) / systrace_ncpus;
+		if (max > SYSTRACE_RINGSIZE) {
+			max = SYSTRACE_RINGSIZE;
+		}
+		if (max == 0) {
+			break;
+		}
+		recs = kmalloc(max * sizeof(*recs));
+		if (recs == NULL) {
+			return ENOMEM;
+		}
+		for (i=0; i<systrace_ncpus; i++) {
+			got = systrace_getlog(systrace_cpus[i], recs, max);
+			result = copyout(recs, buf, got * sizeof(*recs));
+			if (result) {
+				break;
+			}
+			buf += got * sizeof(*recs);
+			n += got;
+		}
+		kfree(recs);
+		break;
+	    default:
+		return EINVAL;
+	}
+	if (result) {
+		return result;
+	}
+	*retval = n;
+	return 0;
+}
@@ -0,0 +1,312 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * User thread system calls.
+ *
+ * The thread bookkeeping lives in the process (see proc.h and
+ * proc.c); each user thread has a slot in the process's thread table,
+ * which also picks its user stack. The kernel allocates the stacks
+ * because there's no other way for user code to get memory for them.
+ *
+ * These are the backends for the pthread calls in libpthread. A new
+ * thread starts at a function in libpthread that's given the thread
+ * function and its argument, calls it, and passes its return value to
+ * __thread_exit.
+ */
+
+#include <types.h>
+#include <kern/errno.h>
+#include <lib.h>
+#include <spinlock.h>
+#include <wchan.h>
+#include <thread.h>
+#include <proc.h>
+#include <current.h>
+#include <addrspace.h>
+#include <copyinout.h>
+#include <syscall.h>
+
+/*
+ * Where a new thread starts in user mode; handed from
+ * sys___thread_create to uthread_start.
+ */
+struct uthread_args {
+	vaddr_t ua_entry;
+	vaddr_t ua_stack;
+	int ua_arg1;
+	userptr_t ua_arg2;
+};
+
+/*
+ * Find thread TID in the current process's table. Call with p_lock
+ * held. Returns NULL if there's no such thread.
+ */
+static
+struct uthread *
+uthread_find(struct proc *proc, unsigned tid)
+{
+	unsigned i;
+
+	KASSERT(spinlock_do_i_hold(&proc->p_lock));
+
+	if (tid == 0) {
+		return NULL;
+	}
+	for (i=0; i<PROC_MAXTHREADS; i++) {
+		if (proc->p_uthreads[i].ut_tid == tid) {
+			return &proc->p_uthreads[i];
+		}
+	}
+	return NULL;
+}
+
+/*
+ * Release a thread table slot. Call with p_lock held.
+ */
+static
+void
+uthread_free(struct uthread *ut)
+{
+	ut->ut_tid = 0;
+	ut->ut_exited = false;
+	ut->ut_detached = false;
+	ut->ut_retval = NULL;
+}
+
+/*
+ * New thread: go to user mode.
+ */
+static
+void
+uthread_start(void *vua, unsigned long slot)
+{
+	struct uthread_args *ua = vua;
+	vaddr_t entry, stack;
+	int arg1;
+	userptr_t arg2;
+
+	entry = ua->ua_entry;
+	stack = ua->ua_stack;
+	arg1 = ua->ua_arg1;
+	arg2 = ua->ua_arg2;
+	kfree(ua);
+
+	curthread->t_uslot = slot;
+
+	/*
+	 * If the process started exiting while we were being created,
+	 * it's too late to go anywhere.
+	 */
+	if (curproc->p_exiting) {
+		proc_exit(0);
+	}
+
+	/* The arguments go where argc and argv would. */
+	enter_new_process(arg1, arg2, NULL, stack, entry);
+}
+
+/*
+ * __thread_create: start a thread at ENTRY(ARG1, ARG2) on a new
+ * stack. Returns the new thread's id.
+ */
+int
+sys___thread_create(userptr_t entry, userptr_t arg1, userptr_t arg2,
+		    int *retval)
+{
+	struct proc *proc = curproc;
+	struct uthread_args *ua;
+	struct uthread *ut;
+	unsigned slot, tid;
+	int result;
+
+	ua = kmalloc(sizeof(*ua));
+	if (ua == NULL) {
+		return ENOMEM;
+	}
+	ua->ua_entry = (vaddr_t)entry;
+	ua->ua_arg1 = (int)(vaddr_t)arg1;
+	ua->ua_arg2 = arg2;
+
+	/*
+	 * Claim a slot. Slot 0 is never reused, even after the main
+	 * thread exits, because argv is on the main stack.
+	 */
+	spinlock_acquire(&proc->p_lock);
+	if (proc->p_exiting) {
+		spinlock_release(&proc->p_lock);
+		kfree(ua);
+		return EINTR;
+	}
+	for (slot=1; slot<PROC_MAXTHREADS; slot++) {
+		if (proc->p_uthreads[slot].ut_tid == 0) {
+			break;
+		}
+	}
+	if (slot == PROC_MAXTHREADS) {
+		spinlock_release(&proc->p_lock);
+		kfree(ua);
+		return EAGAIN;
+	}
+	tid = proc->p_nexttid++;
+	if (proc->p_nexttid == 0) {
+		proc->p_nexttid = 1;
+	}
+	ut = &proc->p_uthreads[slot];
+	uthread_free(ut);
+	ut->ut_tid = tid;
+	/* Count it now so the process can't finish exiting under it. */
+	proc->p_nthreads++;
+	spinlock_release(&proc->p_lock);
+
+	result = as_define_threadstack(proc_getas(), slot, &ua->ua_stack);
+	if (result == 0) {
+		result = thread_fork(curthread->t_name, proc,
+				     uthread_start, ua, slot);
+	}
+	if (result) {
+		kfree(ua);
+		spinlock_acquire(&proc->p_lock);
+		uthread_free(ut);
+		proc->p_nthreads--;
+		spinlock_release(&proc->p_lock);
+		return result;
+	}
+
+	*retval = tid;
+	return 0;
+}
+
+/*
+ * __thread_exit: exit the current thread, leaving RETVAL for
+ * __thread_join.
+ */
+__DEAD
+void
+sys___thread_exit(userptr_t retval)
+{
+	proc_uthread_exit(retval);
+}
+
+/*
+ * __thread_join: wait for thread TID to exit and collect its exit
+ * value. There's no EDEADLK; joining yourself is EINVAL, as is
+ * joining a detached thread.
+ */
+int
+sys___thread_join(unsigned tid, userptr_t retvalp)
+{
+	struct proc *proc = curproc;
+	struct uthread *ut;
+	userptr_t val;
+
+	spinlock_acquire(&proc->p_lock);
+	ut = uthread_find(proc, tid);
+	if (ut == NULL) {
+		spinlock_release(&proc->p_lock);
+		return ESRCH;
+	}
+	if (ut == &proc->p_uthreads[curthread->t_uslot] || ut->ut_detached) {
+		spinlock_release(&proc->p_lock);
+		return EINVAL;
+	}
+	while (!ut->ut_exited) {
+		if (proc->p_exiting) {
+			spinlock_release(&proc->p_lock);
+			return EINTR;
+		}
+		wchan_sleep(proc->p_joinchan, &proc->p_lock);
+
+		/* It might have been joined or detached in the meantime. */
+		if (ut->ut_tid != tid) {
+			spinlock_release(&proc->p_lock);
+			return ESRCH;
+		}
+		if (ut->ut_detached) {
+			spinlock_release(&proc->p_lock);
+			return EINVAL;
+		}
+	}
+	val = ut->ut_retval;
+	uthread_free(ut);
+	spinlock_release(&proc->p_lock);
+
+	if (retvalp != NULL) {
+		return copyout(&val, retvalp, sizeof(val));
+	}
+	return 0;
+}
+
+/*
+ * __thread_detach: nobody will join thread TID; free its slot as soon
+ * as it exits.
+ */
+int
+sys___thread_detach(unsigned tid)
+{
+	struct proc *proc = curproc;
+	struct uthread *ut;
+
+	spinlock_acquire(&proc->p_lock);
+	ut = uthread_find(proc, tid);
+	if (ut == NULL) {
+		spinlock_release(&proc->p_lock);
+		return ESRCH;
+	}
+	if (ut->ut_detached) {
+		spinlock_release(&proc->p_lock);
+		return EINVAL;
+	}
+	if (ut->ut_exited) {
+		uthread_free(ut);
+	}
+	else {
+		ut->ut_detached = true;
+	}
+	/* Send anyone trying to join it away. */
+	wchan_wakeall(proc->p_joinchan, &proc->p_lock);
+	spinlock_release(&proc->p_lock);
+	return 0;
+}
+
+/*
+ * __thread_self: return the current thread's id.
+ */
+int
+sys___thread_self(int *retval)
+{
+	struct proc *proc = curproc;
+
+	KASSERT(curthread->t_uslot >= 0);
+
+	spinlock_acquire(&proc->p_lock);
+	*retval = proc->p_uthreads[curthread->t_uslot].ut_tid;
+	spinlock_release(&proc->p_lock);
+	return 0;
+}
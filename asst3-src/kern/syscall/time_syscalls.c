@@ -28,7 +28,11 @@
  */
 
 #include <types.h>
+#include <kern/errno.h>
 #include <clock.h>
+#include <callout.h>
+#include <proc.h>
+#include <current.h>
 #include <copyinout.h>
 #include <syscall.h>
 
@@ -56,3 +60,173 @@ sys___time(userptr_t user_seconds_ptr, userptr_t user_nanoseconds_ptr)
 
 	return 0;
 }
+
+/*
+ * nanosleep: sleep for the requested time.
+ *
+ * The sleep is done in hardclock ticks, and clocksleep_ticks can come
+ * up short by the part of a tick that had already gone by when we
+ * started, so check the time afterwards and go around again if
+ * necessary.
+ */
+int
+sys_nanosleep(const_userptr_t user_req, userptr_t user_rem)
+{
+	struct timespec req, now, deadline, rem;
+	int result;
+
+	result = copyin(user_req, &req, sizeof(req));
+	if (result) {
+		return result;
+	}
+	if (req.tv_sec < 0 || req.tv_nsec < 0 || req.tv_nsec >= 1000000000) {
+		return EINVAL;
+	}
+
+	gettime(&now);
+	timespec_add(&now, &req, &deadline);
+	while (1) {
+		timespec_sub(&deadline, &now, &rem);
+		if (rem.tv_sec < 0 || (rem.tv_sec == 0 && rem.tv_nsec == 0)) {
+			return 0;
+		}
+		result = clocksleep_ticks(timespec_to_ticks(&rem), true);
+		gettime(&now);
+		if (result) {
+			break;
+		}
+	}
+
+	/* Interrupted by ITIMER_REAL; report the time left. */
+	if (user_rem != NULL) {
+		timespec_sub(&deadline, &now, &rem);
+		if (rem.tv_sec < 0) {
+			rem.tv_sec = 0;
+			rem.tv_nsec = 0;
+		}
+		result = copyout(&rem, user_rem, sizeof(rem));
+		if (result) {
+			return result;
+		}
+	}
+	return EINTR;
+}
+
+/*
+ * Interval timers.
+ *
+ * Only ITIMER_REAL is supported. Since there are no signals, when it
+ * goes off it interrupts any nanosleep in progress in the process, as
+ * a caught SIGALRM would, instead of sending one. The timer itself is
+ * a callout on the wheel of the CPU that last set it; see
+ * itimer_expire in clock.c.
+ */
+
+static
+int
+timeval_to_ticks(const struct timeval *tv, unsigned *ret)
+{
+	struct timespec ts;
+
+	if (tv->tv_sec < 0 || tv->tv_usec < 0 || tv->tv_usec >= 1000000) {
+		return EINVAL;
+	}
+	ts.tv_sec = tv->tv_sec;
+	ts.tv_nsec = tv->tv_usec * 1000;
+	*ret = timespec_to_ticks(&ts);
+	return 0;
+}
+
+static
+void
+ticks_to_timeval(unsigned ticks, struct timeval *ret)
+{
+	struct timespec ts;
+
+	ticks_to_timespec(ticks, &ts);
+	ret->tv_sec = ts.tv_sec;
+	ret->tv_usec = ts.tv_nsec / 1000;
+}
+
+/*
+ * Read the current setting. Call with p_lock held.
+ */
+static
+void
+itimer_get(struct proc *p, struct itimerval *ret)
+{
+	unsigned remaining = 0;
+
+	KASSERT(spinlock_do_i_hold(&p->p_lock));
+
+	if (p->p_itimer_armed) {
+		remaining = callout_remaining(&p->p_itimer);
+		if (remaining == 0) {
+			/* Going off right now */
+			remaining = 1;
+		}
+	}
+	ticks_to_timeval(remaining, &ret->it_value);
+	ticks_to_timeval(p->p_itimer_interval, &ret->it_interval);
+}
+
+int
+sys_getitimer(int which, userptr_t user_curval)
+{
+	struct proc *p = curproc;
+	struct itimerval curval;
+
+	if (which != ITIMER_REAL) {
+		return EINVAL;
+	}
+
+	spinlock_acquire(&p->p_lock);
+	itimer_get(p, &curval);
+	spinlock_release(&p->p_lock);
+
+	return copyout(&curval, user_curval, sizeof(curval));
+}
+
+int
+sys_setitimer(int which, const_userptr_t user_newval, userptr_t user_oldval)
+{
+	struct proc *p = curproc;
+	struct itimerval newval, oldval;
+	unsigned value, interval;
+	int result;
+
+	if (which != ITIMER_REAL) {
+		return EINVAL;
+	}
+
+	result = copyin(user_newval, &newval, sizeof(newval));
+	if (result) {
+		return result;
+	}
+	result = timeval_to_ticks(&newval.it_value, &value);
+	if (result) {
+		return result;
+	}
+	result = timeval_to_ticks(&newval.it_interval, &interval);
+	if (result) {
+		return result;
+	}
+
+	spinlock_acquire(&p->p_lock);
+	itimer_get(p, &oldval);
+	callout_cancel(&p->p_itimer);
+	p->p_itimer_interval = interval;
+	p->p_itimer_armed = (value > 0);
+	if (value > 0) {
+		callout_schedule(&p->p_itimer, value);
+	}
+	spinlock_release(&p->p_lock);
+
+	if (user_oldval != NULL) {
+		result = copyout(&oldval, user_oldval, sizeof(oldval));
+		if (result) {
+			return result;
+		}
+	}
+	return 0;
+}
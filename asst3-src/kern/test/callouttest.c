@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Callout test.
+ */
+
+#include <types.h>
+#include <lib.h>
+#include <spl.h>
+#include <spinlock.h>
+#include <synch.h>
+#include <cpu.h>
+#include <current.h>
+#include <callout.h>
+#include <test.h>
+
+/*
+ * Delays to test with. These include several that land in the same
+ * bucket on different trips around the wheel. The last one gets
+ * cancelled before it fires.
+ */
+static const unsigned delays[] = {
+	1,
+	5,
+	5 + CALLWHEEL_SIZE,
+	3,
+	2 * CALLWHEEL_SIZE + 1,
+	CALLWHEEL_SIZE,
+	20,
+};
+#define NDELAYS (sizeof(delays) / sizeof(delays[0]))
+#define CANCELLED (NDELAYS - 1)
+
+static struct callout cotest_callouts[NDELAYS];
+static unsigned cotest_firedat[NDELAYS];
+static unsigned cotest_order[NDELAYS];
+static unsigned cotest_nfired;
+static struct spinlock cotest_lock = SPINLOCK_INITIALIZER;
+static struct semaphore *cotest_sem;
+
+static
+void
+cotest_fire(void *arg)
+{
+	unsigned n = (uintptr_t)arg;
+
+	spinlock_acquire(&cotest_lock);
+	cotest_firedat[n] = curcpu->c_callwheel.cw_ticks;
+	cotest_order[cotest_nfired++] = n;
+	spinlock_release(&cotest_lock);
+	V(cotest_sem);
+}
+
+int
+callouttest(int nargs, char **args)
+{
+	unsigned start, i, prev;
+	int spl;
+	bool ok = true;
+
+	(void)nargs;
+	(void)args;
+
+	cotest_sem = sem_create("cotest", 0);
+	if (cotest_sem == NULL) {
+		panic("callouttest: sem_create failed\n");
+	}
+	cotest_nfired = 0;
+
+	kprintf("Starting callout test...\n");
+
+	/* Keep the clock off so all the delays count from the same tick. */
+	spl = splhigh();
+	start = curcpu->c_callwheel.cw_ticks;
+	for (i=0; i<NDELAYS; i++) {
+		cotest_firedat[i] = 0;
+		callout_init(&cotest_callouts[i], cotest_fire,
+			     (void *)(uintptr_t)i);
+		callout_schedule(&cotest_callouts[i], delays[i]);
+	}
+	splx(spl);
+
+	if (!callout_cancel(&cotest_callouts[CANCELLED])) {
+		kprintf("callouttest: cancel of pending callout failed\n");
+		ok = false;
+	}
+
+	for (i=0; i<NDELAYS-1; i++) {
+		P(cotest_sem);
+	}
+
+	for (i=0; i<NDELAYS; i++) {
+		if (callout_pending(&cotest_callouts[i])) {
+			kprintf("callouttest: callout %u still pending\n", i);
+			ok = false;
+		}
+	}
+	if (callout_cancel(&cotest_callouts[0])) {
+		kprintf("callouttest: cancel of fired callout succeeded\n");
+		ok = false;
+	}
+
+	spinlock_acquire(&cotest_lock);
+	if (cotest_nfired != NDELAYS-1) {
+		kprintf("callouttest: %u callouts fired, expected %u\n",
+			cotest_nfired, (unsigned)NDELAYS-1);
+		ok = false;
+	}
+	for (i=0; i<NDELAYS-1; i++) {
+		if (cotest_firedat[i] - start != delays[i]) {
+			kprintf("callouttest: callout %u fired after %u ticks,"
+				" expected %u\n", i, cotest_firedat[i] - start,
+				delays[i]);
+			ok = false;
+		}
+	}
+	prev = 0;
+	for (i=0; i<cotest_nfired; i++) {
+		if (delays[cotest_order[i]] < prev) {
+			kprintf("callouttest: callout %u fired out of order\n",
+				cotest_order[i]);
+			ok = false;
+		}
+		prev = delays[cotest_order[i]];
+	}
+	spinlock_release(&cotest_lock);
+
+	sem_destroy(cotest_sem);
+	cotest_sem = NULL;
+
+	kprintf("Callout test %s\n", ok ? "done" : "FAILED");
+	return 0;
+}
@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Priority inheritance tests.
+ *
+ * The classic priority inversion: a low-priority thread holds a lock,
+ * a high-priority thread wants it, and a medium-priority thread that
+ * has nothing to do with the lock hogs the cpu. Without priority
+ * inheritance the low thread can't run to release the lock until the
+ * hog is done, so the high thread waits for the hog. With it, the low
+ * thread runs at high priority until it lets go, and the high thread
+ * waits only for the low thread's critical section.
+ *
+ * pi2 does the same thing with a chain: the high thread waits for a
+ * lock held by a thread (below the hog's priority) that is itself
+ * waiting for the lock the low thread holds. The boost has to pass
+ * along the chain to the low thread.
+ *
+ * Everything runs on one cpu so the threads really compete.
+ */
+
+#include <types.h>
+#include <lib.h>
+#include <clock.h>
+#include <synch.h>
+#include <thread.h>
+#include <cpu.h>
+#include <current.h>
+#include <test.h>
+
+#define PRI_LOW		10
+#define PRI_CHAIN	20
+#define PRI_HOG		30
+#define PRI_HIGH	70
+
+/* How long the low thread holds its lock, and the hog runs, in ms. */
+#define HOLD_MS		200
+#define HOG_MS		3000
+
+static struct lock *pi_locka;		/* The low thread holds this */
+static struct lock *pi_lockb;		/* The chain thread holds this */
+static struct semaphore *pi_ready;
+static struct semaphore *pi_done;
+static volatile bool pi_hogdone;	/* Hog has finished */
+static volatile bool pi_beathog;	/* High thread got in before that */
+static volatile bool pi_ok;
+static struct timespec pi_waited;	/* How long the high thread waited */
+
+static
+unsigned
+pi_elapsed_ms(const struct timespec *start)
+{
+	struct timespec now;
+
+	gettime(&now);
+	timespec_sub(&now, start, &now);
+	return now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/*
+ * Keep the cpu busy for MS milliseconds, without giving it up except
+ * when the timer makes us.
+ */
+static
+void
+pi_spin(unsigned ms)
+{
+	struct timespec start;
+
+	gettime(&start);
+	while (pi_elapsed_ms(&start) < ms) {
+		/* nothing */
+	}
+}
+
+static
+void
+pi_low(void *junk, unsigned long boostedpri)
+{
+	(void)junk;
+
+	thread_setpriority(PRI_LOW);
+	lock_acquire(pi_locka);
+	V(pi_ready);
+	pi_spin(HOLD_MS);
+	if (curthread->t_pri != (int)boostedpri) {
+		kprintf("pitest: low thread ran at priority %d, "
+			"expected %lu\n", curthread->t_pri, boostedpri);
+		pi_ok = false;
+	}
+	lock_release(pi_locka);
+	if (curthread->t_pri != PRI_LOW) {
+		kprintf("pitest: low thread still at priority %d after "
+			"releasing\n", curthread->t_pri);
+		pi_ok = false;
+	}
+	V(pi_done);
+}
+
+static
+void
+pi_chain(void *junk, unsigned long unused)
+{
+	(void)junk;
+	(void)unused;
+
+	thread_setpriority(PRI_CHAIN);
+	lock_acquire(pi_lockb);
+	V(pi_ready);
+	lock_acquire(pi_locka);
+	lock_release(pi_locka);
+	lock_release(pi_lockb);
+	if (curthread->t_pri != PRI_CHAIN) {
+		kprintf("pitest: chain thread still at priority %d after "
+			"releasing\n", curthread->t_pri);
+		pi_ok = false;
+	}
+	V(pi_done);
+}
+
+static
+void
+pi_hog(void *junk, unsigned long unused)
+{
+	(void)junk;
+	(void)unused;
+
+	thread_setpriority(PRI_HOG);
+	pi_spin(HOG_MS);
+	pi_hogdone = true;
+	V(pi_done);
+}
+
+static
+void
+pi_high(void *lock, unsigned long unused)
+{
+	struct timespec start, end;
+
+	(void)unused;
+
+	thread_setpriority(PRI_HIGH);
+	gettime(&start);
+	lock_acquire(lock);
+	gettime(&end);
+	pi_beathog = !pi_hogdone;
+	lock_release(lock);
+	timespec_sub(&end, &start, &pi_waited);
+	V(pi_done);
+}
+
+static
+void
+pi_fork(const char *name, void (*func)(void *, unsigned long),
+	 void *data1, unsigned long data2)
+{
+	int result;
+
+	result = thread_fork(name, NULL, func, data1, data2);
+	if (result) {
+		panic("pitest: thread_fork failed: %s\n", strerror(result));
+	}
+}
+
+static
+void
+pi_run(bool chain)
+{
+	uint32_t oldmask;
+	unsigned i, nthreads, waitms;
+
+	pi_locka = lock_create("pitest-a");
+	pi_lockb = lock_create("pitest-b");
+	pi_ready = sem_create("pitest-ready", 0);
+	pi_done = sem_create("pitest-done", 0);
+	if (pi_locka == NULL || pi_lockb == NULL ||
+	    pi_ready == NULL || pi_done == NULL) {
+		panic("pitest: out of memory\n");
+	}
+	pi_hogdone = false;
+	pi_beathog = false;
+	pi_ok = true;
+
+	/* The children inherit this. */
+	oldmask = thread_getaffinity(curthread);
+	thread_setaffinity(curthread, CPUMASK_BIT(curcpu->c_number));
+
+	pi_fork("pitest-low", pi_low, NULL, PRI_HIGH);
+	P(pi_ready);
+	nthreads = 1;
+	if (chain) {
+		pi_fork("pitest-chain", pi_chain, NULL, 0);
+		P(pi_ready);
+		nthreads++;
+	}
+	pi_fork("pitest-hog", pi_hog, NULL, 0);
+	pi_fork("pitest-high", pi_high, chain ? pi_lockb : pi_locka, 0);
+	nthreads += 2;
+
+	for (i=0; i<nthreads; i++) {
+		P(pi_done);
+	}
+	thread_setaffinity(curthread, oldmask);
+
+	waitms = pi_waited.tv_sec * 1000 + pi_waited.tv_nsec / 1000000;
+	kprintf("High-priority thread waited %u ms (lock held %u ms, "
+		"hog runs %u ms)\n", waitms, HOLD_MS, HOG_MS);
+	if (!pi_beathog || waitms >= HOG_MS) {
+		kprintf("pitest: priority inversion: high thread waited "
+			"for the hog\n");
+		pi_ok = false;
+	}
+
+	sem_destroy(pi_done);
+	sem_destroy(pi_ready);
+	lock_destroy(pi_lockb);
+	lock_destroy(pi_locka);
+	pi_done = pi_ready = NULL;
+	pi_locka = pi_lockb = NULL;
+}
+
+int
+pitest(int nargs, char **args)
+{
+	(void)nargs;
+	(void)args;
+
+	kprintf("Starting priority inheritance test...\n");
+	pi_run(false);
+	kprintf("Priority inheritance test %s\n", pi_ok ? "done" : "FAILED");
+	return 0;
+}
+
+int
+pichaintest(int nargs, char **args)
+{
+	(void)nargs;
+	(void)args;
+
+	kprintf("Starting chained priority inheritance test...\n");
+	pi_run(true);
+	kprintf("Chained priority inheritance test %s\n",
+		pi_ok ? "done" : "FAILED");
+	return 0;
+}
@@ -0,0 +1,460 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#include <types.h>
+#include <lib.h>
+#include <spinlock.h>
+#include <synch.h>
+#include <thread.h>
+#include <current.h>
+#include <clock.h>
+#include <test.h>
+
+/*
+ * Unit tests for reader-writer locks.
+ *
+ * As in semunit.c, each test states its correctness criterion in a
+ * comment at the top, the tests go inside the rwlock abstraction to
+ * check its internal state, and tests that don't crash clean up after
+ * themselves, calling ok() first.
+ *
+ * Several tests fork threads that try to take the lock and then check
+ * (after sleeping long enough for them to have run) whether they got
+ * it. Threads that get it record the order in rwu_log.
+ */
+
+#define NAMESTRING "some-silly-name"
+
+////////////////////////////////////////////////////////////
+// support code
+
+#define RWU_READ	0
+#define RWU_WRITE	1
+#define RWU_MAXLOG	8
+
+static struct spinlock rwu_lock = SPINLOCK_INITIALIZER;
+static char rwu_log[RWU_MAXLOG];
+static unsigned rwu_nlog;
+static unsigned rwu_running;
+
+static
+void
+ok(void)
+{
+	kprintf("Test passed; now cleaning up.\n");
+}
+
+static
+struct rwlock *
+makerwlock(void)
+{
+	struct rwlock *rw;
+
+	rw = rwlock_create(NAMESTRING);
+	if (rw == NULL) {
+		panic("rwunit: whoops: rwlock_create failed\n");
+	}
+	return rw;
+}
+
+/*
+ * A thread that takes the lock, logs that it got it, and lets it go.
+ */
+static
+void
+rwu_sub(void *vrw, unsigned long mode)
+{
+	struct rwlock *rw = vrw;
+
+	if (mode == RWU_READ) {
+		rwlock_acquire_read(rw);
+	}
+	else {
+		rwlock_acquire_write(rw);
+	}
+
+	spinlock_acquire(&rwu_lock);
+	KASSERT(rwu_nlog < RWU_MAXLOG);
+	rwu_log[rwu_nlog++] = (mode == RWU_READ) ? 'r' : 'w';
+	spinlock_release(&rwu_lock);
+
+	if (mode == RWU_READ) {
+		rwlock_release_read(rw);
+	}
+	else {
+		rwlock_release_write(rw);
+	}
+
+	spinlock_acquire(&rwu_lock);
+	KASSERT(rwu_running > 0);
+	rwu_running--;
+	spinlock_release(&rwu_lock);
+}
+
+/*
+ * Start a thread that tries to take the lock, and give it time to
+ * either get it or block.
+ */
+static
+void
+makesub(struct rwlock *rw, unsigned long mode)
+{
+	int result;
+
+	spinlock_acquire(&rwu_lock);
+	rwu_running++;
+	spinlock_release(&rwu_lock);
+
+	result = thread_fork("rwunit sub", NULL, rwu_sub, rw, mode);
+	if (result) {
+		panic("rwunit: thread_fork failed\n");
+	}
+	kprintf("Sleeping for subthread to run\n");
+	clocksleep(1);
+}
+
+static
+void
+resetlog(void)
+{
+	spinlock_acquire(&rwu_lock);
+	KASSERT(rwu_running == 0);
+	rwu_nlog = 0;
+	spinlock_release(&rwu_lock);
+}
+
+/*
+ * Check the log against what we expected, and that the expected
+ * number of subthreads are still waiting.
+ */
+static
+void
+checklog(const char *expected, unsigned nwaiting)
+{
+	unsigned i;
+
+	spinlock_acquire(&rwu_lock);
+	KASSERT(rwu_running == nwaiting);
+	KASSERT(rwu_nlog == strlen(expected));
+	for (i=0; i<rwu_nlog; i++) {
+		KASSERT(rwu_log[i] == expected[i]);
+	}
+	spinlock_release(&rwu_lock);
+}
+
+////////////////////////////////////////////////////////////
+// tests
+
+/*
+ * 1. After a successful rwlock_create:
+ *     - rwlock_name compares equal to the passed-in name
+ *     - rwlock_name is not the same pointer as the passed-in name
+ *     - both wchans are not null
+ *     - there are no readers, no writer, and no waiting writers
+ */
+int
+rwu1(int nargs, char **args)
+{
+	struct rwlock *rw;
+	const char *name = NAMESTRING;
+
+	(void)nargs; (void)args;
+
+	rw = rwlock_create(name);
+	if (rw == NULL) {
+		panic("rwu1: whoops: rwlock_create failed\n");
+	}
+	KASSERT(!strcmp(rw->rwlock_name, name));
+	KASSERT(rw->rwlock_name != name);
+	KASSERT(rw->rw_readwchan != NULL);
+	KASSERT(rw->rw_writewchan != NULL);
+	KASSERT(rw->rw_readers == 0);
+	KASSERT(rw->rw_writer == NULL);
+	KASSERT(rw->rw_writerswaiting == 0);
+
+	ok();
+	rwlock_destroy(rw);
+	return 0;
+}
+
+/*
+ * 2. Passing a null rwlock to rwlock_destroy asserts.
+ */
+int
+rwu2(int nargs, char **args)
+{
+	(void)nargs; (void)args;
+
+	kprintf("This should assert that rw != NULL\n");
+	rwlock_destroy(NULL);
+	panic("rwu2: rwlock_destroy accepted a null rwlock\n");
+	return 0;
+}
+
+/*
+ * 3. Acquiring for reading while only readers hold the lock does not
+ * block, and counts the readers.
+ */
+int
+rwu3(int nargs, char **args)
+{
+	struct rwlock *rw;
+	struct spinlock lk;
+
+	(void)nargs; (void)args;
+
+	rw = makerwlock();
+
+	/*
+	 * Check for blocking by taking a spinlock; if we block while
+	 * holding a spinlock, wchan_sleep will assert.
+	 */
+	spinlock_init(&lk);
+	spinlock_acquire(&lk);
+
+	rwlock_acquire_read(rw);
+	rwlock_acquire_read(rw);
+	KASSERT(rw->rw_readers == 2);
+	KASSERT(rw->rw_writer == NULL);
+
+	rwlock_release_read(rw);
+	rwlock_release_read(rw);
+	KASSERT(rw->rw_readers == 0);
+
+	ok();
+	spinlock_release(&lk);
+	spinlock_cleanup(&lk);
+	rwlock_destroy(rw);
+	return 0;
+}
+
+/*
+ * 4. Acquiring for writing while nobody holds the lock does not
+ * block, and records the writer.
+ */
+int
+rwu4(int nargs, char **args)
+{
+	struct rwlock *rw;
+	struct spinlock lk;
+
+	(void)nargs; (void)args;
+
+	rw = makerwlock();
+
+	/* As above, check for improper blocking by taking a spinlock. */
+	spinlock_init(&lk);
+	spinlock_acquire(&lk);
+
+	rwlock_acquire_write(rw);
+	KASSERT(rw->rw_writer == curthread);
+	KASSERT(rw->rw_readers == 0);
+	KASSERT(rw->rw_writerswaiting == 0);
+	KASSERT(rwlock_do_i_hold_write(rw));
+
+	rwlock_release_write(rw);
+	KASSERT(rw->rw_writer == NULL);
+	KASSERT(!rwlock_do_i_hold_write(rw));
+
+	ok();
+	spinlock_release(&lk);
+	spinlock_cleanup(&lk);
+	rwlock_destroy(rw);
+	return 0;
+}
+
+/*
+ * 5. A writer blocks while a reader holds the lock, and gets it once
+ * the reader lets go.
+ */
+int
+rwu5(int nargs, char **args)
+{
+	struct rwlock *rw;
+
+	(void)nargs; (void)args;
+
+	rw = makerwlock();
+	resetlog();
+
+	rwlock_acquire_read(rw);
+	makesub(rw, RWU_WRITE);
+	KASSERT(rw->rw_writerswaiting == 1);
+	checklog("", 1);
+
+	rwlock_release_read(rw);
+	clocksleep(1);
+	checklog("w", 0);
+
+	ok();
+	rwlock_destroy(rw);
+	return 0;
+}
+
+/*
+ * 6. A reader blocks while a writer holds the lock, and gets it once
+ * the writer lets go.
+ */
+int
+rwu6(int nargs, char **args)
+{
+	struct rwlock *rw;
+
+	(void)nargs; (void)args;
+
+	rw = makerwlock();
+	resetlog();
+
+	rwlock_acquire_write(rw);
+	makesub(rw, RWU_READ);
+	KASSERT(rw->rw_readers == 0);
+	checklog("", 1);
+
+	rwlock_release_write(rw);
+	clocksleep(1);
+	checklog("r", 0);
+
+	ok();
+	rwlock_destroy(rw);
+	return 0;
+}
+
+/*
+ * 7. Writer preference: while a writer is waiting, a new reader
+ * blocks even though only readers hold the lock. When the readers
+ * let go the writer goes first.
+ */
+int
+rwu7(int nargs, char **args)
+{
+	struct rwlock *rw;
+
+	(void)nargs; (void)args;
+
+	rw = makerwlock();
+	resetlog();
+
+	rwlock_acquire_read(rw);
+	makesub(rw, RWU_WRITE);
+	makesub(rw, RWU_READ);
+	KASSERT(rw->rw_readers == 1);
+	KASSERT(rw->rw_writerswaiting == 1);
+	checklog("", 2);
+
+	rwlock_release_read(rw);
+	clocksleep(1);
+	checklog("wr", 0);
+
+	ok();
+	rwlock_destroy(rw);
+	return 0;
+}
+
+/*
+ * 8. When a writer releases the lock, waiting writers get it before
+ * waiting readers, and then all the waiting readers get it.
+ */
+int
+rwu8(int nargs, char **args)
+{
+	struct rwlock *rw;
+
+	(void)nargs; (void)args;
+
+	rw = makerwlock();
+	resetlog();
+
+	rwlock_acquire_write(rw);
+	makesub(rw, RWU_READ);
+	makesub(rw, RWU_READ);
+	makesub(rw, RWU_WRITE);
+	KASSERT(rw->rw_writerswaiting == 1);
+	checklog("", 3);
+
+	rwlock_release_write(rw);
+	clocksleep(1);
+	checklog("wrr", 0);
+
+	ok();
+	rwlock_destroy(rw);
+	return 0;
+}
+
+/*
+ * 9. Releasing a read lock that isn't held asserts.
+ */
+int
+rwu9(int nargs, char **args)
+{
+	struct rwlock *rw;
+
+	(void)nargs; (void)args;
+
+	kprintf("This should assert that rw_readers > 0\n");
+	rw = makerwlock();
+	rwlock_release_read(rw);
+	panic("rwu9: rwlock_release_read tolerated an unheld lock\n");
+	return 0;
+}
+
+/*
+ * 10. Releasing a write lock we don't hold asserts.
+ */
+int
+rwu10(int nargs, char **args)
+{
+	struct rwlock *rw;
+
+	(void)nargs; (void)args;
+
+	kprintf("This should assert that rw_writer == curthread\n");
+	rw = makerwlock();
+	rwlock_release_write(rw);
+	panic("rwu10: rwlock_release_write tolerated an unheld lock\n");
+	return 0;
+}
+
+/*
+ * 11. Destroying an rwlock that's held asserts.
+ */
+int
+rwu11(int nargs, char **args)
+{
+	struct rwlock *rw;
+
+	(void)nargs; (void)args;
+
+	kprintf("This should assert that rw_readers == 0\n");
+	rw = makerwlock();
+	rwlock_acquire_read(rw);
+	rwlock_destroy(rw);
+	panic("rwu11: rwlock_destroy tolerated a held lock\n");
+	return 0;
+}
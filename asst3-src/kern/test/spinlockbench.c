@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Spinlock benchmark.
+ *
+ * For each kind of spinlock (test-and-set and ticket), and for 1, 2,
+ * 4, and 8 cpus (as many of those as there are), run one thread
+ * pinned to each cpu in use, all taking and dropping the same
+ * spinlock SPLBENCH_LOOPS times around a short critical section.
+ * Report the throughput and the longest any one acquisition had to
+ * wait. With the ticket lock the longest wait should stay around one
+ * critical section per other cpu; with test-and-set an unlucky cpu
+ * can lose the race over and over.
+ *
+ * Wait times are in cpu cycles, from cpu_getcycles. Each thread stays
+ * on its own cpu, so its clock readings are comparable.
+ */
+
+#include <types.h>
+#include <lib.h>
+#include <clock.h>
+#include <spinlock.h>
+#include <synch.h>
+#include <thread.h>
+#include <cpu.h>
+#include <current.h>
+#include <test.h>
+
+#define SPLBENCH_LOOPS		5000
+#define SPLBENCH_HOLD		20	/* Loop iterations inside the lock */
+#define SPLBENCH_MAXCPUS	8
+
+static struct spinlock splbench_lock;
+static volatile unsigned long splbench_count;
+static uint64_t splbench_maxwait[SPLBENCH_MAXCPUS];
+static struct semaphore *splbench_ready;
+static struct semaphore *splbench_go;
+static struct semaphore *splbench_done;
+
+static
+void
+splbenchthread(void *junk, unsigned long cpunum)
+{
+	uint64_t start, wait, maxwait;
+	volatile int j;
+	int i, result;
+
+	(void)junk;
+
+	result = thread_setaffinity(curthread, CPUMASK_BIT(cpunum));
+	if (result) {
+		panic("splbench: thread_setaffinity: %s\n", strerror(result));
+	}
+	V(splbench_ready);
+	P(splbench_go);
+
+	maxwait = 0;
+	for (i=0; i<SPLBENCH_LOOPS; i++) {
+		start = cpu_getcycles();
+		spinlock_acquire(&splbench_lock);
+		wait = cpu_cycles_since(start);
+		splbench_count++;
+		for (j=0; j<SPLBENCH_HOLD; j++);
+		spinlock_release(&splbench_lock);
+		if (wait > maxwait) {
+			maxwait = wait;
+		}
+	}
+	splbench_maxwait[cpunum] = maxwait;
+	V(splbench_done);
+}
+
+static
+void
+splbench_run(bool ticket, unsigned ncpus)
+{
+	struct timespec ts1, ts2;
+	uint64_t count, ns, maxwait;
+	unsigned i;
+	int result;
+
+	if (ticket) {
+		spinlock_init_ticket(&splbench_lock);
+	}
+	else {
+		spinlock_init(&splbench_lock);
+	}
+	splbench_count = 0;
+
+	for (i=0; i<ncpus; i++) {
+		result = thread_fork("splbench", NULL, splbenchthread,
+				     NULL, i);
+		if (result) {
+			panic("splbench: thread_fork failed: %s\n",
+			      strerror(result));
+		}
+	}
+	for (i=0; i<ncpus; i++) {
+		P(splbench_ready);
+	}
+
+	gettime(&ts1);
+	for (i=0; i<ncpus; i++) {
+		V(splbench_go);
+	}
+	for (i=0; i<ncpus; i++) {
+		P(splbench_done);
+	}
+	gettime(&ts2);
+
+	spinlock_cleanup(&splbench_lock);
+
+	count = (uint64_t)ncpus * SPLBENCH_LOOPS;
+	if (splbench_count != count) {
+		kprintf("splbench: count is %lu, expected %llu\n",
+			splbench_count, count);
+		kprintf("Test failed\n");
+	}
+
+	maxwait = 0;
+	for (i=0; i<ncpus; i++) {
+		if (splbench_maxwait[i] > maxwait) {
+			maxwait = splbench_maxwait[i];
+		}
+	}
+
+	timespec_sub(&ts2, &ts1, &ts2);
+	ns = ts2.tv_sec * 1000000000ULL + ts2.tv_nsec;
+	if (ns == 0) {
+		ns = 1;
+	}
+	kprintf("%-6s %u cpus: %llu acquisitions/sec, max wait %llu cycles\n",
+		ticket ? "ticket" : "tas", ncpus,
+		count * 1000000000ULL / ns, maxwait);
+}
+
+int
+spinlockbench(int nargs, char **args)
+{
+	unsigned ncpus, maxcpus;
+
+	(void)nargs;
+	(void)args;
+
+	splbench_ready = sem_create("splbench_ready", 0);
+	splbench_go = sem_create("splbench_go", 0);
+	splbench_done = sem_create("splbench_done", 0);
+	if (splbench_ready == NULL || splbench_go == NULL ||
+	    splbench_done == NULL) {
+		panic("splbench: sem_create failed\n");
+	}
+
+	kprintf("Starting spinlock benchmark...\n");
+
+	maxcpus = cpu_count();
+	if (maxcpus > SPLBENCH_MAXCPUS) {
+		maxcpus = SPLBENCH_MAXCPUS;
+	}
+	for (ncpus = 1; ncpus <= maxcpus; ncpus *= 2) {
+		splbench_run(false, ncpus);
+		splbench_run(true, ncpus);
+	}
+
+	sem_destroy(splbench_done);
+	sem_destroy(splbench_go);
+	sem_destroy(splbench_ready);
+	splbench_done = splbench_go = splbench_ready = NULL;
+
+	kprintf("Spinlock benchmark done.\n");
+	return 0;
+}
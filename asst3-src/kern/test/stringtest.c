@@ -0,0 +1,390 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Tests for the word-at-a-time string functions in common/libc/string.
+ *
+ * str1 is a fuzzer: it runs memcpy, memmove, memset, bzero, and
+ * strlen with random lengths and random alignments of source and
+ * destination, including overlapping memmoves in both directions,
+ * and checks each result byte-for-byte against a plain byte loop run
+ * on a second copy of the same data. The buffers have margins so
+ * writing outside the requested range is caught too.
+ *
+ * str2 is a benchmark: for a range of sizes, with the buffers
+ * aligned and misaligned, it reports cpu cycles (from cpu_getcycles,
+ * which keeps counting across clock ticks) per call for each function
+ * and for the byte loop it replaced.
+ */
+
+#include <types.h>
+#include <lib.h>
+#include <cpu.h>
+#include <vm.h> /* for PAGE_SIZE */
+#include <test.h>
+
+#define STRFUZZ_LOOPS	20000
+#define STRFUZZ_BUFSIZE	(2 * PAGE_SIZE + 256)
+#define STRFUZZ_MAXLEN	(PAGE_SIZE + 64)
+
+#define STRBENCH_LOOPS	64
+#define STRBENCH_BUFSIZE (PAGE_SIZE + 64)
+
+/*
+ * Reference versions: the obvious byte loops. The volatile keeps the
+ * compiler from recognizing them and calling the functions under test.
+ */
+
+static
+void
+ref_memcpy(void *dst, const void *src, size_t len)
+{
+	volatile unsigned char *d = dst;
+	const volatile unsigned char *s = src;
+	size_t i;
+
+	for (i=0; i<len; i++) {
+		d[i] = s[i];
+	}
+}
+
+static
+void
+ref_memmove(void *dst, const void *src, size_t len)
+{
+	volatile unsigned char *d = dst;
+	const volatile unsigned char *s = src;
+	size_t i;
+
+	if ((uintptr_t)dst < (uintptr_t)src) {
+		for (i=0; i<len; i++) {
+			d[i] = s[i];
+		}
+	}
+	else {
+		for (i=len; i>0; i--) {
+			d[i-1] = s[i-1];
+		}
+	}
+}
+
+static
+void
+ref_memset(void *ptr, int ch, size_t len)
+{
+	volatile unsigned char *p = ptr;
+	size_t i;
+
+	for (i=0; i<len; i++) {
+		p[i] = ch;
+	}
+}
+
+static
+size_t
+ref_strlen(const char *str)
+{
+	const volatile char *p = str;
+	size_t ret = 0;
+
+	while (p[ret]) {
+		ret++;
+	}
+	return ret;
+}
+
+////////////////////////////////////////////////////////////
+// str1
+
+/*
+ * Pick a length: mostly short, sometimes up to a page and a bit, to
+ * get both the byte paths and the block paths.
+ */
+static
+size_t
+strfuzz_len(void)
+{
+	switch (random() % 4) {
+	    case 0:
+		return random() % STRFUZZ_MAXLEN;
+	    case 1:
+		return PAGE_SIZE - 8 + random() % 16;
+	    default:
+		return random() % 80;
+	}
+}
+
+static
+void
+strfuzz_fill(unsigned char *a, unsigned char *b)
+{
+	size_t i;
+
+	for (i=0; i<STRFUZZ_BUFSIZE; i++) {
+		a[i] = b[i] = random();
+	}
+}
+
+/*
+ * Compare the buffers; there's no memcmp in the kernel.
+ */
+static
+bool
+strfuzz_same(const unsigned char *a, const unsigned char *b)
+{
+	size_t i;
+
+	for (i=0; i<STRFUZZ_BUFSIZE; i++) {
+		if (a[i] != b[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int
+stringtest(int nargs, char **args)
+{
+	unsigned char *a, *b;
+	size_t len, soff, doff, n, i;
+	unsigned op, failures;
+	int ch;
+
+	(void)nargs;
+	(void)args;
+
+	a = kmalloc(STRFUZZ_BUFSIZE);
+	b = kmalloc(STRFUZZ_BUFSIZE);
+	if (a == NULL || b == NULL) {
+		kprintf("stringtest: Out of memory\n");
+		kfree(a);
+		kfree(b);
+		return 0;
+	}
+
+	kprintf("Starting string function fuzzer...\n");
+
+	failures = 0;
+	for (i=0; i<STRFUZZ_LOOPS; i++) {
+		strfuzz_fill(a, b);
+		len = strfuzz_len();
+		soff = random() % 16;
+		doff = random() % 16;
+		op = random() % 5;
+
+		switch (op) {
+		    case 0:
+			/* non-overlapping: source in the upper part */
+			memcpy(a + doff, a + STRFUZZ_MAXLEN + 32 + soff, len);
+			ref_memcpy(b + doff, b + STRFUZZ_MAXLEN + 32 + soff,
+				   len);
+			break;
+		    case 1:
+			/* overlapping, in either direction */
+			soff = random() % 128;
+			doff = random() % 128;
+			memmove(a + doff, a + soff, len);
+			ref_memmove(b + doff, b + soff, len);
+			break;
+		    case 2:
+			ch = random();
+			memset(a + doff, ch, len);
+			ref_memset(b + doff, ch, len);
+			break;
+		    case 3:
+			bzero(a + doff, len);
+			ref_memset(b + doff, 0, len);
+			break;
+		    case 4:
+			/* no zeros before the end, then a zero */
+			for (n=0; n<len; n++) {
+				if (a[soff + n] == 0) {
+					a[soff + n] = b[soff + n] = 1;
+				}
+			}
+			a[soff + len] = b[soff + len] = 0;
+			n = strlen((char *)a + soff);
+			if (n != ref_strlen((char *)b + soff)) {
+				kprintf("strlen: offset %zu length %zu: "
+					"got %zu\n", soff, len, n);
+				failures++;
+			}
+			break;
+		}
+
+		if (!strfuzz_same(a, b)) {
+			kprintf("op %u: src offset %zu, dest offset %zu, "
+				"length %zu: wrong result\n",
+				op, soff, doff, len);
+			failures++;
+		}
+		if (failures > 10) {
+			kprintf("Too many failures; giving up\n");
+			break;
+		}
+		if (i % 1000 == 0) {
+			kprintf(".");
+		}
+	}
+	kprintf("\n");
+
+	kfree(a);
+	kfree(b);
+
+	if (failures) {
+		kprintf("String function fuzzer: %u failures\n", failures);
+		kprintf("Test failed\n");
+	}
+	else {
+		kprintf("String function fuzzer done.\n");
+	}
+	return 0;
+}
+
+////////////////////////////////////////////////////////////
+// str2
+
+static const size_t strbench_sizes[] = { 16, 64, 256, 1024, PAGE_SIZE };
+
+/* Offsets of the destination and source from word alignment */
+static const struct {
+	size_t doff, soff;
+} strbench_aligns[] = {
+	{ 0, 0 },
+	{ 1, 1 },
+	{ 0, 3 },
+};
+
+static
+void
+strbench_report(const char *name, size_t size, size_t doff, size_t soff,
+		uint64_t cycles, uint64_t refcycles)
+{
+	if (cycles == 0) {
+		cycles = 1;
+	}
+	kprintf("%-7s %5zu +%zu/+%zu: %7llu cycles/call, byte loop %7llu "
+		"(%llu.%02llux)\n", name, size, doff, soff,
+		cycles / STRBENCH_LOOPS, refcycles / STRBENCH_LOOPS,
+		refcycles / cycles, (refcycles % cycles) * 100 / cycles);
+}
+
+int
+stringbench(int nargs, char **args)
+{
+	unsigned char *a, *b;
+	size_t size, doff, soff;
+	uint64_t start, cycles, refcycles;
+	unsigned i, j, k;
+
+	(void)nargs;
+	(void)args;
+
+	a = kmalloc(STRBENCH_BUFSIZE);
+	b = kmalloc(STRBENCH_BUFSIZE);
+	if (a == NULL || b == NULL) {
+		kprintf("stringbench: Out of memory\n");
+		kfree(a);
+		kfree(b);
+		return 0;
+	}
+
+	kprintf("Starting string function benchmark...\n");
+
+	for (i=0; i<ARRAYCOUNT(strbench_sizes); i++) {
+		size = strbench_sizes[i];
+		for (j=0; j<ARRAYCOUNT(strbench_aligns); j++) {
+			doff = strbench_aligns[j].doff;
+			soff = strbench_aligns[j].soff;
+
+			start = cpu_getcycles();
+			for (k=0; k<STRBENCH_LOOPS; k++) {
+				memcpy(a + doff, b + soff, size);
+			}
+			cycles = cpu_cycles_since(start);
+			start = cpu_getcycles();
+			for (k=0; k<STRBENCH_LOOPS; k++) {
+				ref_memcpy(a + doff, b + soff, size);
+			}
+			refcycles = cpu_cycles_since(start);
+			strbench_report("memcpy", size, doff, soff,
+					cycles, refcycles);
+
+			/* overlapping, so it has to go backwards */
+			start = cpu_getcycles();
+			for (k=0; k<STRBENCH_LOOPS; k++) {
+				memmove(a + 32 + doff, a + soff, size);
+			}
+			cycles = cpu_cycles_since(start);
+			start = cpu_getcycles();
+			for (k=0; k<STRBENCH_LOOPS; k++) {
+				ref_memmove(a + 32 + doff, a + soff, size);
+			}
+			refcycles = cpu_cycles_since(start);
+			strbench_report("memmove", size, doff, soff,
+					cycles, refcycles);
+		}
+
+		/* memset and strlen only have the one pointer */
+		for (doff=0; doff<2; doff++) {
+			start = cpu_getcycles();
+			for (k=0; k<STRBENCH_LOOPS; k++) {
+				memset(a + doff, 'x', size);
+			}
+			cycles = cpu_cycles_since(start);
+			start = cpu_getcycles();
+			for (k=0; k<STRBENCH_LOOPS; k++) {
+				ref_memset(a + doff, 'x', size);
+			}
+			refcycles = cpu_cycles_since(start);
+			strbench_report("memset", size, doff, 0,
+					cycles, refcycles);
+
+			a[doff + size - 1] = 0;
+			start = cpu_getcycles();
+			for (k=0; k<STRBENCH_LOOPS; k++) {
+				(void)strlen((char *)a + doff);
+			}
+			cycles = cpu_cycles_since(start);
+			start = cpu_getcycles();
+			for (k=0; k<STRBENCH_LOOPS; k++) {
+				(void)ref_strlen((char *)a + doff);
+			}
+			refcycles = cpu_cycles_since(start);
+			strbench_report("strlen", size, doff, 0,
+					cycles, refcycles);
+		}
+	}
+
+	kfree(a);
+	kfree(b);
+
+	kprintf("String function benchmark done.\n");
+	return 0;
+}
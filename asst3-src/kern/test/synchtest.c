@@ -36,6 +36,8 @@
 #include <lib.h>
 #include <clock.h>
 #include <thread.h>
+#include <cpu.h>
+#include <current.h>
 #include <synch.h>
 #include <test.h>
 
@@ -221,6 +223,322 @@ locktest(int nargs, char **args)
 	return 0;
 }
 
+/*
+ * Lock benchmark.
+ *
+ * Measures how fast a contended lock changes hands. For 1, 2, 4, and
+ * 8 cpus (as many of those as there are), start LOCKBENCH_PERCPU
+ * threads pinned to each cpu in use, and have them all take and drop
+ * testlock LOCKBENCH_LOOPS times around a short critical section.
+ * Report the throughput and the average time per acquisition.
+ */
+
+#define LOCKBENCH_LOOPS		2000
+#define LOCKBENCH_PERCPU	2
+#define LOCKBENCH_MAXCPUS	8
+
+static struct semaphore *lockbench_ready;
+static struct semaphore *lockbench_go;
+
+static
+void
+lockbenchthread(void *junk, unsigned long cpunum)
+{
+	int i, result;
+	(void)junk;
+
+	result = thread_setaffinity(curthread, CPUMASK_BIT(cpunum));
+	if (result) {
+		panic("lockbench: thread_setaffinity: %s\n",
+		      strerror(result));
+	}
+	V(lockbench_ready);
+	P(lockbench_go);
+
+	for (i=0; i<LOCKBENCH_LOOPS; i++) {
+		lock_acquire(testlock);
+		testval1++;
+		lock_release(testlock);
+	}
+	V(donesem);
+}
+
+static
+void
+lockbench_run(unsigned ncpus)
+{
+	struct timespec ts1, ts2;
+	unsigned i, nthreads;
+	uint64_t ns, count;
+	int result;
+
+	nthreads = ncpus * LOCKBENCH_PERCPU;
+	testval1 = 0;
+	for (i=0; i<nthreads; i++) {
+		result = thread_fork("lockbench", NULL, lockbenchthread,
+				     NULL, i % ncpus);
+		if (result) {
+			panic("lockbench: thread_fork failed: %s\n",
+			      strerror(result));
+		}
+	}
+	for (i=0; i<nthreads; i++) {
+		P(lockbench_ready);
+	}
+
+	gettime(&ts1);
+	for (i=0; i<nthreads; i++) {
+		V(lockbench_go);
+	}
+	for (i=0; i<nthreads; i++) {
+		P(donesem);
+	}
+	gettime(&ts2);
+
+	count = (uint64_t)nthreads * LOCKBENCH_LOOPS;
+	if (testval1 != count) {
+		kprintf("lockbench: count is %lu, expected %llu\n",
+			testval1, count);
+		kprintf("Test failed\n");
+	}
+
+	timespec_sub(&ts2, &ts1, &ts2);
+	ns = ts2.tv_sec * 1000000000ULL + ts2.tv_nsec;
+	if (ns == 0) {
+		ns = 1;
+	}
+	kprintf("%u cpus, %u threads: %llu acquisitions in %llu.%09lu "
+		"seconds\n", ncpus, nthreads, count,
+		ts2.tv_sec, (unsigned long)ts2.tv_nsec);
+	kprintf("    %llu per second, %llu ns per acquisition\n",
+		count * 1000000000ULL / ns, ns / count);
+}
+
+int
+lockbench(int nargs, char **args)
+{
+	unsigned ncpus, maxcpus;
+
+	(void)nargs;
+	(void)args;
+
+	inititems();
+	lockbench_ready = sem_create("lockbench_ready", 0);
+	lockbench_go = sem_create("lockbench_go", 0);
+	if (lockbench_ready == NULL || lockbench_go == NULL) {
+		panic("lockbench: sem_create failed\n");
+	}
+
+	kprintf("Starting lock benchmark...\n");
+
+	maxcpus = cpu_count();
+	if (maxcpus > LOCKBENCH_MAXCPUS) {
+		maxcpus = LOCKBENCH_MAXCPUS;
+	}
+	for (ncpus = 1; ncpus <= maxcpus; ncpus *= 2) {
+		lockbench_run(ncpus);
+	}
+
+	sem_destroy(lockbench_go);
+	sem_destroy(lockbench_ready);
+	lockbench_go = lockbench_ready = NULL;
+
+	kprintf("Lock benchmark done.\n");
+	return 0;
+}
+
+/*
+ * Fairness and throughput of the sleeping primitives.
+ *
+ * FAIRBENCH_THREADS threads take turns through a semaphore used as a
+ * mutex (and then through a lock), yielding while inside so the
+ * others have to go to sleep, until FAIRBENCH_TOTAL passes have been
+ * made between them. With FIFO hand-off every thread should get very
+ * nearly the same share; we print the smallest and largest.
+ *
+ * Then CVBENCH_WAITERS threads wait on a CV, and we broadcast to them
+ * CVBENCH_ROUNDS times, waiting each time until all of them have got
+ * through the lock. This measures how fast a broadcast drains.
+ */
+
+#define FAIRBENCH_THREADS	8
+#define FAIRBENCH_TOTAL		2000
+#define CVBENCH_WAITERS		8
+#define CVBENCH_ROUNDS		200
+
+static struct semaphore *fairsem;
+static unsigned fair_counts[FAIRBENCH_THREADS];
+static volatile unsigned fair_total;
+static volatile unsigned cvbench_gen, cvbench_passed;
+static struct semaphore *cvbench_roundsem;
+
+static
+void
+fairthread(void *junk, unsigned long num)
+{
+	bool uselock = (junk != NULL);
+	bool done = false;
+
+	while (!done) {
+		if (uselock) {
+			lock_acquire(testlock);
+		}
+		else {
+			P(fairsem);
+		}
+		if (fair_total < FAIRBENCH_TOTAL) {
+			fair_total++;
+			fair_counts[num]++;
+			/* Make the others wait for us. */
+			thread_yield();
+		}
+		else {
+			done = true;
+		}
+		if (uselock) {
+			lock_release(testlock);
+		}
+		else {
+			V(fairsem);
+		}
+	}
+	V(donesem);
+}
+
+static
+void
+fairbench_run(bool uselock)
+{
+	struct timespec ts1, ts2;
+	unsigned i, min, max;
+	int result;
+
+	fair_total = 0;
+	for (i=0; i<FAIRBENCH_THREADS; i++) {
+		fair_counts[i] = 0;
+	}
+
+	gettime(&ts1);
+	for (i=0; i<FAIRBENCH_THREADS; i++) {
+		result = thread_fork("fairbench", NULL, fairthread,
+				     uselock ? testlock : NULL, i);
+		if (result) {
+			panic("synchbench: thread_fork failed: %s\n",
+			      strerror(result));
+		}
+	}
+	for (i=0; i<FAIRBENCH_THREADS; i++) {
+		P(donesem);
+	}
+	gettime(&ts2);
+	timespec_sub(&ts2, &ts1, &ts2);
+
+	min = max = fair_counts[0];
+	for (i=1; i<FAIRBENCH_THREADS; i++) {
+		if (fair_counts[i] < min) {
+			min = fair_counts[i];
+		}
+		if (fair_counts[i] > max) {
+			max = fair_counts[i];
+		}
+	}
+	kprintf("%s: %u passes in %llu.%09lu seconds; "
+		"per thread min %u, max %u (fair share %u)\n",
+		uselock ? "lock" : "semaphore", fair_total,
+		ts2.tv_sec, (unsigned long)ts2.tv_nsec,
+		min, max, FAIRBENCH_TOTAL / FAIRBENCH_THREADS);
+}
+
+static
+void
+cvbenchthread(void *junk, unsigned long num)
+{
+	unsigned gen = 0;
+
+	(void)junk;
+	(void)num;
+
+	lock_acquire(testlock);
+	while (gen < CVBENCH_ROUNDS) {
+		while (cvbench_gen == gen) {
+			cv_wait(testcv, testlock);
+		}
+		gen = cvbench_gen;
+		cvbench_passed++;
+		if (cvbench_passed == CVBENCH_WAITERS) {
+			V(cvbench_roundsem);
+		}
+	}
+	lock_release(testlock);
+	V(donesem);
+}
+
+static
+void
+cvbench_run(void)
+{
+	struct timespec ts1, ts2;
+	unsigned i;
+	uint64_t ns;
+	int result;
+
+	cvbench_gen = 0;
+	for (i=0; i<CVBENCH_WAITERS; i++) {
+		result = thread_fork("cvbench", NULL, cvbenchthread, NULL, i);
+		if (result) {
+			panic("synchbench: thread_fork failed: %s\n",
+			      strerror(result));
+		}
+	}
+
+	gettime(&ts1);
+	for (i=0; i<CVBENCH_ROUNDS; i++) {
+		lock_acquire(testlock);
+		cvbench_passed = 0;
+		cvbench_gen++;
+		cv_broadcast(testcv, testlock);
+		lock_release(testlock);
+		P(cvbench_roundsem);
+	}
+	gettime(&ts2);
+	for (i=0; i<CVBENCH_WAITERS; i++) {
+		P(donesem);
+	}
+
+	timespec_sub(&ts2, &ts1, &ts2);
+	ns = ts2.tv_sec * 1000000000ULL + ts2.tv_nsec;
+	kprintf("cv: %u broadcasts to %u waiters in %llu.%09lu seconds, "
+		"%llu ns per wakeup\n", CVBENCH_ROUNDS, CVBENCH_WAITERS,
+		ts2.tv_sec, (unsigned long)ts2.tv_nsec,
+		ns / (CVBENCH_ROUNDS * CVBENCH_WAITERS));
+}
+
+int
+synchbench(int nargs, char **args)
+{
+	(void)nargs;
+	(void)args;
+
+	inititems();
+	fairsem = sem_create("fairsem", 1);
+	cvbench_roundsem = sem_create("cvbench_roundsem", 0);
+	if (fairsem == NULL || cvbench_roundsem == NULL) {
+		panic("synchbench: sem_create failed\n");
+	}
+
+	kprintf("Starting synch fairness benchmark...\n");
+	fairbench_run(false);
+	fairbench_run(true);
+	cvbench_run();
+
+	sem_destroy(cvbench_roundsem);
+	sem_destroy(fairsem);
+	cvbench_roundsem = fairsem = NULL;
+
+	kprintf("Synch fairness benchmark done.\n");
+	return 0;
+}
+
 static
 void
 cvtestthread(void *junk, unsigned long num)
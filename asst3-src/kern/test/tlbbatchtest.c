@@ -0,0 +1,324 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Batched TLB shootdown test.
+ *
+ * Make an address space and load it on this cpu (cpu 0) and on every
+ * odd-numbered cpu, by having a thread pinned to each join a scratch
+ * process and as_activate it. Each also plants TLB entries for a few
+ * of its pages. Then:
+ *
+ *   - as_cpus should name exactly those cpus;
+ *
+ *   - a batched flush of those pages should queue exactly one batch
+ *     on each of the other loaded cpus and none anywhere else, and
+ *     should come back only once they've all done it;
+ *
+ *   - afterwards none of the planted entries should be left, here or
+ *     on the other cpus;
+ *
+ *   - a batch too big to hold, which becomes a flush of the whole
+ *     address space, should be sent the same way.
+ *
+ * Shootdowns are counted with the per-cpu c_shootdown_reqs, so nothing
+ * else should be doing shootdowns while this runs.
+ */
+
+#include <types.h>
+#include <lib.h>
+#include <spl.h>
+#include <cpu.h>
+#include <thread.h>
+#include <current.h>
+#include <synch.h>
+#include <proc.h>
+#include <pid.h>
+#include <addrspace.h>
+#include <vm.h>
+#include <machine/tlb.h>
+#include <test.h>
+
+#define TLBBT_PAGES	4
+#define TLBBT_BASE	0x00400000
+#define TLBBT_MAXCPUS	32
+
+static struct semaphore *tlbbt_ready;
+static struct semaphore *tlbbt_go;
+static struct semaphore *tlbbt_done;
+static unsigned tlbbt_left[TLBBT_MAXCPUS];	/* Entries left after */
+static bool tlbbt_failed;
+
+static
+uint32_t
+tlbbt_entryhi(struct addrspace *as, unsigned page)
+{
+	return ((TLBBT_BASE + page * PAGE_SIZE) & PAGE_FRAME) | as->id;
+}
+
+/*
+ * Join PROC long enough to load its address space on this cpu, and
+ * plant an (invalid) TLB entry for each test page.
+ */
+static
+void
+tlbbt_load(struct proc *proc)
+{
+	struct addrspace *as;
+	uint32_t hi;
+	unsigned i;
+	int result, slot, spl;
+
+	proc_remthread(curthread);
+	result = proc_addthread(proc, curthread);
+	if (result) {
+		panic("tlbbt: proc_addthread: %s\n", strerror(result));
+	}
+
+	as = proc->p_addrspace;
+	spl = splhigh();
+	as_activate();
+	KASSERT(curcpu->c_lastas == as->as_serial);
+	for (i=0; i<TLBBT_PAGES; i++) {
+		hi = tlbbt_entryhi(as, i);
+		slot = tlb_probe(hi, 0);
+		if (slot < 0) {
+			slot = NUM_TLB - 1 - i;
+		}
+		tlb_write(hi, TLBLO_INVALID(), slot);
+	}
+	splx(spl);
+
+	proc_remthread(curthread);
+	result = proc_addthread(kproc, curthread);
+	if (result) {
+		panic("tlbbt: proc_addthread: %s\n", strerror(result));
+	}
+}
+
+/*
+ * Count the test pages still in this cpu's TLB.
+ */
+static
+unsigned
+tlbbt_count(struct addrspace *as)
+{
+	unsigned i, n;
+	int spl;
+
+	n = 0;
+	spl = splhigh();
+	for (i=0; i<TLBBT_PAGES; i++) {
+		if (tlb_probe(tlbbt_entryhi(as, i), 0) >= 0) {
+			n++;
+		}
+	}
+	splx(spl);
+	return n;
+}
+
+static
+void
+tlbbt_thread(void *vproc, unsigned long cpunum)
+{
+	struct proc *proc = vproc;
+	int result;
+
+	result = thread_setaffinity(curthread, CPUMASK_BIT(cpunum));
+	if (result) {
+		panic("tlbbt: thread_setaffinity: %s\n", strerror(result));
+	}
+	tlbbt_load(proc);
+	V(tlbbt_ready);
+	P(tlbbt_go);
+	tlbbt_left[cpunum] = tlbbt_count(proc->p_addrspace);
+	V(tlbbt_done);
+}
+
+/*
+ * Flush BATCH and check that exactly the cpus in EXPECT (other than
+ * this one) got it, once each, and have finished with it.
+ */
+static
+void
+tlbbt_flush(struct tlbbatch *batch, uint32_t expect, const char *what)
+{
+	uint32_t before[TLBBT_MAXCPUS], got;
+	struct cpu *c;
+	unsigned i, ncpus;
+
+	ncpus = cpu_count();
+	for (i=0; i<ncpus; i++) {
+		before[i] = cpu_get(i)->c_shootdown_reqs;
+	}
+	tlbbatch_flush(batch);
+	for (i=0; i<ncpus; i++) {
+		c = cpu_get(i);
+		got = c->c_shootdown_reqs - before[i];
+		if (i == curcpu->c_number || (expect & CPUMASK_BIT(i)) == 0) {
+			if (got != 0) {
+				kprintf("tlbbt: %s: cpu%u got %u batches, "
+					"expected none\n", what, i, got);
+				tlbbt_failed = true;
+			}
+			continue;
+		}
+		if (got != 1) {
+			kprintf("tlbbt: %s: cpu%u got %u batches, "
+				"expected 1\n", what, i, got);
+			tlbbt_failed = true;
+		}
+		if ((int32_t)(c->c_shootdown_acks - c->c_shootdown_reqs) < 0) {
+			kprintf("tlbbt: %s: cpu%u hasn't finished\n", what, i);
+			tlbbt_failed = true;
+		}
+	}
+}
+
+int
+tlbbatchtest(int nargs, char **args)
+{
+	struct proc *proc;
+	struct addrspace *as;
+	struct tlbbatch batch;
+	uint32_t oldmask, expect;
+	unsigned i, ncpus, nthreads;
+	int result;
+
+	(void)nargs;
+	(void)args;
+
+	ncpus = cpu_count();
+	if (ncpus < 2) {
+		kprintf("tlbbt: needs more than one cpu\n");
+		return 0;
+	}
+	if (ncpus > TLBBT_MAXCPUS) {
+		ncpus = TLBBT_MAXCPUS;
+	}
+
+	kprintf("Starting TLB shootdown batch test...\n");
+
+	tlbbt_ready = sem_create("tlbbt_ready", 0);
+	tlbbt_go = sem_create("tlbbt_go", 0);
+	tlbbt_done = sem_create("tlbbt_done", 0);
+	if (tlbbt_ready == NULL || tlbbt_go == NULL || tlbbt_done == NULL) {
+		panic("tlbbt: sem_create failed\n");
+	}
+	tlbbt_failed = false;
+
+	result = proc_create_runprogram("tlbbt", &proc);
+	if (result) {
+		panic("tlbbt: proc_create_runprogram: %s\n",
+		      strerror(result));
+	}
+	as = as_create();
+	if (as == NULL) {
+		panic("tlbbt: as_create failed\n");
+	}
+	proc->p_addrspace = as;
+
+	oldmask = thread_getaffinity(curthread);
+	result = thread_setaffinity(curthread, CPUMASK_BIT(0));
+	if (result) {
+		panic("tlbbt: thread_setaffinity: %s\n", strerror(result));
+	}
+
+	expect = CPUMASK_BIT(0);
+	nthreads = 0;
+	for (i=1; i<ncpus; i+=2) {
+		expect |= CPUMASK_BIT(i);
+		result = thread_fork("tlbbt", NULL, tlbbt_thread, proc, i);
+		if (result) {
+			panic("tlbbt: thread_fork: %s\n", strerror(result));
+		}
+		nthreads++;
+	}
+	tlbbt_load(proc);
+	for (i=0; i<nthreads; i++) {
+		P(tlbbt_ready);
+	}
+
+	if (as->as_cpus != expect) {
+		kprintf("tlbbt: as_cpus is 0x%x, expected 0x%x\n",
+			as->as_cpus, expect);
+		tlbbt_failed = true;
+	}
+
+	/* One batch of a few pages. */
+	tlbbatch_init(&batch, as);
+	for (i=0; i<TLBBT_PAGES; i++) {
+		tlbbatch_add(&batch, TLBBT_BASE + i * PAGE_SIZE);
+	}
+	tlbbt_flush(&batch, expect, "pages");
+	if (tlbbt_count(as) != 0) {
+		kprintf("tlbbt: cpu0 still has %u entries\n", tlbbt_count(as));
+		tlbbt_failed = true;
+	}
+
+	for (i=0; i<nthreads; i++) {
+		V(tlbbt_go);
+	}
+	for (i=0; i<nthreads; i++) {
+		P(tlbbt_done);
+	}
+	for (i=1; i<ncpus; i+=2) {
+		if (tlbbt_left[i] != 0) {
+			kprintf("tlbbt: cpu%u still has %u entries\n",
+				i, tlbbt_left[i]);
+			tlbbt_failed = true;
+		}
+	}
+
+	/* Too many pages for a batch: flush the whole address space. */
+	tlbbatch_init(&batch, as);
+	for (i=0; i<=TLBSHOOTDOWN_MAX; i++) {
+		tlbbatch_add(&batch, TLBBT_BASE + i * PAGE_SIZE);
+	}
+	tlbbt_flush(&batch, expect, "whole");
+
+	result = thread_setaffinity(curthread, oldmask);
+	if (result) {
+		panic("tlbbt: thread_setaffinity: %s\n", strerror(result));
+	}
+
+	/* It never ran, so it has no exit status to collect. */
+	pid_unalloc(proc->p_pid);
+	proc->p_pid = INVALID_PID;
+	proc_destroy(proc);
+
+	sem_destroy(tlbbt_done);
+	sem_destroy(tlbbt_go);
+	sem_destroy(tlbbt_ready);
+	tlbbt_done = tlbbt_go = tlbbt_ready = NULL;
+
+	kprintf("TLB shootdown batch test %s\n",
+		tlbbt_failed ? "failed." : "done.");
+	return 0;
+}
@@ -0,0 +1,302 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Callout wheels. See callout.h.
+ */
+
+#include <types.h>
+#include <lib.h>
+#include <cpu.h>
+#include <spinlock.h>
+#include <callout.h>
+#include <current.h>
+
+/*
+ * Set up a CPU's wheel.
+ */
+void
+callwheel_init(struct callwheel *cw)
+{
+	unsigned i;
+
+	spinlock_init(&cw->cw_lock);
+	cw->cw_ticks = 0;
+	cw->cw_pending = 0;
+	cw->cw_running = NULL;
+	for (i=0; i<CALLWHEEL_SIZE; i++) {
+		cw->cw_buckets[i] = NULL;
+	}
+}
+
+/*
+ * Bucket manipulation. Call with the wheel locked.
+ */
+static
+void
+callwheel_insert(struct callwheel *cw, struct callout *co)
+{
+	struct callout **head;
+
+	head = &cw->cw_buckets[co->co_when & (CALLWHEEL_SIZE - 1)];
+	co->co_next = *head;
+	if (co->co_next != NULL) {
+		co->co_next->co_prevp = &co->co_next;
+	}
+	co->co_prevp = head;
+	*head = co;
+	cw->cw_pending++;
+}
+
+static
+void
+callwheel_remove(struct callwheel *cw, struct callout *co)
+{
+	*co->co_prevp = co->co_next;
+	if (co->co_next != NULL) {
+		co->co_next->co_prevp = co->co_prevp;
+	}
+	co->co_next = NULL;
+	co->co_prevp = NULL;
+	KASSERT(cw->cw_pending > 0);
+	cw->cw_pending--;
+}
+
+/*
+ * Lock the wheel a callout is on, if any, and return its CPU. The
+ * callout can move (or fire) while we're getting the lock, so check
+ * again once we have it.
+ */
+static
+struct cpu *
+callout_lockwheel(struct callout *co)
+{
+	struct cpu *c;
+
+	while (1) {
+		c = co->co_cpu;
+		if (c == NULL) {
+			return NULL;
+		}
+		spinlock_acquire(&c->c_callwheel.cw_lock);
+		if (co->co_cpu == c) {
+			return c;
+		}
+		spinlock_release(&c->c_callwheel.cw_lock);
+	}
+}
+
+void
+callout_init(struct callout *co, void (*func)(void *), void *arg)
+{
+	co->co_next = NULL;
+	co->co_prevp = NULL;
+	co->co_cpu = NULL;
+	co->co_when = 0;
+	co->co_func = func;
+	co->co_arg = arg;
+}
+
+void
+callout_schedule(struct callout *co, unsigned ticks)
+{
+	struct callwheel *cw;
+
+	KASSERT(co->co_func != NULL);
+	if (ticks == 0) {
+		ticks = 1;
+	}
+
+	callout_cancel(co);
+
+	cw = &curcpu->c_callwheel;
+	spinlock_acquire(&cw->cw_lock);
+	co->co_cpu = curcpu->c_self;
+	co->co_when = cw->cw_ticks + ticks;
+	callwheel_insert(cw, co);
+	spinlock_release(&cw->cw_lock);
+}
+
+bool
+callout_cancel(struct callout *co)
+{
+	struct cpu *c;
+
+	c = callout_lockwheel(co);
+	if (c == NULL) {
+		return false;
+	}
+	callwheel_remove(&c->c_callwheel, co);
+	co->co_cpu = NULL;
+	spinlock_release(&c->c_callwheel.cw_lock);
+	return true;
+}
+
+/*
+ * Check if CO is firing on any CPU. If it's in the middle of firing
+ * it could be on any wheel, so look at all of them.
+ */
+static
+bool
+callout_running(struct callout *co)
+{
+	struct callwheel *cw;
+	unsigned i, num;
+	bool ret = false;
+
+	num = cpu_count();
+	for (i=0; i<num && !ret; i++) {
+		cw = &cpu_get(i)->c_callwheel;
+		spinlock_acquire(&cw->cw_lock);
+		ret = (cw->cw_running == co);
+		spinlock_release(&cw->cw_lock);
+	}
+	return ret;
+}
+
+void
+callout_halt(struct callout *co)
+{
+	/*
+	 * Callouts are short, so just spin. The callout might
+	 * reschedule itself while we wait, so cancel again after.
+	 */
+	do {
+		callout_cancel(co);
+		while (callout_running(co)) {
+			/* spin */
+		}
+	} while (callout_pending(co));
+}
+
+bool
+callout_pending(struct callout *co)
+{
+	/* Reading one pointer is atomic enough. */
+	return co->co_cpu != NULL;
+}
+
+unsigned
+callout_remaining(struct callout *co)
+{
+	struct cpu *c;
+	unsigned ret;
+
+	c = callout_lockwheel(co);
+	if (c == NULL) {
+		return 0;
+	}
+	ret = co->co_when - c->c_callwheel.cw_ticks;
+	spinlock_release(&c->c_callwheel.cw_lock);
+	return ret;
+}
+
+/*
+ * Advance the current CPU's wheel one tick and run whatever is due.
+ * Call with the wheel locked.
+ *
+ * The callouts are run with the wheel unlocked, so they can
+ * reschedule themselves or touch other callouts. That means the
+ * bucket can change under us, so take the due callouts off one at a
+ * time, starting over each time.
+ */
+static
+void
+callwheel_tick(struct callwheel *cw)
+{
+	struct callout *co;
+	void (*func)(void *);
+	void *arg;
+	unsigned now;
+
+	now = ++cw->cw_ticks;
+	while (cw->cw_pending > 0) {
+		/* Others in the bucket are due on later trips around. */
+		co = cw->cw_buckets[now & (CALLWHEEL_SIZE - 1)];
+		while (co != NULL && co->co_when != now) {
+			co = co->co_next;
+		}
+		if (co == NULL) {
+			break;
+		}
+		callwheel_remove(cw, co);
+		co->co_cpu = NULL;
+
+		/*
+		 * Don't look at the callout once it's unlocked;
+		 * callout_halt waits on cw_running before letting the
+		 * owner free it, but nothing else does.
+		 */
+		func = co->co_func;
+		arg = co->co_arg;
+		cw->cw_running = co;
+		spinlock_release(&cw->cw_lock);
+		func(arg);
+		spinlock_acquire(&cw->cw_lock);
+		cw->cw_running = NULL;
+	}
+}
+
+void
+callout_hardclock(unsigned ticks)
+{
+	struct callwheel *cw = &curcpu->c_callwheel;
+
+	spinlock_acquire(&cw->cw_lock);
+	while (ticks > 0) {
+		if (cw->cw_pending == 0) {
+			/* Nothing to run; skip the rest at once. */
+			cw->cw_ticks += ticks;
+			break;
+		}
+		callwheel_tick(cw);
+		ticks--;
+	}
+	spinlock_release(&cw->cw_lock);
+}
+
+unsigned
+callout_nextdue(void)
+{
+	struct callwheel *cw = &curcpu->c_callwheel;
+	struct callout *co;
+	unsigned i, left, ret = 0;
+
+	spinlock_acquire(&cw->cw_lock);
+	for (i=0; i<CALLWHEEL_SIZE && cw->cw_pending > 0; i++) {
+		for (co = cw->cw_buckets[i]; co != NULL; co = co->co_next) {
+			left = co->co_when - cw->cw_ticks;
+			if (ret == 0 || left < ret) {
+				ret = left;
+			}
+		}
+	}
+	spinlock_release(&cw->cw_lock);
+	return ret;
+}
@@ -28,19 +28,23 @@
  */
 
 #include <types.h>
+#include <kern/errno.h>
 #include <lib.h>
 #include <cpu.h>
 #include <wchan.h>
 #include <clock.h>
+#include <callout.h>
 #include <thread.h>
+#include <proc.h>
 #include <current.h>
+#include <mainbus.h>
 
 /*
  * Time handling.
  *
- * This is pretty primitive. A real kernel will typically have some
- * kind of support for scheduling callbacks to happen at specific
- * points in the future, usually with more resolution than one second.
+ * This is pretty primitive. Callbacks at specific points in the
+ * future, with one-hardclock resolution, are in callout.c; the
+ * one-second timerclock/lbolt mechanism below is the older interface.
  *
  * A real kernel also has to maintain the time of day; in OS/161 we
  * skimp on that because we have a known-good hardware clock.
@@ -92,30 +96,238 @@ timerclock(void)
 void
 hardclock(void)
 {
+	unsigned ticks = 1;
+	unsigned old;
+
+	/*
+	 * If the idle loop stretched the timer, this is the end of
+	 * the last of several ticks; catch up on the ones skipped.
+	 */
+	if (curcpu->c_tickless > 0) {
+		ticks = curcpu->c_tickless;
+		curcpu->c_tickless = 0;
+	}
+
 	/*
-	 * Collect statistics here as desired.
+	 * Charge the ticks to whoever was running, as user or system
+	 * time according to where the interrupt came in. Ticks spent
+	 * idle belong to nobody.
 	 */
+	if (!curcpu->c_isidle) {
+		if (curthread->t_intr_user) {
+			curthread->t_usage.u_utime += ticks;
+		}
+		else {
+			curthread->t_usage.u_stime += ticks;
+		}
+	}
 
-	curcpu->c_hardclocks++;
-	if ((curcpu->c_hardclocks % MIGRATE_HARDCLOCKS) == 0) {
+	/*
+	 * Catching up can step right over a multiple of the migrate
+	 * or schedule period, so check whether we've crossed one
+	 * rather than whether we've landed on one.
+	 */
+	old = curcpu->c_hardclocks;
+	curcpu->c_hardclocks += ticks;
+	callout_hardclock(ticks);
+	if (old / MIGRATE_HARDCLOCKS !=
+	    curcpu->c_hardclocks / MIGRATE_HARDCLOCKS) {
 		thread_consider_migration();
 	}
-	if ((curcpu->c_hardclocks % SCHEDULE_HARDCLOCKS) == 0) {
+	if (old / SCHEDULE_HARDCLOCKS !=
+	    curcpu->c_hardclocks / SCHEDULE_HARDCLOCKS) {
 		schedule();
 	}
 	thread_yield();
 }
 
+/*
+ * Tickless idle.
+ *
+ * An idle CPU has nothing to do on a clock tick except run callouts,
+ * so before going idle, stretch the timer to the next callout due on
+ * this CPU (or as far as it goes if there are none) and skip the
+ * ticks in between. Anything else that needs the CPU (new threads to
+ * run, mostly) sends an interrupt anyway. If some other interrupt
+ * wakes us first, put the timer back and catch up the ticks that
+ * went by.
+ *
+ * These are called by the idle loop around cpu_idle(), with
+ * interrupts off.
+ */
+void
+hardclock_idle_begin(void)
+{
+	unsigned ticks;
+
+	KASSERT(curcpu->c_isidle);
+
+	if (curcpu->c_tickless > 0) {
+		/* Still stretched; the timer interrupt is pending */
+		return;
+	}
+
+	ticks = callout_nextdue();
+	if (ticks == 0) {
+		/* No callouts; sleep as long as the timer allows. */
+		ticks = (unsigned)-1;
+	}
+	if (ticks > 1) {
+		ticks = mainbus_timer_stretch(ticks);
+		if (ticks > 1) {
+			curcpu->c_tickless = ticks;
+		}
+	}
+}
+
+void
+hardclock_idle_end(void)
+{
+	unsigned elapsed;
+
+	if (curcpu->c_tickless == 0) {
+		/* Not stretched, or hardclock has caught up already */
+		return;
+	}
+	if (!mainbus_timer_unstretch(&elapsed)) {
+		/* Just went off; leave it to hardclock */
+		return;
+	}
+	curcpu->c_tickless = 0;
+	if (elapsed > 0) {
+		curcpu->c_hardclocks += elapsed;
+		callout_hardclock(elapsed);
+	}
+}
+
+/*
+ * Convert between times and ticks.
+ */
+
+#define NSEC_PER_TICK	(1000000000 / HZ)
+
+/* Longest we'll sleep at a time, so callout ticks don't wrap. */
+#define TICKS_MAX	0x7fffffffU
+
+unsigned
+timespec_to_ticks(const struct timespec *ts)
+{
+	unsigned ticks;
+
+	if (ts->tv_sec < 0) {
+		return 0;
+	}
+	if (ts->tv_sec >= TICKS_MAX / HZ) {
+		return TICKS_MAX;
+	}
+	ticks = ts->tv_sec * HZ;
+	ticks += (ts->tv_nsec + NSEC_PER_TICK - 1) / NSEC_PER_TICK;
+	return ticks;
+}
+
+void
+ticks_to_timespec(unsigned ticks, struct timespec *ret)
+{
+	ret->tv_sec = ticks / HZ;
+	ret->tv_nsec = (ticks % HZ) * NSEC_PER_TICK;
+}
+
+/*
+ * Sleeping for some number of ticks.
+ *
+ * Each sleeper puts a callout on the wheel of the CPU it's on and
+ * waits on its process's nap channel; only the sleepers in that one
+ * process wake up when it fires. The process's ITIMER_REAL wakes the
+ * same channel, which is how it interrupts sleeps; so does another
+ * thread of the process calling _exit.
+ */
+struct nap {
+	struct callout n_callout;
+	struct proc *n_proc;
+	bool n_done;
+};
+
+static
+void
+nap_wakeup(void *arg)
+{
+	struct nap *n = arg;
+	struct proc *p = n->n_proc;
+
+	spinlock_acquire(&p->p_lock);
+	n->n_done = true;
+	wchan_wakeall(p->p_napchan, &p->p_lock);
+	spinlock_release(&p->p_lock);
+}
+
+int
+clocksleep_ticks(unsigned ticks, bool interruptible)
+{
+	struct proc *p = curproc;
+	struct nap n;
+	unsigned expirations;
+	int result = 0;
+
+	if (ticks == 0) {
+		return 0;
+	}
+
+	callout_init(&n.n_callout, nap_wakeup, &n);
+	n.n_proc = p;
+	n.n_done = false;
+
+	spinlock_acquire(&p->p_lock);
+	expirations = p->p_itimer_expirations;
+	callout_schedule(&n.n_callout, ticks);
+	while (!n.n_done) {
+		if (interruptible && (p->p_itimer_expirations != expirations
+				      || p->p_exiting)) {
+			result = EINTR;
+			break;
+		}
+		wchan_sleep(p->p_napchan, &p->p_lock);
+	}
+	spinlock_release(&p->p_lock);
+
+	/* N is on our stack; make sure the callout is done with it. */
+	callout_halt(&n.n_callout);
+	return result;
+}
+
 /*
  * Suspend execution for n seconds.
  */
 void
 clocksleep(int num_secs)
 {
-	spinlock_acquire(&lbolt_lock);
-	while (num_secs > 0) {
-		wchan_sleep(lbolt, &lbolt_lock);
-		num_secs--;
+	if (num_secs > 0) {
+		clocksleep_ticks(num_secs * HZ, false);
 	}
-	spinlock_release(&lbolt_lock);
+}
+
+/*
+ * A process's ITIMER_REAL went off. Count it, reload it if it's
+ * periodic, and interrupt any sleeps. (There's no SIGALRM to send.)
+ */
+void
+itimer_expire(void *arg)
+{
+	struct proc *p = arg;
+
+	spinlock_acquire(&p->p_lock);
+	/*
+	 * If setitimer changed the timer after we were unhooked from
+	 * the wheel, this expiry is stale: ignore it.
+	 */
+	if (p->p_itimer_armed && !callout_pending(&p->p_itimer)) {
+		p->p_itimer_expirations++;
+		if (p->p_itimer_interval > 0) {
+			callout_schedule(&p->p_itimer, p->p_itimer_interval);
+		}
+		else {
+			p->p_itimer_armed = false;
+		}
+		wchan_wakeall(p->p_napchan, &p->p_lock);
+	}
+	spinlock_release(&p->p_lock);
 }
@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Lock contention statistics. See lockstat.h.
+ */
+
+#include <types.h>
+#include <lib.h>
+#include <cpu.h>
+#include <spl.h>
+#include <spinlock.h>
+#include <lockstat.h>
+
+/*
+ * We can't use a spinlock to protect the class table, because
+ * spinlocks use the class table. Use the machine-level lock word
+ * directly instead, with interrupts off.
+ */
+static volatile spinlock_data_t lockstat_tablelock = SPINLOCK_DATA_INITIALIZER;
+
+/*
+ * Statistics for one class of lock.
+ *
+ * The table is static because spinlocks get initialized long before
+ * kmalloc works (and kmalloc uses spinlocks). If it fills up, further
+ * classes are lumped together in the last entry.
+ */
+#define LOCKSTAT_MAXCLASSES	256
+#define LOCKSTAT_NAMELEN	24
+
+struct lockstat {
+	char ls_name[LOCKSTAT_NAMELEN];	/* Name (copied, as locks die) */
+	const void *ls_site;		/* Where created */
+	unsigned ls_acquires;		/* Number of acquisitions */
+	unsigned ls_contended;		/* Number that had to wait */
+	uint64_t ls_waitcycles;		/* Total time spent waiting */
+	uint64_t ls_maxhold;		/* Longest time held */
+};
+
+static struct lockstat lockstat_classes[LOCKSTAT_MAXCLASSES];
+static unsigned lockstat_numclasses;
+
+/*
+ * Find the class for NAME and SITE, creating it if needed.
+ */
+static
+struct lockstat *
+lockstat_getclass(const char *name, const void *site)
+{
+	char key[LOCKSTAT_NAMELEN];
+	struct lockstat *ls;
+	unsigned i;
+	int spl;
+
+	/* Names that don't fit are truncated. */
+	for (i=0; i<LOCKSTAT_NAMELEN-1 && name[i] != 0; i++) {
+		key[i] = name[i];
+	}
+	key[i] = 0;
+
+	spl = splhigh();
+	while (spinlock_data_testandset(&lockstat_tablelock) != 0) {
+		/* spin */
+	}
+
+	for (i=0; i<lockstat_numclasses; i++) {
+		ls = &lockstat_classes[i];
+		if (ls->ls_site == site && !strcmp(ls->ls_name, key)) {
+			goto done;
+		}
+	}
+
+	if (lockstat_numclasses == LOCKSTAT_MAXCLASSES) {
+		ls = &lockstat_classes[LOCKSTAT_MAXCLASSES-1];
+		strcpy(ls->ls_name, "(overflow)");
+		ls->ls_site = NULL;
+		goto done;
+	}
+
+	ls = &lockstat_classes[lockstat_numclasses++];
+	strcpy(ls->ls_name, key);
+	ls->ls_site = site;
+	ls->ls_acquires = 0;
+	ls->ls_contended = 0;
+	ls->ls_waitcycles = 0;
+	ls->ls_maxhold = 0;
+
+ done:
+	spinlock_data_set(&lockstat_tablelock, 0);
+	splx(spl);
+	return ls;
+}
+
+/*
+ * Set up the statistics for a new lock.
+ */
+void
+lockstat_init(struct lockstat_lockable *l, const char *name, const void *site)
+{
+	l->lsl_class = lockstat_getclass(name, site);
+	l->lsl_holdstart = 0;
+}
+
+/*
+ * Get a timestamp.
+ */
+uint64_t
+lockstat_now(void)
+{
+	return cpu_getcycles();
+}
+
+/*
+ * Record an acquisition. Called with the lock held. START is the
+ * timestamp from when the acquirer started trying to get it.
+ */
+void
+lockstat_acquired(struct lockstat_lockable *l, bool contended,
+		  uint64_t start)
+{
+	struct lockstat *ls;
+	uint64_t now;
+
+	if (l->lsl_class == NULL) {
+		/* Statically initialized spinlock; see lockstat.h. */
+		l->lsl_class = lockstat_getclass("static spinlock", l);
+	}
+	ls = l->lsl_class;
+
+	now = lockstat_now();
+	ls->ls_acquires++;
+	if (contended) {
+		ls->ls_contended++;
+		ls->ls_waitcycles += now > start ? now - start : 0;
+	}
+	l->lsl_holdstart = now;
+}
+
+/*
+ * Record a release. Called with the lock (still) held.
+ */
+void
+lockstat_released(struct lockstat_lockable *l)
+{
+	struct lockstat *ls = l->lsl_class;
+	uint64_t held;
+
+	if (ls == NULL) {
+		return;
+	}
+	held = cpu_cycles_since(l->lsl_holdstart);
+	if (held > ls->ls_maxhold) {
+		ls->ls_maxhold = held;
+	}
+}
+
+/*
+ * Print the statistics, most contended classes first. Classes that
+ * haven't been used since the last reset are skipped.
+ */
+void
+lockstat_dump(void)
+{
+	static unsigned order[LOCKSTAT_MAXCLASSES];
+	struct lockstat *ls;
+	unsigned i, j, num, tmp;
+
+	num = lockstat_numclasses;
+	for (i=0; i<num; i++) {
+		order[i] = i;
+	}
+
+	/* Insertion sort by contended count; this isn't performance-critical */
+	for (i=1; i<num; i++) {
+		for (j=i; j>0; j--) {
+			if (lockstat_classes[order[j]].ls_contended <=
+			    lockstat_classes[order[j-1]].ls_contended) {
+				break;
+			}
+			tmp = order[j];
+			order[j] = order[j-1];
+			order[j-1] = tmp;
+		}
+	}
+
+	kprintf("%-23s %-10s %10s %10s %12s %10s\n", "name", "site",
+		"acquires", "contended", "wait cycles", "max hold");
+	for (i=0; i<num; i++) {
+		ls = &lockstat_classes[order[i]];
+		if (ls->ls_acquires == 0) {
+			continue;
+		}
+		kprintf("%-23s %-10p %10u %10u %12llu %10llu\n",
+			ls->ls_name, ls->ls_site, ls->ls_acquires,
+			ls->ls_contended, ls->ls_waitcycles, ls->ls_maxhold);
+	}
+}
+
+/*
+ * Zero the counters.
+ */
+void
+lockstat_reset(void)
+{
+	struct lockstat *ls;
+	unsigned i, num;
+
+	num = lockstat_numclasses;
+	for (i=0; i<num; i++) {
+		ls = &lockstat_classes[i];
+		ls->ls_acquires = 0;
+		ls->ls_contended = 0;
+		ls->ls_waitcycles = 0;
+		ls->ls_maxhold = 0;
+	}
+}
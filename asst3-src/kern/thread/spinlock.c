@@ -53,6 +53,24 @@ spinlock_init(struct spinlock *splk)
 	spinlock_data_set(&splk->splk_lock, 0);
 	splk->splk_holder = NULL;
 	HANGMAN_LOCKABLEINIT(&splk->splk_hangman, "spinlock");
+	LOCKSTAT_INIT(&splk->splk_lockstat, "spinlock");
+	spinlock_data_set(&splk->splk_next, 0);
+	splk->splk_ticket = false;
+}
+
+/*
+ * Initialize ticket spinlock. For a ticket lock, splk_lock is the
+ * number now being served rather than a held flag.
+ */
+void
+spinlock_init_ticket(struct spinlock *splk)
+{
+	spinlock_data_set(&splk->splk_lock, 0);
+	splk->splk_holder = NULL;
+	HANGMAN_LOCKABLEINIT(&splk->splk_hangman, "spinlock");
+	LOCKSTAT_INIT(&splk->splk_lockstat, "spinlock");
+	spinlock_data_set(&splk->splk_next, 0);
+	splk->splk_ticket = true;
 }
 
 /*
@@ -62,7 +80,13 @@ void
 spinlock_cleanup(struct spinlock *splk)
 {
 	KASSERT(splk->splk_holder == NULL);
-	KASSERT(spinlock_data_get(&splk->splk_lock) == 0);
+	if (splk->splk_ticket) {
+		KASSERT(spinlock_data_get(&splk->splk_lock) ==
+			spinlock_data_get(&splk->splk_next));
+	}
+	else {
+		KASSERT(spinlock_data_get(&splk->splk_lock) == 0);
+	}
 }
 
 /*
@@ -76,7 +100,11 @@ void
 spinlock_acquire(struct spinlock *splk)
 {
 	struct cpu *mycpu;
+	spinlock_data_t ticket;
+	uint64_t lsstart;
+	bool contended;
 
+	lsstart = LOCKSTAT_NOW();
 	splraise(IPL_NONE, IPL_HIGH);
 
 	/* this must work before curcpu initialization */
@@ -93,28 +121,45 @@ spinlock_acquire(struct spinlock *splk)
 		mycpu = NULL;
 	}
 
-	while (1) {
+	contended = false;
+	if (splk->splk_ticket) {
 		/*
-		 * Do test-test-and-set, that is, read first before
-		 * doing test-and-set, to reduce bus contention.
-		 *
-		 * Test-and-set is a machine-level atomic operation
-		 * that writes 1 into the lock word and returns the
-		 * previous value. If that value was 0, the lock was
-		 * previously unheld and we now own it. If it was 1,
-		 * we don't.
+		 * Take a number and wait for it to come up. Only
+		 * the holder ever writes the number being served,
+		 * so while we wait we only read.
 		 */
-		if (spinlock_data_get(&splk->splk_lock) != 0) {
-			continue;
+		ticket = spinlock_data_fetchinc(&splk->splk_next);
+		while (spinlock_data_get(&splk->splk_lock) != ticket) {
+			contended = true;
 		}
-		if (spinlock_data_testandset(&splk->splk_lock) != 0) {
-			continue;
+	}
+	else {
+		while (1) {
+			/*
+			 * Do test-test-and-set, that is, read first before
+			 * doing test-and-set, to reduce bus contention.
+			 *
+			 * Test-and-set is a machine-level atomic operation
+			 * that writes 1 into the lock word and returns the
+			 * previous value. If that value was 0, the lock was
+			 * previously unheld and we now own it. If it was 1,
+			 * we don't.
+			 */
+			if (spinlock_data_get(&splk->splk_lock) != 0) {
+				contended = true;
+				continue;
+			}
+			if (spinlock_data_testandset(&splk->splk_lock) != 0) {
+				contended = true;
+				continue;
+			}
+			break;
 		}
-		break;
 	}
 
 	membar_store_any();
 	splk->splk_holder = mycpu;
+	LOCKSTAT_ACQUIRED(&splk->splk_lockstat, contended, lsstart);
 
 	if (CURCPU_EXISTS()) {
 		HANGMAN_ACQUIRE(&curcpu->c_hangman, &splk->splk_hangman);
@@ -135,9 +180,17 @@ spinlock_release(struct spinlock *splk)
 		HANGMAN_RELEASE(&curcpu->c_hangman, &splk->splk_hangman);
 	}
 
+	LOCKSTAT_RELEASED(&splk->splk_lockstat);
 	splk->splk_holder = NULL;
 	membar_any_store();
-	spinlock_data_set(&splk->splk_lock, 0);
+	if (splk->splk_ticket) {
+		/* Serve the next ticket. */
+		spinlock_data_set(&splk->splk_lock,
+				  spinlock_data_get(&splk->splk_lock) + 1);
+	}
+	else {
+		spinlock_data_set(&splk->splk_lock, 0);
+	}
 	spllower(IPL_HIGH, IPL_NONE);
 }
 
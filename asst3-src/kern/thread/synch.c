@@ -37,6 +37,7 @@
 #include <spinlock.h>
 #include <wchan.h>
 #include <thread.h>
+#include <cpu.h>
 #include <current.h>
 #include <synch.h>
 
@@ -100,23 +101,19 @@ P(struct semaphore *sem)
 
 	/* Use the semaphore spinlock to protect the wchan as well. */
 	spinlock_acquire(&sem->sem_lock);
-	while (sem->sem_count == 0) {
+	if (sem->sem_count > 0) {
+		sem->sem_count--;
+	}
+	else {
 		/*
-		 *
-		 * Note that we don't maintain strict FIFO ordering of
-		 * threads going through the semaphore; that is, we
-		 * might "get" it on the first try even if other
-		 * threads are waiting. Apparently according to some
-		 * textbooks semaphores must for some reason have
-		 * strict ordering. Too bad. :-)
-		 *
-		 * Exercise: how would you implement strict FIFO
-		 * ordering?
+		 * Threads go through the semaphore in strict FIFO
+		 * order: V doesn't increment the count if anyone is
+		 * waiting, but hands it straight to the first waiter.
+		 * So there's no count for a latecomer to grab ahead
+		 * of us, and when we wake up we already have it.
 		 */
 		wchan_sleep(sem->sem_wchan, &sem->sem_lock);
 	}
-	KASSERT(sem->sem_count > 0);
-	sem->sem_count--;
 	spinlock_release(&sem->sem_lock);
 }
 
@@ -127,9 +124,11 @@ V(struct semaphore *sem)
 
 	spinlock_acquire(&sem->sem_lock);
 
-	sem->sem_count++;
-	KASSERT(sem->sem_count > 0);
-	wchan_wakeone(sem->sem_wchan, &sem->sem_lock);
+	/* Hand off to the first waiter, if any; see P. */
+	if (wchan_wakeone(sem->sem_wchan, &sem->sem_lock) == NULL) {
+		sem->sem_count++;
+		KASSERT(sem->sem_count > 0);
+	}
 
 	spinlock_release(&sem->sem_lock);
 }
@@ -164,6 +163,9 @@ lock_create(const char *name)
 	}
 	spinlock_init(&lock->lk_lock);
 	lock->lk_holder = NULL;
+	lock->lk_waitpri = -1;
+	lock->lk_heldnext = NULL;
+	LOCKSTAT_INIT(&lock->lk_lockstat, lock->lk_name);
 
 	return lock;
 }
@@ -181,23 +183,212 @@ lock_destroy(struct lock *lock)
 	kfree(lock);
 }
 
+/*
+ * Priority inheritance.
+ *
+ * This spinlock protects every thread's t_pri and t_waitlock, and
+ * every lock's lk_waitpri. It also covers lk_holder whenever the lock
+ * has sleepers: the only way a lock with sleepers changes hands is
+ * lock_release handing it off, which does so with this held, so
+ * following a chain of holders and the locks they're waiting for
+ * only needs this one spinlock. (Locks nobody is asleep on can change
+ * hands without it, but nobody follows a chain through those.)
+ *
+ * It comes after the locks' lk_lock spinlocks and before the run
+ * queue locks.
+ *
+ * Threads that don't take part in contention never touch it:
+ * acquiring a free lock and releasing a lock nobody is waiting for
+ * don't need it, unless the releasing thread was boosted.
+ */
+static struct spinlock lock_pilock = SPINLOCK_INITIALIZER;
+
+/*
+ * Add LOCK to T's list of locks held. T must be curthread, or asleep
+ * waiting to be handed LOCK.
+ */
+static
+void
+lock_addheld(struct thread *t, struct lock *lock)
+{
+	lock->lk_heldnext = t->t_heldlocks;
+	t->t_heldlocks = lock;
+}
+
+/*
+ * Remove LOCK from curthread's list of locks held. Locks are mostly
+ * released in the opposite order they were acquired, so it's usually
+ * first.
+ */
+static
+void
+lock_remheld(struct lock *lock)
+{
+	struct lock **lp;
+
+	for (lp = &curthread->t_heldlocks; *lp != lock;
+	     lp = &(*lp)->lk_heldnext) {
+		KASSERT(*lp != NULL);
+	}
+	*lp = lock->lk_heldnext;
+	lock->lk_heldnext = NULL;
+}
+
+/*
+ * Recompute T's effective priority: its own, or that of the most
+ * important thread waiting for a lock it holds. Call with lock_pilock
+ * held.
+ */
+static
+void
+lock_pi_recompute(struct thread *t)
+{
+	struct lock *lk;
+	int pri;
+
+	KASSERT(spinlock_do_i_hold(&lock_pilock));
+
+	pri = t->t_basepri;
+	for (lk = t->t_heldlocks; lk != NULL; lk = lk->lk_heldnext) {
+		if (lk->lk_waitpri > pri) {
+			pri = lk->lk_waitpri;
+		}
+	}
+	if (pri != t->t_pri) {
+		thread_reprioritize(t, pri);
+	}
+}
+
+/*
+ * A thread of priority PRI is about to wait for LOCK. Boost the
+ * holder, and if the holder is itself waiting for a lock, that lock's
+ * holder, and so on, until we find one that's already at least as
+ * important. (If the chain loops, that's a deadlock, but it still
+ * stops after going around once.) Call with lock_pilock held.
+ */
+static
+void
+lock_pi_boost(struct lock *lock, int pri)
+{
+	struct thread *holder;
+
+	KASSERT(spinlock_do_i_hold(&lock_pilock));
+
+	while (lock != NULL) {
+		if (lock->lk_waitpri < pri) {
+			lock->lk_waitpri = pri;
+		}
+		holder = lock->lk_holder;
+		if (holder == NULL || holder->t_pri >= pri) {
+			break;
+		}
+		thread_reprioritize(holder, pri);
+		lock = holder->t_waitlock;
+	}
+}
+
+void
+thread_setpriority(int pri)
+{
+	int oldpri;
+
+	KASSERT(pri >= PRI_MIN && pri <= PRI_MAX);
+
+	spinlock_acquire(&lock_pilock);
+	oldpri = curthread->t_pri;
+	curthread->t_basepri = pri;
+	lock_pi_recompute(curthread);
+	pri = curthread->t_pri;
+	spinlock_release(&lock_pilock);
+
+	if (pri < oldpri) {
+		/* Let anything that now outranks us run */
+		thread_yield();
+	}
+}
+
+/*
+ * How many times lock_acquire polls a lock whose holder is running on
+ * another cpu before giving up and going to sleep. This should be
+ * roughly the cost of sleeping and being woken again (two context
+ * switches); if the holder hasn't let go by then it probably isn't
+ * going to soon.
+ */
+#define LOCK_SPINLIMIT	1000
+
+/*
+ * Check if the holder of a lock is running on some other cpu, so it
+ * might let go soon and it's worth spinning. Call with the lock's
+ * spinlock held; that keeps the holder from going away.
+ */
+static
+bool
+lock_holder_running(struct thread *holder)
+{
+	return holder->t_state == S_RUN && holder->t_cpu != curcpu->c_self;
+}
+
 void
 lock_acquire(struct lock *lock)
 {
+	struct thread *holder;
+	unsigned spins;
+	uint64_t lsstart;
+	bool contended;
+
 	DEBUGASSERT(lock != NULL);
 	KASSERT(curthread->t_in_interrupt == false);
 
+	lsstart = LOCKSTAT_NOW();
 	spinlock_acquire(&lock->lk_lock);
 
 	/* Call this (atomically) before waiting for a lock */
 	HANGMAN_WAIT(&curthread->t_hangman, &lock->lk_hangman);
 
 	KASSERT(lock->lk_holder != curthread);
-	while (lock->lk_holder != NULL) {
-		/* As in the semaphore. */
+	contended = (lock->lk_holder != NULL);
+	spins = 0;
+	while ((holder = lock->lk_holder) != NULL) {
+		if (holder == curthread) {
+			/* lock_release handed it to us while asleep */
+			break;
+		}
+		if (spins < LOCK_SPINLIMIT && lock_holder_running(holder)) {
+			/*
+			 * Adaptive spinning: the holder is running, so
+			 * watch (without the spinlock, so it can get in
+			 * to release) for it to let go. Don't look at
+			 * the holder itself in here; once it releases
+			 * the lock it can exit at any time.
+			 */
+			spinlock_release(&lock->lk_lock);
+			while (lock->lk_holder == holder &&
+			       spins < LOCK_SPINLIMIT) {
+				spins++;
+			}
+			spinlock_acquire(&lock->lk_lock);
+			continue;
+		}
+		/*
+		 * Sleepers get the lock in FIFO order: lock_release
+		 * gives it directly to the first one, as V does with
+		 * the semaphore count. (Spinners can still get in
+		 * ahead when nobody is asleep.) Lend the holder our
+		 * priority while we wait; lock_release clears
+		 * t_waitlock when it hands us the lock.
+		 */
+		spinlock_acquire(&lock_pilock);
+		curthread->t_waitlock = lock;
+		lock_pi_boost(lock, curthread->t_pri);
+		spinlock_release(&lock_pilock);
 		wchan_sleep(lock->lk_wchan, &lock->lk_lock);
 	}
-	lock->lk_holder = curthread;
+	if (holder == NULL) {
+		/* Otherwise lock_release already did this for us */
+		lock->lk_holder = curthread;
+		lock_addheld(curthread, lock);
+	}
+	LOCKSTAT_ACQUIRED(&lock->lk_lockstat, contended, lsstart);
 
 	/* Call this (atomically) once the lock is acquired */
 	HANGMAN_ACQUIRE(&curthread->t_hangman, &lock->lk_hangman);
@@ -208,13 +399,40 @@ lock_acquire(struct lock *lock)
 void
 lock_release(struct lock *lock)
 {
+	struct thread *next;
+
 	DEBUGASSERT(lock != NULL);
 
 	spinlock_acquire(&lock->lk_lock);
 
 	KASSERT(lock->lk_holder == curthread);
-	lock->lk_holder = NULL;
-	wchan_wakeone(lock->lk_wchan, &lock->lk_lock);
+	LOCKSTAT_RELEASED(&lock->lk_lockstat);
+	lock_remheld(lock);
+
+	/*
+	 * Hand off to the first sleeper, if there is one. It can't
+	 * get going until we let go of lk_lock, so we can finish
+	 * setting it up as the holder first: it inherits whatever
+	 * priority the remaining sleepers lend, and we give up ours.
+	 */
+	next = wchan_wakeone(lock->lk_wchan, &lock->lk_lock);
+	if (next == NULL && curthread->t_pri == curthread->t_basepri) {
+		/* Nobody waiting and nothing to give back */
+		lock->lk_holder = NULL;
+	}
+	else {
+		spinlock_acquire(&lock_pilock);
+		lock->lk_holder = next;
+		lock->lk_waitpri = wchan_maxpriority(lock->lk_wchan,
+						     &lock->lk_lock);
+		if (next != NULL) {
+			next->t_waitlock = NULL;
+			lock_addheld(next, lock);
+			lock_pi_recompute(next);
+		}
+		lock_pi_recompute(curthread);
+		spinlock_release(&lock_pilock);
+	}
 
 	/* Call this (atomically) when the lock is released */
 	HANGMAN_RELEASE(&curthread->t_hangman, &lock->lk_hangman);
@@ -280,9 +498,21 @@ cv_destroy(struct cv *cv)
 	kfree(cv);
 }
 
+/*
+ * Wait morphing: rather than waking CV waiters only to have them
+ * pile up on the lock the signaller is still holding, cv_signal and
+ * cv_broadcast move them straight onto the lock's wait channel. Then
+ * lock_release hands the lock to them one at a time, and a waiter
+ * wakes up already holding it.
+ *
+ * If the caller doesn't hold the lock (which it should), there's
+ * nothing to hand off and the waiters are just woken up.
+ */
 void
 cv_wait(struct cv *cv, struct lock *lock)
 {
+	uint64_t lsstart;
+
 	spinlock_acquire(&cv->cv_wchanlock);
 	lock_release(lock);
 	wchan_sleep(cv->cv_wchan, &cv->cv_wchanlock);
@@ -290,28 +520,203 @@ cv_wait(struct cv *cv, struct lock *lock)
 	 * It is kind of silly to acquire this spinlock in wchan_sleep
 	 * and then release it right away. If we were going for
 	 * performance we might pass a flag to avoid that in this
-	 * case. Or we might use lock->lk_lock to protect the wchan
-	 * and separate out enough of the lock_acquire/lock_release
-	 * logic to make that work cleanly.
+	 * case.
 	 */
 	spinlock_release(&cv->cv_wchanlock);
-	lock_acquire(lock);
+
+	lsstart = LOCKSTAT_NOW();
+	spinlock_acquire(&lock->lk_lock);
+	if (lock->lk_holder == curthread) {
+		/* We were moved to the lock and handed it. */
+		HANGMAN_WAIT(&curthread->t_hangman, &lock->lk_hangman);
+		LOCKSTAT_ACQUIRED(&lock->lk_lockstat, true, lsstart);
+		HANGMAN_ACQUIRE(&curthread->t_hangman, &lock->lk_hangman);
+		spinlock_release(&lock->lk_lock);
+	}
+	else {
+		spinlock_release(&lock->lk_lock);
+		lock_acquire(lock);
+	}
 }
 
+/*
+ * Move one or all waiters to the lock, or wake them if we can't.
+ */
+static
 void
-cv_signal(struct cv *cv, struct lock *lock)
+cv_wake(struct cv *cv, struct lock *lock, bool all)
 {
-	(void)lock;
 	spinlock_acquire(&cv->cv_wchanlock);
-	wchan_wakeone(cv->cv_wchan, &cv->cv_wchanlock);
+	spinlock_acquire(&lock->lk_lock);
+	if (lock->lk_holder == curthread) {
+		if (wchan_transfer(cv->cv_wchan, &cv->cv_wchanlock,
+				   lock->lk_wchan, &lock->lk_lock, all) > 0) {
+			/* They're waiting for the lock now; lend priority */
+			spinlock_acquire(&lock_pilock);
+			lock->lk_waitpri = wchan_maxpriority(lock->lk_wchan,
+							     &lock->lk_lock);
+			lock_pi_recompute(curthread);
+			spinlock_release(&lock_pilock);
+		}
+	}
+	else if (all) {
+		wchan_wakeall(cv->cv_wchan, &cv->cv_wchanlock);
+	}
+	else {
+		wchan_wakeone(cv->cv_wchan, &cv->cv_wchanlock);
+	}
+	spinlock_release(&lock->lk_lock);
 	spinlock_release(&cv->cv_wchanlock);
 }
 
+void
+cv_signal(struct cv *cv, struct lock *lock)
+{
+	cv_wake(cv, lock, false);
+}
+
 void
 cv_broadcast(struct cv *cv, struct lock *lock)
 {
-	(void)lock;
-	spinlock_acquire(&cv->cv_wchanlock);
-	wchan_wakeall(cv->cv_wchan, &cv->cv_wchanlock);
-	spinlock_release(&cv->cv_wchanlock);
+	cv_wake(cv, lock, true);
+}
+
+////////////////////////////////////////////////////////////
+//
+// Reader-writer lock.
+
+struct rwlock *
+rwlock_create(const char *name)
+{
+	struct rwlock *rw;
+
+	rw = kmalloc(sizeof(*rw));
+	if (rw == NULL) {
+		return NULL;
+	}
+
+	rw->rwlock_name = kstrdup(name);
+	if (rw->rwlock_name == NULL) {
+		kfree(rw);
+		return NULL;
+	}
+
+	rw->rw_readwchan = wchan_create(rw->rwlock_name);
+	if (rw->rw_readwchan == NULL) {
+		kfree(rw->rwlock_name);
+		kfree(rw);
+		return NULL;
+	}
+
+	rw->rw_writewchan = wchan_create(rw->rwlock_name);
+	if (rw->rw_writewchan == NULL) {
+		wchan_destroy(rw->rw_readwchan);
+		kfree(rw->rwlock_name);
+		kfree(rw);
+		return NULL;
+	}
+
+	spinlock_init(&rw->rw_lock);
+	rw->rw_readers = 0;
+	rw->rw_writerswaiting = 0;
+	rw->rw_writer = NULL;
+
+	return rw;
+}
+
+void
+rwlock_destroy(struct rwlock *rw)
+{
+	KASSERT(rw != NULL);
+
+	KASSERT(rw->rw_readers == 0);
+	KASSERT(rw->rw_writerswaiting == 0);
+	KASSERT(rw->rw_writer == NULL);
+	spinlock_cleanup(&rw->rw_lock);
+	wchan_destroy(rw->rw_writewchan);
+	wchan_destroy(rw->rw_readwchan);
+
+	kfree(rw->rwlock_name);
+	kfree(rw);
+}
+
+void
+rwlock_acquire_read(struct rwlock *rw)
+{
+	DEBUGASSERT(rw != NULL);
+	KASSERT(curthread->t_in_interrupt == false);
+
+	spinlock_acquire(&rw->rw_lock);
+	KASSERT(rw->rw_writer != curthread);
+	/* Wait for the writer, and for any writers already waiting. */
+	while (rw->rw_writer != NULL || rw->rw_writerswaiting > 0) {
+		wchan_sleep(rw->rw_readwchan, &rw->rw_lock);
+	}
+	rw->rw_readers++;
+	spinlock_release(&rw->rw_lock);
+}
+
+void
+rwlock_release_read(struct rwlock *rw)
+{
+	DEBUGASSERT(rw != NULL);
+
+	spinlock_acquire(&rw->rw_lock);
+	KASSERT(rw->rw_readers > 0);
+	KASSERT(rw->rw_writer == NULL);
+	rw->rw_readers--;
+	if (rw->rw_readers == 0 && rw->rw_writerswaiting > 0) {
+		wchan_wakeone(rw->rw_writewchan, &rw->rw_lock);
+	}
+	spinlock_release(&rw->rw_lock);
+}
+
+void
+rwlock_acquire_write(struct rwlock *rw)
+{
+	DEBUGASSERT(rw != NULL);
+	KASSERT(curthread->t_in_interrupt == false);
+
+	spinlock_acquire(&rw->rw_lock);
+	KASSERT(rw->rw_writer != curthread);
+	rw->rw_writerswaiting++;
+	while (rw->rw_writer != NULL || rw->rw_readers > 0) {
+		wchan_sleep(rw->rw_writewchan, &rw->rw_lock);
+	}
+	rw->rw_writerswaiting--;
+	rw->rw_writer = curthread;
+	spinlock_release(&rw->rw_lock);
+}
+
+void
+rwlock_release_write(struct rwlock *rw)
+{
+	DEBUGASSERT(rw != NULL);
+
+	spinlock_acquire(&rw->rw_lock);
+	KASSERT(rw->rw_writer == curthread);
+	KASSERT(rw->rw_readers == 0);
+	rw->rw_writer = NULL;
+	/* Writers first; the readers would just block again anyway. */
+	if (rw->rw_writerswaiting > 0) {
+		wchan_wakeone(rw->rw_writewchan, &rw->rw_lock);
+	}
+	else {
+		wchan_wakeall(rw->rw_readwchan, &rw->rw_lock);
+	}
+	spinlock_release(&rw->rw_lock);
+}
+
+bool
+rwlock_do_i_hold_write(struct rwlock *rw)
+{
+	bool ret;
+
+	DEBUGASSERT(rw != NULL);
+
+	spinlock_acquire(&rw->rw_lock);
+	ret = (rw->rw_writer == curthread);
+	spinlock_release(&rw->rw_lock);
+
+	return ret;
 }
@@ -51,6 +51,8 @@
 #include <synch.h>
 #include <addrspace.h>
 #include <mainbus.h>
+#include <membar.h>
+#include <clock.h>
 #include <vnode.h>
 #include <pid.h>
 
@@ -58,6 +60,9 @@
 /* Magic number used as a guard value on kernel thread stacks. */
 #define THREAD_STACK_MAGIC 0xbaadf00d
 
+/* Most dead threads kept on each cpu for reuse. */
+#define THREADCACHE_MAX 8
+
 /* Wait channel. A wchan is protected by an associated, passed-in spinlock. */
 struct wchan {
 	const char *wc_name;		/* name for this channel */
@@ -111,6 +116,41 @@ thread_checkstack(struct thread *thread)
 	}
 }
 
+/*
+ * Initialize a new (or recycled) thread. The name should already be
+ * set; the stack is left alone.
+ */
+static
+void
+thread_init(struct thread *thread)
+{
+	thread->t_wchan_name = "NEW";
+	thread->t_state = S_READY;
+
+	/* Thread subsystem fields */
+	thread_machdep_init(&thread->t_machdep);
+	threadlistnode_init(&thread->t_listnode, thread);
+	thread->t_context = NULL;
+	thread->t_cpu = NULL;
+	thread->t_cpumask = CPUMASK_ALL;
+	thread->t_proc = NULL;
+	thread->t_uslot = -1;
+	usage_init(&thread->t_usage);
+	HANGMAN_ACTORINIT(&thread->t_hangman, thread->t_name);
+	thread->t_basepri = PRI_DEFAULT;
+	thread->t_pri = PRI_DEFAULT;
+	thread->t_waitlock = NULL;
+	thread->t_heldlocks = NULL;
+
+	/* Interrupt state fields */
+	thread->t_in_interrupt = false;
+	thread->t_intr_user = false;
+	thread->t_curspl = IPL_HIGH;
+	thread->t_iplhigh_count = 1; /* corresponding to t_curspl */
+
+	/* If you add to struct thread, be sure to initialize here */
+}
+
 /*
  * Create a thread. This is used both to create a first thread
  * for each CPU and to create subsequent forked threads.
@@ -133,24 +173,8 @@ thread_create(const char *name)
 		kfree(thread);
 		return NULL;
 	}
-	thread->t_wchan_name = "NEW";
-	thread->t_state = S_READY;
-
-	/* Thread subsystem fields */
-	thread_machdep_init(&thread->t_machdep);
-	threadlistnode_init(&thread->t_listnode, thread);
 	thread->t_stack = NULL;
-	thread->t_context = NULL;
-	thread->t_cpu = NULL;
-	thread->t_proc = NULL;
-	HANGMAN_ACTORINIT(&thread->t_hangman, thread->t_name);
-
-	/* Interrupt state fields */
-	thread->t_in_interrupt = false;
-	thread->t_curspl = IPL_HIGH;
-	thread->t_iplhigh_count = 1; /* corresponding to t_curspl */
-
-	/* If you add to struct thread, be sure to initialize here */
+	thread_init(thread);
 
 	return thread;
 }
@@ -180,15 +204,26 @@ cpu_create(unsigned hardware_number)
 
 	c->c_curthread = NULL;
 	threadlist_init(&c->c_zombies);
+	threadlist_init(&c->c_migrating);
+	threadlist_init(&c->c_threadcache);
+	c->c_threadcache_hits = 0;
+	c->c_threadcache_misses = 0;
 	c->c_hardclocks = 0;
+	c->c_tickless = 0;
 	c->c_spinlocks = 0;
+	c->c_lastas = 0;
+	callwheel_init(&c->c_callwheel);
 
 	c->c_isidle = false;
 	threadlist_init(&c->c_runqueue);
-	spinlock_init(&c->c_runqueue_lock);
+	/* Other cpus hit this a lot (wakeups, migration); keep it fair. */
+	spinlock_init_ticket(&c->c_runqueue_lock);
 
 	c->c_ipi_pending = 0;
 	c->c_numshootdown = 0;
+	c->c_shootdown_all = false;
+	c->c_shootdown_reqs = 0;
+	c->c_shootdown_acks = 0;
 	spinlock_init(&c->c_ipi_lock);
 
 	result = cpuarray_add(&allcpus, c, &c->c_number);
@@ -255,6 +290,25 @@ cpu_create(unsigned hardware_number)
 	return c;
 }
 
+/*
+ * Return the number of cpus. They're numbered 0 through one less
+ * than this.
+ */
+unsigned
+cpu_count(void)
+{
+	return cpuarray_num(&allcpus);
+}
+
+/*
+ * Return a cpu by number.
+ */
+struct cpu *
+cpu_get(unsigned num)
+{
+	return cpuarray_get(&allcpus, num);
+}
+
 /*
  * Destroy a thread.
  *
@@ -290,9 +344,105 @@ thread_destroy(struct thread *thread)
 	kfree(thread);
 }
 
+/*
+ * Thread recycling.
+ *
+ * Rather than freeing the struct thread and the stack of each thread
+ * that exits, keep up to THREADCACHE_MAX of them on each cpu and hand
+ * them out again in thread_fork. This saves two large kmallocs and
+ * frees per fork. The cache is per-cpu and only touched with
+ * interrupts off, so it needs no lock.
+ *
+ * Only threads with their own stack can be recycled; the boot thread
+ * can't.
+ */
+
+/*
+ * Put a zombie in the cache, or return false if it won't fit.
+ */
+static
+bool
+thread_cache_put(struct thread *thread)
+{
+	KASSERT(curthread->t_curspl > 0);
+	KASSERT(thread->t_proc == NULL);
+
+	if (thread->t_stack == NULL ||
+	    curcpu->c_threadcache.tl_count >= THREADCACHE_MAX) {
+		return false;
+	}
+
+	/* Don't reuse a stack that was overrun. */
+	thread_checkstack(thread);
+
+	thread_machdep_cleanup(&thread->t_machdep);
+	kfree(thread->t_name);
+	thread->t_name = NULL;
+	thread->t_wchan_name = "RECYCLED";
+	threadlist_addhead(&curcpu->c_threadcache, thread);
+	return true;
+}
+
+/*
+ * Get a thread (with stack) from the cache, or return NULL if there
+ * isn't one.
+ */
+static
+struct thread *
+thread_cache_get(const char *name)
+{
+	struct thread *thread;
+	int spl;
+
+	spl = splhigh();
+	thread = threadlist_remhead(&curcpu->c_threadcache);
+	if (thread != NULL) {
+		curcpu->c_threadcache_hits++;
+	}
+	else {
+		curcpu->c_threadcache_misses++;
+	}
+	splx(spl);
+
+	if (thread == NULL) {
+		return NULL;
+	}
+
+	thread->t_name = kstrdup(name);
+	if (thread->t_name == NULL) {
+		/* Still as thread_cache_put left it; just put it back. */
+		spl = splhigh();
+		threadlist_addhead(&curcpu->c_threadcache, thread);
+		splx(spl);
+		return NULL;
+	}
+	thread_init(thread);
+	return thread;
+}
+
+/*
+ * Print the cache statistics.
+ */
+void
+thread_cache_stats(void)
+{
+	struct cpu *c;
+	unsigned i, num;
+
+	num = cpuarray_num(&allcpus);
+	for (i=0; i<num; i++) {
+		c = cpuarray_get(&allcpus, i);
+		/* Just a snapshot; don't bother locking */
+		kprintf("cpu%u: %u cached, %u hits, %u misses\n",
+			c->c_number, c->c_threadcache.tl_count,
+			c->c_threadcache_hits, c->c_threadcache_misses);
+	}
+}
+
 /*
  * Clean up zombies. (Zombies are threads that have exited but still
- * need to have thread_destroy called on them.)
+ * need to have thread_destroy called on them.) Keep some of them
+ * for reuse.
  *
  * The list of zombies is per-cpu.
  */
@@ -305,7 +455,9 @@ exorcise(void)
 	while ((z = threadlist_remhead(&curcpu->c_zombies)) != NULL) {
 		KASSERT(z != curthread);
 		KASSERT(z->t_state == S_ZOMBIE);
-		thread_destroy(z);
+		if (!thread_cache_put(z)) {
+			thread_destroy(z);
+		}
 	}
 }
 
@@ -445,10 +597,114 @@ thread_start_cpus(void)
 	cpu_startup_sem = NULL;
 }
 
+/*
+ * Check if a thread's affinity mask allows it to run on a cpu. The
+ * mask is changed only with the run queue of the thread's t_cpu
+ * locked (see thread_setaffinity), so hold that for a stable answer.
+ */
+static
+bool
+thread_cpu_allowed(struct thread *t, struct cpu *c)
+{
+	return (t->t_cpumask & CPUMASK_BIT(c->c_number)) != 0;
+}
+
+/*
+ * Choose the cpu a thread that's becoming runnable should go on, and
+ * return it with its run queue locked.
+ *
+ * Prefer the cpu the thread last ran on, which is where its cache
+ * state (if any) is. If its affinity mask no longer allows that cpu,
+ * choose another allowed one: an idle one if possible, otherwise the
+ * one with the shortest run queue. (The run queue counts are read
+ * without locking; they're only a hint.)
+ *
+ * The thread can only be moved if its old cpu isn't still sitting
+ * idle on its stack; see the comments in thread_consider_migration.
+ * Checking this under the old cpu's run queue lock also makes sure
+ * the thread has finished switching out, because a cpu holds its run
+ * queue lock across the switch.
+ *
+ * thread_setaffinity changes the mask under the lock of whatever cpu
+ * t_cpu points at. Once we set t_cpu to the new cpu and drop the old
+ * cpu's lock, but before we have the new cpu's lock, it can bar the
+ * new cpu without seeing anything to move. So check the mask again
+ * once we hold the new cpu's lock, and choose again if it changed.
+ */
+static
+struct cpu *
+thread_choose_cpu(struct thread *t)
+{
+	struct cpu *oldcpu, *c, *best;
+	unsigned i, numcpus;
+
+ again:
+	oldcpu = t->t_cpu;
+	spinlock_acquire(&oldcpu->c_runqueue_lock);
+	if (thread_cpu_allowed(t, oldcpu) || oldcpu->c_curthread == t) {
+		return oldcpu;
+	}
+
+	best = NULL;
+	numcpus = cpuarray_num(&allcpus);
+	for (i=0; i<numcpus; i++) {
+		c = cpuarray_get(&allcpus, i);
+		if (!thread_cpu_allowed(t, c)) {
+			continue;
+		}
+		if (c->c_isidle) {
+			best = c;
+			break;
+		}
+		if (best == NULL ||
+		    c->c_runqueue.tl_count < best->c_runqueue.tl_count) {
+			best = c;
+		}
+	}
+	/* thread_setaffinity doesn't allow masks with no cpus in them */
+	KASSERT(best != NULL);
+
+	DEBUG(DB_THREADS, "Moved thread %s on wakeup: cpu %u -> %u\n",
+	      t->t_name, oldcpu->c_number, best->c_number);
+	t->t_cpu = best;
+	spinlock_release(&oldcpu->c_runqueue_lock);
+	spinlock_acquire(&best->c_runqueue_lock);
+	if (!thread_cpu_allowed(t, best)) {
+		spinlock_release(&best->c_runqueue_lock);
+		goto again;
+	}
+	return best;
+}
+
+/*
+ * Put a thread on a cpu's run queue, which is kept in priority order:
+ * it goes behind every thread of the same or higher priority. The run
+ * queue must be locked.
+ */
+static
+void
+thread_runqueue_add(struct cpu *c, struct thread *t)
+{
+	struct threadlistnode *tln;
+
+	tln = c->c_runqueue.tl_tail.tln_prev;
+	while (tln->tln_self != NULL && tln->tln_self->t_pri < t->t_pri) {
+		tln = tln->tln_prev;
+	}
+	if (tln->tln_self == NULL) {
+		threadlist_addhead(&c->c_runqueue, t);
+	}
+	else {
+		threadlist_insertafter(&c->c_runqueue, tln->tln_self, t);
+	}
+}
+
 /*
  * Make a thread runnable.
  *
- * targetcpu might be curcpu; it might not be, too.
+ * targetcpu might be curcpu; it might not be, too. If we already hold
+ * a run queue lock, the thread goes on that cpu (which must be the
+ * thread's t_cpu); otherwise thread_choose_cpu decides.
  */
 static
 void
@@ -456,20 +712,19 @@ thread_make_runnable(struct thread *target, bool already_have_lock)
 {
 	struct cpu *targetcpu;
 
-	/* Lock the run queue of the target thread's cpu. */
-	targetcpu = target->t_cpu;
-
 	if (already_have_lock) {
 		/* The target thread's cpu should be already locked. */
+		targetcpu = target->t_cpu;
 		KASSERT(spinlock_do_i_hold(&targetcpu->c_runqueue_lock));
 	}
 	else {
-		spinlock_acquire(&targetcpu->c_runqueue_lock);
+		/* Pick a cpu and lock its run queue. */
+		targetcpu = thread_choose_cpu(target);
 	}
 
 	/* Target thread is now ready to run; put it on the run queue. */
 	target->t_state = S_READY;
-	threadlist_addtail(&targetcpu->c_runqueue, target);
+	thread_runqueue_add(targetcpu, target);
 
 	if (targetcpu->c_isidle && targetcpu != curcpu->c_self) {
 		/*
@@ -485,34 +740,51 @@ thread_make_runnable(struct thread *target, bool already_have_lock)
 }
 
 /*
- * Create a new thread based on an existing one.
- *
- * The new thread has name NAME, and starts executing in function
- * ENTRYPOINT. DATA1 and DATA2 are passed to ENTRYPOINT.
- *
- * The new thread is created in the process P. If P is null, the
- * process is inherited from the caller. It will start on the same CPU
- * as the caller, unless the scheduler intervenes first.
+ * Send threads whose affinity masks made them leave this cpu (see
+ * thread_switch) to a cpu they're allowed on. This must happen after
+ * they've switched out, so it's done by the next thread to run, like
+ * exorcise().
+ */
+static
+void
+send_migrants(void)
+{
+	struct thread *t;
+
+	while ((t = threadlist_remhead(&curcpu->c_migrating)) != NULL) {
+		KASSERT(t != curthread);
+		KASSERT(t->t_state == S_READY);
+		thread_make_runnable(t, false);
+	}
+}
+
+/*
+ * Create a new thread with affinity mask CPUMASK and priority PRI;
+ * otherwise as thread_fork, below.
  */
+static
 int
-thread_fork(const char *name,
-	    struct proc *proc,
-	    void (*entrypoint)(void *data1, unsigned long data2),
-	    void *data1, unsigned long data2)
+thread_fork_with(const char *name, struct proc *proc,
+		 uint32_t cpumask, int pri,
+		 void (*entrypoint)(void *data1, unsigned long data2),
+		 void *data1, unsigned long data2)
 {
 	struct thread *newthread;
 	int result;
 
-	newthread = thread_create(name);
+	newthread = thread_cache_get(name);
 	if (newthread == NULL) {
-		return ENOMEM;
-	}
+		newthread = thread_create(name);
+		if (newthread == NULL) {
+			return ENOMEM;
+		}
 
-	/* Allocate a stack */
-	newthread->t_stack = kmalloc(STACK_SIZE);
-	if (newthread->t_stack == NULL) {
-		thread_destroy(newthread);
-		return ENOMEM;
+		/* Allocate a stack */
+		newthread->t_stack = kmalloc(STACK_SIZE);
+		if (newthread->t_stack == NULL) {
+			thread_destroy(newthread);
+			return ENOMEM;
+		}
 	}
 	thread_checkstack_init(newthread);
 
@@ -522,6 +794,9 @@ thread_fork(const char *name,
 
 	/* Thread subsystem fields */
 	newthread->t_cpu = curthread->t_cpu;
+	newthread->t_cpumask = cpumask;
+	newthread->t_basepri = pri;
+	newthread->t_pri = pri;
 
 	/* Attach the new thread to its process */
 	if (proc == NULL) {
@@ -550,6 +825,28 @@ thread_fork(const char *name,
 	return 0;
 }
 
+/*
+ * Create a new thread based on an existing one.
+ *
+ * The new thread has name NAME, and starts executing in function
+ * ENTRYPOINT. DATA1 and DATA2 are passed to ENTRYPOINT.
+ *
+ * The new thread is created in the process P. If P is null, the
+ * process is inherited from the caller. It will start on the same CPU
+ * as the caller, unless the scheduler intervenes first or the caller's
+ * affinity mask doesn't include that CPU.
+ */
+int
+thread_fork(const char *name,
+	    struct proc *proc,
+	    void (*entrypoint)(void *data1, unsigned long data2),
+	    void *data1, unsigned long data2)
+{
+	return thread_fork_with(name, proc, curthread->t_cpumask,
+				curthread->t_basepri,
+				entrypoint, data1, data2);
+}
+
 /*
  * High level, machine-independent context switch code.
  *
@@ -590,8 +887,15 @@ thread_switch(threadstate_t newstate, struct wchan *wc, struct spinlock *lk)
 	/* Lock the run queue. */
 	spinlock_acquire(&curcpu->c_runqueue_lock);
 
-	/* Micro-optimization: if nothing to do, just return */
-	if (newstate == S_READY && threadlist_isempty(&curcpu->c_runqueue)) {
+	/*
+	 * Micro-optimization: if nothing to do, just return. That
+	 * includes yielding when everything else waiting here has
+	 * lower priority, unless we have to leave this cpu.
+	 */
+	if (newstate == S_READY &&
+	    (threadlist_isempty(&curcpu->c_runqueue) ||
+	     (curcpu->c_runqueue.tl_head.tln_next->tln_self->t_pri <
+	      cur->t_pri && thread_cpu_allowed(cur, curcpu->c_self)))) {
 		spinlock_release(&curcpu->c_runqueue_lock);
 		splx(spl);
 		return;
@@ -602,7 +906,18 @@ thread_switch(threadstate_t newstate, struct wchan *wc, struct spinlock *lk)
 	    case S_RUN:
 		panic("Illegal S_RUN in thread_switch\n");
 	    case S_READY:
-		thread_make_runnable(cur, true /*have lock*/);
+		if (thread_cpu_allowed(cur, curcpu->c_self)) {
+			thread_make_runnable(cur, true /*have lock*/);
+		}
+		else {
+			/*
+			 * Our affinity mask says we can't stay here.
+			 * We can't go on another cpu's run queue until
+			 * we're off our stack, so wait in c_migrating
+			 * for the next thread to send us on.
+			 */
+			threadlist_addtail(&curcpu->c_migrating, cur);
+		}
 		break;
 	    case S_SLEEP:
 		cur->t_wchan_name = wc->wc_name;
@@ -624,6 +939,17 @@ thread_switch(threadstate_t newstate, struct wchan *wc, struct spinlock *lk)
 	}
 	cur->t_state = newstate;
 
+	/*
+	 * Count the switch. Being preempted from an interrupt handler
+	 * is involuntary; sleeping or yielding is voluntary.
+	 */
+	if (newstate == S_READY && cur->t_in_interrupt) {
+		cur->t_usage.u_nivcsw++;
+	}
+	else if (newstate != S_ZOMBIE) {
+		cur->t_usage.u_nvcsw++;
+	}
+
 	/*
 	 * Get the next thread. While there isn't one, call cpu_idle().
 	 * curcpu->c_isidle must be true when cpu_idle is
@@ -647,7 +973,9 @@ thread_switch(threadstate_t newstate, struct wchan *wc, struct spinlock *lk)
 		next = threadlist_remhead(&curcpu->c_runqueue);
 		if (next == NULL) {
 			spinlock_release(&curcpu->c_runqueue_lock);
+			hardclock_idle_begin();
 			cpu_idle();
+			hardclock_idle_end();
 			spinlock_acquire(&curcpu->c_runqueue_lock);
 		}
 	} while (next == NULL);
@@ -726,6 +1054,9 @@ thread_switch(threadstate_t newstate, struct wchan *wc, struct spinlock *lk)
 	/* Clean up dead threads. */
 	exorcise();
 
+	/* Send on threads that can't run here. */
+	send_migrants();
+
 	/* Turn interrupts back on. */
 	splx(spl);
 }
@@ -759,6 +1090,9 @@ thread_startup(void (*entrypoint)(void *data1, unsigned long data2),
 	/* Clean up dead threads. */
 	exorcise();
 
+	/* Send on threads that can't run here. */
+	send_migrants();
+
 	/* Enable interrupts. */
 	spl0();
 
@@ -829,11 +1163,51 @@ void
 schedule(void)
 {
 	/*
-	 * You can write this. If we do nothing, threads will run in
-	 * round-robin fashion.
+	 * Nothing to do here: the run queues are kept in priority
+	 * order as threads are added (thread_runqueue_add), and
+	 * thread_reprioritize moves threads whose priority changes.
+	 * Threads of equal priority run in round-robin fashion.
 	 */
 }
 
+/*
+ * Change the effective priority of T. If it's on a run queue, move it
+ * to its new place. It might be on its way between run queues
+ * (thread_consider_migration), so check that it's really on the one
+ * it claims; if not, whoever has it puts it in the right place when
+ * it lands.
+ */
+void
+thread_reprioritize(struct thread *t, int pri)
+{
+	struct cpu *c;
+	struct threadlistnode *tln;
+
+	c = t->t_cpu;
+	if (c == NULL || t->t_state != S_READY) {
+		t->t_pri = pri;
+		return;
+	}
+
+	spinlock_acquire(&c->c_runqueue_lock);
+	for (tln = c->c_runqueue.tl_head.tln_next;
+	     tln->tln_self != NULL;
+	     tln = tln->tln_next) {
+		if (tln->tln_self == t) {
+			break;
+		}
+	}
+	if (tln->tln_self == t) {
+		threadlist_remove(&c->c_runqueue, t);
+		t->t_pri = pri;
+		thread_runqueue_add(c, t);
+	}
+	else {
+		t->t_pri = pri;
+	}
+	spinlock_release(&c->c_runqueue_lock);
+}
+
 /*
  * Thread migration.
  *
@@ -850,6 +1224,11 @@ schedule(void)
  * For here and now, because we know we're running on System/161 and
  * System/161 does not (yet) model such cache effects, we'll be very
  * aggressive.
+ *
+ * Threads whose affinity masks don't include this CPU are always
+ * sent away; beyond that, only threads that are allowed to run
+ * somewhere else are candidates, and they only go to CPUs they're
+ * allowed on.
  */
 void
 thread_consider_migration(void)
@@ -858,7 +1237,9 @@ thread_consider_migration(void)
 	unsigned i, numcpus;
 	struct cpu *c;
 	struct threadlist victims;
+	struct threadlistnode *tln;
 	struct thread *t;
+	uint32_t mycpubit;
 
 	my_count = total_count = 0;
 	numcpus = cpuarray_num(&allcpus);
@@ -873,27 +1254,49 @@ thread_consider_migration(void)
 	}
 
 	one_share = DIVROUNDUP(total_count, numcpus);
-	if (my_count < one_share) {
-		return;
-	}
+	to_send = (my_count > one_share) ? my_count - one_share : 0;
+	mycpubit = CPUMASK_BIT(curcpu->c_number);
 
-	to_send = my_count - one_share;
+	/*
+	 * Pick the victims, starting at the tail of the run queue
+	 * (those threads have the longest wait ahead of them here).
+	 * Take everything that isn't allowed here, and up to to_send
+	 * threads that are allowed here but also somewhere else.
+	 */
 	threadlist_init(&victims);
 	spinlock_acquire(&curcpu->c_runqueue_lock);
-	for (i=0; i<to_send; i++) {
-		t = threadlist_remtail(&curcpu->c_runqueue);
-		threadlist_addhead(&victims, t);
+	tln = curcpu->c_runqueue.tl_tail.tln_prev;
+	while (tln->tln_self != NULL) {
+		t = tln->tln_self;
+		tln = tln->tln_prev;
+		if ((t->t_cpumask & mycpubit) == 0) {
+			threadlist_remove(&curcpu->c_runqueue, t);
+			threadlist_addhead(&victims, t);
+		}
+		else if (to_send > 0 && (t->t_cpumask & ~mycpubit) != 0) {
+			threadlist_remove(&curcpu->c_runqueue, t);
+			threadlist_addhead(&victims, t);
+			to_send--;
+		}
 	}
 	spinlock_release(&curcpu->c_runqueue_lock);
 
-	for (i=0; i < numcpus && to_send > 0; i++) {
+	if (threadlist_isempty(&victims)) {
+		threadlist_cleanup(&victims);
+		return;
+	}
+
+	for (i=0; i < numcpus; i++) {
 		c = cpuarray_get(&allcpus, i);
 		if (c == curcpu->c_self) {
 			continue;
 		}
 		spinlock_acquire(&c->c_runqueue_lock);
-		while (c->c_runqueue.tl_count < one_share && to_send > 0) {
-			t = threadlist_remhead(&victims);
+		tln = victims.tl_head.tln_next;
+		while (tln->tln_self != NULL) {
+			t = tln->tln_self;
+			tln = tln->tln_next;
+
 			/*
 			 * Ordinarily, curthread will not appear on
 			 * the run queue. However, it can under the
@@ -911,23 +1314,28 @@ thread_consider_migration(void)
 			 * while things are in this state and see
 			 * curthread. However, *migrating* curthread
 			 * can cause bad things to happen (Exercise:
-			 * Why? And what?) so shuffle it to the end of
-			 * the list and decrement to_send in order to
-			 * skip it. Then it goes back on our own run
-			 * queue below.
+			 * Why? And what?) so skip it. It goes back on
+			 * our own run queue below, and if it isn't
+			 * allowed here thread_switch moves it along
+			 * once it's off its stack.
 			 */
 			if (t == curthread) {
-				threadlist_addtail(&victims, t);
-				to_send--;
+				continue;
+			}
+			if (!thread_cpu_allowed(t, c)) {
+				continue;
+			}
+			if (thread_cpu_allowed(t, curcpu->c_self) &&
+			    c->c_runqueue.tl_count >= one_share) {
 				continue;
 			}
 
+			threadlist_remove(&victims, t);
 			t->t_cpu = c;
-			threadlist_addtail(&c->c_runqueue, t);
+			thread_runqueue_add(c, t);
 			DEBUG(DB_THREADS,
 			      "Migrated thread %s: cpu %u -> %u",
 			      t->t_name, curcpu->c_number, c->c_number);
-			to_send--;
 			if (c->c_isidle) {
 				/*
 				 * Other processor is idle; send
@@ -947,7 +1355,7 @@ thread_consider_migration(void)
 	if (!threadlist_isempty(&victims)) {
 		spinlock_acquire(&curcpu->c_runqueue_lock);
 		while ((t = threadlist_remhead(&victims)) != NULL) {
-			threadlist_addtail(&curcpu->c_runqueue, t);
+			thread_runqueue_add(curcpu->c_self, t);
 		}
 		spinlock_release(&curcpu->c_runqueue_lock);
 	}
@@ -958,6 +1366,134 @@ thread_consider_migration(void)
 
 ////////////////////////////////////////////////////////////
 
+/*
+ * CPU affinity.
+ */
+
+/*
+ * Placeholder thread for thread_setaffinity; see below.
+ */
+static
+void
+thread_affinity_bounce(void *junk1, unsigned long junk2)
+{
+	(void)junk1;
+	(void)junk2;
+}
+
+/*
+ * Make a thread that's not allowed on cpu C get off it. When it
+ * yields (at the next clock tick if not sooner) thread_switch sets
+ * it aside for the next thread on C to send on, but if C has nothing
+ * else to run it just keeps running the thread. So give it something
+ * to do: a thread that's pinned to C and exits right away. It has the
+ * lowest priority so it doesn't run first and leave C empty again.
+ */
+static
+int
+thread_affinity_kick(struct cpu *c)
+{
+	return thread_fork_with("affinity", kproc,
+				CPUMASK_BIT(c->c_number), PRI_MIN,
+				thread_affinity_bounce, NULL, 0);
+}
+
+/*
+ * Change T's affinity mask, with the run queue of T's cpu locked, and
+ * return the old mask. If T is running or waiting to run on that cpu
+ * and isn't allowed there any more, also hand back the cpu in
+ * KICKCPU so it can be kicked; otherwise that's set to NULL.
+ */
+static
+uint32_t
+thread_setmask(struct thread *t, uint32_t mask, struct cpu **kickcpu)
+{
+	struct cpu *c;
+	uint32_t oldmask;
+
+	/* T can change cpus while we wait for the lock; recheck. */
+	while (1) {
+		c = t->t_cpu;
+		spinlock_acquire(&c->c_runqueue_lock);
+		if (t->t_cpu == c) {
+			break;
+		}
+		spinlock_release(&c->c_runqueue_lock);
+	}
+	oldmask = t->t_cpumask;
+	t->t_cpumask = mask;
+	if (!thread_cpu_allowed(t, c) &&
+	    (t->t_state != S_SLEEP || c->c_curthread == t)) {
+		*kickcpu = c;
+	}
+	else {
+		*kickcpu = NULL;
+	}
+	spinlock_release(&c->c_runqueue_lock);
+	return oldmask;
+}
+
+/*
+ * Set the set of CPUs thread T may run on. MASK has one bit per CPU,
+ * by CPU number; bits for CPUs that don't exist are ignored, but at
+ * least one CPU that does must be included.
+ *
+ * T must be curthread or a thread of the current process. If it's
+ * asleep it moves when it's woken up; if it's running or waiting to
+ * run on a cpu it isn't allowed on any more, that cpu is kicked so it
+ * moves soon. If T is curthread we move before returning. If we run
+ * out of memory kicking, the old mask is put back.
+ */
+int
+thread_setaffinity(struct thread *t, uint32_t mask)
+{
+	struct cpu *c;
+	uint32_t oldmask, allmask;
+	unsigned numcpus;
+	int result;
+
+	numcpus = cpuarray_num(&allcpus);
+	allmask = numcpus >= 32 ? CPUMASK_ALL : CPUMASK_BIT(numcpus) - 1;
+	if ((mask & allmask) == 0) {
+		return EINVAL;
+	}
+
+	oldmask = thread_setmask(t, mask, &c);
+	if (t != curthread) {
+		if (c != NULL) {
+			result = thread_affinity_kick(c);
+			if (result) {
+				thread_setmask(t, oldmask, &c);
+				return result;
+			}
+		}
+		return 0;
+	}
+
+	while (!thread_cpu_allowed(t, curcpu->c_self)) {
+		if (threadlist_isempty(&curcpu->c_runqueue)) {
+			result = thread_affinity_kick(curcpu->c_self);
+			if (result) {
+				thread_setmask(t, oldmask, &c);
+				return result;
+			}
+		}
+		thread_yield();
+	}
+	return 0;
+}
+
+/*
+ * Get the set of CPUs thread T may run on.
+ */
+uint32_t
+thread_getaffinity(struct thread *t)
+{
+	return t->t_cpumask;
+}
+
+////////////////////////////////////////////////////////////
+
 /*
  * Wait channel functions
  */
@@ -1020,9 +1556,10 @@ wchan_sleep(struct wchan *wc, struct spinlock *lk)
 }
 
 /*
- * Wake up one thread sleeping on a wait channel.
+ * Wake up one thread sleeping on a wait channel. Return it, or NULL
+ * if there wasn't one.
  */
-void
+struct thread *
 wchan_wakeone(struct wchan *wc, struct spinlock *lk)
 {
 	struct thread *target;
@@ -1034,7 +1571,7 @@ wchan_wakeone(struct wchan *wc, struct spinlock *lk)
 
 	if (target == NULL) {
 		/* Nobody was sleeping. */
-		return;
+		return NULL;
 	}
 
 	/*
@@ -1046,6 +1583,7 @@ wchan_wakeone(struct wchan *wc, struct spinlock *lk)
 	 */
 
 	thread_make_runnable(target, false);
+	return target;
 }
 
 /*
@@ -1081,6 +1619,33 @@ wchan_wakeall(struct wchan *wc, struct spinlock *lk)
 	threadlist_cleanup(&list);
 }
 
+/*
+ * Move one thread, or all threads, sleeping on FROM to the end of TO
+ * without waking them up. When they do wake up, wchan_sleep relocks
+ * the spinlock of the channel they originally slept on. Returns the
+ * number of threads moved.
+ */
+unsigned
+wchan_transfer(struct wchan *from, struct spinlock *fromlk,
+	       struct wchan *to, struct spinlock *tolk, bool all)
+{
+	struct thread *target;
+	unsigned moved = 0;
+
+	KASSERT(spinlock_do_i_hold(fromlk));
+	KASSERT(spinlock_do_i_hold(tolk));
+
+	while ((target = threadlist_remhead(&from->wc_threads)) != NULL) {
+		target->t_wchan_name = to->wc_name;
+		threadlist_addtail(&to->wc_threads, target);
+		moved++;
+		if (!all) {
+			break;
+		}
+	}
+	return moved;
+}
+
 /*
  * Return nonzero if there are no threads sleeping on the channel.
  * This is meant to be used only for diagnostic purposes.
@@ -1096,6 +1661,50 @@ wchan_isempty(struct wchan *wc, struct spinlock *lk)
 	return ret;
 }
 
+/*
+ * Wake up a particular thread, if it's sleeping on WC.
+ */
+bool
+wchan_wakethread(struct wchan *wc, struct spinlock *lk, struct thread *t)
+{
+	struct threadlistnode *tln;
+
+	KASSERT(spinlock_do_i_hold(lk));
+
+	for (tln = wc->wc_threads.tl_head.tln_next;
+	     tln->tln_self != NULL;
+	     tln = tln->tln_next) {
+		if (tln->tln_self == t) {
+			threadlist_remove(&wc->wc_threads, t);
+			thread_make_runnable(t, false);
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+ * Return the highest priority of the threads sleeping on WC, or -1.
+ */
+int
+wchan_maxpriority(struct wchan *wc, struct spinlock *lk)
+{
+	struct threadlistnode *tln;
+	int pri;
+
+	KASSERT(spinlock_do_i_hold(lk));
+
+	pri = -1;
+	for (tln = wc->wc_threads.tl_head.tln_next;
+	     tln->tln_self != NULL;
+	     tln = tln->tln_next) {
+		if (tln->tln_self->t_pri > pri) {
+			pri = tln->tln_self->t_pri;
+		}
+	}
+	return pri;
+}
+
 ////////////////////////////////////////////////////////////
 
 /*
@@ -1139,32 +1748,114 @@ ipi_broadcast(int code)
 void
 ipi_tlbshootdown(struct cpu *target, const struct tlbshootdown *mapping)
 {
-	unsigned n;
+	ipi_tlbshootdown_batch(target, mapping, 1);
+}
+
+/*
+ * Queue N TLB shootdowns for the specified CPU and send it one IPI
+ * for all of them. Returns the ticket for ipi_tlbshootdown_wait.
+ *
+ * If the queue won't hold them all, rather than sleeping or panicking
+ * we give up on the individual entries and have the target flush its
+ * whole TLB. That costs it some refaults but is always correct.
+ */
+uint32_t
+ipi_tlbshootdown_batch(struct cpu *target,
+		       const struct tlbshootdown *mappings, unsigned n)
+{
+	unsigned i, num;
+	uint32_t ticket;
 
 	spinlock_acquire(&target->c_ipi_lock);
 
-	n = target->c_numshootdown;
-	if (n == TLBSHOOTDOWN_MAX) {
-		/*
-		 * If you have problems with this panic going off,
-		 * consider: (1) increasing the maximum, (2) putting
-		 * logic here to sleep until space appears (may
-		 * interact awkwardly with VM system locking), (3)
-		 * putting logic here to coalesce requests together,
-		 * and/or (4) improving VM system state tracking to
-		 * reduce the number of unnecessary shootdowns.
-		 */
-		panic("ipi_tlbshootdown: Too many shootdowns queued\n");
+	num = target->c_numshootdown;
+	if (target->c_shootdown_all || n > TLBSHOOTDOWN_MAX - num) {
+		target->c_shootdown_all = true;
+		target->c_numshootdown = 0;
 	}
 	else {
-		target->c_shootdown[n] = *mapping;
-		target->c_numshootdown = n+1;
+		for (i=0; i<n; i++) {
+			target->c_shootdown[num + i] = mappings[i];
+		}
+		target->c_numshootdown = num + n;
 	}
+	ticket = ++target->c_shootdown_reqs;
 
-	target->c_ipi_pending |= (uint32_t)1 << IPI_TLBSHOOTDOWN;
-	mainbus_send_ipi(target);
+	/* Only interrupt it if it isn't already due to look. */
+	if ((target->c_ipi_pending & (1U << IPI_TLBSHOOTDOWN)) == 0) {
+		target->c_ipi_pending |= (uint32_t)1 << IPI_TLBSHOOTDOWN;
+		mainbus_send_ipi(target);
+	}
 
 	spinlock_release(&target->c_ipi_lock);
+	return ticket;
+}
+
+/*
+ * Do the shootdowns queued for the current CPU and acknowledge them.
+ * Call with the current CPU's IPI lock held.
+ */
+static
+void
+ipi_tlbshootdown_run(void)
+{
+	struct tlbshootdown all;
+	unsigned i;
+
+	KASSERT(spinlock_do_i_hold(&curcpu->c_ipi_lock));
+
+	/*
+	 * Note: depending on your VM system locking you might
+	 * need to release the ipi lock while calling
+	 * vm_tlbshootdown.
+	 */
+	if (curcpu->c_shootdown_all) {
+		all.ts_serial = 0;
+		all.ts_entryhi = TLBSHOOTDOWN_ALL;
+		vm_tlbshootdown(&all);
+	}
+	else {
+		for (i=0; i<curcpu->c_numshootdown; i++) {
+			vm_tlbshootdown(&curcpu->c_shootdown[i]);
+		}
+	}
+	curcpu->c_numshootdown = 0;
+	curcpu->c_shootdown_all = false;
+	curcpu->c_ipi_pending &= ~(1U << IPI_TLBSHOOTDOWN);
+
+	membar_store_store();
+	curcpu->c_shootdown_acks = curcpu->c_shootdown_reqs;
+}
+
+/*
+ * Wait for TARGET to finish the shootdowns up through TICKET.
+ *
+ * The counters wrap, so compare by difference. While waiting, do any
+ * shootdowns sent to us; the sender may well be waiting on us too,
+ * and we're at splhigh so the IPI won't get in by itself.
+ */
+void
+ipi_tlbshootdown_wait(struct cpu *target, uint32_t ticket)
+{
+	int spl;
+
+	KASSERT(target != curcpu->c_self);
+
+	spl = splhigh();
+	/* A cpu spinning for a lock we hold would never answer. */
+	KASSERT(curcpu->c_spinlocks == 0);
+	while ((int32_t)(target->c_shootdown_acks - ticket) < 0) {
+		if (curcpu->c_ipi_pending & (1U << IPI_TLBSHOOTDOWN)) {
+			spinlock_acquire(&curcpu->c_ipi_lock);
+			if (curcpu->c_ipi_pending &
+			    (1U << IPI_TLBSHOOTDOWN)) {
+				ipi_tlbshootdown_run();
+			}
+			spinlock_release(&curcpu->c_ipi_lock);
+		}
+	}
+	membar_load_load();
+	splx(spl);
 }
 
 /*
@@ -1174,7 +1865,6 @@ void
 interprocessor_interrupt(void)
 {
 	uint32_t bits;
-	unsigned i;
 
 	spinlock_acquire(&curcpu->c_ipi_lock);
 	bits = curcpu->c_ipi_pending;
@@ -1203,15 +1893,7 @@ interprocessor_interrupt(void)
 		 */
 	}
 	if (bits & (1U << IPI_TLBSHOOTDOWN)) {
-		/*
-		 * Note: depending on your VM system locking you might
-		 * need to release the ipi lock while calling
-		 * vm_tlbshootdown.
-		 */
-		for (i=0; i<curcpu->c_numshootdown; i++) {
-			vm_tlbshootdown(&curcpu->c_shootdown[i]);
-		}
-		curcpu->c_numshootdown = 0;
+		ipi_tlbshootdown_run();
 	}
 
 	curcpu->c_ipi_pending = 0;
@@ -150,6 +150,21 @@ dev_ioctl(struct vnode *v, int op, userptr_t data)
 	return DEVOP_IOCTL(d, op, data);
 }
 
+/*
+ * Called for poll(). Pass through, if the device knows how.
+ */
+static
+int
+dev_poll(struct vnode *v, int events, struct pollset *ps)
+{
+	struct device *d = v->vn_data;
+
+	if (d->d_ops->devop_poll == NULL) {
+		return vnode_pollready(v, events, ps);
+	}
+	return DEVOP_POLL(d, events, ps);
+}
+
 /*
  * Called for stat().
  * Set the type and the size (block devices only).
@@ -335,6 +350,7 @@ static const struct vnode_ops dev_vnode_ops = {
 	.vop_stat = dev_stat,
 	.vop_gettype = dev_gettype,
 	.vop_isseekable = dev_isseekable,
+	.vop_poll = dev_poll,
 	.vop_fsync = null_fsync,
 	.vop_mmap = dev_mmap,
 	.vop_truncate = dev_truncate,
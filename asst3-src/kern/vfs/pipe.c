@@ -0,0 +1,670 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Anonymous pipes. See pipe.h.
+ *
+ * Everything is done under the pipe's lock; readers wait on p_readers
+ * for data and writers wait on p_writers for space.
+ *
+ * Waiting doesn't use a CV, because a thread stuck in a pipe has to
+ * notice when another thread of its process calls _exit. Instead the
+ * waiter puts a record on the pipe's list and sleeps on its process's
+ * nap channel, like poll and clocksleep do; waking the list wakes
+ * each thread there in particular, and proc_exit wakes the whole nap
+ * channel, after which the waiter sees p_exiting and fails with
+ * EINTR. The waiter's record says whether it was really woken, under
+ * its process's p_lock.
+ *
+ * Normally a byte is copied twice, once from the writer into the ring
+ * and once from the ring out to the reader. But if a reader is asleep
+ * waiting on an empty pipe, it leaves its uio in p_rdirect, and the
+ * next writer copies straight from its own buffer into the reader's,
+ * by way of the physical pages behind it. Pages of the reader's buffer
+ * that haven't been touched yet have no physical page to copy into
+ * (and we can't fault them in from here), so the writer stops there
+ * and puts the rest in the ring as usual.
+ */
+
+#include <types.h>
+#include <kern/errno.h>
+#include <kern/poll.h>
+#include <limits.h>
+#include <stat.h>
+#include <lib.h>
+#include <uio.h>
+#include <spinlock.h>
+#include <synch.h>
+#include <wchan.h>
+#include <thread.h>
+#include <current.h>
+#include <proc.h>
+#include <addrspace.h>
+#include <vfs.h>
+#include <vnode.h>
+#include <poll.h>
+#include <pipe.h>
+
+/*
+ * A thread waiting in a pipe. Lives on the waiter's stack.
+ */
+struct pipewaiter {
+	struct thread *pw_thread;
+	struct proc *pw_proc;
+	bool pw_woken;			/* under pw_proc->p_lock */
+	struct pipewaiter *pw_next;
+};
+
+struct pipe {
+	struct lock *p_lock;
+	struct pipewaiter *p_readers;	/* readers wait here for data */
+	struct pipewaiter *p_writers;	/* writers wait here for space */
+
+	char *p_buf;			/* ring buffer */
+	size_t p_size;			/* its size (a power of 2) */
+	size_t p_start;			/* where the data begins */
+	size_t p_count;			/* how much there is */
+
+	bool p_readable;		/* read end still open */
+	bool p_writable;		/* write end still open */
+
+	struct uio *p_rdirect;		/* sleeping reader's uio, or NULL */
+	struct pollhead p_pollhead;	/* for poll() on either end */
+	struct vnode p_rvn;		/* read end */
+	struct vnode p_wvn;		/* write end */
+};
+
+/*
+ * Free a pipe; both ends must be gone.
+ */
+static
+void
+pipe_destroy(struct pipe *p)
+{
+	KASSERT(!p->p_readable && !p->p_writable);
+	KASSERT(p->p_rdirect == NULL);
+	KASSERT(p->p_readers == NULL && p->p_writers == NULL);
+
+	pollhead_cleanup(&p->p_pollhead);
+	kfree(p->p_buf);
+	lock_destroy(p->p_lock);
+	kfree(p);
+}
+
+/*
+ * Wait on LIST until woken. Called with the pipe locked; the lock is
+ * released while sleeping and held again on return. Fails with EINTR
+ * if the process is exiting.
+ */
+static
+int
+pipe_wait(struct pipe *p, struct pipewaiter **list)
+{
+	struct proc *proc = curproc;
+	struct pipewaiter pw, **pwp;
+	int result;
+
+	pw.pw_thread = curthread;
+	pw.pw_proc = proc;
+	pw.pw_woken = false;
+	pw.pw_next = *list;
+	*list = &pw;
+	lock_release(p->p_lock);
+
+	result = 0;
+	spinlock_acquire(&proc->p_lock);
+	while (!pw.pw_woken) {
+		if (proc->p_exiting) {
+			result = EINTR;
+			break;
+		}
+		wchan_sleep(proc->p_napchan, &proc->p_lock);
+	}
+	spinlock_release(&proc->p_lock);
+
+	lock_acquire(p->p_lock);
+	/* If we weren't woken, we're still on the list. */
+	for (pwp = list; *pwp != NULL; pwp = &(*pwp)->pw_next) {
+		if (*pwp == &pw) {
+			*pwp = pw.pw_next;
+			break;
+		}
+	}
+	return result;
+}
+
+/*
+ * Wake everyone waiting on LIST. Called with the pipe locked. Each
+ * record can vanish as soon as its thread is woken, so take it off the
+ * list first.
+ */
+static
+void
+pipe_wakeall(struct pipewaiter **list)
+{
+	struct pipewaiter *pw;
+	struct proc *proc;
+
+	while (*list != NULL) {
+		pw = *list;
+		*list = pw->pw_next;
+		proc = pw->pw_proc;
+
+		spinlock_acquire(&proc->p_lock);
+		pw->pw_woken = true;
+		wchan_wakethread(proc->p_napchan, &proc->p_lock,
+				 pw->pw_thread);
+		spinlock_release(&proc->p_lock);
+	}
+}
+
+/*
+ * Double the ring buffer, if it isn't as big as it gets yet. The data
+ * is moved to the front of the new buffer. Returns false if the buffer
+ * can't grow.
+ */
+static
+bool
+pipe_grow(struct pipe *p)
+{
+	char *newbuf;
+	size_t newsize, first;
+
+	if (p->p_size >= PIPE_MAXBUF) {
+		return false;
+	}
+	newsize = p->p_size * 2;
+	newbuf = kmalloc(newsize);
+	if (newbuf == NULL) {
+		return false;
+	}
+
+	first = p->p_size - p->p_start;
+	if (first > p->p_count) {
+		first = p->p_count;
+	}
+	memcpy(newbuf, p->p_buf + p->p_start, first);
+	memcpy(newbuf + first, p->p_buf, p->p_count - first);
+
+	kfree(p->p_buf);
+	p->p_buf = newbuf;
+	p->p_size = newsize;
+	p->p_start = 0;
+	return true;
+}
+
+/*
+ * Move LEN bytes between UIO and the ring, starting at ring position
+ * POS and wrapping around the end if needed.
+ */
+static
+int
+pipe_ringmove(struct pipe *p, size_t pos, size_t len, struct uio *uio)
+{
+	size_t first;
+	int result;
+
+	pos &= p->p_size - 1;
+	first = p->p_size - pos;
+	if (first > len) {
+		first = len;
+	}
+	result = uiomove(p->p_buf + pos, first, uio);
+	if (result == 0 && len > first) {
+		result = uiomove(p->p_buf, len - first, uio);
+	}
+	return result;
+}
+
+/*
+ * Copy from the writer's UIO straight into the sleeping reader's
+ * buffer, a page at a time, for as long as the reader's pages are
+ * there to copy into. Sets *MOVED to the number of bytes transferred.
+ */
+static
+int
+pipe_direct(struct pipe *p, struct uio *uio, size_t *moved)
+{
+	struct uio *ruio = p->p_rdirect;
+	struct iovec *iov;
+	vaddr_t va;
+	paddr_t pa;
+	size_t len;
+	int result;
+
+	*moved = 0;
+	while (ruio->uio_resid > 0 && uio->uio_resid > 0) {
+		iov = ruio->uio_iov;
+		if (iov->iov_len == 0) {
+			KASSERT(ruio->uio_iovcnt > 1);
+			ruio->uio_iov++;
+			ruio->uio_iovcnt--;
+			continue;
+		}
+
+		va = (vaddr_t)iov->iov_ubase;
+		len = PAGE_SIZE - (va & ~PAGE_FRAME);
+		if (len > iov->iov_len) {
+			len = iov->iov_len;
+		}
+		if (len > uio->uio_resid) {
+			len = uio->uio_resid;
+		}
+
+		if (vm_translate(ruio->uio_space, va, true, &pa)) {
+			break;
+		}
+		result = uiomove((void *)(PADDR_TO_KVADDR(pa) +
+					  (va & ~PAGE_FRAME)), len, uio);
+		if (result) {
+			return result;
+		}
+
+		iov->iov_ubase += len;
+		iov->iov_len -= len;
+		ruio->uio_resid -= len;
+		ruio->uio_offset += len;
+		*moved += len;
+	}
+	return 0;
+}
+
+/*
+ * Read. Wait for data (or for the write end to go away, which is EOF)
+ * and then take as much as there is, up to the size of the request.
+ */
+static
+int
+pipe_read(struct vnode *v, struct uio *uio)
+{
+	struct pipe *p = v->vn_data;
+	size_t len;
+	int result;
+
+	KASSERT(uio->uio_rw == UIO_READ);
+
+	lock_acquire(p->p_lock);
+	while (p->p_count == 0) {
+		if (!p->p_writable || uio->uio_resid == 0) {
+			lock_release(p->p_lock);
+			return 0;
+		}
+		if (p->p_rdirect == NULL &&
+		    uio->uio_segflg == UIO_USERSPACE) {
+			/* Let the next writer hand us the data directly. */
+			p->p_rdirect = uio;
+			result = pipe_wait(p, &p->p_readers);
+			if (p->p_rdirect != uio) {
+				/* The writer filled some in and let go. */
+				break;
+			}
+			p->p_rdirect = NULL;
+		}
+		else {
+			result = pipe_wait(p, &p->p_readers);
+		}
+		if (result) {
+			lock_release(p->p_lock);
+			return result;
+		}
+	}
+
+	/* Take what's in the ring, if anything. */
+	len = p->p_count;
+	if (len > uio->uio_resid) {
+		len = uio->uio_resid;
+	}
+	result = 0;
+	if (len > 0) {
+		result = pipe_ringmove(p, p->p_start, len, uio);
+		if (result == 0) {
+			p->p_start = (p->p_start + len) & (p->p_size - 1);
+			p->p_count -= len;
+			pipe_wakeall(&p->p_writers);
+			pollwakeup(&p->p_pollhead);
+		}
+	}
+	lock_release(p->p_lock);
+	return result;
+}
+
+/*
+ * Write. Hand data directly to a waiting reader if there is one, and
+ * otherwise put it in the ring, growing the ring or waiting for space
+ * as needed. Writes of PIPE_BUF or less wait until the whole thing
+ * fits, so they never get split up.
+ */
+static
+int
+pipe_write(struct vnode *v, struct uio *uio)
+{
+	struct pipe *p = v->vn_data;
+	size_t space, len, want, size;
+	int result;
+
+	KASSERT(uio->uio_rw == UIO_WRITE);
+
+	size = uio->uio_resid;
+	want = size <= PIPE_BUF ? size : 1;
+
+	result = 0;
+	lock_acquire(p->p_lock);
+	while (uio->uio_resid > 0) {
+		if (!p->p_readable) {
+			result = EPIPE;
+			break;
+		}
+
+		if (p->p_count == 0 && p->p_rdirect != NULL) {
+			result = pipe_direct(p, uio, &len);
+			if (result) {
+				break;
+			}
+			if (len > 0) {
+				p->p_rdirect = NULL;
+				pipe_wakeall(&p->p_readers);
+				want = 1;
+				continue;
+			}
+		}
+
+		space = p->p_size - p->p_count;
+		if (space < want || space == 0) {
+			if (!pipe_grow(p)) {
+				result = pipe_wait(p, &p->p_writers);
+				if (result) {
+					break;
+				}
+			}
+			continue;
+		}
+
+		len = uio->uio_resid;
+		if (len > space) {
+			len = space;
+		}
+		result = pipe_ringmove(p, p->p_start + p->p_count, len, uio);
+		if (result) {
+			break;
+		}
+		p->p_count += len;
+		pipe_wakeall(&p->p_readers);
+		pollwakeup(&p->p_pollhead);
+	}
+	lock_release(p->p_lock);
+
+	/* If some of it got through, report that instead of the error. */
+	if ((result == EPIPE || result == EINTR) && uio->uio_resid < size) {
+		result = 0;
+	}
+	return result;
+}
+
+/*
+ * Poll. The read end is readable when there's data, or at EOF (which
+ * is also POLLHUP). The write end is writable when a PIPE_BUF-sized
+ * write would go through without waiting, and gets POLLERR once
+ * there's no reader. Data handed directly to a reader never sits in
+ * the pipe, so it doesn't need to be counted here.
+ */
+static
+int
+pipe_poll(struct vnode *v, int events, struct pollset *ps)
+{
+	struct pipe *p = v->vn_data;
+	int ret;
+
+	ret = 0;
+	lock_acquire(p->p_lock);
+	if (v == &p->p_rvn) {
+		if (p->p_count > 0) {
+			ret |= events & POLLIN;
+		}
+		if (!p->p_writable) {
+			ret |= (events & POLLIN) | POLLHUP;
+		}
+	}
+	else {
+		if (!p->p_readable) {
+			ret |= POLLERR;
+		}
+		else if (p->p_size - p->p_count >= PIPE_BUF ||
+			 p->p_size < PIPE_MAXBUF) {
+			ret |= events & POLLOUT;
+		}
+	}
+	if (ret == 0 && ps != NULL) {
+		pollrecord(&p->p_pollhead, ps);
+	}
+	lock_release(p->p_lock);
+	return ret;
+}
+
+/*
+ * Last reference to one end went away. Tell the other side; if it's
+ * gone too, the pipe goes.
+ */
+static
+int
+pipe_reclaim(struct vnode *v)
+{
+	struct pipe *p = v->vn_data;
+	bool destroy;
+
+	lock_acquire(p->p_lock);
+	if (v == &p->p_rvn) {
+		p->p_readable = false;
+		pipe_wakeall(&p->p_writers);
+	}
+	else {
+		KASSERT(v == &p->p_wvn);
+		p->p_writable = false;
+		pipe_wakeall(&p->p_readers);
+	}
+	pollwakeup(&p->p_pollhead);
+	destroy = !p->p_readable && !p->p_writable;
+	lock_release(p->p_lock);
+
+	vnode_cleanup(v);
+	if (destroy) {
+		pipe_destroy(p);
+	}
+	return 0;
+}
+
+/*
+ * Called on each open; but pipes can't be opened by name.
+ */
+static
+int
+pipe_eachopen(struct vnode *v, int flags)
+{
+	(void)v;
+	(void)flags;
+	return EINVAL;
+}
+
+/*
+ * No ioctls.
+ */
+static
+int
+pipe_ioctl(struct vnode *v, int op, userptr_t data)
+{
+	(void)v;
+	(void)op;
+	(void)data;
+	return EINVAL;
+}
+
+/*
+ * Return the type.
+ */
+static
+int
+pipe_gettype(struct vnode *v, mode_t *ret)
+{
+	(void)v;
+	*ret = S_IFIFO;
+	return 0;
+}
+
+/*
+ * For stat(). The size is how much is waiting to be read.
+ */
+static
+int
+pipe_stat(struct vnode *v, struct stat *statbuf)
+{
+	struct pipe *p = v->vn_data;
+
+	bzero(statbuf, sizeof(struct stat));
+	statbuf->st_mode = S_IFIFO | 0600;
+	statbuf->st_nlink = 1;
+	statbuf->st_blksize = PIPE_BUF;
+
+	lock_acquire(p->p_lock);
+	statbuf->st_size = p->p_count;
+	lock_release(p->p_lock);
+	return 0;
+}
+
+/*
+ * Pipes can't seek.
+ */
+static
+bool
+pipe_isseekable(struct vnode *v)
+{
+	(void)v;
+	return false;
+}
+
+/*
+ * Nothing to sync.
+ */
+static
+int
+pipe_fsync(struct vnode *v)
+{
+	(void)v;
+	return 0;
+}
+
+/*
+ * Can't truncate.
+ */
+static
+int
+pipe_truncate(struct vnode *v, off_t len)
+{
+	(void)v;
+	(void)len;
+	return EINVAL;
+}
+
+/*
+ * Function table for pipe vnodes.
+ */
+static const struct vnode_ops pipe_vnode_ops = {
+	.vop_magic = VOP_MAGIC,
+
+	.vop_eachopen = pipe_eachopen,
+	.vop_reclaim = pipe_reclaim,
+	.vop_read = pipe_read,
+	.vop_readlink = vopfail_uio_inval,
+	.vop_getdirentry = vopfail_uio_notdir,
+	.vop_write = pipe_write,
+	.vop_ioctl = pipe_ioctl,
+	.vop_stat = pipe_stat,
+	.vop_gettype = pipe_gettype,
+	.vop_isseekable = pipe_isseekable,
+	.vop_poll = pipe_poll,
+	.vop_fsync = pipe_fsync,
+	.vop_mmap = vopfail_mmap_nosys,
+	.vop_truncate = pipe_truncate,
+	.vop_namefile = vopfail_uio_nosys,
+	.vop_creat = vopfail_creat_notdir,
+	.vop_symlink = vopfail_symlink_notdir,
+	.vop_mkdir = vopfail_mkdir_notdir,
+	.vop_link = vopfail_link_notdir,
+	.vop_remove = vopfail_string_notdir,
+	.vop_rmdir = vopfail_string_notdir,
+	.vop_rename = vopfail_rename_notdir,
+	.vop_lookup = vopfail_lookup_notdir,
+	.vop_lookparent = vopfail_lookparent_notdir,
+};
+
+/*
+ * Create a pipe.
+ */
+int
+pipe_create(struct vnode **readret, struct vnode **writeret)
+{
+	struct pipe *p;
+	int result;
+
+	p = kmalloc(sizeof(*p));
+	if (p == NULL) {
+		return ENOMEM;
+	}
+	p->p_buf = kmalloc(PAGE_SIZE);
+	if (p->p_buf == NULL) {
+		goto fail_pipe;
+	}
+	p->p_lock = lock_create("pipe");
+	if (p->p_lock == NULL) {
+		goto fail_buf;
+	}
+	p->p_readers = NULL;
+	p->p_writers = NULL;
+
+	p->p_size = PAGE_SIZE;
+	p->p_start = 0;
+	p->p_count = 0;
+	p->p_readable = true;
+	p->p_writable = true;
+	p->p_rdirect = NULL;
+	pollhead_init(&p->p_pollhead);
+
+	result = vnode_init(&p->p_rvn, &pipe_vnode_ops, NULL, p);
+	KASSERT(result == 0);
+	result = vnode_init(&p->p_wvn, &pipe_vnode_ops, NULL, p);
+	KASSERT(result == 0);
+
+	*readret = &p->p_rvn;
+	*writeret = &p->p_wvn;
+	return 0;
+
+ fail_buf:
+	kfree(p->p_buf);
+ fail_pipe:
+	kfree(p);
+	return ENOMEM;
+}
@@ -90,6 +90,15 @@ DEFARRAY(knowndev, static __UNUSED inline);
 
 static struct knowndevarray *knowndevs;
 
+/*
+ * Lock for knowndevs. Changes to the list (adding devices, mounting,
+ * unmounting) take it exclusive, and still hold the big lock as well;
+ * looking up names (vfs_getroot, vfs_getdevname) takes it shared and
+ * doesn't need the big lock. Lock ordering: vfs_biglock before
+ * knowndevs_lock.
+ */
+static struct rwlock *knowndevs_lock;
+
 /* The big lock for all FS ops. Remove for filesystem assignment. */
 static struct lock *vfs_biglock;
 static unsigned vfs_biglock_depth;
@@ -106,6 +115,11 @@ vfs_bootstrap(void)
 		panic("vfs: Could not create knowndevs array\n");
 	}
 
+	knowndevs_lock = rwlock_create("knowndevs");
+	if (knowndevs_lock==NULL) {
+		panic("vfs: Could not create knowndevs lock\n");
+	}
+
 	vfs_biglock = lock_create("vfs_biglock");
 	if (vfs_biglock==NULL) {
 		panic("vfs: Could not create vfs big lock\n");
@@ -199,8 +213,9 @@ vfs_getroot(const char *devname, struct vnode **ret)
 {
 	struct knowndev *kd;
 	unsigned i, num;
+	int result;
 
-	KASSERT(vfs_biglock_do_i_hold());
+	rwlock_acquire_read(knowndevs_lock);
 
 	num = knowndevarray_num(knowndevs);
 	for (i=0; i<num; i++) {
@@ -221,12 +236,15 @@ vfs_getroot(const char *devname, struct vnode **ret)
 
 			if (!strcmp(kd->kd_name, devname) ||
 			    (volname!=NULL && !strcmp(volname, devname))) {
-				return FSOP_GETROOT(kd->kd_fs, ret);
+				result = FSOP_GETROOT(kd->kd_fs, ret);
+				rwlock_release_read(knowndevs_lock);
+				return result;
 			}
 		}
 		else {
 			if (kd->kd_rawname!=NULL &&
 			    !strcmp(kd->kd_name, devname)) {
+				rwlock_release_read(knowndevs_lock);
 				return ENXIO;
 			}
 		}
@@ -242,6 +260,7 @@ vfs_getroot(const char *devname, struct vnode **ret)
 			KASSERT(kd->kd_device != NULL);
 			VOP_INCREF(kd->kd_vnode);
 			*ret = kd->kd_vnode;
+			rwlock_release_read(knowndevs_lock);
 			return 0;
 		}
 
@@ -253,6 +272,7 @@ vfs_getroot(const char *devname, struct vnode **ret)
 			KASSERT(kd->kd_device != NULL);
 			VOP_INCREF(kd->kd_vnode);
 			*ret = kd->kd_vnode;
+			rwlock_release_read(knowndevs_lock);
 			return 0;
 		}
 
@@ -267,6 +287,7 @@ vfs_getroot(const char *devname, struct vnode **ret)
 	 * If we got here, the device specified by devname doesn't exist.
 	 */
 
+	rwlock_release_read(knowndevs_lock);
 	return ENODEV;
 }
 
@@ -281,7 +302,7 @@ vfs_getdevname(struct fs *fs)
 
 	KASSERT(fs != NULL);
 
-	KASSERT(vfs_biglock_do_i_hold());
+	rwlock_acquire_read(knowndevs_lock);
 
 	num = knowndevarray_num(knowndevs);
 	for (i=0; i<num; i++) {
@@ -294,10 +315,12 @@ vfs_getdevname(struct fs *fs)
 			 * the fs cannot go away, and the device can't
 			 * go away until the fs goes away.
 			 */
+			rwlock_release_read(knowndevs_lock);
 			return kd->kd_name;
 		}
 	}
 
+	rwlock_release_read(knowndevs_lock);
 	return NULL;
 }
 
@@ -402,6 +425,7 @@ vfs_doadd(const char *dname, int mountable, struct device *dev, struct fs *fs)
 	index = 0;
 
 	vfs_biglock_acquire();
+	rwlock_acquire_write(knowndevs_lock);
 
 	name = kstrdup(dname);
 	if (name==NULL) {
@@ -453,6 +477,7 @@ vfs_doadd(const char *dname, int mountable, struct device *dev, struct fs *fs)
 		dev->d_devnumber = index+1;
 	}
 
+	rwlock_release_write(knowndevs_lock);
 	vfs_biglock_release();
 	return 0;
 
@@ -470,6 +495,7 @@ vfs_doadd(const char *dname, int mountable, struct device *dev, struct fs *fs)
 		kfree(kd);
 	}
 
+	rwlock_release_write(knowndevs_lock);
 	vfs_biglock_release();
 	return result;
 }
@@ -510,6 +536,7 @@ findmount(const char *devname, struct knowndev **result)
 	bool found = false;
 
 	KASSERT(vfs_biglock_do_i_hold());
+	KASSERT(rwlock_do_i_hold_write(knowndevs_lock));
 
 	num = knowndevarray_num(knowndevs);
 	for (i=0; !found && i<num; i++) {
@@ -544,14 +571,17 @@ vfs_mount(const char *devname, void *data,
 	int result;
 
 	vfs_biglock_acquire();
+	rwlock_acquire_write(knowndevs_lock);
 
 	result = findmount(devname, &kd);
 	if (result) {
+		rwlock_release_write(knowndevs_lock);
 		vfs_biglock_release();
 		return result;
 	}
 
 	if (kd->kd_fs != NULL) {
+		rwlock_release_write(knowndevs_lock);
 		vfs_biglock_release();
 		return EBUSY;
 	}
@@ -560,6 +590,7 @@ vfs_mount(const char *devname, void *data,
 
 	result = mountfunc(data, kd->kd_device, &fs);
 	if (result) {
+		rwlock_release_write(knowndevs_lock);
 		vfs_biglock_release();
 		return result;
 	}
@@ -573,6 +604,7 @@ vfs_mount(const char *devname, void *data,
 	kprintf("vfs: Mounted %s: on %s\n",
 		volname ? volname : kd->kd_name, kd->kd_name);
 
+	rwlock_release_write(knowndevs_lock);
 	vfs_biglock_release();
 	return 0;
 }
@@ -602,6 +634,7 @@ vfs_swapon(const char *devname, struct vnode **ret)
 	}
 
 	vfs_biglock_acquire();
+	rwlock_acquire_write(knowndevs_lock);
 
 	result = findmount(devname, &kd);
 	if (result) {
@@ -622,6 +655,7 @@ vfs_swapon(const char *devname, struct vnode **ret)
 	*ret = kd->kd_vnode;
 
  out:
+	rwlock_release_write(knowndevs_lock);
 	vfs_biglock_release();
 	if (myname != NULL) {
 		kfree(myname);
@@ -641,6 +675,7 @@ vfs_unmount(const char *devname)
 	int result;
 
 	vfs_biglock_acquire();
+	rwlock_acquire_write(knowndevs_lock);
 
 	result = findmount(devname, &kd);
 	if (result) {
@@ -673,6 +708,7 @@ vfs_unmount(const char *devname)
 	KASSERT(result==0);
 
  fail:
+	rwlock_release_write(knowndevs_lock);
 	vfs_biglock_release();
 	return result;
 }
@@ -691,6 +727,7 @@ vfs_swapoff(const char *devname)
 	int result;
 
 	vfs_biglock_acquire();
+	rwlock_acquire_write(knowndevs_lock);
 
 	result = findmount(devname, &kd);
 	if (result) {
@@ -710,6 +747,7 @@ vfs_swapoff(const char *devname)
 	KASSERT(result==0);
 
  fail:
+	rwlock_release_write(knowndevs_lock);
 	vfs_biglock_release();
 	return result;
 }
@@ -725,6 +763,7 @@ vfs_unmountall(void)
 	int result;
 
 	vfs_biglock_acquire();
+	rwlock_acquire_write(knowndevs_lock);
 
 	num = knowndevarray_num(knowndevs);
 	for (i=0; i<num; i++) {
@@ -780,6 +819,7 @@ vfs_unmountall(void)
 		dev->kd_fs = NULL;
 	}
 
+	rwlock_release_write(knowndevs_lock);
 	vfs_biglock_release();
 
 	return 0;
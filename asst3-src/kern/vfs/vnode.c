@@ -32,6 +32,7 @@
  */
 #include <types.h>
 #include <kern/errno.h>
+#include <kern/poll.h>
 #include <lib.h>
 #include <synch.h>
 #include <vfs.h>
@@ -122,6 +123,18 @@ vnode_decref(struct vnode *vn)
 	}
 }
 
+/*
+ * vop_poll for objects that never block, like regular files and
+ * directories: everything is always ready.
+ */
+int
+vnode_pollready(struct vnode *vn, int events, struct pollset *ps)
+{
+	(void)vn;
+	(void)ps;
+	return events & (POLLIN | POLLOUT);
+}
+
 /*
  * Check for various things being valid.
  * Called before all VOP_* calls.
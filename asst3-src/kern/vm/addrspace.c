@@ -32,7 +32,10 @@
 #include <lib.h>
 #include <spl.h>
 #include <spinlock.h>
+#include <membar.h>
+#include <cpu.h>
 #include <current.h>
+#include <thread.h>
 #include <mips/tlb.h>
 #include <addrspace.h>
 #include <vm.h>
@@ -49,6 +52,63 @@
  * part of the VM subsystem.
  *
  */
+
+/*
+ * Each address space gets a serial number that's never reused (well,
+ * not for 2^32 address spaces), and each CPU remembers the serial of
+ * the one whose entries are in its TLB. Switching between threads of
+ * the same process, or to a kernel thread and back, then doesn't need
+ * to flush the TLB. The region list is only ever appended to once the
+ * process is running (for thread stacks); vm_fault reads it without
+ * locking, so new regions are filled in before they're linked in.
+ */
+static struct spinlock as_spinlock = SPINLOCK_INITIALIZER;
+static uint32_t as_nextserial = 1;
+
+static
+uint32_t
+as_newserial(void)
+{
+	uint32_t serial;
+
+	spinlock_acquire(&as_spinlock);
+	serial = as_nextserial++;
+	if (as_nextserial == 0) {
+		as_nextserial = 1;
+	}
+	spinlock_release(&as_spinlock);
+	return serial;
+}
+
+/*
+ * Invalidate this CPU's whole TLB, which will from now on hold entries
+ * from address space AS. Call at splhigh.
+ *
+ * AS also remembers every CPU that has ever had its entries loaded, so
+ * TLB shootdowns (see tlbbatch_flush) need only interrupt those. The
+ * bit is set before any entry can be loaded and never cleared; a CPU
+ * that has moved on to another address space just ignores the IPI.
+ */
+static
+void
+as_flushtlb(struct addrspace *as)
+{
+	uint32_t mybit;
+
+	for (int i = 0; i < NUM_TLB; i++)
+	{
+		tlb_write(TLBHI_INVALID(i), TLBLO_INVALID(), i);
+	}
+	curcpu->c_lastas = as -> as_serial;
+
+	mybit = CPUMASK_BIT(curcpu->c_number);
+	if ((as -> as_cpus & mybit) == 0)
+	{
+		spinlock_acquire(&as_spinlock);
+		as -> as_cpus |= mybit;
+		spinlock_release(&as_spinlock);
+	}
+}
 struct as_region *
 create_region(vaddr_t v, size_t s, mode_t m)
 {
@@ -86,6 +146,9 @@ as_create(void)
 	as_count += 1;
 	as -> header = NULL;
 	as -> id = as_count << 6;
+	as -> as_serial = as_newserial();
+	as -> as_stackslots = 0;
+	as -> as_cpus = 0;
 	return as;
 }
 
@@ -120,6 +183,7 @@ as_copy(struct addrspace *old, struct addrspace **ret)
 		new_ptr = new_ptr -> next_region;
 		old_ptr = old_ptr -> next_region;
 	}
+	newas -> as_stackslots = old -> as_stackslots;
 	*ret = newas;
 	uint32_t oldid = old -> id, newid = newas -> id;
 	uint32_t new_cnt = 0, empty_cnt = 0, new_frame, old_frame, old_page;
@@ -253,13 +317,14 @@ as_activate(void)
 	}
 
 	/*
-	 * Write this.
+	 * If the TLB already holds this address space's entries (and
+	 * no other's), leave them.
 	 */
 	int spl;
 	spl = splhigh();
-	for (int i = 0; i < NUM_TLB; i++)
+	if (curcpu->c_lastas != as -> as_serial)
 	{
-		tlb_write(TLBHI_INVALID(i), TLBLO_INVALID(), i);
+		as_flushtlb(as);
 	}
 	splx(spl); // restore
 }
@@ -356,6 +421,17 @@ as_complete_load(struct addrspace *as)
 		cur -> mode = cur -> mode >> 8;
 		cur = cur -> next_region;	
 	}
+
+	/*
+	 * TLB entries loaded while the segments were writable must not
+	 * survive. Take a new serial so any CPU we've been on flushes
+	 * the next time it activates us, and flush this one now.
+	 */
+	int spl;
+	as -> as_serial = as_newserial();
+	spl = splhigh();
+	as_flushtlb(as);
+	splx(spl);
 	return 0;
 }
 
@@ -376,9 +452,62 @@ as_define_stack(struct addrspace *as, vaddr_t *stackptr)
 	if (stack_region == NULL)
 		return ENOMEM;
 	cur -> next_region = stack_region; 
+	as -> as_stackslots |= 1;
 	/* Initial user-level stack pointer */
 	*stackptr = USERSTACK;
 
 	return 0;
 }
 
+/*
+ * Stack for user thread SLOT. The stacks go down from the main one,
+ * each with an unmapped guard page below it so that running off the
+ * end of one faults instead of scribbling on the next. Once defined,
+ * a thread stack stays in place for the next thread in the slot; its
+ * pages aren't freed until the address space is.
+ *
+ * Other threads can be running (and faulting) while this happens.
+ */
+int
+as_define_threadstack(struct addrspace *as, unsigned slot, vaddr_t *stackptr)
+{
+	struct as_region *stack_region, *cur;
+	vaddr_t stacktop;
+
+	KASSERT(slot > 0 && slot < 32);
+	KASSERT(as -> as_stackslots & 1);
+
+	stacktop = USERSTACK - slot * (STACKPAGES + 1) * PAGE_SIZE;
+	*stackptr = stacktop;
+
+	spinlock_acquire(&as_spinlock);
+	if (as -> as_stackslots & ((uint32_t)1 << slot))
+	{
+		spinlock_release(&as_spinlock);
+		return 0;
+	}
+	spinlock_release(&as_spinlock);
+
+	stack_region = create_region(stacktop - STACKPAGES * PAGE_SIZE, STACKPAGES, (PF_W | PF_R));
+	if (stack_region == NULL)
+		return ENOMEM;
+
+	spinlock_acquire(&as_spinlock);
+	if (as -> as_stackslots & ((uint32_t)1 << slot))
+	{
+		/* Somebody beat us to it. */
+		spinlock_release(&as_spinlock);
+		kfree(stack_region);
+		return 0;
+	}
+	cur = as -> header;
+	while(cur -> next_region != NULL)
+		cur = cur -> next_region;
+	membar_store_store();
+	cur -> next_region = stack_region;
+	as -> as_stackslots |= (uint32_t)1 << slot;
+	spinlock_release(&as_spinlock);
+
+	return 0;
+}
+
@@ -163,10 +163,11 @@ struct pageref {
  * Use one spinlock for the whole thing. Making parts of the kmalloc
  * logic per-cpu is worthwhile for scalability; however, for the time
  * being at least we won't, because it adds a lot of complexity and in
- * OS/161 performance and scalability aren't super-critical.
+ * OS/161 performance and scalability aren't super-critical. It is a
+ * ticket lock, though, so at least the CPUs waiting for it take turns.
  */
 
-static struct spinlock kmalloc_spinlock = SPINLOCK_INITIALIZER;
+static struct spinlock kmalloc_spinlock = SPINLOCK_TICKET_INITIALIZER;
 
 ////////////////////////////////////////
 
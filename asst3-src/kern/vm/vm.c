@@ -9,6 +9,8 @@
 #include <current.h>
 #include <proc.h>
 #include <spl.h>
+#include <cpu.h>
+#include <membar.h>
 
 /* Place your page table functions here */
 // static struct spinlock stealmem_lock = SPINLOCK_INITIALIZER;
@@ -153,6 +155,8 @@ vm_fault(int faulttype, vaddr_t faultaddress)
             tlb_random(hpt[hi].entryHI, hpt[hi].entryLO|dirtybit);
             splx(spl);
             lock_release(hpt_lock);
+            /* nothing here needs I/O, so every fault is minor */
+            curthread->t_usage.u_minflt++;
             return 0;
         } else if (hpt[hi].entryLO != 0 && hpt[hi].next != -1) {
             hi = hpt[hi].next;
@@ -180,17 +184,166 @@ vm_fault(int faulttype, vaddr_t faultaddress)
     tlb_random(faultaddress, newframe|dirtybit);
     splx(spl);
     lock_release(hpt_lock);
+    curthread->t_usage.u_minflt++;
     return 0;
 }
 
 /*
- * SMP-specific functions.  Unused in our UNSW configuration.
+ * Find the physical page behind user address VADDR in address space
+ * AS, which need not be the current one, without faulting it in. If
+ * WRITE is set the page must also be in a writable region. Fails
+ * with EFAULT if the page isn't mapped (yet); callers that can't take
+ * the fault in AS's own context are expected to fall back to doing
+ * things the slow way. The page stays put as long as AS does.
+ */
+int
+vm_translate(struct addrspace *as, vaddr_t vaddr, bool write, paddr_t *ret)
+{
+	struct as_region *reg;
+	uint32_t hi, idx;
+
+	vaddr &= PAGE_FRAME;
+	for (reg = as->header; reg != NULL; reg = reg->next_region) {
+		if ((reg->vbase & PAGE_FRAME) <= vaddr &&
+		    ((reg->vbase >> 12) + reg->size) << 12 > vaddr) {
+			break;
+		}
+	}
+	if (reg == NULL || (write && (reg->mode & 2) == 0)) {
+		return EFAULT;
+	}
+
+	hi = vaddr | as->id;
+	lock_acquire(hpt_lock);
+	idx = hash_func(as, hi);
+	while (1) {
+		if (hpt[idx].entryHI == hi && hpt[idx].entryLO != 0) {
+			*ret = hpt[idx].entryLO & PAGE_FRAME;
+			lock_release(hpt_lock);
+			return 0;
+		}
+		if (hpt[idx].entryLO == 0 || hpt[idx].next == -1) {
+			break;
+		}
+		idx = hpt[idx].next;
+	}
+	lock_release(hpt_lock);
+	return EFAULT;
+}
+
+/*
+ * SMP-specific functions.
  */
 
+/*
+ * Invalidate one TLB entry, or all of them, on this cpu. Nothing to do
+ * if the TLB is holding some other address space.
+ */
 void
 vm_tlbshootdown(const struct tlbshootdown *ts)
 {
-	(void)ts;
-	panic("vm tried to do tlb shootdown?!\n");
+	int i, spl;
+
+	spl = splhigh();
+	if (ts->ts_serial != 0 && ts->ts_serial != curcpu->c_lastas) {
+		splx(spl);
+		return;
+	}
+	if (ts->ts_entryhi == TLBSHOOTDOWN_ALL) {
+		for (i=0; i<NUM_TLB; i++) {
+			tlb_write(TLBHI_INVALID(i), TLBLO_INVALID(), i);
+		}
+	}
+	else {
+		i = tlb_probe(ts->ts_entryhi, 0);
+		if (i >= 0) {
+			tlb_write(TLBHI_INVALID(i), TLBLO_INVALID(), i);
+		}
+	}
+	splx(spl);
+}
+
+void
+tlbbatch_init(struct tlbbatch *tb, struct addrspace *as)
+{
+	tb->tb_as = as;
+	tb->tb_num = 0;
+	tb->tb_all = false;
+}
+
+void
+tlbbatch_add(struct tlbbatch *tb, vaddr_t vaddr)
+{
+	struct tlbshootdown *ts;
+
+	if (tb->tb_all) {
+		return;
+	}
+	if (tb->tb_num == TLBSHOOTDOWN_MAX) {
+		tb->tb_all = true;
+		return;
+	}
+	ts = &tb->tb_ts[tb->tb_num++];
+	ts->ts_serial = tb->tb_as->as_serial;
+	ts->ts_entryhi = (vaddr & PAGE_FRAME) | tb->tb_as->id;
 }
 
+/*
+ * Shoot the batch down everywhere the address space has been loaded.
+ * Send all the IPIs before waiting on any, so the other cpus do their
+ * invalidations at the same time. We stay at splhigh throughout so we
+ * don't move to another cpu partway. No spinlocks may be held; see
+ * vm.h.
+ */
+void
+tlbbatch_flush(struct tlbbatch *tb)
+{
+	struct tlbshootdown all;
+	const struct tlbshootdown *ts;
+	uint32_t cpus, tickets[32];
+	unsigned i, n, ncpus, me;
+	int spl;
+
+	if (tb->tb_all) {
+		all.ts_serial = tb->tb_as->as_serial;
+		all.ts_entryhi = TLBSHOOTDOWN_ALL;
+		ts = &all;
+		n = 1;
+	}
+	else {
+		ts = tb->tb_ts;
+		n = tb->tb_num;
+	}
+	if (n == 0) {
+		return;
+	}
+
+	/* The page table changes must be visible before we look. */
+	membar_any_any();
+	cpus = tb->tb_as->as_cpus;
+	ncpus = cpu_count();
+	if (ncpus > 32) {
+		ncpus = 32;
+	}
+
+	spl = splhigh();
+	KASSERT(curcpu->c_spinlocks == 0);
+	me = curcpu->c_number;
+	for (i=0; i<n; i++) {
+		vm_tlbshootdown(&ts[i]);
+	}
+	for (i=0; i<ncpus; i++) {
+		if (i != me && (cpus & CPUMASK_BIT(i))) {
+			tickets[i] = ipi_tlbshootdown_batch(cpu_get(i), ts, n);
+		}
+	}
+	for (i=0; i<ncpus; i++) {
+		if (i != me && (cpus & CPUMASK_BIT(i))) {
+			ipi_tlbshootdown_wait(cpu_get(i), tickets[i]);
+		}
+	}
+	splx(spl);
+
+	tb->tb_num = 0;
+	tb->tb_all = false;
+}
@@ -421,11 +421,16 @@ docommand(char *buf, struct exitinfo *ei)
 		__time(&startsecs, &startnsecs);
 	}
 
-	pid = fork();
+	/*
+	 * The child only runs execvp, so use vfork: it borrows our
+	 * address space instead of copying it, and we wait until it
+	 * has exec'd or exited.
+	 */
+	pid = vfork();
 	switch (pid) {
 		case -1:
 			/* error */
-			warn("fork");
+			warn("vfork");
 			exitinfo_exit(ei, 255);
 			return;
 		case 0:
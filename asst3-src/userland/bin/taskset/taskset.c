@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ */
+
+/*
+ * taskset - run a program on a restricted set of CPUs
+ * usage: taskset MASK
+ *        taskset MASK PROGRAM [ARGS...]
+ *
+ * MASK is in hex; bit n stands for CPU n. With no program, just
+ * prints the current mask.
+ */
+
+#include <unistd.h>
+#include <stdio.h>
+#include <err.h>
+
+static
+unsigned
+parsemask(const char *s)
+{
+	unsigned mask = 0;
+	int digit;
+
+	if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+		s += 2;
+	}
+	if (*s == 0) {
+		errx(1, "Invalid mask");
+	}
+	for (; *s; s++) {
+		if (*s >= '0' && *s <= '9') {
+			digit = *s - '0';
+		}
+		else if (*s >= 'a' && *s <= 'f') {
+			digit = *s - 'a' + 10;
+		}
+		else if (*s >= 'A' && *s <= 'F') {
+			digit = *s - 'A' + 10;
+		}
+		else {
+			errx(1, "Invalid mask %s", s);
+		}
+		mask = mask*16 + digit;
+	}
+	return mask;
+}
+
+int
+main(int argc, char *argv[])
+{
+	unsigned mask;
+
+	if (argc == 1) {
+		if (getaffinity(0, &mask)) {
+			err(1, "getaffinity");
+		}
+		printf("%x\n", mask);
+		return 0;
+	}
+
+	mask = parsemask(argv[1]);
+	if (setaffinity(0, mask)) {
+		err(1, "setaffinity");
+	}
+	if (argc == 2) {
+		return 0;
+	}
+
+	execv(argv[2], argv+2);
+	err(1, "%s", argv[2]);
+}
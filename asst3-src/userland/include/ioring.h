@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _IORING_H_
+#define _IORING_H_
+
+/*
+ * Helpers for the I/O submission ring (see __ioring_enter(2) and
+ * <kern/ioring.h>). The ring is an ordinary struct ioring, usually a
+ * global since there's no malloc; initialize it with ioring_init.
+ *
+ * ioring_queue and ioring_queue_open add a submission; they fail
+ * with EAGAIN if the submission queue is full. sqe_data is handed
+ * back with the completion. ioring_submit hands everything queued to
+ * the kernel; it's __ioring_enter. ioring_reap takes the next
+ * completion, returning 1, or returns 0 if there are none yet.
+ */
+
+#include <sys/types.h>
+#include <kern/ioring.h>
+
+void ioring_init(struct ioring *ring);
+int ioring_queue(struct ioring *ring, int op, int fd, void *buf, size_t len,
+		 unsigned data);
+int ioring_queue_open(struct ioring *ring, const char *path, int flags,
+		      mode_t mode, unsigned data);
+int ioring_submit(struct ioring *ring, unsigned want, int flags);
+int ioring_reap(struct ioring *ring, struct ioring_cqe *ret);
+
+
+#endif /* _IORING_H_ */
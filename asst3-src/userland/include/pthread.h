@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _PTHREAD_H_
+#define _PTHREAD_H_
+
+/*
+ * POSIX threads, the subset that fits OS/161 (libpthread, -lpthread;
+ * it also needs -lusync).
+ *
+ * Threads are the kernel's user threads (see __thread_create(2));
+ * mutexes and condition variables are libusync's. There are no thread
+ * attributes, mutex types, cancellation, or thread-specific data:
+ * every attribute argument must be NULL, and the destroy calls don't
+ * need to do anything.
+ *
+ * Unlike everything else, these return an error code instead of
+ * setting errno.
+ *
+ * When any thread calls exit() (including by returning from main),
+ * the whole process exits. To end just the main thread, call
+ * pthread_exit. A process can have at most 32 threads, counting the
+ * main thread, and can't exec until it's back down to one.
+ */
+
+#include <sys/cdefs.h>
+#include <usync.h>
+
+typedef int pthread_t;
+typedef struct umutex pthread_mutex_t;
+typedef struct ucond pthread_cond_t;
+
+/* Placeholders; always pass NULL. */
+typedef struct pthread_attr pthread_attr_t;
+typedef struct pthread_mutexattr pthread_mutexattr_t;
+typedef struct pthread_condattr pthread_condattr_t;
+
+#define PTHREAD_MUTEX_INITIALIZER	UMUTEX_INITIALIZER
+#define PTHREAD_COND_INITIALIZER	UCOND_INITIALIZER
+
+int pthread_create(pthread_t *thread, const pthread_attr_t *attr,
+		   void *(*func)(void *), void *arg);
+__DEAD void pthread_exit(void *retval);
+int pthread_join(pthread_t thread, void **retval);
+int pthread_detach(pthread_t thread);
+pthread_t pthread_self(void);
+int pthread_equal(pthread_t t1, pthread_t t2);
+
+int pthread_mutex_init(pthread_mutex_t *m, const pthread_mutexattr_t *attr);
+int pthread_mutex_destroy(pthread_mutex_t *m);
+int pthread_mutex_lock(pthread_mutex_t *m);
+int pthread_mutex_trylock(pthread_mutex_t *m);
+int pthread_mutex_unlock(pthread_mutex_t *m);
+
+int pthread_cond_init(pthread_cond_t *c, const pthread_condattr_t *attr);
+int pthread_cond_destroy(pthread_cond_t *c);
+int pthread_cond_wait(pthread_cond_t *c, pthread_mutex_t *m);
+int pthread_cond_signal(pthread_cond_t *c);
+int pthread_cond_broadcast(pthread_cond_t *c);
+
+
+#endif /* _PTHREAD_H_ */
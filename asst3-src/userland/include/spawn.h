@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _SPAWN_H_
+#define _SPAWN_H_
+
+/*
+ * posix_spawn: start a new process running a program, with no fork.
+ * The new process gets a copy of the file table (as changed by the
+ * file actions, which are done in order) and the current directory;
+ * nothing else of the caller's is copied. See __spawn(2).
+ *
+ * There are no spawn attributes or environment: attr must be NULL and
+ * envp is ignored. With no malloc, the file actions list has room for
+ * SPAWN_MAXACTIONS actions, and addopen keeps PATH rather than a copy
+ * of it, so it must stay valid until posix_spawn is called.
+ *
+ * Like pthreads, these return an error code instead of setting errno.
+ * If the program can't be run, posix_spawn fails with the error execv
+ * would have given, and no process is left behind.
+ */
+
+#include <sys/types.h>
+#include <kern/spawn.h>
+
+typedef struct {
+	unsigned fa_num;
+	struct spawn_action fa_actions[SPAWN_MAXACTIONS];
+} posix_spawn_file_actions_t;
+
+/* Placeholder; always pass NULL. */
+typedef struct posix_spawnattr posix_spawnattr_t;
+
+int posix_spawn_file_actions_init(posix_spawn_file_actions_t *fa);
+int posix_spawn_file_actions_destroy(posix_spawn_file_actions_t *fa);
+int posix_spawn_file_actions_addclose(posix_spawn_file_actions_t *fa,
+				      int fd);
+int posix_spawn_file_actions_adddup2(posix_spawn_file_actions_t *fa,
+				     int fd, int newfd);
+int posix_spawn_file_actions_addopen(posix_spawn_file_actions_t *fa,
+				     int fd, const char *path,
+				     int flags, mode_t mode);
+
+int posix_spawn(pid_t *pid, const char *path,
+		const posix_spawn_file_actions_t *fa,
+		const posix_spawnattr_t *attr,
+		char *const argv[], char *const envp[]);
+
+
+#endif /* _SPAWN_H_ */
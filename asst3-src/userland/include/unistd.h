@@ -39,10 +39,17 @@
  * about the kern/ headers.
  */
 #include <kern/fcntl.h>
+#include <kern/futex.h>
+#include <kern/ioring.h>
 #include <kern/ioctl.h>
+#include <kern/iovec.h>
+#include <kern/poll.h>
 #include <kern/reboot.h>
 #include <kern/seek.h>
+#include <kern/spawn.h>
+#include <kern/systrace.h>
 #include <kern/time.h>
+#include <kern/resource.h>	/* needs struct timeval */
 #include <kern/unistd.h>
 #include <kern/wait.h>
 
@@ -62,6 +69,8 @@
  * header files as well, as follows:
  *
  *     waitpid:  sys/wait.h
+ *     wait4:    sys/wait.h
+ *     getrusage: sys/resource.h
  *     open:     fcntl.h or sys/fcntl.h
  *     reboot:   sys/reboot.h
  *     ioctl:    sys/ioctl.h
@@ -144,12 +153,43 @@ void *sbrk(__intptr_t change);
 ssize_t getdirentry(int filehandle, char *buf, size_t buflen);
 int symlink(const char *target, const char *linkname);
 ssize_t readlink(const char *path, char *buf, size_t buflen);
+ssize_t pread(int filehandle, void *buf, size_t size, off_t pos);
+ssize_t pwrite(int filehandle, const void *buf, size_t size, off_t pos);
+ssize_t readv(int filehandle, const struct iovec *iov, int iovcnt);
+ssize_t writev(int filehandle, const struct iovec *iov, int iovcnt);
+ssize_t preadv(int filehandle, const struct iovec *iov, int iovcnt,
+	       off_t pos);
+ssize_t pwritev(int filehandle, const struct iovec *iov, int iovcnt,
+		off_t pos);
 int dup2(int filehandle, int newhandle);
 int pipe(int filehandles[2]);
+int poll(struct pollfd *fds, unsigned nfds, int timeout);
+int select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
+	   struct timeval *timeout);
 int __time(time_t *seconds, unsigned long *nanoseconds);
 ssize_t __getcwd(char *buf, size_t buflen);
 /* stat - see sys/stat.h */
 /* lstat - see sys/stat.h */
+int setaffinity(pid_t pid, unsigned mask);
+int getaffinity(pid_t pid, unsigned *mask);
+int nanosleep(const struct timespec *req, struct timespec *rem);
+int getitimer(int which, struct itimerval *curval);
+int setitimer(int which, const struct itimerval *newval,
+	      struct itimerval *oldval);
+int futex(volatile int *addr, int op, int val,
+	  const struct timespec *timeout);
+int __thread_create(void (*entry)(void *, void *), void *arg1, void *arg2);
+__DEAD void __thread_exit(void *retval);
+int __thread_join(int tid, void **retval);
+int __thread_detach(int tid);
+int __thread_self(void);
+pid_t vfork(void);
+pid_t __spawn(const char *prog, char *const *args,
+	      const struct spawn_action *actions, unsigned nactions);
+pid_t wait4(pid_t pid, int *returncode, int flags, struct rusage *usage);
+int getrusage(int who, struct rusage *usage);
+int __systrace(int op, void *buf, size_t len);
+int __ioring_enter(struct ioring *ring, unsigned want, int flags);
 
 /*
  * These are not themselves system calls, but wrapper routines in libc.
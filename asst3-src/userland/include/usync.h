@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _USYNC_H_
+#define _USYNC_H_
+
+/*
+ * User-level synchronization (libusync, -lusync).
+ *
+ * Mutexes, counting semaphores, and condition variables for the
+ * threads of one process.
+ * They live in ordinary memory and are updated with atomic
+ * instructions; the kernel (see futex(2)) is only involved when a
+ * thread has to sleep, or there is a sleeper to wake. When there's no
+ * contention, each operation is a few instructions and no system
+ * calls.
+ *
+ * Neither kind needs cleaning up; just stop using it.
+ */
+
+/*
+ * Mutex.
+ *
+ *    umutex_lock    - Get the mutex, sleeping if necessary.
+ *    umutex_trylock - Get the mutex if it's free; returns 0 if we
+ *                     got it and EBUSY if not.
+ *    umutex_unlock  - Release the mutex. Only the holder may do this.
+ */
+struct umutex {
+	volatile int um_state;	/* 0 free, 1 held, 2 held and contended */
+};
+
+#define UMUTEX_INITIALIZER	{ 0 }
+
+void umutex_init(struct umutex *m);
+void umutex_lock(struct umutex *m);
+int umutex_trylock(struct umutex *m);
+void umutex_unlock(struct umutex *m);
+
+/*
+ * Counting semaphore.
+ *
+ *    usem_P    - Wait until the count is positive, then decrement it.
+ *    usem_tryP - Decrement the count if it's positive; returns 0 if
+ *                it was and EAGAIN if not.
+ *    usem_V    - Increment the count, waking a sleeper if any.
+ */
+struct usem {
+	volatile int us_count;		/* Current count */
+	volatile int us_sleepers;	/* Threads in or near futex wait */
+};
+
+#define USEM_INITIALIZER(count)	{ (count), 0 }
+
+void usem_init(struct usem *s, unsigned count);
+void usem_P(struct usem *s);
+int usem_tryP(struct usem *s);
+void usem_V(struct usem *s);
+
+/*
+ * Condition variable, used with a umutex.
+ *
+ *    ucond_wait      - Release the mutex and sleep until signalled,
+ *                      then get the mutex back. As usual, there can
+ *                      be spurious wakeups, so wait in a loop.
+ *    ucond_signal    - Wake one thread waiting on the condition.
+ *    ucond_broadcast - Wake all of them.
+ */
+struct ucond {
+	volatile int uc_seq;		/* Bumped by every signal */
+	volatile int uc_sleepers;	/* Threads in or near futex wait */
+};
+
+#define UCOND_INITIALIZER	{ 0, 0 }
+
+void ucond_init(struct ucond *c);
+void ucond_wait(struct ucond *c, struct umutex *m);
+void ucond_signal(struct ucond *c);
+void ucond_broadcast(struct ucond *c);
+
+
+#endif /* _USYNC_H_ */
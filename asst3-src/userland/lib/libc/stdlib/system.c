@@ -74,7 +74,12 @@ system(const char *cmd)
 
 	argv[nargs] = NULL;
 
-	pid = fork();
+	/*
+	 * The child only execs, so don't have it copy our address
+	 * space. It mustn't return or touch anything of ours but
+	 * argv until then.
+	 */
+	pid = vfork();
 	switch (pid) {
 	    case -1:
 		return -1;
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * ioring.c
+ *
+ *	Helpers for the I/O submission ring.
+ *
+ * The kernel's worker thread may be reading the submission queue and
+ * filling in the completion queue on another CPU while we go, so an
+ * entry has to be all there before the index that covers it moves,
+ * and we mustn't look at a completion before seeing the index that
+ * says it's there.
+ */
+
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <ioring.h>
+
+/*
+ * Memory barrier.
+ */
+static __inline
+void
+ioring_sync(void)
+{
+	__asm volatile(
+		".set push;"		/* save assembler mode */
+		".set mips32;"		/* allow MIPS32 instructions */
+		"sync;"			/* do it */
+		".set pop"		/* restore assembler mode */
+		: : : "memory");
+}
+
+void
+ioring_init(struct ioring *ring)
+{
+	bzero(ring, sizeof(*ring));
+}
+
+/*
+ * Get the next free submission entry, or NULL if it's full.
+ */
+static
+struct ioring_sqe *
+ioring_getsqe(struct ioring *ring)
+{
+	if (ring->ir_sqtail - ring->ir_sqhead >= IORING_ENTRIES) {
+		errno = EAGAIN;
+		return NULL;
+	}
+	return &ring->ir_sq[ring->ir_sqtail % IORING_ENTRIES];
+}
+
+/*
+ * Make a filled-in submission entry visible to the kernel.
+ */
+static
+void
+ioring_push(struct ioring *ring)
+{
+	ioring_sync();
+	ring->ir_sqtail++;
+}
+
+int
+ioring_queue(struct ioring *ring, int op, int fd, void *buf, size_t len,
+	     unsigned data)
+{
+	struct ioring_sqe *sqe;
+
+	sqe = ioring_getsqe(ring);
+	if (sqe == NULL) {
+		return -1;
+	}
+	sqe->sqe_op = op;
+	sqe->sqe_fd = fd;
+	sqe->sqe_buf = buf;
+	sqe->sqe_len = len;
+	sqe->sqe_flags = 0;
+	sqe->sqe_mode = 0;
+	sqe->sqe_data = data;
+	ioring_push(ring);
+	return 0;
+}
+
+int
+ioring_queue_open(struct ioring *ring, const char *path, int flags,
+		  mode_t mode, unsigned data)
+{
+	struct ioring_sqe *sqe;
+
+	sqe = ioring_getsqe(ring);
+	if (sqe == NULL) {
+		return -1;
+	}
+	sqe->sqe_op = IORING_OP_OPEN;
+	sqe->sqe_fd = -1;
+	sqe->sqe_buf = (void *)path;
+	sqe->sqe_len = 0;
+	sqe->sqe_flags = flags;
+	sqe->sqe_mode = mode;
+	sqe->sqe_data = data;
+	ioring_push(ring);
+	return 0;
+}
+
+int
+ioring_submit(struct ioring *ring, unsigned want, int flags)
+{
+	return __ioring_enter(ring, want, flags);
+}
+
+int
+ioring_reap(struct ioring *ring, struct ioring_cqe *ret)
+{
+	if (ring->ir_cqhead == ring->ir_cqtail) {
+		return 0;
+	}
+	ioring_sync();
+	*ret = ring->ir_cq[ring->ir_cqhead % IORING_ENTRIES];
+	ioring_sync();
+	ring->ir_cqhead++;
+	return 1;
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * spawn.c
+ *
+ *	posix_spawn and its file actions, on top of __spawn.
+ *
+ * The file actions are just an array of the structures __spawn takes,
+ * so posix_spawn passes them straight through.
+ */
+
+#include <unistd.h>
+#include <errno.h>
+#include <spawn.h>
+
+int
+posix_spawn_file_actions_init(posix_spawn_file_actions_t *fa)
+{
+	fa->fa_num = 0;
+	return 0;
+}
+
+int
+posix_spawn_file_actions_destroy(posix_spawn_file_actions_t *fa)
+{
+	(void)fa;
+	return 0;
+}
+
+/*
+ * Add an action, with its type and fd filled in, and return it.
+ */
+static
+int
+addaction(posix_spawn_file_actions_t *fa, int type, int fd,
+	  struct spawn_action **ret)
+{
+	struct spawn_action *sa;
+
+	if (fd < 0) {
+		return EBADF;
+	}
+	if (fa->fa_num == SPAWN_MAXACTIONS) {
+		return ENOMEM;
+	}
+	sa = &fa->fa_actions[fa->fa_num++];
+	sa->sa_type = type;
+	sa->sa_fd = fd;
+	sa->sa_newfd = -1;
+	sa->sa_flags = 0;
+	sa->sa_mode = 0;
+	sa->sa_path = NULL;
+	*ret = sa;
+	return 0;
+}
+
+int
+posix_spawn_file_actions_addclose(posix_spawn_file_actions_t *fa, int fd)
+{
+	struct spawn_action *sa;
+
+	return addaction(fa, SPAWN_CLOSE, fd, &sa);
+}
+
+int
+posix_spawn_file_actions_adddup2(posix_spawn_file_actions_t *fa,
+				 int fd, int newfd)
+{
+	struct spawn_action *sa;
+	int result;
+
+	if (newfd < 0) {
+		return EBADF;
+	}
+	result = addaction(fa, SPAWN_DUP2, fd, &sa);
+	if (result) {
+		return result;
+	}
+	sa->sa_newfd = newfd;
+	return 0;
+}
+
+int
+posix_spawn_file_actions_addopen(posix_spawn_file_actions_t *fa,
+				 int fd, const char *path,
+				 int flags, mode_t mode)
+{
+	struct spawn_action *sa;
+	int result;
+
+	result = addaction(fa, SPAWN_OPEN, fd, &sa);
+	if (result) {
+		return result;
+	}
+	sa->sa_flags = flags;
+	sa->sa_mode = mode;
+	sa->sa_path = path;
+	return 0;
+}
+
+int
+posix_spawn(pid_t *pid, const char *path,
+	    const posix_spawn_file_actions_t *fa,
+	    const posix_spawnattr_t *attr,
+	    char *const argv[], char *const envp[])
+{
+	pid_t newpid;
+
+	(void)envp;
+
+	if (attr != NULL) {
+		return EINVAL;
+	}
+
+	if (fa != NULL) {
+		newpid = __spawn(path, argv, fa->fa_actions, fa->fa_num);
+	}
+	else {
+		newpid = __spawn(path, argv, NULL, 0);
+	}
+	if (newpid < 0) {
+		return errno;
+	}
+	if (pid != NULL) {
+		*pid = newpid;
+	}
+	return 0;
+}
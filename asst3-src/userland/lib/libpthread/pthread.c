@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * pthread.c
+ *
+ *	POSIX threads, as far as OS/161 supports them.
+ *
+ * pthread_create hands the kernel pthread_start as the entry point,
+ * with the thread function and its argument as the two arguments;
+ * there's no malloc to put them anywhere else. pthread_start calls
+ * the function and passes what it returns to __thread_exit, which is
+ * what pthread_join collects.
+ */
+
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+
+static
+void
+pthread_start(void *vfunc, void *arg)
+{
+	void *(*func)(void *) = (void *(*)(void *))vfunc;
+
+	__thread_exit(func(arg));
+}
+
+int
+pthread_create(pthread_t *thread, const pthread_attr_t *attr,
+	       void *(*func)(void *), void *arg)
+{
+	int tid;
+
+	if (attr != NULL) {
+		return EINVAL;
+	}
+	tid = __thread_create(pthread_start, (void *)func, arg);
+	if (tid < 0) {
+		return errno;
+	}
+	*thread = tid;
+	return 0;
+}
+
+void
+pthread_exit(void *retval)
+{
+	__thread_exit(retval);
+}
+
+int
+pthread_join(pthread_t thread, void **retval)
+{
+	if (__thread_join(thread, retval) < 0) {
+		return errno;
+	}
+	return 0;
+}
+
+int
+pthread_detach(pthread_t thread)
+{
+	if (__thread_detach(thread) < 0) {
+		return errno;
+	}
+	return 0;
+}
+
+pthread_t
+pthread_self(void)
+{
+	return __thread_self();
+}
+
+int
+pthread_equal(pthread_t t1, pthread_t t2)
+{
+	return t1 == t2;
+}
+
+/*
+ * Mutexes and condition variables are just libusync's.
+ */
+
+int
+pthread_mutex_init(pthread_mutex_t *m, const pthread_mutexattr_t *attr)
+{
+	if (attr != NULL) {
+		return EINVAL;
+	}
+	umutex_init(m);
+	return 0;
+}
+
+int
+pthread_mutex_destroy(pthread_mutex_t *m)
+{
+	if (m->um_state != 0) {
+		return EBUSY;
+	}
+	return 0;
+}
+
+int
+pthread_mutex_lock(pthread_mutex_t *m)
+{
+	umutex_lock(m);
+	return 0;
+}
+
+int
+pthread_mutex_trylock(pthread_mutex_t *m)
+{
+	return umutex_trylock(m);
+}
+
+int
+pthread_mutex_unlock(pthread_mutex_t *m)
+{
+	umutex_unlock(m);
+	return 0;
+}
+
+int
+pthread_cond_init(pthread_cond_t *c, const pthread_condattr_t *attr)
+{
+	if (attr != NULL) {
+		return EINVAL;
+	}
+	ucond_init(c);
+	return 0;
+}
+
+int
+pthread_cond_destroy(pthread_cond_t *c)
+{
+	(void)c;
+	return 0;
+}
+
+int
+pthread_cond_wait(pthread_cond_t *c, pthread_mutex_t *m)
+{
+	ucond_wait(c, m);
+	return 0;
+}
+
+int
+pthread_cond_signal(pthread_cond_t *c)
+{
+	ucond_signal(c);
+	return 0;
+}
+
+int
+pthread_cond_broadcast(pthread_cond_t *c)
+{
+	ucond_broadcast(c);
+	return 0;
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _USYNC_ATOMIC_H_
+#define _USYNC_ATOMIC_H_
+
+/*
+ * Atomic operations on ints for libusync, using LL/SC. (See the
+ * kernel's spinlock_data_testandset for how LL/SC works.) Each one
+ * ends with a SYNC so the operation is also a memory barrier: nothing
+ * after it is done before it, which lock acquisition needs, and
+ * nothing before it is done after it, which release needs.
+ */
+
+/*
+ * If *P is OLD, set it to NEW. Either way, return what *P was.
+ */
+static __inline
+int
+atomic_cas(volatile int *p, int old, int new)
+{
+	int prev, tmp;
+
+	__asm volatile(
+		".set push;"		/* save assembler mode */
+		".set mips32;"		/* allow MIPS32 instructions */
+		".set noreorder;"	/* we fill the delay slots */
+		"1: ll %0, 0(%2);"	/*   prev = *p */
+		"bne %0, %3, 2f;"	/*   if (prev != old) done */
+		" move %1, %4;"		/*   tmp = new (delay slot) */
+		"sc %1, 0(%2);"		/*   *p = tmp; tmp = success? */
+		"beqz %1, 1b;"		/*   retry on failure */
+		" nop;"
+		"2: sync;"
+		".set pop"		/* restore assembler mode */
+		: "=&r" (prev), "=&r" (tmp)
+		: "r" (p), "r" (old), "r" (new)
+		: "memory");
+	return prev;
+}
+
+/*
+ * Set *P to VAL and return what it was.
+ */
+static __inline
+int
+atomic_swap(volatile int *p, int val)
+{
+	int prev, tmp;
+
+	__asm volatile(
+		".set push;"
+		".set mips32;"
+		".set noreorder;"
+		"1: ll %0, 0(%2);"	/*   prev = *p */
+		"move %1, %3;"		/*   tmp = val */
+		"sc %1, 0(%2);"		/*   *p = tmp; tmp = success? */
+		"beqz %1, 1b;"
+		" nop;"
+		"sync;"
+		".set pop"
+		: "=&r" (prev), "=&r" (tmp)
+		: "r" (p), "r" (val)
+		: "memory");
+	return prev;
+}
+
+/*
+ * Add DELTA to *P and return the new value.
+ */
+static __inline
+int
+atomic_add(volatile int *p, int delta)
+{
+	int prev, tmp;
+
+	__asm volatile(
+		".set push;"
+		".set mips32;"
+		".set noreorder;"
+		"1: ll %0, 0(%2);"	/*   prev = *p */
+		"addu %1, %0, %3;"	/*   tmp = prev + delta */
+		"sc %1, 0(%2);"		/*   *p = tmp; tmp = success? */
+		"beqz %1, 1b;"
+		" nop;"
+		"sync;"
+		".set pop"
+		: "=&r" (prev), "=&r" (tmp)
+		: "r" (p), "r" (delta)
+		: "memory");
+	return prev + delta;
+}
+
+
+#endif /* _USYNC_ATOMIC_H_ */
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * ucond.c
+ *
+ *	User-level condition variables on top of futex().
+ *
+ * A waiter reads the sequence number, drops the mutex, and sleeps on
+ * the sequence number as long as it still has the value it read.
+ * Signal and broadcast bump the sequence number first, so a waiter
+ * that hasn't got into the kernel yet sees it change and doesn't
+ * sleep; no wakeup is lost between unlocking and sleeping.
+ *
+ * uc_sleepers lets signal and broadcast skip the system call when
+ * nobody's waiting, the same way usem does.
+ */
+
+#include <unistd.h>
+#include <usync.h>
+#include "atomic.h"
+
+/* FUTEX_WAKE count that means everybody. */
+#define WAKE_ALL	0x7fffffff
+
+void
+ucond_init(struct ucond *c)
+{
+	c->uc_seq = 0;
+	c->uc_sleepers = 0;
+}
+
+void
+ucond_wait(struct ucond *c, struct umutex *m)
+{
+	int seq;
+
+	atomic_add(&c->uc_sleepers, 1);
+	seq = c->uc_seq;
+	umutex_unlock(m);
+	(void)futex(&c->uc_seq, FUTEX_WAIT, seq, NULL);
+	atomic_add(&c->uc_sleepers, -1);
+	umutex_lock(m);
+}
+
+void
+ucond_signal(struct ucond *c)
+{
+	atomic_add(&c->uc_seq, 1);
+	if (c->uc_sleepers > 0) {
+		(void)futex(&c->uc_seq, FUTEX_WAKE, 1, NULL);
+	}
+}
+
+void
+ucond_broadcast(struct ucond *c)
+{
+	atomic_add(&c->uc_seq, 1);
+	if (c->uc_sleepers > 0) {
+		(void)futex(&c->uc_seq, FUTEX_WAKE, WAKE_ALL, NULL);
+	}
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * umutex.c
+ *
+ *	User-level mutexes on top of futex().
+ *
+ * This is the three-state mutex from Drepper's "Futexes Are Tricky":
+ * the state is 0 when the mutex is free, 1 when it's held and nobody
+ * is waiting, and 2 when it's held and somebody might be. Locking a
+ * free mutex is one compare-and-swap; unlocking goes into the kernel
+ * only from state 2.
+ */
+
+#include <unistd.h>
+#include <errno.h>
+#include <usync.h>
+#include "atomic.h"
+
+void
+umutex_init(struct umutex *m)
+{
+	m->um_state = 0;
+}
+
+void
+umutex_lock(struct umutex *m)
+{
+	int state;
+
+	state = atomic_cas(&m->um_state, 0, 1);
+	if (state == 0) {
+		return;
+	}
+
+	/*
+	 * Contended. Mark it so the holder knows to wake someone, and
+	 * sleep until it's free. Once we've been through here the
+	 * mutex stays marked contended until it's unlocked, even if
+	 * we were the only waiter; that costs at most one extra
+	 * FUTEX_WAKE.
+	 */
+	if (state != 2) {
+		state = atomic_swap(&m->um_state, 2);
+	}
+	while (state != 0) {
+		(void)futex(&m->um_state, FUTEX_WAIT, 2, NULL);
+		state = atomic_swap(&m->um_state, 2);
+	}
+}
+
+int
+umutex_trylock(struct umutex *m)
+{
+	if (atomic_cas(&m->um_state, 0, 1) == 0) {
+		return 0;
+	}
+	return EBUSY;
+}
+
+void
+umutex_unlock(struct umutex *m)
+{
+	if (atomic_swap(&m->um_state, 0) == 2) {
+		(void)futex(&m->um_state, FUTEX_WAKE, 1, NULL);
+	}
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * usem.c
+ *
+ *	User-level counting semaphores on top of futex().
+ *
+ * The count is kept in user memory and P and V adjust it with atomic
+ * operations. P only sleeps, on the count, when it's 0; us_sleepers
+ * counts threads that might be asleep there so V can skip the system
+ * call when there aren't any.
+ *
+ * A sleeper increments us_sleepers before checking the count in the
+ * kernel, and V increments the count before checking us_sleepers, so
+ * either V sees the sleeper and wakes it or the sleeper's FUTEX_WAIT
+ * sees the new count and doesn't sleep.
+ */
+
+#include <unistd.h>
+#include <errno.h>
+#include <usync.h>
+#include "atomic.h"
+
+void
+usem_init(struct usem *s, unsigned count)
+{
+	s->us_count = count;
+	s->us_sleepers = 0;
+}
+
+int
+usem_tryP(struct usem *s)
+{
+	int count, prev;
+
+	count = s->us_count;
+	while (count > 0) {
+		prev = atomic_cas(&s->us_count, count, count - 1);
+		if (prev == count) {
+			return 0;
+		}
+		count = prev;
+	}
+	return EAGAIN;
+}
+
+void
+usem_P(struct usem *s)
+{
+	while (usem_tryP(s) != 0) {
+		atomic_add(&s->us_sleepers, 1);
+		(void)futex(&s->us_count, FUTEX_WAIT, 0, NULL);
+		atomic_add(&s->us_sleepers, -1);
+	}
+}
+
+void
+usem_V(struct usem *s)
+{
+	atomic_add(&s->us_count, 1);
+	if (s->us_sleepers > 0) {
+		(void)futex(&s->us_count, FUTEX_WAKE, 1, NULL);
+	}
+}
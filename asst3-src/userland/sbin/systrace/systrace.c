@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * systrace - control the kernel's system call tracer.
+ * Usage: systrace on | off | reset | stats | log
+ *        systrace command [args...]
+ *
+ * "stats" prints, for each system call made since the last reset,
+ * how many times it was called, how many times it failed, its
+ * average time, and a log2 histogram of its times. "log" prints the
+ * most recent calls on each CPU.
+ *
+ * Given a command, clears the counts, runs the command with tracing
+ * on, and prints the stats afterwards.
+ *
+ * The kernel needs to be built with "options systrace".
+ */
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <err.h>
+
+#define LOGMAX		1024
+#define BARWIDTH	40
+
+static struct systrace_stats stats[SYSTRACE_NCALLS];
+static struct systrace_record records[LOGMAX];
+
+static
+void
+trace(int op)
+{
+	if (__systrace(op, NULL, 0) < 0) {
+		err(1, "__systrace");
+	}
+}
+
+static
+void
+printstats(void)
+{
+	struct systrace_stats *ss;
+	unsigned i, k, max, width;
+
+	if (__systrace(SYSTRACE_STATS, stats, sizeof(stats)) < 0) {
+		err(1, "__systrace");
+	}
+
+	printf("%-20s %10s %10s %12s\n", "call", "calls", "errors",
+	       "avg cycles");
+	for (i=0; i<SYSTRACE_NCALLS; i++) {
+		ss = &stats[i];
+		if (ss->ss_calls == 0) {
+			continue;
+		}
+		printf("%-20s %10lu %10lu %12lu\n",
+		       ss->ss_name[0] ? ss->ss_name : "(unknown)",
+		       (unsigned long)ss->ss_calls,
+		       (unsigned long)ss->ss_errors,
+		       (unsigned long)(ss->ss_cycles / ss->ss_calls));
+
+		max = 0;
+		for (k=0; k<SYSTRACE_NBUCKETS; k++) {
+			if (ss->ss_hist[k] > max) {
+				max = ss->ss_hist[k];
+			}
+		}
+		for (k=0; k<SYSTRACE_NBUCKETS; k++) {
+			if (ss->ss_hist[k] == 0) {
+				continue;
+			}
+			width = (ss->ss_hist[k] * BARWIDTH + max - 1) / max;
+			printf("    2^%-2u %8lu |", k,
+			       (unsigned long)ss->ss_hist[k]);
+			while (width-- > 0) {
+				putchar('#');
+			}
+			putchar('\n');
+		}
+	}
+}
+
+static
+void
+printlog(void)
+{
+	struct systrace_record *sr;
+	const char *name;
+	int i, n;
+
+	/* The names come with the stats. */
+	if (__systrace(SYSTRACE_STATS, stats, sizeof(stats)) < 0) {
+		err(1, "__systrace");
+	}
+	n = __systrace(SYSTRACE_LOG, records, sizeof(records));
+	if (n < 0) {
+		err(1, "__systrace");
+	}
+
+	for (i=0; i<n; i++) {
+		sr = &records[i];
+		name = stats[sr->sr_callno].ss_name;
+		printf("cpu%lu %lu: pid %d %s(0x%lx, 0x%lx, 0x%lx, 0x%lx) = %d",
+		       (unsigned long)sr->sr_cpu, (unsigned long)sr->sr_seq,
+		       sr->sr_pid, name[0] ? name : "(unknown)",
+		       (unsigned long)sr->sr_args[0],
+		       (unsigned long)sr->sr_args[1],
+		       (unsigned long)sr->sr_args[2],
+		       (unsigned long)sr->sr_args[3], sr->sr_retval);
+		if (sr->sr_err) {
+			printf(" (%s)", strerror(sr->sr_err));
+		}
+		printf(" [%lu cycles]\n", (unsigned long)sr->sr_cycles);
+	}
+}
+
+static
+void
+run(char **args)
+{
+	pid_t pid;
+	int status;
+
+	trace(SYSTRACE_RESET);
+	trace(SYSTRACE_ON);
+
+	pid = vfork();
+	if (pid < 0) {
+		err(1, "vfork");
+	}
+	if (pid == 0) {
+		execv(args[0], args);
+		warn("%s", args[0]);
+		_exit(1);
+	}
+	if (waitpid(pid, &status, 0) < 0) {
+		err(1, "waitpid");
+	}
+
+	trace(SYSTRACE_OFF);
+
+	if (WIFSIGNALED(status)) {
+		warnx("%s: signal %d", args[0], WTERMSIG(status));
+	}
+	else if (WEXITSTATUS(status) != 0) {
+		warnx("%s: exit %d", args[0], WEXITSTATUS(status));
+	}
+	printstats();
+}
+
+int
+main(int argc, char *argv[])
+{
+	if (argc < 2) {
+		errx(1, "Usage: systrace on | off | reset | stats | log | "
+		     "command [args...]");
+	}
+
+	if (argc == 2 && !strcmp(argv[1], "on")) {
+		trace(SYSTRACE_ON);
+	}
+	else if (argc == 2 && !strcmp(argv[1], "off")) {
+		trace(SYSTRACE_OFF);
+	}
+	else if (argc == 2 && !strcmp(argv[1], "reset")) {
+		trace(SYSTRACE_RESET);
+	}
+	else if (argc == 2 && !strcmp(argv[1], "stats")) {
+		printstats();
+	}
+	else if (argc == 2 && !strcmp(argv[1], "log")) {
+		printlog();
+	}
+	else {
+		run(&argv[1]);
+	}
+	return 0;
+}
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * fdtabletest - test the growable file table.
+ *
+ * Places descriptors far past the initial table size, fills the table
+ * up to OPEN_MAX, checks that fork hands the child a working copy,
+ * and has one thread keep reading a pipe through a descriptor while
+ * another keeps closing and re-dup2'ing it.
+ */
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <err.h>
+#include <test/check.h>
+
+#define HIGHFD		(OPEN_MAX - 10)
+#define RACEFD		100
+#define RACELOOPS	2000
+
+static
+void
+mkpipe(int fds[2])
+{
+	if (pipe(fds) < 0) {
+		err(1, "pipe");
+	}
+}
+
+/*
+ * dup2 to a descriptor well past the initial table size, and use it.
+ */
+static
+void
+high(void)
+{
+	int fds[2];
+	char ch;
+
+	mkpipe(fds);
+	check(dup2(fds[1], HIGHFD) == HIGHFD, "dup2 to a high fd");
+	check(write(HIGHFD, "h", 1) == 1, "write through the high fd");
+	check(read(fds[0], &ch, 1) == 1 && ch == 'h', "read what it wrote");
+	check(close(HIGHFD) == 0, "close the high fd");
+	check(close(HIGHFD) < 0 && errno == EBADF, "close it again");
+	check(dup2(fds[1], OPEN_MAX) < 0 && errno == EBADF,
+	      "dup2 to OPEN_MAX");
+	close(fds[0]);
+	close(fds[1]);
+}
+
+/*
+ * dup2 onto every descriptor until the table is full, then fork and
+ * check the child sees the same files.
+ */
+static
+void
+fill(void)
+{
+	int fds[2], more[2];
+	int fd, status;
+	pid_t pid;
+	char ch;
+
+	mkpipe(fds);
+	for (fd = fds[1] + 1; fd < OPEN_MAX; fd++) {
+		if (dup2(fds[1], fd) != fd) {
+			check(0, "dup2 while filling the table");
+			break;
+		}
+	}
+	check(pipe(more) < 0 && errno == EMFILE, "pipe fails when full");
+
+	pid = fork();
+	if (pid < 0) {
+		err(1, "fork");
+	}
+	if (pid == 0) {
+		/* the child writes through the last slot */
+		_exit(write(OPEN_MAX - 1, "c", 1) == 1 ? 0 : 1);
+	}
+	check(waitpid(pid, &status, 0) == pid &&
+	      WIFEXITED(status) && WEXITSTATUS(status) == 0,
+	      "child used an inherited high fd");
+	check(read(fds[0], &ch, 1) == 1 && ch == 'c', "parent got it");
+
+	for (fd = fds[1] + 1; fd < OPEN_MAX; fd++) {
+		if (close(fd) < 0) {
+			check(0, "close a dup");
+			break;
+		}
+	}
+	mkpipe(more);
+	check(more[0] == fds[1] + 1, "lowest free fd is reused");
+	close(more[0]);
+	close(more[1]);
+	close(fds[0]);
+	close(fds[1]);
+}
+
+static int racepipe[2];
+
+static
+void *
+closer(void *arg)
+{
+	int i;
+
+	(void)arg;
+	for (i=0; i<RACELOOPS; i++) {
+		close(RACEFD);
+		dup2(racepipe[0], RACEFD);
+	}
+	return NULL;
+}
+
+/*
+ * Read through RACEFD while another thread closes and recreates it.
+ * Every read has to either work or fail cleanly with EBADF.
+ */
+static
+void
+race(void)
+{
+	pthread_t t;
+	int i, r, bad;
+	char ch;
+
+	mkpipe(racepipe);
+	check(dup2(racepipe[0], RACEFD) == RACEFD, "dup2 for the race");
+	if (pthread_create(&t, NULL, closer, NULL)) {
+		err(1, "pthread_create");
+	}
+	bad = 0;
+	for (i=0; i<RACELOOPS; i++) {
+		write(racepipe[1], "r", 1);
+		r = read(RACEFD, &ch, 1);
+		if (r < 0 && errno == EBADF) {
+			/* it was closed; drain through the other fd */
+			r = read(racepipe[0], &ch, 1);
+		}
+		if (r != 1 || ch != 'r') {
+			bad++;
+		}
+	}
+	pthread_join(t, NULL);
+	check(bad == 0, "reads racing with close");
+	close(RACEFD);
+	close(racepipe[0]);
+	close(racepipe[1]);
+}
+
+int
+main(void)
+{
+	high();
+	fill();
+	race();
+
+	return check_report("fdtabletest");
+}
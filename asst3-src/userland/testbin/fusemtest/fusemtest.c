@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * fusemtest - usemtest for the futex-based semaphores in libusync.
+ *
+ * First check that futex() and the libusync mutexes and semaphores
+ * behave, then time uncontended P/V pairs on a semfs semaphore (as
+ * usemtest uses) against the same thing with a usem, which never
+ * enters the kernel when nobody has to wait.
+ *
+ * usemtest's ping-pong between processes can't be done with futexes,
+ * which only work within one address space, and there's no shared
+ * memory between processes.
+ */
+
+#include <sys/types.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <err.h>
+#include <usync.h>
+#include <test/check.h>
+
+#define SEMNAME		"sem:fusemtest"
+#define BENCHLOOPS	2000
+
+/* Microseconds since some point. */
+static
+unsigned long long
+now_us(void)
+{
+	time_t secs;
+	unsigned long nsecs;
+
+	__time(&secs, &nsecs);
+	return (unsigned long long)secs * 1000000 + nsecs / 1000;
+}
+
+////////////////////////////////////////////////////////////
+// functional tests
+
+static
+void
+futextest(void)
+{
+	volatile int words[2];
+	struct timespec ts;
+	unsigned long long start, elapsed;
+	int r;
+
+	printf("futex...\n");
+
+	words[0] = 0;
+	r = futex(&words[0], FUTEX_WAIT, 1, NULL);
+	check(r == -1 && errno == EAGAIN, "FUTEX_WAIT with wrong value");
+
+	ts.tv_sec = 0;
+	ts.tv_nsec = 50000000;
+	start = now_us();
+	r = futex(&words[0], FUTEX_WAIT, 0, &ts);
+	elapsed = now_us() - start;
+	check(r == -1 && errno == ETIMEDOUT, "FUTEX_WAIT timeout");
+	check(elapsed >= 50000, "FUTEX_WAIT timeout came early");
+
+	ts.tv_nsec = 0;
+	r = futex(&words[0], FUTEX_WAIT, 0, &ts);
+	check(r == -1 && errno == ETIMEDOUT, "FUTEX_WAIT zero timeout");
+
+	r = futex(&words[0], FUTEX_WAKE, 1, NULL);
+	check(r == 0, "FUTEX_WAKE with no sleepers");
+
+	r = futex((volatile int *)((char *)&words[0] + 1),
+		  FUTEX_WAKE, 1, NULL);
+	check(r == -1 && errno == EINVAL, "misaligned address");
+
+	r = futex(&words[0], 42, 0, NULL);
+	check(r == -1 && errno == EINVAL, "bad op");
+
+	r = futex(NULL, FUTEX_WAIT, 0, NULL);
+	check(r == -1 && errno == EFAULT, "NULL address");
+}
+
+static
+void
+umutextest(void)
+{
+	struct umutex m = UMUTEX_INITIALIZER;
+
+	printf("umutex...\n");
+
+	check(umutex_trylock(&m) == 0, "trylock of free mutex");
+	check(umutex_trylock(&m) == EBUSY, "trylock of held mutex");
+	umutex_unlock(&m);
+	umutex_lock(&m);
+	check(m.um_state == 1, "uncontended lock state");
+	umutex_unlock(&m);
+	check(m.um_state == 0, "unlocked state");
+}
+
+static
+void
+usemtest(void)
+{
+	struct usem s;
+
+	printf("usem...\n");
+
+	usem_init(&s, 2);
+	check(usem_tryP(&s) == 0, "tryP with count 2");
+	usem_P(&s);
+	check(usem_tryP(&s) == EAGAIN, "tryP with count 0");
+	usem_V(&s);
+	check(s.us_count == 1, "count after V");
+	usem_P(&s);
+	check(s.us_count == 0 && s.us_sleepers == 0, "final state");
+}
+
+////////////////////////////////////////////////////////////
+// timing
+
+static
+unsigned long long
+bench_semfs(void)
+{
+	unsigned long long start, end;
+	unsigned i;
+	int fd;
+	char c = 0;
+
+	fd = open(SEMNAME, O_RDWR|O_CREAT|O_TRUNC, 0664);
+	if (fd < 0) {
+		err(1, "%s", SEMNAME);
+	}
+	start = now_us();
+	for (i=0; i<BENCHLOOPS; i++) {
+		if (write(fd, &c, 1) != 1) {
+			err(1, "%s: write", SEMNAME);
+		}
+		if (read(fd, &c, 1) != 1) {
+			err(1, "%s: read", SEMNAME);
+		}
+	}
+	end = now_us();
+	close(fd);
+	(void)remove(SEMNAME);
+	return end - start;
+}
+
+static
+unsigned long long
+bench_usem(void)
+{
+	struct usem s = USEM_INITIALIZER(0);
+	unsigned long long start, end;
+	unsigned i;
+
+	start = now_us();
+	for (i=0; i<BENCHLOOPS; i++) {
+		usem_V(&s);
+		usem_P(&s);
+	}
+	end = now_us();
+	return end - start;
+}
+
+static
+unsigned long long
+bench_umutex(void)
+{
+	struct umutex m = UMUTEX_INITIALIZER;
+	unsigned long long start, end;
+	unsigned i;
+
+	start = now_us();
+	for (i=0; i<BENCHLOOPS; i++) {
+		umutex_lock(&m);
+		umutex_unlock(&m);
+	}
+	end = now_us();
+	return end - start;
+}
+
+static
+void
+report(const char *what, unsigned long long us)
+{
+	printf("%-24s %8llu us total, %6llu ns per pair\n",
+	       what, us, us * 1000 / BENCHLOOPS);
+}
+
+static
+void
+bench(void)
+{
+	unsigned long long semfs, usem, umutex;
+
+	printf("Timing %u uncontended pairs...\n", BENCHLOOPS);
+	semfs = bench_semfs();
+	usem = bench_usem();
+	umutex = bench_umutex();
+	report("semfs V/P:", semfs);
+	report("usem V/P:", usem);
+	report("umutex lock/unlock:", umutex);
+	if (usem > 0) {
+		printf("usem is %llu times faster than semfs\n",
+		       semfs / usem);
+	}
+}
+
+int
+main(void)
+{
+	futextest();
+	umutextest();
+	usemtest();
+	if (check_failures() > 0) {
+		errx(1, "%d failures", check_failures());
+	}
+	bench();
+	printf("Passed.\n");
+	return 0;
+}
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * ioringbench - compare reading a file in small records with plain
+ * read() against the I/O submission ring.
+ *
+ * Writes a test file of NRECS records of RECSIZE bytes, then reads it
+ * back three ways, checking the data each time:
+ *    read:   one read() per record;
+ *    ring:   a ringful of reads per __ioring_enter, done in the call;
+ *    async:  the same, done by the kernel's worker thread while we
+ *            wait for completions.
+ */
+
+#include <sys/types.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <ioring.h>
+#include <err.h>
+
+#define TESTFILE	"ioringbench.dat"
+#define RECSIZE		64
+#define NRECS		2048
+
+static struct ioring ring;
+static char recs[IORING_ENTRIES][RECSIZE];
+static char buf[RECSIZE];
+
+/*
+ * Contents of record N.
+ */
+static
+void
+fillrec(char *rec, unsigned n)
+{
+	unsigned i;
+
+	for (i=0; i<RECSIZE; i++) {
+		rec[i] = (char)(n * 7 + i);
+	}
+}
+
+static
+void
+checkrec(const char *rec, unsigned n)
+{
+	char want[RECSIZE];
+
+	fillrec(want, n);
+	if (memcmp(rec, want, RECSIZE) != 0) {
+		errx(1, "record %u is wrong", n);
+	}
+}
+
+static
+void
+makefile(void)
+{
+	unsigned n;
+	int fd;
+
+	fd = open(TESTFILE, O_WRONLY|O_CREAT|O_TRUNC, 0664);
+	if (fd < 0) {
+		err(1, "%s", TESTFILE);
+	}
+	for (n=0; n<NRECS; n++) {
+		fillrec(buf, n);
+		if (write(fd, buf, RECSIZE) != RECSIZE) {
+			err(1, "%s: write", TESTFILE);
+		}
+	}
+	close(fd);
+}
+
+static
+int
+openfile(void)
+{
+	int fd;
+
+	fd = open(TESTFILE, O_RDONLY);
+	if (fd < 0) {
+		err(1, "%s", TESTFILE);
+	}
+	return fd;
+}
+
+static
+void
+readplain(void)
+{
+	unsigned n;
+	int fd;
+
+	fd = openfile();
+	for (n=0; n<NRECS; n++) {
+		if (read(fd, buf, RECSIZE) != RECSIZE) {
+			err(1, "%s: read", TESTFILE);
+		}
+		checkrec(buf, n);
+	}
+	close(fd);
+}
+
+/*
+ * Read the file a ringful of records at a time. Reads through one
+ * file handle are done in order, so each lands at the next offset.
+ */
+static
+void
+readring(int flags)
+{
+	struct ioring_cqe cqe;
+	unsigned n, i, batch, got;
+	int fd;
+
+	fd = openfile();
+	ioring_init(&ring);
+	for (n=0; n<NRECS; n+=batch) {
+		batch = NRECS - n;
+		if (batch > IORING_ENTRIES) {
+			batch = IORING_ENTRIES;
+		}
+		for (i=0; i<batch; i++) {
+			if (ioring_queue(&ring, IORING_OP_READ, fd, recs[i],
+					 RECSIZE, n + i)) {
+				err(1, "ioring_queue");
+			}
+		}
+		if (ioring_submit(&ring, batch,
+				  flags | IORING_ENTER_GETEVENTS) < 0) {
+			err(1, "__ioring_enter");
+		}
+		for (got=0; got<batch; got++) {
+			if (!ioring_reap(&ring, &cqe)) {
+				errx(1, "completion %u missing", n + got);
+			}
+			if (cqe.cqe_err) {
+				errx(1, "record %u: %s", cqe.cqe_data,
+				     strerror(cqe.cqe_err));
+			}
+			if (cqe.cqe_res != RECSIZE) {
+				errx(1, "record %u: short read", cqe.cqe_data);
+			}
+			checkrec(recs[cqe.cqe_data - n], cqe.cqe_data);
+		}
+	}
+	close(fd);
+}
+
+static
+unsigned long
+timeit(const char *name, void (*func)(int), int arg)
+{
+	time_t s0, s1;
+	unsigned long ns0, ns1, us;
+
+	__time(&s0, &ns0);
+	func(arg);
+	__time(&s1, &ns1);
+	us = (s1 - s0) * 1000000UL + ns1 / 1000 - ns0 / 1000;
+	printf("%-6s %8lu us  (%lu ns per record)\n", name, us,
+	       us * 1000 / NRECS);
+	return us;
+}
+
+static
+void
+plain(int arg)
+{
+	(void)arg;
+	readplain();
+}
+
+int
+main(void)
+{
+	makefile();
+	timeit("read", plain, 0);
+	timeit("ring", readring, 0);
+	timeit("async", readring, IORING_ENTER_ASYNC);
+	remove(TESTFILE);
+	printf("ioringbench: passed\n");
+	return 0;
+}
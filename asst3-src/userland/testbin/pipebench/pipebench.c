@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * pipebench - pipe throughput for various write sizes.
+ *
+ * For each write size, forks a child that pushes a stream of
+ * patterned data through a pipe in writes of that size, while the
+ * parent reads it with large reads, checks it, and reports the rate.
+ * The stream is at most TOTAL bytes, and shorter for the tiny write
+ * sizes so they don't take forever.
+ *
+ * Before that, checks EOF and EPIPE behavior.
+ */
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <err.h>
+
+#define TOTAL		(1024 * 1024)
+#define MAXWRITES	4096
+#define READSIZE	(64 * 1024)
+
+static const size_t sizes[] = { 1, 16, 64, 512, 4096, 16384, 65536 };
+#define NSIZES	(sizeof(sizes) / sizeof(sizes[0]))
+
+static char wbuf[65536];
+static char rbuf[READSIZE];
+
+/*
+ * Byte N of the stream.
+ */
+static
+char
+pattern(size_t n)
+{
+	return (char)(n % 251);
+}
+
+static
+pid_t
+dofork(void)
+{
+	pid_t pid;
+
+	pid = fork();
+	if (pid < 0) {
+		err(1, "fork");
+	}
+	return pid;
+}
+
+static
+void
+dowait(pid_t pid)
+{
+	int status;
+
+	if (waitpid(pid, &status, 0) < 0) {
+		err(1, "waitpid");
+	}
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+		errx(1, "child failed");
+	}
+}
+
+/*
+ * The write end gone means EOF after the data; the read end gone
+ * means EPIPE.
+ */
+static
+void
+semantics(void)
+{
+	int fds[2];
+	char c;
+
+	if (pipe(fds) < 0) {
+		err(1, "pipe");
+	}
+	if (write(fds[1], "x", 1) != 1) {
+		err(1, "write");
+	}
+	close(fds[1]);
+	if (read(fds[0], &c, 1) != 1 || c != 'x') {
+		errx(1, "didn't read back what was written");
+	}
+	if (read(fds[0], &c, 1) != 0) {
+		errx(1, "no EOF after the write end was closed");
+	}
+	close(fds[0]);
+
+	if (pipe(fds) < 0) {
+		err(1, "pipe");
+	}
+	close(fds[0]);
+	if (write(fds[1], "x", 1) >= 0 || errno != EPIPE) {
+		errx(1, "no EPIPE after the read end was closed");
+	}
+	if (lseek(fds[1], 0, SEEK_SET) >= 0 || errno != ESPIPE) {
+		errx(1, "lseek on a pipe didn't fail with ESPIPE");
+	}
+	close(fds[1]);
+}
+
+static
+void
+writer(int fd, size_t size, size_t total)
+{
+	size_t done, len, i;
+	ssize_t r;
+
+	for (done = 0; done < total; done += len) {
+		len = total - done < size ? total - done : size;
+		for (i=0; i<len; i++) {
+			wbuf[i] = pattern(done + i);
+		}
+		r = write(fd, wbuf, len);
+		if (r < 0) {
+			err(1, "write");
+		}
+		/* a pipe write doesn't come back until it's all written */
+		if ((size_t)r != len) {
+			errx(1, "short write (%ld of %lu)", (long)r,
+			     (unsigned long)len);
+		}
+	}
+}
+
+static
+void
+reader(int fd, size_t total)
+{
+	size_t done, i;
+	ssize_t r;
+
+	done = 0;
+	while ((r = read(fd, rbuf, sizeof(rbuf))) > 0) {
+		for (i=0; i<(size_t)r; i++) {
+			if (rbuf[i] != pattern(done + i)) {
+				errx(1, "bad data at byte %lu",
+				     (unsigned long)(done + i));
+			}
+		}
+		done += r;
+	}
+	if (r < 0) {
+		err(1, "read");
+	}
+	if (done != total) {
+		errx(1, "got %lu bytes, expected %lu", (unsigned long)done,
+		     (unsigned long)total);
+	}
+}
+
+static
+void
+bench(size_t size)
+{
+	time_t s0, s1;
+	unsigned long ns0, ns1, us, kbps;
+	size_t total;
+	int fds[2];
+	pid_t pid;
+
+	total = size * MAXWRITES < TOTAL ? size * MAXWRITES : TOTAL;
+
+	if (pipe(fds) < 0) {
+		err(1, "pipe");
+	}
+
+	__time(&s0, &ns0);
+	pid = dofork();
+	if (pid == 0) {
+		close(fds[0]);
+		writer(fds[1], size, total);
+		_exit(0);
+	}
+	close(fds[1]);
+	reader(fds[0], total);
+	__time(&s1, &ns1);
+	close(fds[0]);
+	dowait(pid);
+
+	us = (s1 - s0) * 1000000UL + ns1 / 1000 - ns0 / 1000;
+	kbps = us ? (total / 1024) * 1000000UL / us : 0;
+	printf("%6lu-byte writes: %7lu bytes in %8lu us, %6lu KB/s\n",
+	       (unsigned long)size, (unsigned long)total, us, kbps);
+}
+
+int
+main(void)
+{
+	unsigned i;
+
+	semantics();
+
+	/* Touch the read buffer so writers can copy straight into it. */
+	memset(rbuf, 0, sizeof(rbuf));
+
+	for (i=0; i<NSIZES; i++) {
+		bench(sizes[i]);
+	}
+	printf("pipebench: passed\n");
+	return 0;
+}
@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * polltest - test poll() and select().
+ *
+ * Uses pipes and a semfs semaphore: readiness of each end, timeouts,
+ * waking up when another process writes, hangups, and bad file
+ * handles.
+ */
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/select.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <err.h>
+#include <test/check.h>
+
+#define SEMNAME		"sem:polltest"
+
+static
+unsigned long
+now_ms(void)
+{
+	time_t secs;
+	unsigned long nsecs;
+
+	__time(&secs, &nsecs);
+	return secs * 1000UL + nsecs / 1000000;
+}
+
+static
+void
+mkpipe(int fds[2])
+{
+	if (pipe(fds) < 0) {
+		err(1, "pipe");
+	}
+}
+
+/*
+ * Readiness of the two ends of a pipe, and POLLHUP/POLLERR.
+ */
+static
+void
+ends(void)
+{
+	struct pollfd pfd[2];
+	int fds[2];
+
+	mkpipe(fds);
+	pfd[0].fd = fds[0];
+	pfd[0].events = POLLIN;
+	pfd[1].fd = fds[1];
+	pfd[1].events = POLLOUT;
+
+	check(poll(pfd, 2, 0) == 1, "empty pipe: one ready");
+	check(pfd[0].revents == 0, "empty pipe: not readable");
+	check(pfd[1].revents == POLLOUT, "empty pipe: writable");
+
+	write(fds[1], "x", 1);
+	check(poll(pfd, 2, 0) == 2, "nonempty pipe: both ready");
+	check(pfd[0].revents == POLLIN, "nonempty pipe: readable");
+
+	close(fds[1]);
+	pfd[1].fd = -1;
+	check(poll(pfd, 2, 0) == 1 && pfd[0].revents == (POLLIN|POLLHUP) &&
+	      pfd[1].revents == 0, "no writer: POLLHUP, negative fd skipped");
+	close(fds[0]);
+
+	mkpipe(fds);
+	close(fds[0]);
+	pfd[0].fd = fds[1];
+	pfd[0].events = POLLOUT;
+	check(poll(pfd, 1, 0) == 1 && (pfd[0].revents & POLLERR),
+	      "no reader: POLLERR");
+	close(fds[1]);
+
+	pfd[0].fd = fds[1];
+	pfd[0].events = POLLIN;
+	check(poll(pfd, 1, 0) == 1 && pfd[0].revents == POLLNVAL,
+	      "closed fd: POLLNVAL");
+}
+
+/*
+ * Timeouts, and being woken by another process.
+ */
+static
+void
+waiting(void)
+{
+	struct pollfd pfd;
+	struct timespec ts;
+	unsigned long start, ms;
+	int fds[2];
+	pid_t pid;
+
+	mkpipe(fds);
+	pfd.fd = fds[0];
+	pfd.events = POLLIN;
+
+	start = now_ms();
+	check(poll(&pfd, 1, 300) == 0, "timeout: nothing ready");
+	ms = now_ms() - start;
+	printf("300 ms timeout took %lu ms\n", ms);
+	check(ms >= 250, "timeout: waited long enough");
+
+	pid = fork();
+	if (pid < 0) {
+		err(1, "fork");
+	}
+	if (pid == 0) {
+		ts.tv_sec = 0;
+		ts.tv_nsec = 500 * 1000000;
+		nanosleep(&ts, NULL);
+		write(fds[1], "x", 1);
+		_exit(0);
+	}
+
+	start = now_ms();
+	check(poll(&pfd, 1, -1) == 1 && pfd.revents == POLLIN,
+	      "woken by a write");
+	ms = now_ms() - start;
+	printf("woken after %lu ms\n", ms);
+	check(ms >= 400, "woken only after the write");
+	waitpid(pid, NULL, 0);
+
+	close(fds[0]);
+	close(fds[1]);
+}
+
+/*
+ * Many descriptors at once, including a semaphore.
+ */
+static
+void
+many(void)
+{
+	struct pollfd pfd[3];
+	int a[2], b[2], sem;
+
+	mkpipe(a);
+	mkpipe(b);
+	sem = open(SEMNAME, O_RDWR|O_CREAT|O_TRUNC, 0664);
+	if (sem < 0) {
+		err(1, "%s", SEMNAME);
+	}
+
+	pfd[0].fd = a[0];
+	pfd[1].fd = b[0];
+	pfd[2].fd = sem;
+	pfd[0].events = pfd[1].events = pfd[2].events = POLLIN;
+
+	check(poll(pfd, 3, 0) == 0, "nothing ready yet");
+	write(b[1], "x", 1);
+	check(poll(pfd, 3, 0) == 1 && pfd[0].revents == 0 &&
+	      pfd[1].revents == POLLIN && pfd[2].revents == 0,
+	      "only the second pipe ready");
+	write(sem, "x", 1);
+	check(poll(pfd, 3, 0) == 2 && pfd[2].revents == POLLIN,
+	      "semaphore ready after V");
+
+	close(sem);
+	remove(SEMNAME);
+	close(a[0]);
+	close(a[1]);
+	close(b[0]);
+	close(b[1]);
+}
+
+/*
+ * select.
+ */
+static
+void
+selecting(void)
+{
+	fd_set rd, wr;
+	struct timeval tv;
+	int fds[2], max;
+
+	mkpipe(fds);
+	max = fds[0] > fds[1] ? fds[0] : fds[1];
+
+	FD_ZERO(&rd);
+	FD_ZERO(&wr);
+	FD_SET(fds[0], &rd);
+	FD_SET(fds[1], &wr);
+	tv.tv_sec = 0;
+	tv.tv_usec = 0;
+	check(select(max + 1, &rd, &wr, NULL, &tv) == 1 &&
+	      !FD_ISSET(fds[0], &rd) && FD_ISSET(fds[1], &wr),
+	      "select: only the write end ready");
+
+	write(fds[1], "x", 1);
+	FD_ZERO(&rd);
+	FD_SET(fds[0], &rd);
+	check(select(max + 1, &rd, NULL, NULL, NULL) == 1 &&
+	      FD_ISSET(fds[0], &rd), "select: read end ready");
+
+	close(fds[1]);
+	FD_ZERO(&rd);
+	FD_SET(fds[1], &rd);
+	check(select(max + 1, &rd, NULL, NULL, &tv) < 0 && errno == EBADF,
+	      "select: closed fd");
+	close(fds[0]);
+}
+
+int
+main(void)
+{
+	ends();
+	waiting();
+	many();
+	selecting();
+
+	return check_report("polltest");
+}
@@ -0,0 +1,429 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * pthreadtest - test multithreaded processes.
+ *
+ * Checks thread creation, join, and detach; mutual exclusion with a
+ * pthread mutex; a bounded buffer with condition variables; and how
+ * threads interact with the process-level calls: the thread limit,
+ * fork from a thread, exec with threads running (EBUSY), and one
+ * thread's exit() taking the others with it, even ones blocked in a
+ * pipe.
+ */
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <err.h>
+#include <pthread.h>
+#include <test/check.h>
+
+#define NTHREADS	8
+#define NINCS		5000
+#define NITEMS		500
+#define BUFSIZE		4
+#define MAXTHREADS	32	/* PROC_MAXTHREADS in the kernel */
+
+static
+pthread_t
+spawn(void *(*func)(void *), void *arg)
+{
+	pthread_t t;
+	int result;
+
+	result = pthread_create(&t, NULL, func, arg);
+	if (result) {
+		errno = result;
+		err(1, "pthread_create");
+	}
+	return t;
+}
+
+////////////////////////////////////////////////////////////
+// create/join/detach
+
+static
+void *
+doubler(void *arg)
+{
+	return (void *)((int)arg * 2);
+}
+
+static
+void *
+selfie(void *arg)
+{
+	pthread_t *where = arg;
+
+	*where = pthread_self();
+	return NULL;
+}
+
+static
+void
+jointest(void)
+{
+	pthread_t ts[NTHREADS], t, who;
+	void *val;
+	int i;
+
+	printf("create/join...\n");
+
+	for (i=0; i<NTHREADS; i++) {
+		ts[i] = spawn(doubler, (void *)i);
+	}
+	for (i=NTHREADS-1; i>=0; i--) {
+		check(pthread_join(ts[i], &val) == 0, "join");
+		check((int)val == i * 2, "join value");
+	}
+	check(pthread_join(ts[0], NULL) == ESRCH, "join twice");
+	check(pthread_join(pthread_self(), NULL) == EINVAL, "join self");
+
+	t = spawn(selfie, &who);
+	check(pthread_join(t, NULL) == 0, "join selfie");
+	check(pthread_equal(t, who), "pthread_self in thread");
+	check(!pthread_equal(t, pthread_self()), "pthread_self in main");
+
+	t = spawn(doubler, NULL);
+	check(pthread_detach(t) == 0, "detach");
+	check(pthread_join(t, NULL) != 0, "join detached");
+}
+
+////////////////////////////////////////////////////////////
+// mutex
+
+static pthread_mutex_t countlock = PTHREAD_MUTEX_INITIALIZER;
+static volatile int count;
+
+static
+void *
+incrementer(void *junk)
+{
+	int i;
+
+	(void)junk;
+	for (i=0; i<NINCS; i++) {
+		pthread_mutex_lock(&countlock);
+		count = count + 1;
+		pthread_mutex_unlock(&countlock);
+	}
+	return NULL;
+}
+
+static
+void
+mutextest(void)
+{
+	pthread_t ts[NTHREADS];
+	int i;
+
+	printf("mutex...\n");
+
+	count = 0;
+	for (i=0; i<NTHREADS; i++) {
+		ts[i] = spawn(incrementer, NULL);
+	}
+	for (i=0; i<NTHREADS; i++) {
+		pthread_join(ts[i], NULL);
+	}
+	check(count == NTHREADS * NINCS, "mutex count");
+	check(pthread_mutex_trylock(&countlock) == 0, "trylock");
+	check(pthread_mutex_trylock(&countlock) == EBUSY, "trylock held");
+	pthread_mutex_unlock(&countlock);
+}
+
+////////////////////////////////////////////////////////////
+// condition variables
+
+static pthread_mutex_t buflock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t notfull = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t notempty = PTHREAD_COND_INITIALIZER;
+static int buf[BUFSIZE];
+static unsigned bufhead, buftail;
+
+static
+void *
+producer(void *junk)
+{
+	int i;
+
+	(void)junk;
+	for (i=1; i<=NITEMS; i++) {
+		pthread_mutex_lock(&buflock);
+		while (buftail - bufhead == BUFSIZE) {
+			pthread_cond_wait(&notfull, &buflock);
+		}
+		buf[buftail++ % BUFSIZE] = i;
+		pthread_cond_signal(&notempty);
+		pthread_mutex_unlock(&buflock);
+	}
+	return NULL;
+}
+
+static
+void *
+consumer(void *junk)
+{
+	int i, sum;
+
+	(void)junk;
+	sum = 0;
+	for (i=0; i<NITEMS; i++) {
+		pthread_mutex_lock(&buflock);
+		while (buftail == bufhead) {
+			pthread_cond_wait(&notempty, &buflock);
+		}
+		sum += buf[bufhead++ % BUFSIZE];
+		pthread_cond_signal(&notfull);
+		pthread_mutex_unlock(&buflock);
+	}
+	return (void *)sum;
+}
+
+static
+void
+condtest(void)
+{
+	pthread_t p, c;
+	void *sum;
+
+	printf("condition variables...\n");
+
+	bufhead = buftail = 0;
+	c = spawn(consumer, NULL);
+	p = spawn(producer, NULL);
+	pthread_join(p, NULL);
+	pthread_join(c, &sum);
+	check((int)sum == NITEMS * (NITEMS + 1) / 2, "bounded buffer sum");
+}
+
+////////////////////////////////////////////////////////////
+// process-level interactions
+
+static pthread_mutex_t gatelock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gatecond = PTHREAD_COND_INITIALIZER;
+static int gateopen;
+
+/* Wait until the gate opens. */
+static
+void *
+waiter(void *junk)
+{
+	(void)junk;
+	pthread_mutex_lock(&gatelock);
+	while (!gateopen) {
+		pthread_cond_wait(&gatecond, &gatelock);
+	}
+	pthread_mutex_unlock(&gatelock);
+	return NULL;
+}
+
+static
+void
+opengate(void)
+{
+	pthread_mutex_lock(&gatelock);
+	gateopen = 1;
+	pthread_cond_broadcast(&gatecond);
+	pthread_mutex_unlock(&gatelock);
+}
+
+static
+void
+limittest(void)
+{
+	pthread_t ts[MAXTHREADS];
+	int n, i, result;
+
+	printf("thread limit...\n");
+
+	gateopen = 0;
+	for (n=0; n<MAXTHREADS; n++) {
+		result = pthread_create(&ts[n], NULL, waiter, NULL);
+		if (result) {
+			check(result == EAGAIN, "error at thread limit");
+			break;
+		}
+	}
+	check(n == MAXTHREADS - 1, "thread limit");
+	opengate();
+	for (i=0; i<n; i++) {
+		pthread_join(ts[i], NULL);
+	}
+}
+
+static
+void
+exectest(void)
+{
+	char *args[2] = { (char *)"/testbin/add", NULL };
+	pthread_t t;
+
+	printf("exec with threads...\n");
+
+	gateopen = 0;
+	t = spawn(waiter, NULL);
+	check(execv(args[0], args) == -1 && errno == EBUSY,
+	      "exec with another thread");
+	opengate();
+	pthread_join(t, NULL);
+}
+
+static
+void *
+forker(void *junk)
+{
+	pid_t pid;
+	int status;
+
+	(void)junk;
+	pid = fork();
+	if (pid < 0) {
+		warn("fork");
+		return (void *)1;
+	}
+	if (pid == 0) {
+		/* Only this thread exists in the child. */
+		_exit(pthread_join(1, NULL) == ESRCH ? 7 : 8);
+	}
+	if (waitpid(pid, &status, 0) < 0) {
+		warn("waitpid");
+		return (void *)1;
+	}
+	return (void *)(WIFEXITED(status) ? WEXITSTATUS(status) : 9);
+}
+
+static volatile int spinning;
+
+static
+void *
+spinner(void *junk)
+{
+	(void)junk;
+	while (spinning) {
+		/* until the process exits */
+	}
+	return NULL;
+}
+
+static
+void
+forktest(void)
+{
+	pthread_t t;
+	pid_t pid;
+	void *val;
+	int status;
+
+	printf("fork from a thread...\n");
+	t = spawn(forker, NULL);
+	pthread_join(t, &val);
+	check((int)val == 7, "forked child of a thread");
+
+	printf("exit with threads running...\n");
+	pid = fork();
+	if (pid < 0) {
+		err(1, "fork");
+	}
+	if (pid == 0) {
+		gateopen = 0;
+		spinning = 1;
+		spawn(spinner, NULL);
+		spawn(waiter, NULL);
+		spawn(spinner, NULL);
+		exit(3);
+	}
+	if (waitpid(pid, &status, 0) < 0) {
+		err(1, "waitpid");
+	}
+	check(WIFEXITED(status) && WEXITSTATUS(status) == 3,
+	      "exit status with threads running");
+}
+
+static
+void *
+pipereader(void *arg)
+{
+	int fd = *(int *)arg;
+	char ch;
+
+	/* Our own process holds the write end, so this never returns. */
+	(void)read(fd, &ch, 1);
+	return NULL;
+}
+
+static
+void
+pipeexittest(void)
+{
+	pid_t pid;
+	int fds[2], status;
+	volatile int i;
+
+	printf("exit with a thread blocked in a pipe...\n");
+	pid = fork();
+	if (pid < 0) {
+		err(1, "fork");
+	}
+	if (pid == 0) {
+		if (pipe(fds) < 0) {
+			err(1, "pipe");
+		}
+		spawn(pipereader, &fds[0]);
+		/* give it a chance to get to sleep */
+		for (i=0; i<100000; i++);
+		_exit(4);
+	}
+	if (waitpid(pid, &status, 0) < 0) {
+		err(1, "waitpid");
+	}
+	check(WIFEXITED(status) && WEXITSTATUS(status) == 4,
+	      "exit status with a thread in a pipe");
+}
+
+////////////////////////////////////////////////////////////
+// main
+
+int
+main(void)
+{
+	jointest();
+	mutextest();
+	condtest();
+	limittest();
+	exectest();
+	forktest();
+	pipeexittest();
+
+	return check_report("pthreadtest");
+}
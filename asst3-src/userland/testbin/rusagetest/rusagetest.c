@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * rusagetest - test wait4 and getrusage.
+ *
+ * Runs a child that burns some user time and touches a known number
+ * of fresh pages, then checks what wait4 and getrusage report for it.
+ */
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <err.h>
+#include <test/check.h>
+
+#define NPAGES		64
+#define PAGESIZE	4096
+#define SPINSECS	1
+
+static char pages[NPAGES * PAGESIZE];
+static
+unsigned long
+usecs(const struct timeval *tv)
+{
+	return tv->tv_sec * 1000000UL + tv->tv_usec;
+}
+
+static
+void
+show(const char *what, const struct rusage *ru)
+{
+	printf("%s: user %lu us, sys %lu us, minflt %lu, majflt %lu, "
+	       "inblock %lu, oublock %lu, nvcsw %lu, nivcsw %lu\n", what,
+	       usecs(&ru->ru_utime), usecs(&ru->ru_stime),
+	       (unsigned long)ru->ru_minflt, (unsigned long)ru->ru_majflt,
+	       (unsigned long)ru->ru_inblock, (unsigned long)ru->ru_oublock,
+	       (unsigned long)ru->ru_nvcsw, (unsigned long)ru->ru_nivcsw);
+}
+
+static
+void
+child(void)
+{
+	time_t start, now;
+	unsigned long ns;
+	unsigned i;
+
+	for (i=0; i<NPAGES; i++) {
+		pages[i * PAGESIZE] = 1;
+	}
+	__time(&start, &ns);
+	do {
+		__time(&now, &ns);
+	} while (now - start <= SPINSECS);
+	_exit(0);
+}
+
+int
+main(void)
+{
+	struct rusage ru, kids;
+	int status;
+	pid_t pid;
+
+	pid = fork();
+	if (pid < 0) {
+		err(1, "fork");
+	}
+	if (pid == 0) {
+		child();
+	}
+
+	memset(&ru, 0, sizeof(ru));
+	if (wait4(pid, &status, 0, &ru) != pid) {
+		err(1, "wait4");
+	}
+	show("child", &ru);
+	check(WIFEXITED(status) && WEXITSTATUS(status) == 0,
+	      "child's exit status");
+	check(ru.ru_minflt >= NPAGES, "child's faults counted");
+	check(usecs(&ru.ru_utime) + usecs(&ru.ru_stime) > 0,
+	      "child's time counted");
+
+	if (getrusage(RUSAGE_CHILDREN, &kids) < 0) {
+		err(1, "getrusage(RUSAGE_CHILDREN)");
+	}
+	check(kids.ru_minflt == ru.ru_minflt &&
+	      usecs(&kids.ru_utime) == usecs(&ru.ru_utime) &&
+	      usecs(&kids.ru_stime) == usecs(&ru.ru_stime),
+	      "RUSAGE_CHILDREN matches what wait4 returned");
+
+	if (getrusage(RUSAGE_SELF, &ru) < 0) {
+		err(1, "getrusage(RUSAGE_SELF)");
+	}
+	show("self", &ru);
+
+	check(getrusage(12345, &ru) < 0 && errno == EINVAL,
+	      "getrusage with a bad who");
+
+	return check_report("rusagetest");
+}
@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * rwvtest - test pread/pwrite and readv/writev (and preadv/pwritev).
+ *
+ * Checks that the positional calls put the data in the right place
+ * without moving the seek position, that the vectored calls gather
+ * and scatter across their buffers in order, and a few of the error
+ * cases.
+ */
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <err.h>
+#include <test/check.h>
+
+#define FILENAME	"rwvtest.dat"
+#define NBUFS		20	/* more than the kernel keeps on its stack */
+#define BUFLEN		37
+
+static char bufs[NBUFS][BUFLEN];
+static char big[NBUFS * BUFLEN];
+static struct iovec iov[NBUFS];
+static
+void
+fill(char *buf, size_t len, unsigned seed)
+{
+	size_t i;
+
+	for (i=0; i<len; i++) {
+		buf[i] = 'a' + (seed + i) % 26;
+	}
+}
+
+static
+void
+setupiov(void)
+{
+	unsigned i;
+
+	for (i=0; i<NBUFS; i++) {
+		iov[i].iov_base = bufs[i];
+		iov[i].iov_len = BUFLEN;
+	}
+}
+
+static
+void
+positional(int fd)
+{
+	char buf[16], back[16];
+
+	fill(buf, sizeof(buf), 7);
+	check(pwrite(fd, buf, sizeof(buf), 1000) == sizeof(buf),
+	      "pwrite returns the length");
+	check(lseek(fd, 0, SEEK_CUR) == 0, "pwrite leaves the offset alone");
+	check(pread(fd, back, sizeof(back), 1000) == sizeof(back),
+	      "pread returns the length");
+	check(!memcmp(buf, back, sizeof(buf)), "pread reads what pwrite wrote");
+	check(lseek(fd, 0, SEEK_CUR) == 0, "pread leaves the offset alone");
+	check(pread(fd, back, sizeof(back), 1016) == 0, "pread at EOF");
+
+	check(pread(fd, back, sizeof(back), -1) < 0 && errno == EINVAL,
+	      "pread at a negative offset");
+	check(pread(STDOUT_FILENO, back, sizeof(back), 0) < 0 &&
+	      errno == ESPIPE, "pread on the console");
+}
+
+static
+void
+vectored(int fd)
+{
+	unsigned i;
+
+	for (i=0; i<NBUFS; i++) {
+		fill(bufs[i], BUFLEN, i);
+		memcpy(big + i*BUFLEN, bufs[i], BUFLEN);
+	}
+	setupiov();
+
+	/* writev gathers, and moves the offset */
+	check(writev(fd, iov, NBUFS) == sizeof(big), "writev returns the total");
+	check(lseek(fd, 0, SEEK_CUR) == sizeof(big), "writev moves the offset");
+
+	memset(big, 0, sizeof(big));
+	check(pread(fd, big, sizeof(big), 0) == sizeof(big),
+	      "pread after writev");
+	for (i=0; i<NBUFS; i++) {
+		if (memcmp(big + i*BUFLEN, bufs[i], BUFLEN)) {
+			break;
+		}
+	}
+	check(i == NBUFS, "writev gathers the buffers in order");
+
+	/* readv scatters */
+	memset(bufs, 0, sizeof(bufs));
+	check(lseek(fd, 0, SEEK_SET) == 0, "lseek");
+	check(readv(fd, iov, NBUFS) == sizeof(big), "readv returns the total");
+	check(!memcmp(bufs, big, sizeof(big)),
+	      "readv scatters the buffers in order");
+
+	/* preadv with a zero-length buffer in the middle */
+	memset(bufs, 0, sizeof(bufs));
+	iov[1].iov_len = 0;
+	check(preadv(fd, iov, 3, BUFLEN) == 2*BUFLEN,
+	      "preadv returns the total");
+	check(!memcmp(bufs[0], big + BUFLEN, BUFLEN) &&
+	      !memcmp(bufs[2], big + 2*BUFLEN, BUFLEN) && bufs[1][0] == 0,
+	      "preadv skips an empty buffer");
+	check(lseek(fd, 0, SEEK_CUR) == sizeof(big),
+	      "preadv leaves the offset alone");
+
+	/* pwritev */
+	setupiov();
+	fill(bufs[0], BUFLEN, 99);
+	fill(bufs[1], BUFLEN, 98);
+	check(pwritev(fd, iov, 2, 0) == 2*BUFLEN, "pwritev returns the total");
+	check(pread(fd, big, 2*BUFLEN, 0) == 2*BUFLEN &&
+	      !memcmp(big, bufs[0], BUFLEN) &&
+	      !memcmp(big + BUFLEN, bufs[1], BUFLEN),
+	      "pwritev writes at the position");
+
+	/* errors */
+	check(readv(fd, iov, -1) < 0 && errno == EINVAL, "readv with count -1");
+	check(readv(fd, iov, 1025) < 0 && errno == EINVAL,
+	      "readv with count > IOV_MAX");
+	iov[0].iov_len = (size_t)-1 / 2;
+	iov[1].iov_len = (size_t)-1 / 2;
+	check(readv(fd, iov, 3) < 0 && errno == EINVAL,
+	      "readv with an overlong total");
+	check(readv(fd, NULL, 2) < 0 && errno == EFAULT,
+	      "readv with a bad iovec pointer");
+	check(readv(fd, iov, 0) == 0, "readv with no buffers");
+}
+
+int
+main(void)
+{
+	int fd;
+
+	fd = open(FILENAME, O_RDWR|O_CREAT|O_TRUNC, 0664);
+	if (fd < 0) {
+		err(1, "%s", FILENAME);
+	}
+
+	positional(fd);
+	if (ftruncate(fd, 0) < 0) {
+		err(1, "ftruncate");
+	}
+	vectored(fd);
+
+	close(fd);
+	remove(FILENAME);
+
+	return check_report("rwvtest");
+}
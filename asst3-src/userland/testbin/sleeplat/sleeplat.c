@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * sleeplat - measure how long nanosleep and the interval timer
+ * actually take to wake us up.
+ *
+ * For each of several sleep lengths, sleep a number of times and
+ * print a histogram of how late each wakeup was. Then set a periodic
+ * ITIMER_REAL and do the same for the time between its ticks.
+ *
+ * A nanosleep that wakes up early is an error. Late is expected, but
+ * should normally be under one clock tick (10 ms).
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <err.h>
+
+#define NSLEEPS		50	/* sleeps per length */
+#define NTICKS		50	/* itimer ticks to time */
+#define ITIMER_USEC	20000	/* itimer period */
+#define NBUCKETS	18	/* histogram buckets: <1us .. >=64ms */
+
+static const unsigned long lengths[] = {	/* in microseconds */
+	500, 5000, 10000, 25000, 100000,
+};
+#define NLENGTHS (sizeof(lengths) / sizeof(lengths[0]))
+
+struct stats {
+	unsigned count;
+	unsigned long min, max, total;
+	unsigned buckets[NBUCKETS];
+};
+
+static
+void
+getnow(struct timespec *ts)
+{
+	time_t secs;
+	unsigned long nsecs;
+
+	if (__time(&secs, &nsecs)) {
+		err(1, "__time");
+	}
+	ts->tv_sec = secs;
+	ts->tv_nsec = nsecs;
+}
+
+/*
+ * Microseconds from T1 to T2. Returns a negative number if T2 is
+ * before T1.
+ */
+static
+long
+usecs_between(const struct timespec *t1, const struct timespec *t2)
+{
+	long secs, nsecs;
+
+	secs = t2->tv_sec - t1->tv_sec;
+	nsecs = t2->tv_nsec - t1->tv_nsec;
+	return secs * 1000000 + nsecs / 1000;
+}
+
+static
+void
+stats_init(struct stats *st)
+{
+	bzero(st, sizeof(*st));
+	st->min = (unsigned long)-1;
+}
+
+static
+void
+stats_add(struct stats *st, unsigned long usecs)
+{
+	unsigned b;
+
+	st->count++;
+	st->total += usecs;
+	if (usecs < st->min) {
+		st->min = usecs;
+	}
+	if (usecs > st->max) {
+		st->max = usecs;
+	}
+
+	/* Bucket 0 is under 1 us; bucket b is [2^(b-1), 2^b) us. */
+	for (b = 0; b < NBUCKETS-1 && usecs >= (1UL << b); b++) {
+		/* nothing */
+	}
+	st->buckets[b]++;
+}
+
+static
+void
+stats_print(const struct stats *st)
+{
+	unsigned b, i, width;
+
+	if (st->count == 0) {
+		return;
+	}
+	printf("    min %lu us, avg %lu us, max %lu us\n",
+	       st->min, st->total / st->count, st->max);
+	for (b = 0; b < NBUCKETS; b++) {
+		if (st->buckets[b] == 0) {
+			continue;
+		}
+		if (b == 0) {
+			printf("    %8s < %-6lu", "", 1UL);
+		}
+		else if (b == NBUCKETS-1) {
+			printf("    %8lu <= %-4s", 1UL << (b-1), "");
+		}
+		else {
+			printf("    %8lu .. %-6lu", 1UL << (b-1), 1UL << b);
+		}
+		printf(" %4u ", st->buckets[b]);
+		width = (st->buckets[b] * 40 + st->count - 1) / st->count;
+		for (i = 0; i < width; i++) {
+			putchar('*');
+		}
+		putchar('\n');
+	}
+}
+
+/*
+ * Time NSLEEPS nanosleeps of USECS each.
+ */
+static
+unsigned
+sleeptest(unsigned long usecs)
+{
+	struct timespec req, before, after;
+	struct stats st;
+	unsigned i, early = 0;
+	long took;
+
+	req.tv_sec = usecs / 1000000;
+	req.tv_nsec = (usecs % 1000000) * 1000;
+
+	stats_init(&st);
+	for (i = 0; i < NSLEEPS; i++) {
+		getnow(&before);
+		if (nanosleep(&req, NULL)) {
+			err(1, "nanosleep");
+		}
+		getnow(&after);
+		took = usecs_between(&before, &after);
+		if (took < (long)usecs) {
+			warnx("nanosleep of %lu us returned after %ld us",
+			      usecs, took);
+			early++;
+			continue;
+		}
+		stats_add(&st, took - usecs);
+	}
+
+	printf("nanosleep %lu us: latency\n", usecs);
+	stats_print(&st);
+	return early;
+}
+
+/*
+ * Time NTICKS ticks of a periodic ITIMER_REAL, by sleeping until it
+ * interrupts us.
+ */
+static
+unsigned
+itimertest(void)
+{
+	struct itimerval itv, cur;
+	struct timespec forever, before, after;
+	struct stats st;
+	unsigned i, bad = 0;
+	long took;
+
+	itv.it_value.tv_sec = 0;
+	itv.it_value.tv_usec = ITIMER_USEC;
+	itv.it_interval = itv.it_value;
+	forever.tv_sec = 1000;
+	forever.tv_nsec = 0;
+
+	stats_init(&st);
+	if (setitimer(ITIMER_REAL, &itv, NULL)) {
+		err(1, "setitimer");
+	}
+	getnow(&before);
+	for (i = 0; i < NTICKS; i++) {
+		if (nanosleep(&forever, NULL) == 0) {
+			errx(1, "nanosleep: not interrupted by itimer");
+		}
+		if (errno != EINTR) {
+			err(1, "nanosleep");
+		}
+		getnow(&after);
+		took = usecs_between(&before, &after);
+		before = after;
+		/* jitter either way */
+		stats_add(&st, took < ITIMER_USEC ?
+			  ITIMER_USEC - took : took - ITIMER_USEC);
+	}
+
+	bzero(&itv, sizeof(itv));
+	if (setitimer(ITIMER_REAL, &itv, NULL)) {
+		err(1, "setitimer");
+	}
+	if (getitimer(ITIMER_REAL, &cur)) {
+		err(1, "getitimer");
+	}
+	if (cur.it_value.tv_sec != 0 || cur.it_value.tv_usec != 0) {
+		warnx("getitimer: timer still set after turning it off");
+		bad++;
+	}
+
+	printf("itimer every %d us: jitter\n", ITIMER_USEC);
+	stats_print(&st);
+	return bad;
+}
+
+int
+main(void)
+{
+	unsigned i, bad = 0;
+
+	for (i = 0; i < NLENGTHS; i++) {
+		bad += sleeptest(lengths[i]);
+	}
+	bad += itimertest();
+
+	if (bad) {
+		errx(1, "%u errors", bad);
+	}
+	printf("sleeplat: passed\n");
+	return 0;
+}
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * spawntest - test posix_spawn.
+ *
+ * Runs /bin/cat with its input and output set up by each kind of file
+ * action and checks what comes out, and checks that spawning a
+ * program that doesn't exist, or with a bad file action, fails with
+ * the right error.
+ */
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <err.h>
+#include <spawn.h>
+#include <test/check.h>
+
+#define INFILE		"spawntest.in"
+#define OUTFILE		"spawntest.out"
+#define DATA		"Ducks spawn in spring.\n"
+
+static char *catargv[2] = { (char *)"cat", NULL };
+static
+void
+writefile(const char *path, const char *data)
+{
+	int fd;
+
+	fd = open(path, O_WRONLY|O_CREAT|O_TRUNC, 0664);
+	if (fd < 0) {
+		err(1, "%s", path);
+	}
+	if (write(fd, data, strlen(data)) != (ssize_t)strlen(data)) {
+		err(1, "%s: write", path);
+	}
+	close(fd);
+}
+
+static
+int
+filematches(const char *path, const char *data)
+{
+	char buf[128];
+	ssize_t len;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		err(1, "%s", path);
+	}
+	len = read(fd, buf, sizeof(buf));
+	close(fd);
+	return len == (ssize_t)strlen(data) && !memcmp(buf, data, len);
+}
+
+/*
+ * Spawn cat with file actions FA and wait for it.
+ */
+static
+void
+runcat(const posix_spawn_file_actions_t *fa, const char *what)
+{
+	pid_t pid;
+	int result, status;
+
+	result = posix_spawn(&pid, "/bin/cat", fa, NULL, catargv, NULL);
+	if (result) {
+		errno = result;
+		err(1, "%s: posix_spawn", what);
+	}
+	if (waitpid(pid, &status, 0) < 0) {
+		err(1, "%s: waitpid", what);
+	}
+	check(WIFEXITED(status) && WEXITSTATUS(status) == 0, what);
+	check(filematches(OUTFILE, DATA), what);
+	remove(OUTFILE);
+}
+
+static
+void
+test_open(void)
+{
+	posix_spawn_file_actions_t fa;
+
+	posix_spawn_file_actions_init(&fa);
+	posix_spawn_file_actions_addopen(&fa, STDIN_FILENO, INFILE,
+					 O_RDONLY, 0);
+	posix_spawn_file_actions_addopen(&fa, STDOUT_FILENO, OUTFILE,
+					 O_WRONLY|O_CREAT|O_TRUNC, 0664);
+	runcat(&fa, "open actions");
+	posix_spawn_file_actions_destroy(&fa);
+}
+
+static
+void
+test_dup2close(void)
+{
+	posix_spawn_file_actions_t fa;
+	int infd, outfd;
+
+	infd = open(INFILE, O_RDONLY);
+	outfd = open(OUTFILE, O_WRONLY|O_CREAT|O_TRUNC, 0664);
+	if (infd < 0 || outfd < 0) {
+		err(1, "open");
+	}
+
+	posix_spawn_file_actions_init(&fa);
+	posix_spawn_file_actions_adddup2(&fa, infd, STDIN_FILENO);
+	posix_spawn_file_actions_adddup2(&fa, outfd, STDOUT_FILENO);
+	posix_spawn_file_actions_addclose(&fa, infd);
+	posix_spawn_file_actions_addclose(&fa, outfd);
+	runcat(&fa, "dup2 and close actions");
+	posix_spawn_file_actions_destroy(&fa);
+
+	/* Our own files are untouched. */
+	check(close(infd) == 0 && close(outfd) == 0, "parent's fds still open");
+}
+
+static
+void
+test_errors(void)
+{
+	posix_spawn_file_actions_t fa;
+	pid_t pid;
+
+	check(posix_spawn(&pid, "/nonexistent", NULL, NULL, catargv, NULL)
+	      == ENOENT, "missing program gives ENOENT");
+
+	posix_spawn_file_actions_init(&fa);
+	posix_spawn_file_actions_adddup2(&fa, 40, STDIN_FILENO);
+	check(posix_spawn(&pid, "/bin/cat", &fa, NULL, catargv, NULL)
+	      == EBADF, "dup2 of a closed fd gives EBADF");
+	posix_spawn_file_actions_destroy(&fa);
+}
+
+int
+main(void)
+{
+	writefile(INFILE, DATA);
+
+	test_open();
+	test_dup2close();
+	test_errors();
+
+	remove(INFILE);
+
+	return check_report("spawntest");
+}
@@ -32,25 +32,20 @@
  * forks 3 threads off 2 to functions, each of which displays a string
  * every once in a while.
  *
- * This won't do much of anything unless you implement user-level
- * threads.
+ * The threads are made with pthread_create (see libpthread). Since
+ * exit() takes the whole process with it, the parent leaves with
+ * pthread_exit so the children keep running; they exit when they
+ * return from the function they started in.
  *
- * It also makes various assumptions about the thread API. In
- * particular, it believes (1) that you create a thread by calling
- * "threadfork()" and passing the address for execution of the new
- * thread to begin at, (2) that if the parent thread exits any child
- * threads will keep running, and (3) child threads will exit if they
- * return from the function they started in. If any or all of these
- * assumptions are not met by your user-level threads, you will need
- * to patch this test accordingly.
- *
- * This is also a rather basic test and you'll probably want to write
- * some more of your own.
+ * This is a rather basic test; see pthreadtest for more.
  */
 
 
 #include <unistd.h>
 #include <stdio.h>
+#include <errno.h>
+#include <err.h>
+#include <pthread.h>
 
 #define NTHREADS  3
 #define MAX       1<<25
@@ -61,26 +56,32 @@
 volatile int count = 0;
 
 /* the 2 threads : */
-void ThreadRunner(void);
-void BladeRunner(void);
+void *ThreadRunner(void *);
+void *BladeRunner(void *);
 
 int
 main(int argc, char *argv[])
 {
-    int i;
+    pthread_t t;
+    int i, result;
 
     (void)argc;
     (void)argv;
 
     for (i=0; i<NTHREADS; i++) {
 	if (i)
-	    threadfork(ThreadRunner);
+	    result = pthread_create(&t, NULL, ThreadRunner, NULL);
         else
-	    threadfork(BladeRunner);
+	    result = pthread_create(&t, NULL, BladeRunner, NULL);
+	if (result) {
+	    errno = result;
+	    err(1, "pthread_create");
+	}
+	pthread_detach(t);
     }
 
     printf("Parent has left.\n");
-    return 0;
+    pthread_exit(NULL);
 }
 
 /* multiple threads will simply print out the global variable.
@@ -88,22 +89,26 @@ main(int argc, char *argv[])
    random results.
 */
 
-void
-BladeRunner()
+void *
+BladeRunner(void *junk)
 {
+    (void)junk;
     while (count < MAX) {
 	if (count % 500 == 0)
 	    printf("Blade ");
 	count++;
     }
+    return NULL;
 }
 
-void
-ThreadRunner()
+void *
+ThreadRunner(void *junk)
 {
+    (void)junk;
     while (count < MAX) {
 	if (count % 513 == 0)
 	    printf(" Runner\n");
 	count++;
     }
+    return NULL;
 }
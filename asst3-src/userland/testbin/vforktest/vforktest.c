@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2026
+ *	The President and Fellows of Harvard College.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE UNIVERSITY OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * vforktest - test vfork.
+ *
+ * Checks that the child really runs in the parent's address space and
+ * that the parent doesn't run again until the child has exited or
+ * exec'd, that a failed exec in the child leaves the parent's memory
+ * alone, and then times fork+exec against vfork+exec of /bin/true.
+ */
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <err.h>
+#include <test/check.h>
+
+#define NSPAWNS		20
+
+static volatile int shared;
+static
+int
+reap(pid_t pid)
+{
+	int status;
+
+	if (waitpid(pid, &status, 0) < 0) {
+		err(1, "waitpid");
+	}
+	if (!WIFEXITED(status)) {
+		return -1;
+	}
+	return WEXITSTATUS(status);
+}
+
+static
+void
+test_shared(void)
+{
+	volatile int i;
+	pid_t pid;
+
+	shared = 0;
+	pid = vfork();
+	if (pid < 0) {
+		err(1, "vfork");
+	}
+	if (pid == 0) {
+		/* Dawdle; the parent must not run meanwhile. */
+		for (i=0; i<100000; i++);
+		shared = 1;
+		_exit(3);
+	}
+	check(shared == 1, "child's store visible to parent after vfork");
+	check(reap(pid) == 3, "vforked child's exit status");
+}
+
+static
+void
+test_badexec(void)
+{
+	char *args[2];
+	pid_t pid;
+
+	shared = 0;
+	args[0] = (char *)"/nonexistent";
+	args[1] = NULL;
+	pid = vfork();
+	if (pid < 0) {
+		err(1, "vfork");
+	}
+	if (pid == 0) {
+		execv(args[0], args);
+		shared = 2;
+		_exit(4);
+	}
+	check(shared == 2, "child continues in our memory after failed exec");
+	check(reap(pid) == 4, "exit status after failed exec");
+}
+
+static
+unsigned long
+spawn(int usevfork)
+{
+	time_t s0, s1;
+	unsigned long ns0, ns1;
+	char *args[2];
+	pid_t pid;
+	int i;
+
+	args[0] = (char *)"/bin/true";
+	args[1] = NULL;
+
+	__time(&s0, &ns0);
+	for (i=0; i<NSPAWNS; i++) {
+		pid = usevfork ? vfork() : fork();
+		if (pid < 0) {
+			err(1, usevfork ? "vfork" : "fork");
+		}
+		if (pid == 0) {
+			execv(args[0], args);
+			_exit(255);
+		}
+		check(reap(pid) == 0, "/bin/true exit status");
+	}
+	__time(&s1, &ns1);
+
+	/* Microseconds per spawn */
+	return ((s1 - s0) * 1000000UL + ns1 / 1000 - ns0 / 1000) / NSPAWNS;
+}
+
+int
+main(void)
+{
+	unsigned long forkus, vforkus;
+
+	test_shared();
+	test_badexec();
+
+	forkus = spawn(0);
+	vforkus = spawn(1);
+	printf("fork+exec:  %lu us\n", forkus);
+	printf("vfork+exec: %lu us\n", vforkus);
+
+	return check_report("vforktest");
+}